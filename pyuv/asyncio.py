@@ -0,0 +1,920 @@
+"""asyncio event loop which runs on top of a pyuv Loop.
+
+The ready queue, the timers and the loop iteration are implemented in C (pyuv._cpyuv._asyncio).
+Stream and datagram sockets, pipes and subprocesses are served by pyuv TCP, Pipe, UDP and
+Process handles, so that reading and writing happens in libuv, without going through the
+selector. Everything else (file descriptor callbacks, signal handlers, the sock_* methods and
+the cases the pyuv handles don't cover) is handled by the standard selector based event loop,
+with a UVSelector which collects readiness through the same pyuv loop. When an existing pyuv
+Loop is given, its handles are processed while asyncio waits for events, so both worlds can
+share a single thread.
+"""
+
+from __future__ import absolute_import
+
+import asyncio
+import functools
+import os
+import socket
+import stat
+import subprocess
+import sys
+import warnings
+
+from asyncio import base_events, base_subprocess, constants, futures, protocols, sslproto, transports
+from asyncio.log import logger
+
+import pyuv
+from pyuv._cpyuv import _asyncio
+from pyuv.selectors import UVSelector
+
+try:
+    from asyncio.trsock import TransportSocket
+except ImportError:
+    TransportSocket = None
+
+
+__all__ = ['EventLoop', 'EventLoopPolicy']
+
+
+_BufferedProtocol = getattr(protocols, 'BufferedProtocol', None)
+
+# Linux reports these flags as part of the socket type on Python < 3.7
+_SOCK_TYPE_MASK = ~(getattr(socket, 'SOCK_NONBLOCK', 0) | getattr(socket, 'SOCK_CLOEXEC', 0))
+
+_IP_FAMILIES = (socket.AF_INET, socket.AF_INET6)
+_STREAM_FAMILIES = _IP_FAMILIES + ((socket.AF_UNIX,) if hasattr(socket, 'AF_UNIX') else ())
+
+
+def _os_error(err):
+    """Build the OSError subclass matching a libuv error code."""
+    return OSError(-err, pyuv.errno.strerror(err))
+
+
+def _raise(exc):
+    raise exc
+
+
+def _is_stream_socket(sock, families):
+    return sock.family in families and sock.type & _SOCK_TYPE_MASK == socket.SOCK_STREAM
+
+
+def _is_connected(sock):
+    try:
+        sock.getpeername()
+    except OSError:
+        return False
+    return True
+
+
+def _open_handle(handle, fd):
+    """Let handle manage a duplicate of fd, so that the original file object stays valid.
+    Returns False if libuv can't manage it."""
+    fd = os.dup(fd)
+    try:
+        handle.open(fd)
+    except pyuv.error.UVError:
+        os.close(fd)
+        handle.close()
+        return False
+    return True
+
+
+class _ReadProtocol(object):
+    """Read buffers provider given to Stream.start_read_protocol, on behalf of the transport."""
+
+    def __init__(self, transport):
+        self.get_buffer = transport._get_buffer
+        self.buffer_updated = transport._buffer_updated
+        self.eof_received = transport._on_eof
+        self.connection_lost = transport._on_read_error
+
+
+class _StreamTransport(transports._FlowControlMixin, transports.Transport):
+    """Transport for a pyuv stream handle (TCP or Pipe).
+
+    Writes are tried right away with try_write, what can't be written is queued in libuv.
+    Protocols derived from BufferedProtocol have the data read into their buffers by libuv.
+    """
+
+    _start_tls_compatible = True
+    _handle = None
+
+    def __init__(self, loop, handle, protocol, waiter=None, extra=None, server=None, sock=None, family=None):
+        super(_StreamTransport, self).__init__(extra, loop)
+        # file object the handle was opened from, closed together with the transport. For
+        # accepted connections a socket is only created if the 'socket' extra is requested
+        self._sock = sock
+        self._family = getattr(sock, 'family', family)
+        self._server = server
+        self._protocol = None
+        self._protocol_connected = False
+        self._buffered = False
+        self._closing = False
+        self._paused = False
+        self._reading = False
+        self._eof = False
+        self._conn_lost = 0
+        self._pending_writes = 0
+        self._read_error = None
+        self.set_protocol(protocol)
+        self._handle = handle
+
+        if server is not None:
+            if sys.version_info >= (3, 13):
+                server._attach(self)
+            else:
+                server._attach()
+        loop._transports[handle.fileno()] = self
+
+        loop.call_soon(self._protocol.connection_made, self)
+        loop.call_soon(self._start_reading)
+        if waiter is not None:
+            loop.call_soon(futures._set_result_unless_cancelled, waiter, None)
+
+    def __repr__(self):
+        info = [self.__class__.__name__]
+        if self._handle is None or self._handle.closed:
+            info.append('closed')
+        else:
+            if self._closing:
+                info.append('closing')
+            info.append('fd=%s' % self._handle.fileno())
+            info.append('read=%s' % ('polling' if self._reading else 'idle'))
+            info.append('write=<bufsize=%s>' % self.get_write_buffer_size())
+        return '<%s>' % ' '.join(info)
+
+    def __del__(self, _warn=warnings.warn):
+        if self._handle is not None:
+            _warn("unclosed transport %r" % self, ResourceWarning, source=self)
+            self._close_handle()
+
+    def get_extra_info(self, name, default=None):
+        if name not in self._extra and self._handle is not None:
+            self._fill_extra(name)
+        return self._extra.get(name, default)
+
+    def _fill_extra(self, name):
+        if name not in ('socket', 'sockname', 'peername'):
+            return
+        if self._sock is None and self._family is not None:
+            self._sock = socket.socket(self._family, socket.SOCK_STREAM, 0, os.dup(self._handle.fileno()))
+        sock = self._sock
+        if not isinstance(sock, socket.socket):
+            return
+        self._extra['socket'] = sock if TransportSocket is None else TransportSocket(sock)
+        try:
+            self._extra['sockname'] = sock.getsockname()
+        except OSError:
+            self._extra['sockname'] = None
+        try:
+            self._extra['peername'] = sock.getpeername()
+        except OSError:
+            self._extra['peername'] = None
+
+    def set_protocol(self, protocol):
+        buffered = _BufferedProtocol is not None and isinstance(protocol, _BufferedProtocol)
+        self._protocol = protocol
+        self._protocol_connected = True
+        if self._reading and buffered != self._buffered:
+            self._handle.stop_read()
+            self._buffered = buffered
+            self._read_start()
+        self._buffered = buffered
+
+    def get_protocol(self):
+        return self._protocol
+
+    def is_closing(self):
+        return self._closing
+
+    # Reading
+
+    def _start_reading(self):
+        if self.is_reading():
+            self._read_start()
+
+    def _read_start(self):
+        if self._buffered:
+            self._handle.start_read_protocol(_ReadProtocol(self))
+        else:
+            self._handle.start_read(self._on_read)
+        self._reading = True
+
+    def _read_stop(self):
+        if self._reading:
+            self._reading = False
+            self._handle.stop_read()
+
+    def is_reading(self):
+        return not self._closing and not self._paused
+
+    def pause_reading(self):
+        if not self.is_reading():
+            return
+        self._paused = True
+        self._read_stop()
+        if self._loop.get_debug():
+            logger.debug("%r pauses reading", self)
+
+    def resume_reading(self):
+        if self._closing or not self._paused:
+            return
+        self._paused = False
+        self._read_start()
+        if self._loop.get_debug():
+            logger.debug("%r resumes reading", self)
+
+    def _on_read(self, handle, data, error):
+        if error is not None:
+            if error == pyuv.errno.UV_EOF:
+                self._on_eof()
+            else:
+                self._on_read_error(error)
+            return
+        if self._conn_lost:
+            return
+        try:
+            self._protocol.data_received(data)
+        except (SystemExit, KeyboardInterrupt) as exc:
+            self._loop.call_soon(_raise, exc)
+        except BaseException as exc:
+            self._fatal_error(exc, 'Fatal error: protocol.data_received() call failed.')
+
+    def _get_buffer(self, size):
+        if not self._conn_lost:
+            try:
+                buf = self._protocol.get_buffer(-1)
+                if not len(buf):
+                    raise RuntimeError('get_buffer() returned an empty buffer')
+                return buf
+            except (SystemExit, KeyboardInterrupt) as exc:
+                self._loop.call_soon(_raise, exc)
+            except BaseException as exc:
+                # reading can't be stopped while libuv waits for a buffer, the error is
+                # handled when the read completes
+                self._read_error = exc
+        return bytearray(size)
+
+    def _buffer_updated(self, nbytes):
+        if self._read_error is not None:
+            exc, self._read_error = self._read_error, None
+            self._fatal_error(exc, 'Fatal error: protocol.get_buffer() call failed.')
+            return
+        if self._conn_lost:
+            return
+        try:
+            self._protocol.buffer_updated(nbytes)
+        except (SystemExit, KeyboardInterrupt) as exc:
+            self._loop.call_soon(_raise, exc)
+        except BaseException as exc:
+            self._fatal_error(exc, 'Fatal error: protocol.buffer_updated() call failed.')
+
+    def _on_eof(self):
+        # libuv stopped reading already
+        self._reading = False
+        if self._conn_lost:
+            return
+        if self._loop.get_debug():
+            logger.debug("%r received EOF", self)
+        try:
+            keep_open = self._protocol.eof_received()
+        except (SystemExit, KeyboardInterrupt) as exc:
+            self._loop.call_soon(_raise, exc)
+            return
+        except BaseException as exc:
+            self._fatal_error(exc, 'Fatal error: protocol.eof_received() call failed.')
+            return
+        if not keep_open:
+            self.close()
+
+    def _on_read_error(self, error):
+        self._reading = False
+        if not self._conn_lost:
+            self._fatal_error(_os_error(error), 'Fatal read error on socket transport')
+
+    # Writing
+
+    def get_write_buffer_size(self):
+        if self._handle is None:
+            return 0
+        return self._handle.write_queue_size
+
+    def write(self, data):
+        if not isinstance(data, (bytes, bytearray, memoryview)):
+            raise TypeError('data argument must be a bytes-like object, not %r' % type(data).__name__)
+        if self._eof:
+            raise RuntimeError('Cannot call write() after write_eof()')
+        if not data:
+            return
+
+        if self._conn_lost:
+            if self._conn_lost >= constants.LOG_THRESHOLD_FOR_CONNLOST_WRITES:
+                logger.warning('socket.send() raised exception.')
+            self._conn_lost += 1
+            return
+
+        # libuv fails with UV_EAGAIN if writes are queued, so data is never reordered
+        try:
+            n = self._handle.try_write(data)
+        except pyuv.error.StreamError as e:
+            if e.args[0] != pyuv.errno.UV_EAGAIN:
+                self._fatal_error(_os_error(e.args[0]), 'Fatal write error on socket transport')
+                return
+            n = 0
+        if n == len(data):
+            return
+
+        # the data could be changed by the caller before it's written
+        data = bytes(memoryview(data)[n:])
+        self._handle.write(data, self._on_write)
+        self._pending_writes += 1
+        self._maybe_pause_protocol()
+
+    def _on_write(self, handle, error):
+        self._pending_writes -= 1
+        if self._conn_lost:
+            return
+        if error is not None:
+            self._fatal_error(_os_error(error), 'Fatal write error on socket transport')
+            return
+        self._maybe_resume_protocol()
+        if not self._pending_writes:
+            if self._closing:
+                self._conn_lost += 1
+                self._call_connection_lost(None)
+            elif self._eof:
+                self._shutdown()
+
+    def write_eof(self):
+        if self._closing or self._eof:
+            return
+        self._eof = True
+        if not self._pending_writes:
+            self._shutdown()
+
+    def _shutdown(self):
+        try:
+            self._handle.shutdown()
+        except pyuv.error.StreamError:
+            pass
+
+    def can_write_eof(self):
+        return True
+
+    # Closing
+
+    def close(self):
+        if self._closing:
+            return
+        self._closing = True
+        self._read_stop()
+        if not self._pending_writes:
+            self._conn_lost += 1
+            self._loop.call_soon(self._call_connection_lost, None)
+
+    def abort(self):
+        self._force_close(None)
+
+    def _fatal_error(self, exc, message='Fatal error on transport'):
+        if isinstance(exc, OSError):
+            if self._loop.get_debug():
+                logger.debug("%r: %s", self, message, exc_info=True)
+        else:
+            self._loop.call_exception_handler({
+                'message': message,
+                'exception': exc,
+                'transport': self,
+                'protocol': self._protocol,
+            })
+        self._force_close(exc)
+
+    def _force_close(self, exc):
+        if self._conn_lost:
+            return
+        # reading stops when the handle is closed, data read in the meantime is dropped
+        self._closing = True
+        self._conn_lost += 1
+        self._loop.call_soon(self._call_connection_lost, exc)
+
+    def _close_handle(self):
+        if not self._handle.closed:
+            self._handle.close()
+        self._handle = None
+        if self._sock is not None:
+            self._sock.close()
+            self._sock = None
+
+    def _call_connection_lost(self, exc):
+        try:
+            if self._protocol_connected:
+                self._protocol.connection_lost(exc)
+        finally:
+            self._close_handle()
+            self._protocol = None
+            self._loop = None
+            server = self._server
+            if server is not None:
+                if sys.version_info >= (3, 13):
+                    server._detach(self)
+                else:
+                    server._detach()
+                self._server = None
+
+
+class _ReadPipeTransport(_StreamTransport):
+    """Transport for the read end of a pipe, the pipe is closed once the end of file is read."""
+
+    def _on_eof(self):
+        self._reading = False
+        if self._conn_lost:
+            return
+        if self._loop.get_debug():
+            logger.info("%r was closed by peer", self)
+        self._closing = True
+        self._conn_lost += 1
+        self._loop.call_soon(self._protocol.eof_received)
+        self._loop.call_soon(self._call_connection_lost, None)
+
+    def _fill_extra(self, name):
+        pass
+
+    def write(self, data):
+        raise NotImplementedError
+
+    def can_write_eof(self):
+        return False
+
+
+class _WritePipeTransport(_StreamTransport):
+    """Transport for the write end of a pipe, write_eof closes it once everything is written."""
+
+    def _start_reading(self):
+        pass
+
+    def _fill_extra(self, name):
+        pass
+
+    def is_reading(self):
+        return False
+
+    def pause_reading(self):
+        pass
+
+    def resume_reading(self):
+        pass
+
+    def write_eof(self):
+        self.close()
+
+
+class _DatagramTransport(transports._FlowControlMixin, transports.DatagramTransport):
+    """Transport for a pyuv UDP handle, on an unconnected socket."""
+
+    _handle = None
+
+    def __init__(self, loop, handle, sock, protocol, waiter=None, extra=None):
+        super(_DatagramTransport, self).__init__(extra, loop)
+        self._handle = handle
+        self._sock = sock
+        self._protocol = protocol
+        self._closing = False
+        self._conn_lost = 0
+        self._buffer_size = 0
+        self._extra['socket'] = sock if TransportSocket is None else TransportSocket(sock)
+        self._extra['sockname'] = sock.getsockname()
+        self._extra['peername'] = None
+        loop._transports[handle.fileno()] = self
+
+        loop.call_soon(self._protocol.connection_made, self)
+        loop.call_soon(self._start_reading)
+        if waiter is not None:
+            loop.call_soon(futures._set_result_unless_cancelled, waiter, None)
+
+    def __repr__(self):
+        info = [self.__class__.__name__]
+        if self._handle is None or self._handle.closed:
+            info.append('closed')
+        else:
+            if self._closing:
+                info.append('closing')
+            info.append('fd=%s' % self._handle.fileno())
+        return '<%s>' % ' '.join(info)
+
+    def __del__(self, _warn=warnings.warn):
+        if self._handle is not None:
+            _warn("unclosed transport %r" % self, ResourceWarning, source=self)
+            if not self._handle.closed:
+                self._handle.close()
+            self._sock.close()
+
+    def get_protocol(self):
+        return self._protocol
+
+    def set_protocol(self, protocol):
+        self._protocol = protocol
+
+    def is_closing(self):
+        return self._closing
+
+    def get_write_buffer_size(self):
+        return self._buffer_size
+
+    def _start_reading(self):
+        if not self._closing:
+            self._handle.start_recv(self._on_recv)
+
+    def _on_recv(self, handle, addr, flags, data, error):
+        if self._conn_lost:
+            return
+        try:
+            if error is not None:
+                self._protocol.error_received(_os_error(error))
+            else:
+                self._protocol.datagram_received(data, addr)
+        except (SystemExit, KeyboardInterrupt) as exc:
+            self._loop.call_soon(_raise, exc)
+        except BaseException as exc:
+            self._fatal_error(exc, 'Fatal read error on datagram transport')
+
+    def sendto(self, data, addr=None):
+        if not isinstance(data, (bytes, bytearray, memoryview)):
+            raise TypeError('data argument must be a bytes-like object, not %r' % type(data).__name__)
+        if addr is None:
+            raise ValueError('Invalid address: the transport is not connected')
+
+        if self._conn_lost:
+            if self._conn_lost >= constants.LOG_THRESHOLD_FOR_CONNLOST_WRITES:
+                logger.warning('socket.send() raised exception.')
+            self._conn_lost += 1
+            return
+
+        if not self._buffer_size:
+            try:
+                self._handle.try_send(addr, data)
+                return
+            except pyuv.error.UDPError as e:
+                if e.args[0] != pyuv.errno.UV_EAGAIN:
+                    self._protocol.error_received(_os_error(e.args[0]))
+                    return
+
+        data = bytes(data)
+        self._handle.send(addr, data, functools.partial(self._on_send, len(data)))
+        self._buffer_size += len(data)
+        self._maybe_pause_protocol()
+
+    def _on_send(self, size, handle, error):
+        self._buffer_size -= size
+        if self._conn_lost:
+            return
+        if error is not None:
+            self._protocol.error_received(_os_error(error))
+        self._maybe_resume_protocol()
+        if not self._buffer_size and self._closing:
+            self._conn_lost += 1
+            self._call_connection_lost(None)
+
+    def close(self):
+        if self._closing:
+            return
+        self._closing = True
+        self._handle.stop_recv()
+        if not self._buffer_size:
+            self._conn_lost += 1
+            self._loop.call_soon(self._call_connection_lost, None)
+
+    def abort(self):
+        self._force_close(None)
+
+    def _fatal_error(self, exc, message='Fatal error on transport'):
+        if isinstance(exc, OSError):
+            if self._loop.get_debug():
+                logger.debug("%r: %s", self, message, exc_info=True)
+        else:
+            self._loop.call_exception_handler({
+                'message': message,
+                'exception': exc,
+                'transport': self,
+                'protocol': self._protocol,
+            })
+        self._force_close(exc)
+
+    def _force_close(self, exc):
+        if self._conn_lost:
+            return
+        self._closing = True
+        self._conn_lost += 1
+        self._loop.call_soon(self._call_connection_lost, exc)
+
+    def _call_connection_lost(self, exc):
+        try:
+            self._protocol.connection_lost(exc)
+        finally:
+            self._handle.close()
+            self._handle = None
+            self._sock.close()
+            self._sock = None
+            self._protocol = None
+            self._loop = None
+
+
+class _Process(object):
+    """Popen look-alike for BaseSubprocessTransport, running the child with a pyuv Process.
+
+    Pipes are created with os.pipe, the parent ends are exposed as file objects, which the
+    subprocess transport connects to pipe transports.
+    """
+
+    # Popen arguments which can be honored, with the values which can be
+    _OPTIONS = {'cwd': None, 'env': None, 'executable': None, 'start_new_session': None,
+                'close_fds': True, 'restore_signals': True}
+
+    @classmethod
+    def supports(cls, kwargs):
+        for key, value in kwargs.items():
+            if key not in cls._OPTIONS:
+                return False
+            if cls._OPTIONS[key] is not None and value != cls._OPTIONS[key]:
+                return False
+        return True
+
+    def __init__(self, loop, args, shell, stdin, stdout, stderr, exit_callback, cwd=None, env=None,
+                 executable=None, start_new_session=False, close_fds=True, restore_signals=True):
+        if shell:
+            args = ['/bin/sh', '-c', args]
+        elif isinstance(args, (str, bytes)) or hasattr(args, '__fspath__'):
+            args = [args]
+        args = [os.fsdecode(arg) if hasattr(arg, '__fspath__') else arg for arg in args]
+        if executable is not None:
+            executable = os.fsdecode(executable)
+
+        self.pid = None
+        self.returncode = None
+        self.stdin = self.stdout = self.stderr = None
+        self._exit_callback = exit_callback
+
+        # file descriptors to be closed in the parent once the child is spawned
+        child_fds = []
+        stdio = []
+        try:
+            for fd, value, mode in ((0, stdin, 'wb'), (1, stdout, 'rb'), (2, stderr, 'rb')):
+                if value is None:
+                    child_fd = fd
+                elif value == subprocess.PIPE:
+                    r, w = os.pipe()
+                    child_fd, parent_fd = (r, w) if fd == 0 else (w, r)
+                    child_fds.append(child_fd)
+                    setattr(self, ('stdin', 'stdout', 'stderr')[fd], open(parent_fd, mode, buffering=0))
+                elif value == subprocess.DEVNULL:
+                    child_fd = os.open(os.devnull, os.O_RDWR)
+                    child_fds.append(child_fd)
+                elif value == subprocess.STDOUT and fd == 2:
+                    child_fd = stdio[1].fd
+                elif isinstance(value, int):
+                    child_fd = value
+                else:
+                    child_fd = value.fileno()
+                stdio.append(pyuv.StdIO(fd=child_fd, flags=pyuv.UV_INHERIT_FD))
+
+            options = dict(executable=executable, cwd=cwd, stdio=stdio, exit_callback=self._on_exit)
+            if env is not None:
+                options['env'] = dict(env)
+            if start_new_session:
+                options['flags'] = pyuv.UV_PROCESS_DETACHED
+            try:
+                self._handle = pyuv.Process.spawn(loop, args, **options)
+            except pyuv.error.ProcessError as e:
+                raise _os_error(e.args[0])
+        except BaseException:
+            for f in (self.stdin, self.stdout, self.stderr):
+                if f is not None:
+                    f.close()
+            raise
+        finally:
+            for fd in child_fds:
+                os.close(fd)
+
+        self.pid = self._handle.pid
+
+    def _on_exit(self, handle, exit_status, term_signal):
+        handle.close()
+        self.returncode = -term_signal if term_signal else exit_status
+        self._exit_callback(self.returncode)
+
+    def poll(self):
+        return self.returncode
+
+    def send_signal(self, signum):
+        if self.returncode is not None:
+            return
+        try:
+            self._handle.kill(signum)
+        except pyuv.error.ProcessError as e:
+            raise _os_error(e.args[0])
+
+    def terminate(self):
+        import signal
+        self.send_signal(signal.SIGTERM)
+
+    def kill(self):
+        import signal
+        self.send_signal(signal.SIGKILL)
+
+
+class _SubprocessTransport(base_subprocess.BaseSubprocessTransport):
+    """Subprocess transport whose child is watched by libuv, no child watcher is involved."""
+
+    def _start(self, args, shell, stdin, stdout, stderr, bufsize, **kwargs):
+        self._proc = _Process(self._loop._uv_loop, args, shell, stdin, stdout, stderr, self._on_exit, **kwargs)
+
+    def _on_exit(self, returncode):
+        if not self._closed or self._returncode is None:
+            self._process_exited(returncode)
+
+
+class EventLoop(_asyncio.EventLoop, asyncio.SelectorEventLoop):
+    """asyncio event loop running on a pyuv Loop.
+
+    If no loop is given a new one is created, and closed together with the event loop.
+    """
+
+    def __init__(self, loop=None):
+        selector = UVSelector(loop)
+        self._uv_loop = selector.loop
+        self._listeners = {}
+        _asyncio.EventLoop.__init__(self, selector.loop, selector._ready)
+        asyncio.SelectorEventLoop.__init__(self, selector)
+
+    @property
+    def uv_loop(self):
+        return self._uv_loop
+
+    def close(self):
+        if self.is_running():
+            raise RuntimeError("Cannot close a running event loop")
+        for handle in self._listeners.values():
+            handle.close()
+        self._listeners.clear()
+        selector = self._selector
+        if selector is not None and selector._own_loop:
+            # the selector runs its loop until all handles are closed, transports left open by
+            # their users would keep it alive
+            for handle in self._uv_loop.handles:
+                if not handle.closed and handle is not selector._group and handle is not selector._timer:
+                    handle.close()
+        super(EventLoop, self).close()
+
+    def _process_io(self):
+        # the poll group collected the events while the loop ran, a non-blocking select maps
+        # them to their keys
+        self._process_events(self._selector.select(0))
+
+    def _run_debug(self, handle):
+        if handle._cancelled:
+            return
+        t0 = self.time()
+        handle._run()
+        dt = self.time() - t0
+        if dt >= self.slow_callback_duration:
+            logger.warning('Executing %s took %.3f seconds', base_events._format_handle(handle), dt)
+
+    def _make_socket_transport(self, sock, protocol, waiter=None, **kwargs):
+        if _is_stream_socket(sock, _STREAM_FAMILIES):
+            if hasattr(self, '_ensure_fd_no_transport'):
+                self._ensure_fd_no_transport(sock)
+            handle = pyuv.TCP(self._uv_loop) if sock.family in _IP_FAMILIES else pyuv.Pipe(self._uv_loop)
+            if _open_handle(handle, sock.fileno()):
+                if sock.family in _IP_FAMILIES:
+                    handle.nodelay(True)
+                return _StreamTransport(self, handle, protocol, waiter, kwargs.get('extra'), kwargs.get('server'), sock=sock)
+        return super(EventLoop, self)._make_socket_transport(sock, protocol, waiter, **kwargs)
+
+    def _make_ssl_transport(self, rawsock, protocol, sslcontext, waiter=None, server_side=False, server_hostname=None,
+                            extra=None, server=None, **kwargs):
+        # TLS runs in Python on top of a native transport
+        ssl_protocol = sslproto.SSLProtocol(self, protocol, sslcontext, waiter, server_side, server_hostname, **kwargs)
+        self._make_socket_transport(rawsock, ssl_protocol, extra=extra, server=server)
+        return ssl_protocol._app_transport
+
+    def _make_datagram_transport(self, sock, protocol, address=None, waiter=None, extra=None):
+        # pyuv UDP handles can't send on connected sockets
+        if sock.family in _IP_FAMILIES and not address and not _is_connected(sock):
+            handle = pyuv.UDP(self._uv_loop)
+            if _open_handle(handle, sock.fileno()):
+                return _DatagramTransport(self, handle, sock, protocol, waiter, extra)
+        return super(EventLoop, self)._make_datagram_transport(sock, protocol, address, waiter, extra)
+
+    def _make_pipe_transport(self, cls, pipe, protocol, waiter, extra):
+        mode = os.fstat(pipe.fileno()).st_mode
+        if not (stat.S_ISFIFO(mode) or stat.S_ISSOCK(mode)):
+            return None
+        handle = pyuv.Pipe(self._uv_loop)
+        if not _open_handle(handle, pipe.fileno()):
+            return None
+        transport = cls(self, handle, protocol, waiter, extra, sock=pipe)
+        transport._extra['pipe'] = pipe
+        return transport
+
+    def _make_read_pipe_transport(self, pipe, protocol, waiter=None, extra=None):
+        transport = self._make_pipe_transport(_ReadPipeTransport, pipe, protocol, waiter, extra)
+        if transport is None:
+            transport = super(EventLoop, self)._make_read_pipe_transport(pipe, protocol, waiter, extra)
+        return transport
+
+    def _make_write_pipe_transport(self, pipe, protocol, waiter=None, extra=None):
+        transport = self._make_pipe_transport(_WritePipeTransport, pipe, protocol, waiter, extra)
+        if transport is None:
+            transport = super(EventLoop, self)._make_write_pipe_transport(pipe, protocol, waiter, extra)
+        return transport
+
+    def _make_subprocess_transport(self, protocol, args, shell, stdin, stdout, stderr, bufsize, extra=None, **kwargs):
+        # not a coroutine, what it returns is awaited
+        if sys.platform == 'win32' or not _Process.supports(kwargs):
+            return super(EventLoop, self)._make_subprocess_transport(protocol, args, shell, stdin, stdout, stderr, bufsize, extra=extra, **kwargs)
+
+        waiter = self.create_future()
+        transport = _SubprocessTransport(self, protocol, args, shell, stdin, stdout, stderr, bufsize,
+                                         waiter=waiter, extra=extra, **kwargs)
+        result = self.create_future()
+
+        def on_connected(fut):
+            if result.done():
+                return
+            if fut.cancelled() or fut.exception() is not None:
+                transport.close()
+                if fut.cancelled():
+                    result.cancel()
+                else:
+                    result.set_exception(fut.exception())
+            else:
+                result.set_result(transport)
+
+        def on_done(fut):
+            if fut.cancelled():
+                transport.close()
+
+        waiter.add_done_callback(on_connected)
+        result.add_done_callback(on_done)
+        return result
+
+    def _start_serving(self, protocol_factory, sock, sslcontext=None, server=None, backlog=100, *args, **kwargs):
+        # TLS servers accept through the selector, connections still get native transports
+        if not sslcontext and _is_stream_socket(sock, _STREAM_FAMILIES) and sock.fileno() not in self._listeners:
+            handle = pyuv.TCP(self._uv_loop) if sock.family in _IP_FAMILIES else pyuv.Pipe(self._uv_loop)
+            if _open_handle(handle, sock.fileno()):
+                handle.listen(functools.partial(self._on_connection, protocol_factory, sock, server), backlog)
+                self._listeners[sock.fileno()] = handle
+                return
+        super(EventLoop, self)._start_serving(protocol_factory, sock, sslcontext, server, backlog, *args, **kwargs)
+
+    def _on_connection(self, protocol_factory, sock, server, handle, error):
+        if error is not None:
+            self.call_exception_handler({
+                'message': 'Error accepting a connection',
+                'exception': _os_error(error),
+                'socket': sock,
+            })
+            return
+
+        client = type(handle)(self._uv_loop)
+        try:
+            handle.accept(client)
+        except pyuv.error.StreamError as e:
+            client.close()
+            if e.args[0] not in (pyuv.errno.UV_EAGAIN, pyuv.errno.UV_ECONNABORTED):
+                self.call_exception_handler({
+                    'message': 'Error accepting a connection',
+                    'exception': _os_error(e.args[0]),
+                    'socket': sock,
+                })
+            return
+        if sock.family in _IP_FAMILIES:
+            client.nodelay(True)
+
+        try:
+            protocol = protocol_factory()
+            _StreamTransport(self, client, protocol, server=server, family=sock.family)
+        except (SystemExit, KeyboardInterrupt):
+            raise
+        except BaseException as exc:
+            client.close()
+            if self._debug:
+                self.call_exception_handler({
+                    'message': 'Error on transport creation for incoming connection',
+                    'exception': exc,
+                })
+
+    def _stop_serving(self, sock):
+        handle = self._listeners.pop(sock.fileno(), None)
+        if handle is not None:
+            handle.close()
+        super(EventLoop, self)._stop_serving(sock)
+
+
+class EventLoopPolicy(asyncio.DefaultEventLoopPolicy):
+    """Event loop policy which creates pyuv backed event loops.
+
+    Install it with ``asyncio.set_event_loop_policy(pyuv.asyncio.EventLoopPolicy())``.
+    """
+
+    _loop_factory = EventLoop
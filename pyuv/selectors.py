@@ -0,0 +1,212 @@
+
+"""Implementation of the standard library selectors API on top of a pyuv Loop.
+
+All the registered file objects are monitored by a single PollGroup handle, so readiness is
+collected in C and only one Python callback runs per loop iteration, regardless of the number
+of ready file objects.
+"""
+
+from __future__ import absolute_import
+
+from collections import namedtuple
+
+try:
+    from collections.abc import Mapping
+except ImportError:
+    from collections import Mapping
+
+try:
+    from selectors import BaseSelector, SelectorKey, EVENT_READ, EVENT_WRITE
+except ImportError:
+    # Python 2 doesn't have the selectors module, provide the bits the implementation needs
+    BaseSelector = object
+    SelectorKey = namedtuple('SelectorKey', ['fileobj', 'fd', 'events', 'data'])
+    EVENT_READ = (1 << 0)
+    EVENT_WRITE = (1 << 1)
+
+import pyuv
+
+
+__all__ = ['UVSelector', 'EVENT_READ', 'EVENT_WRITE']
+
+# select(None) arms the timer with this timeout, so that the loop stays alive and blocks for I/O
+# even when nothing is registered
+_MAX_TIMEOUT = 3600.0
+
+
+def _fileobj_to_fd(fileobj):
+    if isinstance(fileobj, int):
+        fd = fileobj
+    else:
+        try:
+            fd = int(fileobj.fileno())
+        except (AttributeError, TypeError, ValueError):
+            raise ValueError("Invalid file object: {!r}".format(fileobj))
+    if fd < 0:
+        raise ValueError("Invalid file descriptor: {}".format(fd))
+    return fd
+
+
+def _to_uv_events(events):
+    uv_events = 0
+    if events & EVENT_READ:
+        uv_events |= pyuv.UV_READABLE
+    if events & EVENT_WRITE:
+        uv_events |= pyuv.UV_WRITABLE
+    return uv_events
+
+
+def _from_uv_events(uv_events):
+    events = 0
+    if uv_events & (pyuv.UV_READABLE | pyuv.UV_DISCONNECT):
+        events |= EVENT_READ
+    if uv_events & pyuv.UV_WRITABLE:
+        events |= EVENT_WRITE
+    return events
+
+
+class _SelectorMapping(Mapping):
+    """Mapping of file objects to selector keys."""
+
+    def __init__(self, selector):
+        self._selector = selector
+
+    def __len__(self):
+        return len(self._selector._fd_to_key)
+
+    def __getitem__(self, fileobj):
+        try:
+            fd = self._selector._fileobj_lookup(fileobj)
+            return self._selector._fd_to_key[fd]
+        except KeyError:
+            raise KeyError("{!r} is not registered".format(fileobj))
+
+    def __iter__(self):
+        return iter(self._selector._fd_to_key)
+
+
+class UVSelector(BaseSelector):
+    """Selector which runs a pyuv Loop iteration in order to wait for events.
+
+    If a loop is given, other handles running on it are processed while waiting in select().
+    """
+
+    def __init__(self, loop=None):
+        self._own_loop = loop is None
+        self._loop = pyuv.Loop() if loop is None else loop
+        self._fd_to_key = {}
+        self._map = _SelectorMapping(self)
+        self._ready = ready = []
+        self._group = pyuv.PollGroup(self._loop)
+        # the callback doesn't reference the selector, so that it can be garbage collected
+        self._group.start(lambda group, events: ready.extend(events))
+        self._timer = pyuv.Timer(self._loop)
+
+    @property
+    def loop(self):
+        return self._loop
+
+    def _fileobj_lookup(self, fileobj):
+        try:
+            return _fileobj_to_fd(fileobj)
+        except ValueError:
+            # Do an exhaustive search, the file object could have been closed already
+            for key in self._fd_to_key.values():
+                if key.fileobj is fileobj:
+                    return key.fd
+            raise
+
+    def register(self, fileobj, events, data=None):
+        if (not events) or (events & ~(EVENT_READ | EVENT_WRITE)):
+            raise ValueError("Invalid events: {!r}".format(events))
+
+        key = SelectorKey(fileobj, self._fileobj_lookup(fileobj), events, data)
+        if key.fd in self._fd_to_key:
+            raise KeyError("{!r} (FD {}) is already registered".format(fileobj, key.fd))
+
+        self._group.add(key.fd, _to_uv_events(events), key.fd)
+        self._fd_to_key[key.fd] = key
+        return key
+
+    def unregister(self, fileobj):
+        try:
+            key = self._fd_to_key.pop(self._fileobj_lookup(fileobj))
+        except KeyError:
+            raise KeyError("{!r} is not registered".format(fileobj))
+        self._group.remove(key.fd)
+        return key
+
+    def modify(self, fileobj, events, data=None):
+        if (not events) or (events & ~(EVENT_READ | EVENT_WRITE)):
+            raise ValueError("Invalid events: {!r}".format(events))
+        try:
+            key = self._fd_to_key[self._fileobj_lookup(fileobj)]
+        except KeyError:
+            raise KeyError("{!r} is not registered".format(fileobj))
+
+        if events != key.events:
+            self._group.modify(key.fd, _to_uv_events(events))
+            key = key._replace(events=events, data=data)
+            self._fd_to_key[key.fd] = key
+        elif data != key.data:
+            key = key._replace(data=data)
+            self._fd_to_key[key.fd] = key
+        return key
+
+    def select(self, timeout=None):
+        if timeout is not None and timeout <= 0:
+            self._loop.run(pyuv.UV_RUN_NOWAIT)
+        else:
+            if timeout is None:
+                timeout = _MAX_TIMEOUT
+            # the callback does nothing, the expired timer makes run() return. Timers have
+            # millisecond resolution, shorter timeouts are rounded up. The timer is armed against
+            # the current time, not the cached loop time, and it repeats, since if it expires
+            # before polling for I/O the poll would otherwise block
+            timeout = max(timeout, 0.001)
+            self._loop.update_time()
+            self._timer.start(lambda timer: None, timeout, timeout)
+            try:
+                self._loop.run(pyuv.UV_RUN_ONCE)
+            finally:
+                self._timer.stop()
+
+        ready = []
+        fd_to_key = self._fd_to_key
+        for fd, uv_events in self._ready:
+            key = fd_to_key.get(fd)
+            if key is not None:
+                events = _from_uv_events(uv_events) & key.events
+                if events:
+                    ready.append((key, events))
+        del self._ready[:]
+        return ready
+
+    def close(self):
+        if self._group is None:
+            return
+        self._group.close()
+        self._timer.close()
+        if self._own_loop:
+            self._loop.run()
+        self._group = self._timer = None
+        self._fd_to_key.clear()
+        self._map = None
+
+    def get_key(self, fileobj):
+        mapping = self.get_map()
+        if mapping is None:
+            raise RuntimeError("Selector is closed")
+        try:
+            return mapping[fileobj]
+        except KeyError:
+            raise KeyError("{!r} is not registered".format(fileobj))
+
+    def get_map(self):
+        return self._map
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
@@ -161,3 +161,264 @@ static PyTypeObject AsyncType = {
     Async_tp_new,                                                   /*tp_new*/
 };
 
+
+
+/* AsyncQueue: Async handle which carries data. Items are appended to a list while holding the GIL
+ * (so no additional lock is needed) and the handle is only signalled when the list goes from empty
+ * to non-empty, the callback then gets all the pending items at once.
+ */
+
+static void
+pyuv__async_queue_cb(uv_async_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    AsyncQueue *self;
+    PyObject *items, *result;
+    Py_ssize_t count;
+
+    ASSERT(handle);
+    self = PYUV_CONTAINER_OF(handle, AsyncQueue, async_h);
+
+    count = PyList_GET_SIZE(self->items) - self->head;
+    if (count == 0) {
+        goto end;
+    }
+
+    /* Object could go out of scope in the callback, increase refcount to avoid it */
+    Py_INCREF(self);
+
+    if (self->batch_max > 0 && count > self->batch_max) {
+        /* deliver the rest on the next loop iteration, so other handles get a chance to run. The
+         * delivered items are only removed once they make up half of the list, so that draining a
+         * long queue in batches stays linear.
+         */
+        items = PyList_GetSlice(self->items, self->head, self->head + self->batch_max);
+        if (items) {
+            self->head += self->batch_max;
+            if (self->head * 2 >= PyList_GET_SIZE(self->items)) {
+                if (PyList_SetSlice(self->items, 0, self->head, NULL) == 0) {
+                    self->head = 0;
+                } else {
+                    handle_uncaught_exception(HANDLE(self)->loop);
+                }
+            }
+        }
+        uv_async_send(handle);
+    } else {
+        items = PyList_New(0);
+        if (items) {
+            result = self->items;
+            self->items = items;
+            items = result;
+            /* the ones delivered in earlier batches are dropped from it */
+            if (self->head > 0 && PyList_SetSlice(items, 0, self->head, NULL) != 0) {
+                Py_CLEAR(items);
+            }
+            self->head = 0;
+        }
+    }
+
+    if (items) {
+        result = PyObject_CallFunctionObjArgs(self->callback, self, items, NULL);
+        if (result == NULL) {
+            handle_uncaught_exception(HANDLE(self)->loop);
+        }
+        Py_XDECREF(result);
+        Py_DECREF(items);
+    } else {
+        handle_uncaught_exception(HANDLE(self)->loop);
+    }
+
+    Py_DECREF(self);
+
+end:
+    PyGILState_Release(gstate);
+}
+
+
+static PyObject *
+AsyncQueue_func_put(AsyncQueue *self, PyObject *item)
+{
+    int err;
+    Bool was_empty;
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    was_empty = PyList_GET_SIZE(self->items) == 0;
+
+    if (PyList_Append(self->items, item) != 0) {
+        return NULL;
+    }
+
+    /* if there were items already a wakeup is on its way */
+    if (was_empty) {
+        err = uv_async_send(&self->async_h);
+        if (err < 0) {
+            RAISE_UV_EXCEPTION(err, PyExc_AsyncError);
+            return NULL;
+        }
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static Py_ssize_t
+AsyncQueue_tp_len(AsyncQueue *self)
+{
+    return PyList_GET_SIZE(self->items) - self->head;
+}
+
+
+static int
+AsyncQueue_tp_init(AsyncQueue *self, PyObject *args, PyObject *kwargs)
+{
+    int err;
+    Py_ssize_t batch_max;
+    Loop *loop;
+    PyObject *callback;
+
+    static char *kwlist[] = {"loop", "callback", "batch_max", NULL};
+
+    RAISE_IF_HANDLE_INITIALIZED(self, -1);
+
+    batch_max = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!O|n:__init__", kwlist, &LoopType, &loop, &callback, &batch_max)) {
+        return -1;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return -1;
+    }
+
+    if (batch_max < 0) {
+        PyErr_SetString(PyExc_ValueError, "a positive value or zero is required");
+        return -1;
+    }
+
+    err = uv_async_init(loop->uv_loop, &self->async_h, pyuv__async_queue_cb);
+    if (err != 0) {
+        RAISE_UV_EXCEPTION(err, PyExc_AsyncError);
+        return -1;
+    }
+
+    Py_INCREF(callback);
+    self->callback = callback;
+    self->batch_max = batch_max;
+
+    initialize_handle(HANDLE(self), loop);
+
+    return 0;
+}
+
+
+static PyObject *
+AsyncQueue_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    AsyncQueue *self;
+
+    self = (AsyncQueue *)HandleType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+
+    self->items = PyList_New(0);
+    if (!self->items) {
+        Py_DECREF(self);
+        return NULL;
+    }
+
+    self->async_h.data = self;
+    UV_HANDLE(self) = (uv_handle_t *)&self->async_h;
+
+    return (PyObject *)self;
+}
+
+
+static int
+AsyncQueue_tp_traverse(AsyncQueue *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->callback);
+    Py_VISIT(self->items);
+    return HandleType.tp_traverse((PyObject *)self, visit, arg);
+}
+
+
+static int
+AsyncQueue_tp_clear(AsyncQueue *self)
+{
+    Py_CLEAR(self->callback);
+    Py_CLEAR(self->items);
+    self->head = 0;
+    return HandleType.tp_clear((PyObject *)self);
+}
+
+
+static PySequenceMethods AsyncQueue_tp_as_sequence = {
+    (lenfunc)AsyncQueue_tp_len,                                     /*sq_length*/
+    0,                                                              /*sq_concat*/
+    0,                                                              /*sq_repeat*/
+    0,                                                              /*sq_item*/
+    0,                                                              /*sq_slice*/
+    0,                                                              /*sq_ass_item*/
+    0,                                                              /*sq_ass_slice*/
+    0,                                                              /*sq_contains*/
+};
+
+
+static PyMethodDef
+AsyncQueue_tp_methods[] = {
+    { "put", (PyCFunction)AsyncQueue_func_put, METH_O, "Queue an item, to be delivered in the loop thread." },
+    { NULL }
+};
+
+
+static PyMemberDef AsyncQueue_tp_members[] = {
+    {"batch_max", T_PYSSIZET, offsetof(AsyncQueue, batch_max), 0, "Maximum number of items delivered in a single callback, 0 means no limit."},
+    {NULL}
+};
+
+
+static PyTypeObject AsyncQueueType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.AsyncQueue",                                       /*tp_name*/
+    sizeof(AsyncQueue),                                             /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    0,                                                              /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    &AsyncQueue_tp_as_sequence,                                     /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)AsyncQueue_tp_traverse,                           /*tp_traverse*/
+    (inquiry)AsyncQueue_tp_clear,                                   /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    AsyncQueue_tp_methods,                                          /*tp_methods*/
+    AsyncQueue_tp_members,                                          /*tp_members*/
+    0,                                                              /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)AsyncQueue_tp_init,                                   /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    AsyncQueue_tp_new,                                              /*tp_new*/
+};
@@ -0,0 +1,1300 @@
+/*
+ * asyncio event loop core
+ *
+ * pyuv.asyncio.EventLoop inherits from EventLoop and from asyncio's selector event loop: the
+ * ready queue, the scheduled timers and the loop iteration are implemented here, transports,
+ * servers and subprocesses are implemented in Python on top of pyuv handles. Callbacks are kept
+ * in a ring buffer and timers in a binary heap ordered by deadline and scheduling order, so that
+ * timers with the same deadline run in the order they were scheduled. Cancelled timers are
+ * removed from the heap right away. Each iteration polls the pyuv loop once: the timer handle
+ * sets the poll timeout to the earliest deadline and the async handle wakes the poll up when
+ * callbacks are added from other threads. Both are only referenced while the iteration runs, so
+ * they don't keep the pyuv loop alive otherwise.
+ */
+
+#ifdef PYUV_PYTHON3
+
+static INLINE double
+pyuv__asyncio_time(void)
+{
+    return (double)uv_hrtime() / 1e9;
+}
+
+
+static void
+pyuv__asyncio_noop_cb(uv_handle_t *handle)
+{
+    UNUSED_ARG(handle);
+}
+
+
+static void
+pyuv__asyncio_watchers_close_cb(uv_handle_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    asyncio_loop_watchers *watchers;
+
+    if (handle->type == UV_TIMER) {
+        watchers = PYUV_CONTAINER_OF(handle, asyncio_loop_watchers, timer_h);
+    } else {
+        watchers = PYUV_CONTAINER_OF(handle, asyncio_loop_watchers, async_h);
+    }
+
+    if (--watchers->pending_closes == 0) {
+        PyMem_Free(watchers);
+    }
+
+    PyGILState_Release(gstate);
+}
+
+
+/* Ready queue */
+
+static int
+pyuv__asyncio_ready_push(AsyncioLoop *self, PyObject *item)
+{
+    PyObject **items;
+    Py_ssize_t i, capacity;
+
+    if (self->ready.count == self->ready.capacity) {
+        capacity = self->ready.capacity > 0 ? self->ready.capacity * 2 : 64;
+        items = PyMem_Malloc(capacity * sizeof *items);
+        if (!items) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        for (i = 0; i < self->ready.count; i++) {
+            items[i] = self->ready.items[(self->ready.head + i) % self->ready.capacity];
+        }
+        PyMem_Free(self->ready.items);
+        self->ready.items = items;
+        self->ready.capacity = capacity;
+        self->ready.head = 0;
+    }
+
+    Py_INCREF(item);
+    self->ready.items[(self->ready.head + self->ready.count) % self->ready.capacity] = item;
+    self->ready.count++;
+    return 0;
+}
+
+
+/* Returns a new reference */
+static PyObject *
+pyuv__asyncio_ready_pop(AsyncioLoop *self)
+{
+    PyObject *item;
+
+    ASSERT(self->ready.count > 0);
+
+    item = self->ready.items[self->ready.head];
+    self->ready.head = (self->ready.head + 1) % self->ready.capacity;
+    self->ready.count--;
+    return item;
+}
+
+
+/* Scheduled timers */
+
+static INLINE Bool
+pyuv__asyncio_timer_less(AsyncioHandle *a, AsyncioHandle *b)
+{
+    return a->when < b->when || (a->when == b->when && a->seq < b->seq);
+}
+
+
+static INLINE void
+pyuv__asyncio_heap_set(AsyncioLoop *self, Py_ssize_t i, AsyncioHandle *handle)
+{
+    self->scheduled.items[i] = handle;
+    handle->heap_index = i;
+}
+
+
+static void
+pyuv__asyncio_heap_sift_up(AsyncioLoop *self, Py_ssize_t i)
+{
+    AsyncioHandle *handle, *parent;
+
+    handle = self->scheduled.items[i];
+    while (i > 0) {
+        parent = self->scheduled.items[(i - 1) / 2];
+        if (!pyuv__asyncio_timer_less(handle, parent)) {
+            break;
+        }
+        pyuv__asyncio_heap_set(self, i, parent);
+        i = (i - 1) / 2;
+    }
+    pyuv__asyncio_heap_set(self, i, handle);
+}
+
+
+static void
+pyuv__asyncio_heap_sift_down(AsyncioLoop *self, Py_ssize_t i)
+{
+    AsyncioHandle *handle, *child;
+    Py_ssize_t c;
+
+    handle = self->scheduled.items[i];
+    for (;;) {
+        c = 2 * i + 1;
+        if (c >= self->scheduled.count) {
+            break;
+        }
+        if (c + 1 < self->scheduled.count && pyuv__asyncio_timer_less(self->scheduled.items[c + 1], self->scheduled.items[c])) {
+            c++;
+        }
+        child = self->scheduled.items[c];
+        if (!pyuv__asyncio_timer_less(child, handle)) {
+            break;
+        }
+        pyuv__asyncio_heap_set(self, i, child);
+        i = c;
+    }
+    pyuv__asyncio_heap_set(self, i, handle);
+}
+
+
+static int
+pyuv__asyncio_heap_push(AsyncioLoop *self, AsyncioHandle *handle)
+{
+    AsyncioHandle **items;
+    Py_ssize_t capacity;
+
+    if (self->scheduled.count == self->scheduled.capacity) {
+        capacity = self->scheduled.capacity > 0 ? self->scheduled.capacity * 2 : 64;
+        items = PyMem_Realloc(self->scheduled.items, capacity * sizeof *items);
+        if (!items) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->scheduled.items = items;
+        self->scheduled.capacity = capacity;
+    }
+
+    Py_INCREF(handle);
+    handle->seq = self->scheduled.seq++;
+    pyuv__asyncio_heap_set(self, self->scheduled.count++, handle);
+    pyuv__asyncio_heap_sift_up(self, handle->heap_index);
+    return 0;
+}
+
+
+/* Returns the reference held by the heap */
+static AsyncioHandle *
+pyuv__asyncio_heap_remove(AsyncioLoop *self, Py_ssize_t i)
+{
+    AsyncioHandle *handle, *last;
+
+    ASSERT(i >= 0 && i < self->scheduled.count);
+
+    handle = self->scheduled.items[i];
+    last = self->scheduled.items[--self->scheduled.count];
+    if (i < self->scheduled.count) {
+        pyuv__asyncio_heap_set(self, i, last);
+        pyuv__asyncio_heap_sift_down(self, i);
+        pyuv__asyncio_heap_sift_up(self, last->heap_index);
+    }
+    handle->heap_index = -1;
+    return handle;
+}
+
+
+/* Drop the queued callbacks and timers and close the libuv handles, once the event loop is closed */
+static void
+pyuv__asyncio_loop_release(AsyncioLoop *self)
+{
+    PyObject *item;
+
+    while (self->ready.count > 0) {
+        item = pyuv__asyncio_ready_pop(self);
+        Py_DECREF(item);
+    }
+    while (self->scheduled.count > 0) {
+        item = (PyObject *)pyuv__asyncio_heap_remove(self, self->scheduled.count - 1);
+        Py_DECREF(item);
+    }
+
+    if (self->watchers != NULL) {
+        uv_close((uv_handle_t *)&self->watchers->timer_h, pyuv__asyncio_watchers_close_cb);
+        uv_close((uv_handle_t *)&self->watchers->async_h, pyuv__asyncio_watchers_close_cb);
+        self->watchers = NULL;
+    }
+}
+
+
+/* Handle and TimerHandle */
+
+static AsyncioHandle *
+pyuv__asyncio_handle_new(PyTypeObject *type, AsyncioLoop *loop, PyObject *callback, PyObject *args, PyObject *context)
+{
+    AsyncioHandle *self;
+
+    self = PyObject_GC_New(AsyncioHandle, type);
+    if (!self) {
+        return NULL;
+    }
+
+#if PY_VERSION_HEX >= 0x03070000
+    if (context == NULL || context == Py_None) {
+        context = PyContext_CopyCurrent();
+        if (context == NULL) {
+            PyObject_GC_Del(self);
+            return NULL;
+        }
+    } else {
+        Py_INCREF(context);
+    }
+#else
+    UNUSED_ARG(context);
+    context = NULL;
+#endif
+
+    Py_INCREF(callback);
+    Py_INCREF(args);
+    Py_INCREF(loop);
+    self->weakreflist = NULL;
+    self->callback = callback;
+    self->args = args;
+    self->context = context;
+    self->loop = loop;
+    self->cancelled = False;
+    self->when = 0.0;
+    self->heap_index = -1;
+    self->seq = 0;
+
+    PyObject_GC_Track(self);
+    return self;
+}
+
+
+/* Report the exception raised by the callback to the loop's exception handler. Returns -1 if
+ * it must be propagated instead, as is the case for SystemExit and KeyboardInterrupt. */
+static int
+pyuv__asyncio_handle_error(AsyncioHandle *self, PyObject *callback, PyObject *args)
+{
+    PyObject *exc, *value, *tb, *message, *context, *result;
+
+    if (PyErr_ExceptionMatches(PyExc_SystemExit) || PyErr_ExceptionMatches(PyExc_KeyboardInterrupt)) {
+        return -1;
+    }
+
+    PyErr_Fetch(&exc, &value, &tb);
+    PyErr_NormalizeException(&exc, &value, &tb);
+    if (tb != NULL) {
+        PyException_SetTraceback(value, tb);
+    }
+
+    message = PyUnicode_FromFormat("Exception in callback %R%R", callback, args);
+    if (message == NULL) {
+        context = NULL;
+    } else {
+        context = Py_BuildValue("{sNsOsO}", "message", message, "exception", value, "handle", (PyObject *)self);
+    }
+    Py_XDECREF(exc);
+    Py_XDECREF(value);
+    Py_XDECREF(tb);
+    if (context == NULL) {
+        return -1;
+    }
+
+    result = PyObject_CallMethod((PyObject *)self->loop, "call_exception_handler", "O", context);
+    Py_DECREF(context);
+    if (result == NULL) {
+        return -1;
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
+
+static int
+pyuv__asyncio_handle_run(AsyncioHandle *self)
+{
+    PyObject *callback, *args, *result;
+    int r;
+
+    /* cancelling the handle from the callback drops them */
+    callback = self->callback;
+    args = self->args;
+    Py_INCREF(callback);
+    Py_INCREF(args);
+
+#if PY_VERSION_HEX >= 0x03070000
+    if (PyContext_Enter(self->context) < 0) {
+        result = NULL;
+    } else {
+        PyObject *exc, *value, *tb;
+        result = PyObject_Call(callback, args, NULL);
+        PyErr_Fetch(&exc, &value, &tb);
+        if (PyContext_Exit(self->context) < 0) {
+            Py_XDECREF(exc);
+            Py_XDECREF(value);
+            Py_XDECREF(tb);
+            Py_CLEAR(result);
+        } else {
+            PyErr_Restore(exc, value, tb);
+        }
+    }
+#else
+    result = PyObject_Call(callback, args, NULL);
+#endif
+
+    if (result != NULL) {
+        Py_DECREF(result);
+        r = 0;
+    } else {
+        r = pyuv__asyncio_handle_error(self, callback, args);
+    }
+
+    Py_DECREF(callback);
+    Py_DECREF(args);
+    return r;
+}
+
+
+static PyObject *
+AsyncioHandle_func_cancel(AsyncioHandle *self)
+{
+    AsyncioHandle *handle;
+    PyObject *args, *tmp;
+
+    if (self->cancelled) {
+        Py_RETURN_NONE;
+    }
+    self->cancelled = True;
+
+    if (self->heap_index >= 0) {
+        handle = pyuv__asyncio_heap_remove(self->loop, self->heap_index);
+        ASSERT(handle == self);
+        Py_DECREF(handle);
+    }
+
+    /* release whatever the callback references */
+    args = PyTuple_New(0);
+    if (args == NULL) {
+        return NULL;
+    }
+    tmp = self->args;
+    self->args = args;
+    Py_DECREF(tmp);
+    tmp = self->callback;
+    Py_INCREF(Py_None);
+    self->callback = Py_None;
+    Py_DECREF(tmp);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+AsyncioHandle_func_cancelled(AsyncioHandle *self)
+{
+    return PyBool_FromLong((long)self->cancelled);
+}
+
+
+static PyObject *
+AsyncioHandle_func_when(AsyncioHandle *self)
+{
+    return PyFloat_FromDouble(self->when);
+}
+
+
+static PyObject *
+AsyncioHandle_func_run(AsyncioHandle *self)
+{
+    if (pyuv__asyncio_handle_run(self) < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+
+#if PY_VERSION_HEX >= 0x03070000
+static PyObject *
+AsyncioHandle_func_get_context(AsyncioHandle *self)
+{
+    Py_INCREF(self->context);
+    return self->context;
+}
+#endif
+
+
+static PyObject *
+AsyncioHandle_cancelled_get(AsyncioHandle *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyBool_FromLong((long)self->cancelled);
+}
+
+
+static PyObject *
+AsyncioHandle_tp_repr(AsyncioHandle *self)
+{
+    PyObject *when, *result;
+    const char *name;
+
+    name = strrchr(Py_TYPE(self)->tp_name, '.') + 1;
+    if (self->cancelled) {
+        return PyUnicode_FromFormat("<%s cancelled>", name);
+    }
+    if (!PyObject_TypeCheck(self, &AsyncioTimerHandleType)) {
+        return PyUnicode_FromFormat("<%s %R%R>", name, self->callback, self->args);
+    }
+    when = PyFloat_FromDouble(self->when);
+    if (when == NULL) {
+        return NULL;
+    }
+    result = PyUnicode_FromFormat("<%s when=%R %R%R>", name, when, self->callback, self->args);
+    Py_DECREF(when);
+    return result;
+}
+
+
+static int
+AsyncioHandle_tp_traverse(AsyncioHandle *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->callback);
+    Py_VISIT(self->args);
+    Py_VISIT(self->context);
+    Py_VISIT(self->loop);
+    return 0;
+}
+
+
+static int
+AsyncioHandle_tp_clear(AsyncioHandle *self)
+{
+    Py_CLEAR(self->callback);
+    Py_CLEAR(self->args);
+    Py_CLEAR(self->context);
+    Py_CLEAR(self->loop);
+    return 0;
+}
+
+
+static void
+AsyncioHandle_tp_dealloc(AsyncioHandle *self)
+{
+    PyObject_GC_UnTrack(self);
+    if (self->weakreflist != NULL) {
+        PyObject_ClearWeakRefs((PyObject *)self);
+    }
+    AsyncioHandle_tp_clear(self);
+    PyObject_GC_Del(self);
+}
+
+
+static PyMethodDef
+AsyncioHandle_tp_methods[] = {
+    { "cancel", (PyCFunction)AsyncioHandle_func_cancel, METH_NOARGS, "Cancel the callback. If the callback has already been canceled or executed, this method has no effect." },
+    { "cancelled", (PyCFunction)AsyncioHandle_func_cancelled, METH_NOARGS, "Return True if the callback was cancelled." },
+#if PY_VERSION_HEX >= 0x03070000
+    { "get_context", (PyCFunction)AsyncioHandle_func_get_context, METH_NOARGS, "Return the contextvars.Context the callback runs in." },
+#endif
+    { "_run", (PyCFunction)AsyncioHandle_func_run, METH_NOARGS, "Run the callback." },
+    { NULL }
+};
+
+
+static PyMethodDef
+AsyncioTimerHandle_tp_methods[] = {
+    { "when", (PyCFunction)AsyncioHandle_func_when, METH_NOARGS, "Return the scheduled time of the callback, in loop time." },
+    { NULL }
+};
+
+
+static PyMemberDef AsyncioHandle_tp_members[] = {
+    {"_callback", T_OBJECT, offsetof(AsyncioHandle, callback), READONLY, "Callback to run."},
+    {"_args", T_OBJECT, offsetof(AsyncioHandle, args), READONLY, "Arguments the callback is called with."},
+    {"_loop", T_OBJECT, offsetof(AsyncioHandle, loop), READONLY, "Event loop the callback runs in."},
+    {NULL}
+};
+
+
+static PyMemberDef AsyncioTimerHandle_tp_members[] = {
+    {"_when", T_DOUBLE, offsetof(AsyncioHandle, when), READONLY, "Scheduled time of the callback."},
+    {NULL}
+};
+
+
+static PyGetSetDef AsyncioHandle_tp_getsets[] = {
+    {"_cancelled", (getter)AsyncioHandle_cancelled_get, NULL, "True if the callback was cancelled.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject AsyncioHandleType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv._asyncio.Handle",                                  /*tp_name*/
+    sizeof(AsyncioHandle),                                          /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)AsyncioHandle_tp_dealloc,                           /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    (reprfunc)AsyncioHandle_tp_repr,                                /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)AsyncioHandle_tp_traverse,                        /*tp_traverse*/
+    (inquiry)AsyncioHandle_tp_clear,                                /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    offsetof(AsyncioHandle, weakreflist),                           /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    AsyncioHandle_tp_methods,                                       /*tp_methods*/
+    AsyncioHandle_tp_members,                                       /*tp_members*/
+    AsyncioHandle_tp_getsets,                                       /*tp_getsets*/
+};
+
+
+static PyTypeObject AsyncioTimerHandleType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv._asyncio.TimerHandle",                             /*tp_name*/
+    sizeof(AsyncioHandle),                                          /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)AsyncioHandle_tp_dealloc,                           /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    (reprfunc)AsyncioHandle_tp_repr,                                /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)AsyncioHandle_tp_traverse,                        /*tp_traverse*/
+    (inquiry)AsyncioHandle_tp_clear,                                /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    offsetof(AsyncioHandle, weakreflist),                           /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    AsyncioTimerHandle_tp_methods,                                  /*tp_methods*/
+    AsyncioTimerHandle_tp_members,                                  /*tp_members*/
+    0,                                                              /*tp_getsets*/
+};
+
+
+/* EventLoop */
+
+/* Parse (callback, *args) starting at the given position, and the context keyword argument */
+static int
+pyuv__asyncio_parse_callback(const char *name, PyObject *args, Py_ssize_t start, PyObject *kwargs, PyObject **callback, PyObject **cb_args, PyObject **context)
+{
+    Py_ssize_t nkwargs;
+
+    if (PyTuple_GET_SIZE(args) <= start) {
+        PyErr_Format(PyExc_TypeError, "%s() missing the callback argument", name);
+        return -1;
+    }
+
+    *context = NULL;
+    nkwargs = kwargs != NULL ? PyDict_Size(kwargs) : 0;
+    if (nkwargs > 0) {
+#if PY_VERSION_HEX >= 0x03070000
+        *context = PyDict_GetItemString(kwargs, "context");
+        if (nkwargs > (*context != NULL ? 1 : 0)) {
+            PyErr_Format(PyExc_TypeError, "%s() only accepts the 'context' keyword argument", name);
+            return -1;
+        }
+        if (*context != Py_None && !PyContext_CheckExact(*context)) {
+            PyErr_SetString(PyExc_TypeError, "context must be a contextvars.Context object");
+            return -1;
+        }
+#else
+        PyErr_Format(PyExc_TypeError, "%s() takes no keyword arguments", name);
+        return -1;
+#endif
+    }
+
+    *callback = PyTuple_GET_ITEM(args, start);
+    *cb_args = PyTuple_GetSlice(args, start + 1, PyTuple_GET_SIZE(args));
+    if (*cb_args == NULL) {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+pyuv__asyncio_loop_check(AsyncioLoop *self, PyObject *callback, const char *method, Bool threadsafe)
+{
+    PyObject *result;
+
+    RAISE_IF_NOT_INITIALIZED(self, -1);
+
+    if (self->closed) {
+        PyErr_SetString(PyExc_RuntimeError, "Event loop is closed");
+        return -1;
+    }
+
+    /* the expensive checks are only done in debug mode, as asyncio does */
+    if (self->debug) {
+        if (!threadsafe) {
+            result = PyObject_CallMethod((PyObject *)self, "_check_thread", NULL);
+            if (result == NULL) {
+                return -1;
+            }
+            Py_DECREF(result);
+        }
+        result = PyObject_CallMethod((PyObject *)self, "_check_callback", "Os", callback, method);
+        if (result == NULL) {
+            return -1;
+        }
+        Py_DECREF(result);
+    }
+
+    return 0;
+}
+
+
+static PyObject *
+pyuv__asyncio_loop_call_soon(AsyncioLoop *self, PyObject *args, PyObject *kwargs, const char *name, Bool threadsafe)
+{
+    AsyncioHandle *handle;
+    PyObject *callback, *cb_args, *context;
+    int err;
+
+    if (pyuv__asyncio_parse_callback(name, args, 0, kwargs, &callback, &cb_args, &context) < 0) {
+        return NULL;
+    }
+
+    if (pyuv__asyncio_loop_check(self, callback, name, threadsafe) < 0) {
+        Py_DECREF(cb_args);
+        return NULL;
+    }
+
+    handle = pyuv__asyncio_handle_new(&AsyncioHandleType, self, callback, cb_args, context);
+    Py_DECREF(cb_args);
+    if (handle == NULL) {
+        return NULL;
+    }
+
+    if (pyuv__asyncio_ready_push(self, (PyObject *)handle) < 0) {
+        Py_DECREF(handle);
+        return NULL;
+    }
+
+    if (threadsafe) {
+        err = uv_async_send(&self->watchers->async_h);
+        if (err < 0) {
+            Py_DECREF(handle);
+            RAISE_UV_EXCEPTION(err, PyExc_AsyncError);
+            return NULL;
+        }
+    }
+
+    return (PyObject *)handle;
+}
+
+
+static PyObject *
+pyuv__asyncio_loop_call_at(AsyncioLoop *self, double when, PyObject *args, PyObject *kwargs, const char *name)
+{
+    AsyncioHandle *handle;
+    PyObject *callback, *cb_args, *context;
+
+    if (pyuv__asyncio_parse_callback(name, args, 1, kwargs, &callback, &cb_args, &context) < 0) {
+        return NULL;
+    }
+
+    if (pyuv__asyncio_loop_check(self, callback, "call_at", False) < 0) {
+        Py_DECREF(cb_args);
+        return NULL;
+    }
+
+    handle = pyuv__asyncio_handle_new(&AsyncioTimerHandleType, self, callback, cb_args, context);
+    Py_DECREF(cb_args);
+    if (handle == NULL) {
+        return NULL;
+    }
+    handle->when = when;
+
+    if (pyuv__asyncio_heap_push(self, handle) < 0) {
+        Py_DECREF(handle);
+        return NULL;
+    }
+
+    return (PyObject *)handle;
+}
+
+
+static int
+pyuv__asyncio_parse_time(PyObject *args, const char *name, double *value)
+{
+    PyObject *obj;
+
+    if (PyTuple_GET_SIZE(args) < 1 || PyTuple_GET_ITEM(args, 0) == Py_None) {
+        PyErr_Format(PyExc_TypeError, "%s must not be None", name);
+        return -1;
+    }
+
+    obj = PyTuple_GET_ITEM(args, 0);
+    *value = PyFloat_AsDouble(obj);
+    if (*value == -1.0 && PyErr_Occurred()) {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static PyObject *
+AsyncioLoop_func_time(AsyncioLoop *self)
+{
+    return PyFloat_FromDouble(pyuv__asyncio_time());
+}
+
+
+static PyObject *
+AsyncioLoop_func_call_soon(AsyncioLoop *self, PyObject *args, PyObject *kwargs)
+{
+    return pyuv__asyncio_loop_call_soon(self, args, kwargs, "call_soon", False);
+}
+
+
+static PyObject *
+AsyncioLoop_func_call_soon_threadsafe(AsyncioLoop *self, PyObject *args, PyObject *kwargs)
+{
+    return pyuv__asyncio_loop_call_soon(self, args, kwargs, "call_soon_threadsafe", True);
+}
+
+
+static PyObject *
+AsyncioLoop_func_call_later(AsyncioLoop *self, PyObject *args, PyObject *kwargs)
+{
+    double delay;
+
+    if (pyuv__asyncio_parse_time(args, "delay", &delay) < 0) {
+        return NULL;
+    }
+
+    return pyuv__asyncio_loop_call_at(self, pyuv__asyncio_time() + delay, args, kwargs, "call_later");
+}
+
+
+static PyObject *
+AsyncioLoop_func_call_at(AsyncioLoop *self, PyObject *args, PyObject *kwargs)
+{
+    double when;
+
+    if (pyuv__asyncio_parse_time(args, "when", &when) < 0) {
+        return NULL;
+    }
+
+    return pyuv__asyncio_loop_call_at(self, when, args, kwargs, "call_at");
+}
+
+
+/* Handles created by asyncio itself, for signal handlers and file descriptor callbacks */
+static PyObject *
+AsyncioLoop_func_add_callback(AsyncioLoop *self, PyObject *handle)
+{
+    PyObject *cancelled;
+    int r;
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    if (PyObject_TypeCheck(handle, &AsyncioHandleType)) {
+        r = ((AsyncioHandle *)handle)->cancelled;
+    } else {
+        cancelled = PyObject_GetAttrString(handle, "_cancelled");
+        if (cancelled == NULL) {
+            return NULL;
+        }
+        r = PyObject_IsTrue(cancelled);
+        Py_DECREF(cancelled);
+        if (r < 0) {
+            return NULL;
+        }
+    }
+
+    if (!r && pyuv__asyncio_ready_push(self, handle) < 0) {
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+AsyncioLoop_func_write_to_self(AsyncioLoop *self)
+{
+    if (self->watchers != NULL) {
+        uv_async_send(&self->watchers->async_h);
+    }
+    Py_RETURN_NONE;
+}
+
+
+static int
+pyuv__asyncio_loop_run_handle(AsyncioLoop *self, PyObject *item)
+{
+    PyObject *result;
+    int r;
+
+    if (self->debug) {
+        /* slow callbacks are reported in Python */
+        result = PyObject_CallMethod((PyObject *)self, "_run_debug", "O", item);
+    } else if (Py_TYPE(item) == &AsyncioHandleType || Py_TYPE(item) == &AsyncioTimerHandleType) {
+        if (((AsyncioHandle *)item)->cancelled) {
+            return 0;
+        }
+        return pyuv__asyncio_handle_run((AsyncioHandle *)item);
+    } else {
+        result = PyObject_GetAttrString(item, "_cancelled");
+        if (result == NULL) {
+            return -1;
+        }
+        r = PyObject_IsTrue(result);
+        Py_DECREF(result);
+        if (r != 0) {
+            return r < 0 ? -1 : 0;
+        }
+        result = PyObject_CallMethod(item, "_run", NULL);
+    }
+
+    if (result == NULL) {
+        return -1;
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
+
+static PyObject *
+AsyncioLoop_func_run_once(AsyncioLoop *self)
+{
+    AsyncioHandle *timer;
+    PyObject *item, *result;
+    Py_ssize_t i, ntodo;
+    uv_run_mode mode;
+    double timeout, end;
+    uint64_t ms;
+    Bool armed;
+    int r;
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    if (self->closed) {
+        PyErr_SetString(PyExc_RuntimeError, "Event loop is closed");
+        return NULL;
+    }
+
+    /* poll for I/O, blocking until the earliest timer is due if there is nothing to run */
+    armed = False;
+    if (self->ready.count > 0 || self->stopping) {
+        mode = UV_RUN_NOWAIT;
+    } else if (self->scheduled.count > 0) {
+        timeout = self->scheduled.items[0]->when - pyuv__asyncio_time();
+        if (timeout <= 0) {
+            mode = UV_RUN_NOWAIT;
+        } else {
+            /* libuv timers have millisecond resolution, round up so that the timer is due when
+             * the poll returns. The timer repeats, otherwise the poll would block if it expired
+             * before polling */
+            ms = (uint64_t)(timeout * 1000);
+            if ((double)ms < timeout * 1000) {
+                ms++;
+            }
+            uv_update_time(self->loop->uv_loop);
+            uv_timer_start(&self->watchers->timer_h, (uv_timer_cb)pyuv__asyncio_noop_cb, ms, ms);
+            armed = True;
+            mode = UV_RUN_ONCE;
+        }
+    } else {
+        mode = UV_RUN_ONCE;
+    }
+
+    if (pyuv__loop_sched_enter(self->loop) < 0) {
+        if (armed) {
+            uv_timer_stop(&self->watchers->timer_h);
+        }
+        return NULL;
+    }
+
+    uv_ref((uv_handle_t *)&self->watchers->async_h);
+    Py_BEGIN_ALLOW_THREADS
+    uv_run(self->loop->uv_loop, mode);
+    Py_END_ALLOW_THREADS
+    uv_unref((uv_handle_t *)&self->watchers->async_h);
+    if (armed) {
+        uv_timer_stop(&self->watchers->timer_h);
+    }
+
+    pyuv__loop_sched_leave(self->loop);
+
+    /* the selector collected file descriptor events, asyncio dispatches them */
+    if (PyList_GET_SIZE(self->io_events) > 0) {
+        result = PyObject_CallMethod((PyObject *)self, "_process_io", NULL);
+        if (result == NULL) {
+            return NULL;
+        }
+        Py_DECREF(result);
+    }
+
+    /* move the due timers to the ready queue */
+    end = pyuv__asyncio_time();
+    while (self->scheduled.count > 0 && self->scheduled.items[0]->when <= end) {
+        timer = pyuv__asyncio_heap_remove(self, 0);
+        r = pyuv__asyncio_ready_push(self, (PyObject *)timer);
+        Py_DECREF(timer);
+        if (r < 0) {
+            return NULL;
+        }
+    }
+
+    /* only run what was ready when the iteration started, callbacks added by these callbacks
+     * run in the next iteration */
+    ntodo = self->ready.count;
+    for (i = 0; i < ntodo && self->ready.count > 0; i++) {
+        item = pyuv__asyncio_ready_pop(self);
+        r = pyuv__asyncio_loop_run_handle(self, item);
+        Py_DECREF(item);
+        if (r < 0) {
+            return NULL;
+        }
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+AsyncioLoop_debug_get(AsyncioLoop *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyBool_FromLong((long)self->debug);
+}
+
+
+static int
+AsyncioLoop_debug_set(AsyncioLoop *self, PyObject *value, void *closure)
+{
+    int r;
+
+    UNUSED_ARG(closure);
+
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+        return -1;
+    }
+    r = PyObject_IsTrue(value);
+    if (r < 0) {
+        return -1;
+    }
+    self->debug = r ? True : False;
+    return 0;
+}
+
+
+static PyObject *
+AsyncioLoop_stopping_get(AsyncioLoop *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyBool_FromLong((long)self->stopping);
+}
+
+
+static int
+AsyncioLoop_stopping_set(AsyncioLoop *self, PyObject *value, void *closure)
+{
+    int r;
+
+    UNUSED_ARG(closure);
+
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+        return -1;
+    }
+    r = PyObject_IsTrue(value);
+    if (r < 0) {
+        return -1;
+    }
+    self->stopping = r ? True : False;
+    return 0;
+}
+
+
+static PyObject *
+AsyncioLoop_closed_get(AsyncioLoop *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyBool_FromLong((long)self->closed);
+}
+
+
+/* asyncio sets it when the loop is closed */
+static int
+AsyncioLoop_closed_set(AsyncioLoop *self, PyObject *value, void *closure)
+{
+    int r;
+
+    UNUSED_ARG(closure);
+
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+        return -1;
+    }
+    r = PyObject_IsTrue(value);
+    if (r < 0) {
+        return -1;
+    }
+    if (!r) {
+        if (self->closed) {
+            PyErr_SetString(PyExc_RuntimeError, "a closed event loop can't be reopened");
+            return -1;
+        }
+        return 0;
+    }
+
+    self->closed = True;
+    pyuv__asyncio_loop_release(self);
+    return 0;
+}
+
+
+static PyObject *
+AsyncioLoop_ready_count_get(AsyncioLoop *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyInt_FromSsize_t(self->ready.count);
+}
+
+
+static PyObject *
+AsyncioLoop_scheduled_count_get(AsyncioLoop *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyInt_FromSsize_t(self->scheduled.count);
+}
+
+
+static int
+AsyncioLoop_tp_init(AsyncioLoop *self, PyObject *args, PyObject *kwargs)
+{
+    int err;
+    Loop *loop;
+    PyObject *io_events;
+    asyncio_loop_watchers *watchers;
+
+    static char *kwlist[] = {"loop", "io_events", NULL};
+
+    RAISE_IF_INITIALIZED(self, -1);
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!O!:__init__", kwlist, &LoopType, &loop, &PyList_Type, &io_events)) {
+        return -1;
+    }
+
+    watchers = PyMem_Malloc(sizeof *watchers);
+    if (!watchers) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    err = uv_timer_init(loop->uv_loop, &watchers->timer_h);
+    if (err < 0) {
+        PyMem_Free(watchers);
+        RAISE_UV_EXCEPTION(err, PyExc_TimerError);
+        return -1;
+    }
+
+    err = uv_async_init(loop->uv_loop, &watchers->async_h, (uv_async_cb)pyuv__asyncio_noop_cb);
+    if (err < 0) {
+        watchers->pending_closes = 1;
+        uv_close((uv_handle_t *)&watchers->timer_h, pyuv__asyncio_watchers_close_cb);
+        RAISE_UV_EXCEPTION(err, PyExc_AsyncError);
+        return -1;
+    }
+
+    /* they are not pyuv handles, see IS_PYUV_HANDLE */
+    watchers->timer_h.data = NULL;
+    watchers->async_h.data = NULL;
+    watchers->pending_closes = 2;
+    uv_unref((uv_handle_t *)&watchers->timer_h);
+    uv_unref((uv_handle_t *)&watchers->async_h);
+
+    Py_INCREF(loop);
+    self->loop = loop;
+    Py_INCREF(io_events);
+    self->io_events = io_events;
+    self->watchers = watchers;
+    self->initialized = True;
+
+    return 0;
+}
+
+
+static PyObject *
+AsyncioLoop_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    AsyncioLoop *self;
+
+    self = (AsyncioLoop *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->initialized = False;
+    self->closed = False;
+    self->stopping = False;
+    self->debug = False;
+    return (PyObject *)self;
+}
+
+
+static int
+AsyncioLoop_tp_traverse(AsyncioLoop *self, visitproc visit, void *arg)
+{
+    Py_ssize_t i;
+
+    Py_VISIT(self->loop);
+    Py_VISIT(self->io_events);
+    for (i = 0; i < self->ready.count; i++) {
+        Py_VISIT(self->ready.items[(self->ready.head + i) % self->ready.capacity]);
+    }
+    for (i = 0; i < self->scheduled.count; i++) {
+        Py_VISIT(self->scheduled.items[i]);
+    }
+    return 0;
+}
+
+
+static int
+AsyncioLoop_tp_clear(AsyncioLoop *self)
+{
+    /* the libuv handles must be closed while the loop is still around */
+    pyuv__asyncio_loop_release(self);
+    Py_CLEAR(self->io_events);
+    Py_CLEAR(self->loop);
+    return 0;
+}
+
+
+static void
+AsyncioLoop_tp_dealloc(AsyncioLoop *self)
+{
+    PyObject_GC_UnTrack(self);
+    AsyncioLoop_tp_clear(self);
+    PyMem_Free(self->ready.items);
+    PyMem_Free(self->scheduled.items);
+    Py_TYPE(self)->tp_free(self);
+}
+
+
+static PyMethodDef
+AsyncioLoop_tp_methods[] = {
+    { "time", (PyCFunction)AsyncioLoop_func_time, METH_NOARGS, "Return the current time, according to the event loop's internal monotonic clock." },
+    { "call_soon", (PyCFunction)AsyncioLoop_func_call_soon, METH_VARARGS|METH_KEYWORDS, "Arrange for a callback to be called as soon as possible." },
+    { "call_soon_threadsafe", (PyCFunction)AsyncioLoop_func_call_soon_threadsafe, METH_VARARGS|METH_KEYWORDS, "Like call_soon, but thread-safe." },
+    { "call_later", (PyCFunction)AsyncioLoop_func_call_later, METH_VARARGS|METH_KEYWORDS, "Arrange for a callback to be called after the given delay, in seconds." },
+    { "call_at", (PyCFunction)AsyncioLoop_func_call_at, METH_VARARGS|METH_KEYWORDS, "Arrange for a callback to be called at the given loop time." },
+    { "_add_callback", (PyCFunction)AsyncioLoop_func_add_callback, METH_O, "Add a handle to the ready queue." },
+    { "_write_to_self", (PyCFunction)AsyncioLoop_func_write_to_self, METH_NOARGS, "Wake up the event loop. Can be called from any thread." },
+    { "_run_once", (PyCFunction)AsyncioLoop_func_run_once, METH_NOARGS, "Run one full iteration of the event loop." },
+    { NULL }
+};
+
+
+static PyGetSetDef AsyncioLoop_tp_getsets[] = {
+    {"_debug", (getter)AsyncioLoop_debug_get, (setter)AsyncioLoop_debug_set, "Debug mode flag.", NULL},
+    {"_stopping", (getter)AsyncioLoop_stopping_get, (setter)AsyncioLoop_stopping_set, "Set when the event loop must stop after the current iteration.", NULL},
+    {"_closed", (getter)AsyncioLoop_closed_get, (setter)AsyncioLoop_closed_set, "Set when the event loop is closed.", NULL},
+    {"_ready_count", (getter)AsyncioLoop_ready_count_get, NULL, "Number of callbacks ready to run.", NULL},
+    {"_scheduled_count", (getter)AsyncioLoop_scheduled_count_get, NULL, "Number of scheduled timers.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject AsyncioLoopType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv._asyncio.EventLoop",                               /*tp_name*/
+    sizeof(AsyncioLoop),                                            /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)AsyncioLoop_tp_dealloc,                             /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)AsyncioLoop_tp_traverse,                          /*tp_traverse*/
+    (inquiry)AsyncioLoop_tp_clear,                                  /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    AsyncioLoop_tp_methods,                                         /*tp_methods*/
+    0,                                                              /*tp_members*/
+    AsyncioLoop_tp_getsets,                                         /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)AsyncioLoop_tp_init,                                  /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    AsyncioLoop_tp_new,                                             /*tp_new*/
+};
+
+
+static PyModuleDef pyuv_asyncio_module = {
+    PyModuleDef_HEAD_INIT,
+    "pyuv._cpyuv._asyncio", /*m_name*/
+    NULL,                   /*m_doc*/
+    -1,                     /*m_size*/
+    NULL,                   /*m_methods*/
+};
+
+
+PyObject *
+init_asyncio(void)
+{
+    PyObject *module;
+
+    module = PyModule_Create(&pyuv_asyncio_module);
+    if (module == NULL) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&AsyncioHandleType) < 0) {
+        return NULL;
+    }
+    AsyncioTimerHandleType.tp_base = &AsyncioHandleType;
+
+    PyUVModule_AddType(module, "EventLoop", &AsyncioLoopType);
+    PyUVModule_AddType(module, "Handle", &AsyncioHandleType);
+    PyUVModule_AddType(module, "TimerHandle", &AsyncioTimerHandleType);
+
+    return module;
+}
+
+#endif
@@ -0,0 +1,513 @@
+
+/* Channel: bounded queue which threads can put items on and the loop consumes. The items are kept
+ * in a ring buffer protected by a mutex, which is never held while acquiring the GIL, and the loop
+ * is woken up through the async handle when the channel goes from empty to non-empty.
+ */
+
+/* must be called with the mutex held, returns True if the loop needs to be woken up */
+static Bool
+pyuv__channel_push(Channel *self, PyObject *item)
+{
+    self->items[(self->head + self->count) % self->capacity] = item;
+    self->count++;
+    return self->count == 1;
+}
+
+
+static void
+pyuv__channel_async_cb(uv_async_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Channel *self;
+    PyObject *items, *callback, *result;
+    Py_ssize_t i, count;
+    Bool writable;
+
+    ASSERT(handle);
+    self = PYUV_CONTAINER_OF(handle, Channel, async_h);
+
+    /* Object could go out of scope in the callback, increase refcount to avoid it */
+    Py_INCREF(self);
+
+    count = 0;
+    if (self->callback) {
+        /* items are only taken out if someone consumes them, otherwise producers must block */
+        uv_mutex_lock(&self->mutex);
+        count = self->count;
+        for (i = 0; i < count; i++) {
+            self->scratch[i] = self->items[(self->head + i) % self->capacity];
+        }
+        self->head = (self->head + count) % self->capacity;
+        self->count = 0;
+        if (count > 0) {
+            uv_cond_broadcast(&self->not_full);
+        }
+        uv_mutex_unlock(&self->mutex);
+    }
+
+    if (count > 0) {
+        /* the list takes over the references held by the channel */
+        items = PyList_New(count);
+        if (items) {
+            for (i = 0; i < count; i++) {
+                PyList_SET_ITEM(items, i, self->scratch[i]);
+            }
+            result = PyObject_CallFunctionObjArgs(self->callback, self, items, NULL);
+            if (result == NULL) {
+                handle_uncaught_exception(HANDLE(self)->loop);
+            }
+            Py_XDECREF(result);
+            Py_DECREF(items);
+        } else {
+            for (i = 0; i < count; i++) {
+                Py_DECREF(self->scratch[i]);
+            }
+            handle_uncaught_exception(HANDLE(self)->loop);
+        }
+    }
+
+    if (self->writable_cb && !uv_is_closing((uv_handle_t *)handle)) {
+        uv_mutex_lock(&self->mutex);
+        writable = self->count < self->capacity;
+        uv_mutex_unlock(&self->mutex);
+        if (writable) {
+            callback = self->writable_cb;
+            self->writable_cb = NULL;
+            result = PyObject_CallFunctionObjArgs(callback, self, NULL);
+            if (result == NULL) {
+                handle_uncaught_exception(HANDLE(self)->loop);
+            }
+            Py_XDECREF(result);
+            Py_DECREF(callback);
+        }
+    }
+
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+static PyObject *
+Channel_func_put(Channel *self, PyObject *args, PyObject *kwargs)
+{
+    double timeout;
+    uint64_t now, deadline;
+    PyObject *item, *py_timeout;
+    Bool closed, pushed, wakeup;
+
+    static char *kwlist[] = {"item", "timeout", NULL};
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    py_timeout = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O:put", kwlist, &item, &py_timeout)) {
+        return NULL;
+    }
+
+    timeout = -1.0;
+    if (py_timeout != Py_None) {
+        timeout = PyFloat_AsDouble(py_timeout);
+        if (timeout == -1.0 && PyErr_Occurred()) {
+            return NULL;
+        }
+        if (timeout < 0.0) {
+            PyErr_SetString(PyExc_ValueError, "a positive value or zero is required");
+            return NULL;
+        }
+    }
+
+    Py_INCREF(item);
+    pushed = wakeup = False;
+
+    /* fast path, there is room in the channel */
+    uv_mutex_lock(&self->mutex);
+    closed = self->closed;
+    if (!closed && self->count < self->capacity) {
+        wakeup = pyuv__channel_push(self, item);
+        pushed = True;
+    }
+    uv_mutex_unlock(&self->mutex);
+
+    if (!pushed && !closed && timeout != 0.0) {
+        deadline = timeout > 0.0 ? uv_hrtime() + (uint64_t)(timeout * 1e9) : 0;
+        Py_BEGIN_ALLOW_THREADS
+        uv_mutex_lock(&self->mutex);
+        while (self->count == self->capacity && !self->closed) {
+            if (deadline == 0) {
+                uv_cond_wait(&self->not_full, &self->mutex);
+            } else {
+                now = uv_hrtime();
+                if (now >= deadline) {
+                    break;
+                }
+                uv_cond_timedwait(&self->not_full, &self->mutex, deadline - now);
+            }
+        }
+        closed = self->closed;
+        if (!closed && self->count < self->capacity) {
+            wakeup = pyuv__channel_push(self, item);
+            pushed = True;
+        }
+        uv_mutex_unlock(&self->mutex);
+        Py_END_ALLOW_THREADS
+    }
+
+    if (!pushed) {
+        Py_DECREF(item);
+        if (closed) {
+            PyErr_SetString(PyExc_HandleClosedError, "Handle is closing/closed");
+            return NULL;
+        }
+        Py_RETURN_FALSE;
+    }
+
+    if (wakeup) {
+        uv_async_send(&self->async_h);
+    }
+
+    Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+Channel_func_try_put(Channel *self, PyObject *item)
+{
+    Bool pushed, wakeup;
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    pushed = wakeup = False;
+
+    Py_INCREF(item);
+    uv_mutex_lock(&self->mutex);
+    if (self->count < self->capacity) {
+        wakeup = pyuv__channel_push(self, item);
+        pushed = True;
+    }
+    uv_mutex_unlock(&self->mutex);
+
+    if (!pushed) {
+        Py_DECREF(item);
+        Py_RETURN_FALSE;
+    }
+
+    if (wakeup) {
+        uv_async_send(&self->async_h);
+    }
+
+    Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+Channel_func_start(Channel *self, PyObject *args)
+{
+    PyObject *tmp, *callback;
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "O:start", &callback)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    tmp = self->callback;
+    Py_INCREF(callback);
+    self->callback = callback;
+    Py_XDECREF(tmp);
+
+    /* deliver whatever was queued while stopped */
+    uv_async_send(&self->async_h);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Channel_func_stop(Channel *self)
+{
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    Py_CLEAR(self->callback);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Channel_func_notify_writable(Channel *self, PyObject *args)
+{
+    PyObject *tmp, *callback;
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "O:notify_writable", &callback)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    tmp = self->writable_cb;
+    Py_INCREF(callback);
+    self->writable_cb = callback;
+    Py_XDECREF(tmp);
+
+    uv_async_send(&self->async_h);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Channel_func_close(Channel *self, PyObject *args)
+{
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    /* wake up blocked producers, they will get HandleClosedError */
+    uv_mutex_lock(&self->mutex);
+    self->closed = True;
+    uv_cond_broadcast(&self->not_full);
+    uv_mutex_unlock(&self->mutex);
+
+    return Handle_func_close(HANDLE(self), args);
+}
+
+
+static Py_ssize_t
+Channel_tp_len(Channel *self)
+{
+    Py_ssize_t count;
+
+    if (!self->sync_initialized) {
+        return 0;
+    }
+
+    uv_mutex_lock(&self->mutex);
+    count = self->count;
+    uv_mutex_unlock(&self->mutex);
+
+    return count;
+}
+
+
+static int
+Channel_tp_init(Channel *self, PyObject *args, PyObject *kwargs)
+{
+    int err;
+    Py_ssize_t capacity;
+    Loop *loop;
+
+    static char *kwlist[] = {"loop", "capacity", NULL};
+
+    RAISE_IF_HANDLE_INITIALIZED(self, -1);
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!n:__init__", kwlist, &LoopType, &loop, &capacity)) {
+        return -1;
+    }
+
+    if (capacity < 1) {
+        PyErr_SetString(PyExc_ValueError, "capacity must be positive");
+        return -1;
+    }
+
+    self->items = PyMem_Malloc(sizeof(PyObject *) * capacity);
+    self->scratch = PyMem_Malloc(sizeof(PyObject *) * capacity);
+    if (!self->items || !self->scratch) {
+        PyMem_Free(self->items);
+        PyMem_Free(self->scratch);
+        self->items = self->scratch = NULL;
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    if (uv_mutex_init(&self->mutex)) {
+        goto error;
+    }
+    if (uv_cond_init(&self->not_full)) {
+        uv_mutex_destroy(&self->mutex);
+        goto error;
+    }
+
+    err = uv_async_init(loop->uv_loop, &self->async_h, pyuv__channel_async_cb);
+    if (err != 0) {
+        uv_cond_destroy(&self->not_full);
+        uv_mutex_destroy(&self->mutex);
+        PyMem_Free(self->items);
+        PyMem_Free(self->scratch);
+        self->items = self->scratch = NULL;
+        RAISE_UV_EXCEPTION(err, PyExc_AsyncError);
+        return -1;
+    }
+
+    self->sync_initialized = True;
+    self->capacity = capacity;
+    self->head = self->count = 0;
+    self->closed = False;
+
+    initialize_handle(HANDLE(self), loop);
+
+    return 0;
+
+error:
+    PyMem_Free(self->items);
+    PyMem_Free(self->scratch);
+    self->items = self->scratch = NULL;
+    PyErr_SetString(PyExc_ThreadError, "Error initializing Channel");
+    return -1;
+}
+
+
+static PyObject *
+Channel_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    Channel *self;
+
+    self = (Channel *)HandleType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+
+    self->async_h.data = self;
+    UV_HANDLE(self) = (uv_handle_t *)&self->async_h;
+
+    return (PyObject *)self;
+}
+
+
+static int
+Channel_tp_traverse(Channel *self, visitproc visit, void *arg)
+{
+    Py_ssize_t i;
+    int r;
+
+    if (self->sync_initialized) {
+        /* producers blocked with the GIL released could be pushing items */
+        uv_mutex_lock(&self->mutex);
+        for (i = 0; i < self->count; i++) {
+            r = visit(self->items[(self->head + i) % self->capacity], arg);
+            if (r) {
+                uv_mutex_unlock(&self->mutex);
+                return r;
+            }
+        }
+        uv_mutex_unlock(&self->mutex);
+    }
+    Py_VISIT(self->callback);
+    Py_VISIT(self->writable_cb);
+    return HandleType.tp_traverse((PyObject *)self, visit, arg);
+}
+
+
+static int
+Channel_tp_clear(Channel *self)
+{
+    Py_ssize_t i, count;
+
+    /* unreachable, so no producer can be blocked on it */
+    count = self->count;
+    self->count = 0;
+    for (i = 0; i < count; i++) {
+        Py_DECREF(self->items[(self->head + i) % self->capacity]);
+    }
+
+    /* the async callback uses the mutex, so it's only destroyed once the handle is closed,
+     * which is always the case when this is called from Handle_tp_dealloc */
+    if (self->sync_initialized && uv_is_closing(UV_HANDLE(self))) {
+        uv_cond_destroy(&self->not_full);
+        uv_mutex_destroy(&self->mutex);
+        PyMem_Free(self->items);
+        PyMem_Free(self->scratch);
+        self->items = self->scratch = NULL;
+        self->sync_initialized = False;
+    }
+
+    Py_CLEAR(self->callback);
+    Py_CLEAR(self->writable_cb);
+    return HandleType.tp_clear((PyObject *)self);
+}
+
+
+static PySequenceMethods Channel_tp_as_sequence = {
+    (lenfunc)Channel_tp_len,                                        /*sq_length*/
+    0,                                                              /*sq_concat*/
+    0,                                                              /*sq_repeat*/
+    0,                                                              /*sq_item*/
+    0,                                                              /*sq_slice*/
+    0,                                                              /*sq_ass_item*/
+    0,                                                              /*sq_ass_slice*/
+    0,                                                              /*sq_contains*/
+};
+
+
+static PyMethodDef
+Channel_tp_methods[] = {
+    { "put", (PyCFunction)Channel_func_put, METH_VARARGS|METH_KEYWORDS, "Put an item in the channel, blocking while it's full." },
+    { "try_put", (PyCFunction)Channel_func_try_put, METH_O, "Put an item in the channel if there is room for it." },
+    { "start", (PyCFunction)Channel_func_start, METH_VARARGS, "Start consuming items in the loop." },
+    { "stop", (PyCFunction)Channel_func_stop, METH_NOARGS, "Stop consuming items." },
+    { "notify_writable", (PyCFunction)Channel_func_notify_writable, METH_VARARGS, "Call the given function in the loop once there is room in the channel." },
+    { "close", (PyCFunction)Channel_func_close, METH_VARARGS, "Close the channel." },
+    { NULL }
+};
+
+
+static PyMemberDef Channel_tp_members[] = {
+    {"capacity", T_PYSSIZET, offsetof(Channel, capacity), READONLY, "Maximum number of items the channel can hold."},
+    {NULL}
+};
+
+
+static PyTypeObject ChannelType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.Channel",                                          /*tp_name*/
+    sizeof(Channel),                                                /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    0,                                                              /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    &Channel_tp_as_sequence,                                        /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)Channel_tp_traverse,                              /*tp_traverse*/
+    (inquiry)Channel_tp_clear,                                      /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    Channel_tp_methods,                                             /*tp_methods*/
+    Channel_tp_members,                                             /*tp_members*/
+    0,                                                              /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)Channel_tp_init,                                      /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    Channel_tp_new,                                                 /*tp_new*/
+};
@@ -280,3 +280,260 @@ pyuv__alloc_cb(uv_handle_t* handle, size_t suggested_size, uv_buf_t *buf)
     }
 }
 
+
+/* Build a rusage_result structseq out of a uv_rusage_t structure */
+static PyObject *
+pyuv__rusage_result_new(const uv_rusage_t *ru)
+{
+    PyObject *result;
+
+    result = PyStructSequence_New(&RusageResultType);
+    if (!result)
+        return NULL;
+
+#define pyuv__doubletime(TV) ((double)(TV).tv_sec + 1e-6*(TV).tv_usec)
+    PyStructSequence_SET_ITEM(result, 0, PyFloat_FromDouble(pyuv__doubletime(ru->ru_utime)));
+    PyStructSequence_SET_ITEM(result, 1, PyFloat_FromDouble(pyuv__doubletime(ru->ru_stime)));
+    PyStructSequence_SET_ITEM(result, 2, PyLong_FromLong(ru->ru_maxrss));
+    PyStructSequence_SET_ITEM(result, 3, PyLong_FromLong(ru->ru_ixrss));
+    PyStructSequence_SET_ITEM(result, 4, PyLong_FromLong(ru->ru_idrss));
+    PyStructSequence_SET_ITEM(result, 5, PyLong_FromLong(ru->ru_isrss));
+    PyStructSequence_SET_ITEM(result, 6, PyLong_FromLong(ru->ru_minflt));
+    PyStructSequence_SET_ITEM(result, 7, PyLong_FromLong(ru->ru_majflt));
+    PyStructSequence_SET_ITEM(result, 8, PyLong_FromLong(ru->ru_nswap));
+    PyStructSequence_SET_ITEM(result, 9, PyLong_FromLong(ru->ru_inblock));
+    PyStructSequence_SET_ITEM(result, 10, PyLong_FromLong(ru->ru_oublock));
+    PyStructSequence_SET_ITEM(result, 11, PyLong_FromLong(ru->ru_msgsnd));
+    PyStructSequence_SET_ITEM(result, 12, PyLong_FromLong(ru->ru_msgrcv));
+    PyStructSequence_SET_ITEM(result, 13, PyLong_FromLong(ru->ru_nsignals));
+    PyStructSequence_SET_ITEM(result, 14, PyLong_FromLong(ru->ru_nvcsw));
+    PyStructSequence_SET_ITEM(result, 15, PyLong_FromLong(ru->ru_nivcsw));
+#undef pyuv__doubletime
+
+    if (PyErr_Occurred()) {
+        Py_DECREF(result);
+        return NULL;
+    }
+
+    return result;
+}
+
+
+/* Convert the host and service arguments for getaddrinfo to C strings. The strings may point to
+ * the temporary objects returned in idna and ascii, which must be released by the caller once the
+ * strings are no longer used, or to port_str, which must be at least 6 bytes long.
+ */
+static int
+pyuv__getaddrinfo_parse_args(PyObject *host, PyObject *service, char **host_str, char **service_str, char *port_str, PyObject **idna, PyObject **ascii)
+{
+    long port;
+
+    *idna = *ascii = NULL;
+
+    if (host == Py_None) {
+        *host_str = NULL;
+    } else if (PyUnicode_Check(host)) {
+        *idna = PyObject_CallMethod(host, "encode", "s", "idna");
+        if (!*idna)
+            return -1;
+        *host_str = PyBytes_AS_STRING(*idna);
+    } else if (PyBytes_Check(host)) {
+        *host_str = PyBytes_AsString(host);
+    } else {
+        PyErr_SetString(PyExc_TypeError, "getaddrinfo() argument 3 must be string or None");
+        return -1;
+    }
+
+    if (service == Py_None) {
+        *service_str = NULL;
+    } else if (PyUnicode_Check(service)) {
+        *ascii = PyObject_CallMethod(service, "encode", "s", "ascii");
+        if (!*ascii)
+            goto error;
+        *service_str = PyBytes_AS_STRING(*ascii);
+    } else if (PyBytes_Check(service)) {
+        *service_str = PyBytes_AS_STRING(service);
+    } else if (PyInt_Check(service)) {
+        port = PyInt_AsLong(service);
+        if (port < 0 || port > 0xffff) {
+            PyErr_SetString(PyExc_ValueError, "port must be between 0 and 65535");
+            goto error;
+        }
+        PyOS_snprintf(port_str, 6, "%ld", port);
+        *service_str = port_str;
+    } else {
+        PyErr_SetString(PyExc_TypeError, "getaddrinfo() argument 4 must be string or int");
+        goto error;
+    }
+
+    return 0;
+
+error:
+    Py_CLEAR(*idna);
+    Py_CLEAR(*ascii);
+    return -1;
+}
+
+
+
+#ifdef PYUV_LINUX
+/* Validate a sequence of CPU numbers, returns them in a new tuple */
+static PyObject *
+pyuv__cpus_parse(PyObject *cpus)
+{
+    long cpu;
+    Py_ssize_t i;
+    PyObject *result;
+
+    result = PySequence_Tuple(cpus);
+    if (result == NULL) {
+        return NULL;
+    }
+
+    if (PyTuple_GET_SIZE(result) == 0) {
+        PyErr_SetString(PyExc_ValueError, "at least one CPU is required");
+        goto error;
+    }
+
+    for (i = 0; i < PyTuple_GET_SIZE(result); i++) {
+        cpu = PyInt_AsLong(PyTuple_GET_ITEM(result, i));
+        if (cpu == -1 && PyErr_Occurred()) {
+            goto error;
+        }
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            PyErr_Format(PyExc_ValueError, "invalid CPU number: %ld", cpu);
+            goto error;
+        }
+    }
+
+    return result;
+
+error:
+    Py_DECREF(result);
+    return NULL;
+}
+
+
+/* Fill a CPU set from a tuple returned by pyuv__cpus_parse, NULL selects all CPUs */
+static void
+pyuv__cpus_to_cpuset(PyObject *cpus, cpu_set_t *cpuset)
+{
+    Py_ssize_t i;
+
+    CPU_ZERO(cpuset);
+
+    if (cpus == NULL) {
+        for (i = 0; i < CPU_SETSIZE; i++) {
+            CPU_SET(i, cpuset);
+        }
+        return;
+    }
+
+    for (i = 0; i < PyTuple_GET_SIZE(cpus); i++) {
+        CPU_SET(PyInt_AsLong(PyTuple_GET_ITEM(cpus, i)), cpuset);
+    }
+}
+
+
+/* Check a scheduling policy and its priority, which is the nice value for the non real-time policies */
+static int
+pyuv__sched_check(int policy, int priority)
+{
+    int min, max;
+
+    switch (policy) {
+        case SCHED_FIFO:
+        case SCHED_RR:
+            min = sched_get_priority_min(policy);
+            max = sched_get_priority_max(policy);
+            break;
+        case SCHED_OTHER:
+        case SCHED_BATCH:
+        case SCHED_IDLE:
+            min = -20;
+            max = 19;
+            break;
+        default:
+            PyErr_SetString(PyExc_ValueError, "invalid scheduling policy");
+            return -1;
+    }
+
+    if (priority < min || priority > max) {
+        PyErr_Format(PyExc_ValueError, "priority must be between %d and %d", min, max);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/* Set the CPU affinity and the scheduling policy of a thread. A NULL CPU set or a negative policy
+ * leave the respective setting untouched. Returns 0 or a libuv error code. Doesn't need the GIL.
+ */
+static int
+pyuv__sched_apply(pthread_t thread, long tid, const cpu_set_t *cpuset, int policy, int priority)
+{
+    int err;
+    struct sched_param param;
+
+    if (cpuset != NULL) {
+        err = pthread_setaffinity_np(thread, sizeof(*cpuset), cpuset);
+        if (err != 0) {
+            return -err;
+        }
+    }
+
+    if (policy >= 0) {
+        memset(&param, 0, sizeof(param));
+        if (policy == SCHED_FIFO || policy == SCHED_RR) {
+            param.sched_priority = priority;
+        }
+        err = pthread_setschedparam(thread, policy, &param);
+        if (err != 0) {
+            return -err;
+        }
+        /* on Linux the nice value applies to individual threads */
+        if (policy != SCHED_FIFO && policy != SCHED_RR && setpriority(PRIO_PROCESS, (id_t)tid, priority) != 0) {
+            return -errno;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+
+/* Busy poll the device queue for the given socket when it's read from, instead of waiting for an
+ * interrupt. Returns 0 or a libuv error code.
+ */
+static int
+pyuv__set_busy_poll(uv_handle_t *handle, int usecs)
+{
+#if defined(SO_BUSY_POLL)
+    int err;
+    uv_os_fd_t fd;
+
+    err = uv_fileno(handle, &fd);
+    if (err < 0) {
+        return err;
+    }
+
+    if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) != 0) {
+        return -errno;
+    }
+
+#if defined(SO_PREFER_BUSY_POLL)
+    {
+        /* needs Linux >= 5.11, it's only an optimization */
+        int prefer = usecs > 0;
+        setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer));
+    }
+#endif
+
+    return 0;
+#else
+    UNUSED_ARG(handle);
+    UNUSED_ARG(usecs);
+    return UV_ENOTSUP;
+#endif
+}
@@ -67,11 +67,15 @@ pyuv__getaddrinfo_cb(uv_getaddrinfo_t* req, int status, struct addrinfo* res)
         PYUV_SET_NONE(dns_result);
     }
 
-    result = PyObject_CallFunctionObjArgs(gai_req->callback, dns_result, errorno, NULL);
-    if (result == NULL) {
-        handle_uncaught_exception(loop);
+    pyuv__request_complete(REQUEST(gai_req), err, dns_result, PyExc_UVError);
+
+    if (gai_req->callback != pyuv__awaitable) {
+        result = PyObject_CallFunctionObjArgs(gai_req->callback, dns_result, errorno, NULL);
+        if (result == NULL) {
+            handle_uncaught_exception(loop);
+        }
+        Py_XDECREF(result);
     }
-    Py_XDECREF(result);
     Py_DECREF(dns_result);
     Py_DECREF(errorno);
 
@@ -121,11 +125,15 @@ pyuv__getnameinfo_cb(uv_getnameinfo_t* req, int status, const char *hostname, co
         PYUV_SET_NONE(gni_result);
     }
 
-    result = PyObject_CallFunctionObjArgs(gni_req->callback, gni_result, errorno, NULL);
-    if (result == NULL) {
-        handle_uncaught_exception(loop);
+    pyuv__request_complete(REQUEST(gni_req), err, gni_result, PyExc_UVError);
+
+    if (gni_req->callback != pyuv__awaitable) {
+        result = PyObject_CallFunctionObjArgs(gni_req->callback, gni_result, errorno, NULL);
+        if (result == NULL) {
+            handle_uncaught_exception(loop);
+        }
+        Py_XDECREF(result);
     }
-    Py_XDECREF(result);
     Py_DECREF(gni_result);
     Py_DECREF(errorno);
 
@@ -142,7 +150,6 @@ Util_func_getaddrinfo(PyObject *obj, PyObject *args, PyObject *kwargs)
     char *host_str, *service_str;
     char port_str[6];
     int family, socktype, protocol, flags, err;
-    long port;
     struct addrinfo hints;
     Loop *loop;
     GAIRequest *gai_req;
@@ -153,7 +160,7 @@ Util_func_getaddrinfo(PyObject *obj, PyObject *args, PyObject *kwargs)
     UNUSED_ARG(obj);
     gai_req = NULL;
     idna = ascii = NULL;
-    port = socktype = protocol = flags = 0;
+    socktype = protocol = flags = 0;
     family = AF_UNSPEC;
     service = Py_None;
     callback = Py_None;
@@ -162,45 +169,13 @@ Util_func_getaddrinfo(PyObject *obj, PyObject *args, PyObject *kwargs)
         return NULL;
     }
 
-    if (host == Py_None) {
-        host_str = NULL;
-    } else if (PyUnicode_Check(host)) {
-        idna = PyObject_CallMethod(host, "encode", "s", "idna");
-        if (!idna)
-            return NULL;
-        host_str = PyBytes_AS_STRING(idna);
-    } else if (PyBytes_Check(host)) {
-        host_str = PyBytes_AsString(host);
-    } else {
-        PyErr_SetString(PyExc_TypeError, "getaddrinfo() argument 3 must be string or None");
-        goto error;
-    }
-
     if (callback != Py_None && !PyCallable_Check(callback)) {
         PyErr_SetString(PyExc_TypeError, "'callback' must be a callable or None");
-        goto error;
+        return NULL;
     }
 
-    if (service == Py_None) {
-        service_str = NULL;
-    } else if (PyUnicode_Check(service)) {
-        ascii = PyObject_CallMethod(service, "encode", "s", "ascii");
-        if (!ascii)
-            return NULL;
-        service_str = PyBytes_AS_STRING(ascii);
-    } else if (PyBytes_Check(service)) {
-        service_str = PyBytes_AS_STRING(service);
-    } else if (PyInt_Check(service)) {
-        port = PyInt_AsLong(service);
-        if (port < 0 || port > 0xffff) {
-            PyErr_SetString(PyExc_ValueError, "port must be between 0 and 65535");
-            goto error;
-        }
-        PyOS_snprintf(port_str, sizeof(port_str), "%ld", port);
-        service_str = port_str;
-    } else {
-        PyErr_SetString(PyExc_TypeError, "getaddrinfo() argument 4 must be string or int");
-        goto error;
+    if (pyuv__getaddrinfo_parse_args(host, service, &host_str, &service_str, port_str, &idna, &ascii) != 0) {
+        return NULL;
     }
 
     gai_req = (GAIRequest *)PyObject_CallFunctionObjArgs((PyObject *)&GAIRequestType, loop, callback, NULL);
@@ -315,10 +290,811 @@ Util_func_getnameinfo(PyObject *obj, PyObject *args, PyObject *kwargs)
 }
 
 
+/* getaddrinfo_many: resolves a list of names with a bounded number of lookups running on the
+ * threadpool at any given time. Duplicate names are resolved once and results are delivered in
+ * batches of (host, result, errorno) tuples.
+ */
+
+typedef struct pyuv__gai_many_ctx_s pyuv__gai_many_ctx;
+
+typedef struct {
+    uv_getaddrinfo_t req;
+    pyuv__gai_many_ctx *ctx;
+    PyObject *host;
+} pyuv__gai_many_lookup;
+
+struct pyuv__gai_many_ctx_s {
+    uv_idle_t idle_h;
+    Loop *loop;
+    PyObject *callback;
+    PyObject *hosts;
+    PyObject *batch;
+    Py_ssize_t next;
+    char *service;
+    struct addrinfo hints;
+    int concurrency;
+    int batch_size;
+    int active;
+};
+
+
+static void
+pyuv__gai_many_close_cb(uv_handle_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    pyuv__gai_many_ctx *ctx;
+
+    ctx = PYUV_CONTAINER_OF(handle, pyuv__gai_many_ctx, idle_h);
+
+    Py_DECREF(ctx->loop);
+    Py_DECREF(ctx->callback);
+    Py_DECREF(ctx->hosts);
+    Py_DECREF(ctx->batch);
+    free(ctx->service);
+    free(ctx);
+
+    PyGILState_Release(gstate);
+}
+
+
+/* Deliver up to batch_size results. The batch only grows past it by the lookups that completed
+ * while it was full, so removing the delivered ones moves at most concurrency items.
+ */
+static void
+pyuv__gai_many_deliver(pyuv__gai_many_ctx *ctx, Bool finished)
+{
+    PyObject *batch, *result;
+
+    if (PyList_GET_SIZE(ctx->batch) > ctx->batch_size) {
+        batch = PyList_GetSlice(ctx->batch, 0, ctx->batch_size);
+        if (!batch || PyList_SetSlice(ctx->batch, 0, ctx->batch_size, NULL) != 0) {
+            Py_XDECREF(batch);
+            handle_uncaught_exception(ctx->loop);
+            return;
+        }
+    } else {
+        batch = PyList_New(0);
+        if (!batch) {
+            handle_uncaught_exception(ctx->loop);
+            return;
+        }
+
+        /* swap the lists so that lookups completed from within the callback go in the next batch */
+        result = ctx->batch;
+        ctx->batch = batch;
+        batch = result;
+    }
+
+    result = PyObject_CallFunctionObjArgs(ctx->callback, batch, finished ? Py_True : Py_False, NULL);
+    if (result == NULL) {
+        handle_uncaught_exception(ctx->loop);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(batch);
+}
+
+
+static void pyuv__gai_many_start(pyuv__gai_many_ctx *ctx);
+
+static void
+pyuv__gai_many_idle_cb(uv_idle_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    pyuv__gai_many_ctx *ctx;
+    Bool finished;
+
+    ctx = PYUV_CONTAINER_OF(handle, pyuv__gai_many_ctx, idle_h);
+    finished = ctx->active == 0 && ctx->next >= PyList_GET_SIZE(ctx->hosts) && PyList_GET_SIZE(ctx->batch) <= ctx->batch_size;
+
+    uv_idle_stop(handle);
+    if (finished) {
+        uv_close((uv_handle_t *)handle, pyuv__gai_many_close_cb);
+    }
+
+    if (finished || PyList_GET_SIZE(ctx->batch) > 0) {
+        pyuv__gai_many_deliver(ctx, finished);
+    }
+
+    /* resume the names held back by a full batch, the rest of it goes on the next iteration */
+    if (!finished) {
+        pyuv__gai_many_start(ctx);
+    }
+
+    PyGILState_Release(gstate);
+}
+
+
+static void pyuv__gai_many_cb(uv_getaddrinfo_t* req, int status, struct addrinfo* res);
+
+
+/* Start lookups up to the concurrency limit. Names which fail right away fill the batch, so it
+ * stops there and the idle callback resumes once the batch was delivered.
+ */
+static void
+pyuv__gai_many_start(pyuv__gai_many_ctx *ctx)
+{
+    int err;
+    char *host_str, *service_str;
+    char port_str[6];
+    PyObject *host, *idna, *ascii, *item;
+    pyuv__gai_many_lookup *lookup;
+
+    while (ctx->active < ctx->concurrency && ctx->next < PyList_GET_SIZE(ctx->hosts) && PyList_GET_SIZE(ctx->batch) < ctx->batch_size) {
+        host = PyList_GET_ITEM(ctx->hosts, ctx->next);
+        ctx->next++;
+
+        if (pyuv__getaddrinfo_parse_args(host, Py_None, &host_str, &service_str, port_str, &idna, &ascii) != 0) {
+            PyErr_Clear();
+            err = UV_EINVAL;
+            goto failed;
+        }
+
+        lookup = malloc(sizeof *lookup);
+        if (!lookup) {
+            Py_XDECREF(idna);
+            err = UV_ENOMEM;
+            goto failed;
+        }
+
+        err = uv_getaddrinfo(ctx->loop->uv_loop, &lookup->req, pyuv__gai_many_cb, host_str, ctx->service, &ctx->hints);
+        Py_XDECREF(idna);
+        if (err < 0) {
+            free(lookup);
+            goto failed;
+        }
+
+        Py_INCREF(host);
+        lookup->host = host;
+        lookup->ctx = ctx;
+        ctx->active++;
+        continue;
+
+failed:
+        item = Py_BuildValue("(OOi)", host, Py_None, err);
+        if (!item || PyList_Append(ctx->batch, item) != 0) {
+            PyErr_Clear();
+        }
+        Py_XDECREF(item);
+    }
+
+    if (PyList_GET_SIZE(ctx->batch) > 0 || (ctx->active == 0 && ctx->next >= PyList_GET_SIZE(ctx->hosts))) {
+        uv_idle_start(&ctx->idle_h, pyuv__gai_many_idle_cb);
+    }
+}
+
+
+static void
+pyuv__gai_many_cb(uv_getaddrinfo_t* req, int status, struct addrinfo* res)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    pyuv__gai_many_lookup *lookup;
+    pyuv__gai_many_ctx *ctx;
+    PyObject *dns_result, *errorno, *item;
+    int err;
+
+    lookup = PYUV_CONTAINER_OF(req, pyuv__gai_many_lookup, req);
+    ctx = lookup->ctx;
+    ctx->active--;
+    dns_result = NULL;
+
+    err = pyuv__getaddrinfo_process_result(status, res, &dns_result);
+    if (err == 0) {
+        PYUV_SET_NONE(errorno);
+    } else {
+        errorno = PyInt_FromLong((long)err);
+        PYUV_SET_NONE(dns_result);
+    }
+    uv_freeaddrinfo(res);
+
+    item = PyTuple_Pack(3, lookup->host, dns_result, errorno);
+    if (!item || PyList_Append(ctx->batch, item) != 0) {
+        PyErr_Clear();
+    }
+    Py_XDECREF(item);
+    Py_DECREF(dns_result);
+    Py_DECREF(errorno);
+    Py_DECREF(lookup->host);
+    free(lookup);
+
+    /* keep the threadpool busy before calling back into Python */
+    pyuv__gai_many_start(ctx);
+
+    /* full batches are delivered right away, the last one always from the idle callback */
+    if (PyList_GET_SIZE(ctx->batch) >= ctx->batch_size && (ctx->active > 0 || ctx->next < PyList_GET_SIZE(ctx->hosts))) {
+        pyuv__gai_many_deliver(ctx, False);
+    }
+
+    PyGILState_Release(gstate);
+}
+
+
+static PyObject *
+Util_func_getaddrinfo_many(PyObject *obj, PyObject *args, PyObject *kwargs)
+{
+    char *host_str, *service_str;
+    char port_str[6];
+    int family, socktype, protocol, flags, concurrency, batch_size;
+    Loop *loop;
+    PyObject *callback, *hosts, *service, *iter, *host, *seen, *idna, *ascii;
+    pyuv__gai_many_ctx *ctx;
+
+    static char *kwlist[] = {"loop", "hosts", "port", "callback", "family", "socktype", "protocol", "flags", "concurrency", "batch_size", NULL};
+
+    UNUSED_ARG(obj);
+    socktype = protocol = flags = 0;
+    family = AF_UNSPEC;
+    concurrency = 4;
+    batch_size = 64;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!OOO|iiiiii:getaddrinfo_many", kwlist, &LoopType, &loop, &hosts, &service, &callback, &family, &socktype, &protocol, &flags, &concurrency, &batch_size)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    if (concurrency < 1 || batch_size < 1) {
+        PyErr_SetString(PyExc_ValueError, "concurrency and batch_size must be positive");
+        return NULL;
+    }
+
+    ctx = calloc(1, sizeof *ctx);
+    if (!ctx) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    if (pyuv__getaddrinfo_parse_args(Py_None, service, &host_str, &service_str, port_str, &idna, &ascii) != 0) {
+        free(ctx);
+        return NULL;
+    }
+    if (service_str) {
+        ctx->service = malloc(strlen(service_str) + 1);
+        if (ctx->service) {
+            strcpy(ctx->service, service_str);
+        }
+    }
+    Py_XDECREF(ascii);
+    if (service_str && !ctx->service) {
+        free(ctx);
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    /* deduplicate the names, keeping the original order */
+    ctx->hosts = PyList_New(0);
+    ctx->batch = PyList_New(0);
+    seen = PySet_New(NULL);
+    iter = PyObject_GetIter(hosts);
+    if (!ctx->hosts || !ctx->batch || !seen || !iter) {
+        goto error;
+    }
+
+    while ((host = PyIter_Next(iter)) != NULL) {
+        if (!PyUnicode_Check(host) && !PyBytes_Check(host)) {
+            Py_DECREF(host);
+            PyErr_SetString(PyExc_TypeError, "hosts must be strings");
+            goto error;
+        }
+        switch (PySet_Contains(seen, host)) {
+            case 0:
+                if (PySet_Add(seen, host) != 0 || PyList_Append(ctx->hosts, host) != 0) {
+                    Py_DECREF(host);
+                    goto error;
+                }
+                break;
+            case 1:
+                break;
+            default:
+                Py_DECREF(host);
+                goto error;
+        }
+        Py_DECREF(host);
+    }
+    if (PyErr_Occurred()) {
+        goto error;
+    }
+    Py_CLEAR(iter);
+    Py_CLEAR(seen);
+
+    memset(&ctx->hints, 0, sizeof(ctx->hints));
+    ctx->hints.ai_family = family;
+    ctx->hints.ai_socktype = socktype;
+    ctx->hints.ai_protocol = protocol;
+    ctx->hints.ai_flags = flags;
+    ctx->concurrency = concurrency;
+    ctx->batch_size = batch_size;
+
+    Py_INCREF(loop);
+    Py_INCREF(callback);
+    ctx->loop = loop;
+    ctx->callback = callback;
+
+    uv_idle_init(loop->uv_loop, &ctx->idle_h);
+    pyuv__gai_many_start(ctx);
+
+    Py_RETURN_NONE;
+
+error:
+    Py_XDECREF(iter);
+    Py_XDECREF(seen);
+    Py_XDECREF(ctx->hosts);
+    Py_XDECREF(ctx->batch);
+    free(ctx->service);
+    free(ctx);
+    return NULL;
+}
+
+
+/* DNSCache: caches getaddrinfo results (and failures) for a configurable amount of time and
+ * coalesces concurrent lookups for the same key into a single threadpool request.
+ */
+
+typedef struct {
+    uv_getaddrinfo_t req;
+    DNSCache *cache;
+    PyObject *key;
+} pyuv__dnscache_lookup;
+
+
+static void
+pyuv__dnscache_idle_cb(uv_idle_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    DNSCache *self;
+    PyObject *ready, *item, *result;
+    Py_ssize_t i;
+
+    ASSERT(handle);
+    self = PYUV_CONTAINER_OF(handle, DNSCache, idle_h);
+
+    /* Object could go out of scope in the callback, increase refcount to avoid it */
+    Py_INCREF(self);
+
+    uv_idle_stop(handle);
+    PYUV_HANDLE_DECREF(self);
+
+    ready = self->ready;
+    self->ready = PyList_New(0);
+    if (!self->ready) {
+        self->ready = ready;
+        handle_uncaught_exception(HANDLE(self)->loop);
+        goto done;
+    }
+
+    for (i = 0; i < PyList_GET_SIZE(ready); i++) {
+        item = PyList_GET_ITEM(ready, i);
+        result = PyObject_CallFunctionObjArgs(PyTuple_GET_ITEM(item, 0), PyTuple_GET_ITEM(item, 1), PyTuple_GET_ITEM(item, 2), NULL);
+        if (result == NULL) {
+            handle_uncaught_exception(HANDLE(self)->loop);
+        }
+        Py_XDECREF(result);
+    }
+    Py_DECREF(ready);
+
+done:
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+/* Each caller gets its own copy of the result list, the cached one is never handed out */
+static PyObject *
+pyuv__dnscache_result_copy(PyObject *result)
+{
+    if (result == Py_None) {
+        Py_INCREF(result);
+        return result;
+    }
+    return PyList_GetSlice(result, 0, PyList_GET_SIZE(result));
+}
+
+
+static void
+pyuv__dnscache_store(DNSCache *self, PyObject *key, PyObject *result, PyObject *errorno, double ttl)
+{
+    Py_ssize_t pos;
+    PyObject *entry, *k, *v, *expired;
+    uint64_t now, expires;
+
+    if (ttl <= 0.0) {
+        return;
+    }
+
+    now = uv_now(UV_HANDLE_LOOP(self));
+
+    if (self->max_entries > 0 && PyDict_Size(self->entries) >= self->max_entries) {
+        /* purge expired entries first, then evict the oldest one if still full */
+        expired = PyList_New(0);
+        if (!expired) {
+            PyErr_Clear();
+            return;
+        }
+        pos = 0;
+        while (PyDict_Next(self->entries, &pos, &k, &v)) {
+            if ((uint64_t)PyLong_AsUnsignedLongLong(PyTuple_GET_ITEM(v, 0)) <= now) {
+                PyList_Append(expired, k);
+            }
+        }
+        for (pos = 0; pos < PyList_GET_SIZE(expired); pos++) {
+            PyDict_DelItem(self->entries, PyList_GET_ITEM(expired, pos));
+        }
+        Py_DECREF(expired);
+        pos = 0;
+        if (PyDict_Size(self->entries) >= self->max_entries && PyDict_Next(self->entries, &pos, &k, &v)) {
+            Py_INCREF(k);
+            PyDict_DelItem(self->entries, k);
+            Py_DECREF(k);
+        }
+    }
+
+    expires = now + (uint64_t)(ttl * 1000);
+    entry = Py_BuildValue("(KOO)", (unsigned PY_LONG_LONG)expires, result, errorno);
+    if (!entry || PyDict_SetItem(self->entries, key, entry) != 0) {
+        PyErr_Clear();
+    }
+    Py_XDECREF(entry);
+}
+
+
+static void
+pyuv__dnscache_lookup_cb(uv_getaddrinfo_t* req, int status, struct addrinfo* res)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    pyuv__dnscache_lookup *lookup;
+    DNSCache *self;
+    PyObject *dns_result, *errorno, *waiters, *result, *copy;
+    Py_ssize_t i;
+    int err;
+
+    ASSERT(req);
+
+    lookup = PYUV_CONTAINER_OF(req, pyuv__dnscache_lookup, req);
+    self = lookup->cache;
+    dns_result = NULL;
+
+    err = pyuv__getaddrinfo_process_result(status, res, &dns_result);
+    if (err == 0) {
+        PYUV_SET_NONE(errorno);
+        pyuv__dnscache_store(self, lookup->key, dns_result, errorno, self->ttl);
+    } else {
+        errorno = PyInt_FromLong((long)err);
+        PYUV_SET_NONE(dns_result);
+        if (err != UV_EAI_CANCELED) {
+            pyuv__dnscache_store(self, lookup->key, dns_result, errorno, self->negative_ttl);
+        }
+    }
+
+    /* the waiters are missing if registering them failed, there is nobody to notify then */
+    waiters = PyDict_GetItem(self->pending, lookup->key);
+    if (waiters) {
+        Py_INCREF(waiters);
+        if (PyDict_DelItem(self->pending, lookup->key) != 0) {
+            PyErr_Clear();
+        }
+    }
+
+    for (i = 0; waiters && i < PyList_GET_SIZE(waiters); i++) {
+        copy = pyuv__dnscache_result_copy(dns_result);
+        if (!copy) {
+            handle_uncaught_exception(HANDLE(self)->loop);
+            continue;
+        }
+        result = PyObject_CallFunctionObjArgs(PyList_GET_ITEM(waiters, i), copy, errorno, NULL);
+        if (result == NULL) {
+            handle_uncaught_exception(HANDLE(self)->loop);
+        }
+        Py_XDECREF(result);
+        Py_DECREF(copy);
+    }
+
+    Py_XDECREF(waiters);
+    Py_DECREF(dns_result);
+    Py_DECREF(errorno);
+
+    uv_freeaddrinfo(res);
+    Py_DECREF(lookup->key);
+    PyMem_Free(lookup);
+
+    /* Refcount was increased when the lookup was started */
+    Py_DECREF(self);
+
+    PyGILState_Release(gstate);
+}
+
+
+static PyObject *
+DNSCache_func_getaddrinfo(DNSCache *self, PyObject *args, PyObject *kwargs)
+{
+    char *host_str, *service_str;
+    char port_str[6];
+    int family, socktype, protocol, flags, err;
+    struct addrinfo hints;
+    pyuv__dnscache_lookup *lookup;
+    PyObject *callback, *host, *service, *idna, *ascii, *key, *entry, *waiters, *item, *copy;
+
+    static char *kwlist[] = {"host", "port", "family", "socktype", "protocol", "flags", "callback", NULL};
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    socktype = protocol = flags = 0;
+    family = AF_UNSPEC;
+    service = Py_None;
+    callback = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OiiiiO:getaddrinfo", kwlist, &host, &service, &family, &socktype, &protocol, &flags, &callback)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    key = Py_BuildValue("(OOiiii)", host, service, family, socktype, protocol, flags);
+    if (!key) {
+        return NULL;
+    }
+
+    /* cached? */
+    entry = PyDict_GetItem(self->entries, key);
+    if (entry) {
+        if ((uint64_t)PyLong_AsUnsignedLongLong(PyTuple_GET_ITEM(entry, 0)) > uv_now(UV_HANDLE_LOOP(self))) {
+            self->hits++;
+            copy = pyuv__dnscache_result_copy(PyTuple_GET_ITEM(entry, 1));
+            if (!copy) {
+                goto error;
+            }
+            item = PyTuple_Pack(3, callback, copy, PyTuple_GET_ITEM(entry, 2));
+            Py_DECREF(copy);
+            if (!item || PyList_Append(self->ready, item) != 0) {
+                Py_XDECREF(item);
+                goto error;
+            }
+            Py_DECREF(item);
+            uv_idle_start(&self->idle_h, pyuv__dnscache_idle_cb);
+            PYUV_HANDLE_INCREF(self);
+            Py_DECREF(key);
+            Py_RETURN_NONE;
+        }
+        PyDict_DelItem(self->entries, key);
+    }
+
+    /* lookup in progress? */
+    waiters = PyDict_GetItem(self->pending, key);
+    if (waiters) {
+        if (PyList_Append(waiters, callback) != 0) {
+            goto error;
+        }
+        self->coalesced++;
+        Py_DECREF(key);
+        Py_RETURN_NONE;
+    }
+
+    if (pyuv__getaddrinfo_parse_args(host, service, &host_str, &service_str, port_str, &idna, &ascii) != 0) {
+        goto error;
+    }
+
+    lookup = PyMem_Malloc(sizeof *lookup);
+    if (!lookup) {
+        Py_XDECREF(idna);
+        Py_XDECREF(ascii);
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = family;
+    hints.ai_socktype = socktype;
+    hints.ai_protocol = protocol;
+    hints.ai_flags = flags;
+
+    err = uv_getaddrinfo(UV_HANDLE_LOOP(self), &lookup->req, &pyuv__dnscache_lookup_cb, host_str, service_str, &hints);
+    Py_XDECREF(idna);
+    Py_XDECREF(ascii);
+    if (err < 0) {
+        PyMem_Free(lookup);
+        RAISE_UV_EXCEPTION(err, PyExc_UVError);
+        goto error;
+    }
+
+    waiters = Py_BuildValue("[O]", callback);
+    if (!waiters || PyDict_SetItem(self->pending, key, waiters) != 0) {
+        /* the lookup is running already, its result will still be cached */
+        PyErr_Clear();
+    }
+    Py_XDECREF(waiters);
+
+    self->misses++;
+    lookup->key = key;
+    lookup->cache = self;
+    /* Increase refcount so that object is not removed before the lookup finishes */
+    Py_INCREF(self);
+
+    Py_RETURN_NONE;
+
+error:
+    Py_DECREF(key);
+    return NULL;
+}
+
+
+static PyObject *
+DNSCache_func_clear(DNSCache *self)
+{
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+
+    PyDict_Clear(self->entries);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+DNSCache_stats_get(DNSCache *self, void *closure)
+{
+    UNUSED_ARG(closure);
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+
+    return Py_BuildValue("{s:K,s:K,s:K,s:n,s:n}",
+                         "hits", (unsigned PY_LONG_LONG)self->hits,
+                         "misses", (unsigned PY_LONG_LONG)self->misses,
+                         "coalesced", (unsigned PY_LONG_LONG)self->coalesced,
+                         "entries", PyDict_Size(self->entries),
+                         "pending", PyDict_Size(self->pending));
+}
+
+
+static int
+DNSCache_tp_init(DNSCache *self, PyObject *args, PyObject *kwargs)
+{
+    int err;
+    double ttl, negative_ttl;
+    Py_ssize_t max_entries;
+    Loop *loop;
+
+    static char *kwlist[] = {"loop", "ttl", "negative_ttl", "max_entries", NULL};
+
+    RAISE_IF_HANDLE_INITIALIZED(self, -1);
+
+    ttl = 60.0;
+    negative_ttl = 5.0;
+    max_entries = 4096;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|ddn:__init__", kwlist, &LoopType, &loop, &ttl, &negative_ttl, &max_entries)) {
+        return -1;
+    }
+
+    if (ttl < 0.0 || negative_ttl < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "a positive value or zero is required");
+        return -1;
+    }
+
+    self->entries = PyDict_New();
+    self->pending = PyDict_New();
+    self->ready = PyList_New(0);
+    if (!self->entries || !self->pending || !self->ready) {
+        return -1;
+    }
+
+    err = uv_idle_init(loop->uv_loop, &self->idle_h);
+    if (err < 0) {
+        RAISE_UV_EXCEPTION(err, PyExc_UVError);
+        return -1;
+    }
+
+    self->ttl = ttl;
+    self->negative_ttl = negative_ttl;
+    self->max_entries = max_entries;
+
+    initialize_handle(HANDLE(self), loop);
+
+    return 0;
+}
+
+
+static PyObject *
+DNSCache_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    DNSCache *self;
+
+    self = (DNSCache *)HandleType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+
+    self->idle_h.data = self;
+    UV_HANDLE(self) = (uv_handle_t *)&self->idle_h;
+
+    return (PyObject *)self;
+}
+
+
+static int
+DNSCache_tp_traverse(DNSCache *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->entries);
+    Py_VISIT(self->pending);
+    Py_VISIT(self->ready);
+    return HandleType.tp_traverse((PyObject *)self, visit, arg);
+}
+
+
+static int
+DNSCache_tp_clear(DNSCache *self)
+{
+    Py_CLEAR(self->entries);
+    Py_CLEAR(self->pending);
+    Py_CLEAR(self->ready);
+    return HandleType.tp_clear((PyObject *)self);
+}
+
+
+static PyMethodDef
+DNSCache_tp_methods[] = {
+    { "getaddrinfo", (PyCFunction)DNSCache_func_getaddrinfo, METH_VARARGS|METH_KEYWORDS, "Resolve the given host, using the cache if possible." },
+    { "clear", (PyCFunction)DNSCache_func_clear, METH_NOARGS, "Remove all cached entries." },
+    { NULL }
+};
+
+
+static PyGetSetDef DNSCache_tp_getsets[] = {
+    {"stats", (getter)DNSCache_stats_get, NULL, "Cache statistics.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject DNSCacheType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.dns.DNSCache",                                     /*tp_name*/
+    sizeof(DNSCache),                                               /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    0,                                                              /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)DNSCache_tp_traverse,                             /*tp_traverse*/
+    (inquiry)DNSCache_tp_clear,                                     /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    DNSCache_tp_methods,                                            /*tp_methods*/
+    0,                                                              /*tp_members*/
+    DNSCache_tp_getsets,                                            /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)DNSCache_tp_init,                                     /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    DNSCache_tp_new,                                                /*tp_new*/
+};
+
+
 static PyMethodDef
 Dns_methods[] = {
     { "getaddrinfo", (PyCFunction)Util_func_getaddrinfo, METH_VARARGS|METH_KEYWORDS, "Getaddrinfo" },
     { "getnameinfo", (PyCFunction)Util_func_getnameinfo, METH_VARARGS|METH_KEYWORDS, "Getnameinfo" },
+    { "getaddrinfo_many", (PyCFunction)Util_func_getaddrinfo_many, METH_VARARGS|METH_KEYWORDS, "Resolve a list of hosts with bounded concurrency" },
     { NULL }
 };
 
@@ -350,6 +1126,15 @@ init_dns(void)
     if (AddrinfoResultType.tp_name == 0)
         PyStructSequence_InitType(&AddrinfoResultType, &addrinfo_result_desc);
 
+    DNSCacheType.tp_base = &HandleType;
+    PyUVModule_AddType(module, "DNSCache", &DNSCacheType);
+    PyUVModule_AddType(module, "Resolver", &ResolverType);
+
+    PyModule_AddIntConstant(module, "QUERY_TYPE_A", PYUV_QUERY_TYPE_A);
+    PyModule_AddIntConstant(module, "QUERY_TYPE_AAAA", PYUV_QUERY_TYPE_AAAA);
+    PyModule_AddIntConstant(module, "QUERY_TYPE_SRV", PYUV_QUERY_TYPE_SRV);
+    PyModule_AddIntConstant(module, "QUERY_TYPE_TXT", PYUV_QUERY_TYPE_TXT);
+
     return module;
 }
 
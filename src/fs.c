@@ -170,7 +170,9 @@ pyuv__process_fs_req(uv_fs_t* req) {
     fs_req->result = r;
     fs_req->error = errorno;
 
-    if (fs_req->callback != Py_None) {
+    pyuv__request_complete(REQUEST(fs_req), req->result < 0 ? (int)req->result : 0, r, PyExc_FSError);
+
+    if (fs_req->callback != Py_None && fs_req->callback != pyuv__awaitable) {
         result = PyObject_CallFunctionObjArgs(fs_req->callback, fs_req, NULL);
         if (result == NULL) {
             handle_uncaught_exception(loop);
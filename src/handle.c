@@ -40,6 +40,83 @@ resurrect_object(PyObject *self)
 }
 
 
+/* A built-in handle which only references its loop can't be part of a cycle the GC could
+ * break, so it's kept out of the GC lists until a callback or an attribute dictionary is
+ * attached to it. Instances of subclasses are always tracked, since they may hold
+ * arbitrary references in their slots.
+ */
+static INLINE void
+pyuv__handle_gc_track(Handle *self)
+{
+    if (self->flags & PYUV__UNTRACKED) {
+        self->flags &= ~PYUV__UNTRACKED;
+        PyObject_GC_Track((PyObject *)self);
+    }
+}
+
+
+static INLINE void
+pyuv__handle_gc_untrack(Handle *self, PyObject *callback)
+{
+    if (self->flags & PYUV__UNTRACKED || PyType_HasFeature(Py_TYPE(self), Py_TPFLAGS_HEAPTYPE)) {
+        return;
+    }
+    /* the accept policy references its callback */
+    if (self->flags & PYUV__ACCEPT_POLICY) {
+        return;
+    }
+    if (callback == NULL && self->dict == NULL && self->on_close_cb == NULL) {
+        PyObject_GC_UnTrack((PyObject *)self);
+        self->flags |= PYUV__UNTRACKED;
+    }
+}
+
+
+/* Run a handle callback with the given arguments, or queue it by the handle priority if the loop
+ * defers callbacks. nbytes is the amount of data the arguments hold, which counts towards the
+ * memory budget while queued. Steals the reference to args, which may be NULL if building them
+ * failed.
+ */
+static void
+pyuv__handle_dispatch(Handle *self, PyObject *callback, PyObject *args, Py_ssize_t nbytes)
+{
+    Loop *loop;
+    PyObject *item, *result;
+
+    loop = self->loop;
+
+    if (args == NULL) {
+        handle_uncaught_exception(loop);
+        return;
+    }
+
+    if (loop->defer.enabled) {
+        item = Py_BuildValue("(OOOn)", (PyObject *)self, callback, args, nbytes);
+        if (item != NULL && PyList_Append(loop->defer.queues[PYUV_HANDLE_PRIORITY(self) - PYUV_PRIORITY_MIN], item) == 0) {
+            Py_DECREF(item);
+            Py_DECREF(args);
+            loop->defer.bytes += nbytes;
+            if (loop->defer.count++ == 0) {
+                uv_idle_start(&loop->defer.idle_h, pyuv__loop_defer_idle_cb);
+            }
+            return;
+        }
+        /* run it right away rather than losing it */
+        Py_XDECREF(item);
+        PyErr_Clear();
+    }
+
+    result = PyObject_Call(callback, args, NULL);
+    if (result == NULL) {
+        handle_uncaught_exception(loop);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(args);
+}
+
+
+static void pyuv__stream_close_cb(Stream *self);
+
 static void
 pyuv__handle_close_cb(uv_handle_t *handle)
 {
@@ -51,6 +128,10 @@ pyuv__handle_close_cb(uv_handle_t *handle)
     /* Can't use container_of here */
     self = (Handle *)handle->data;
 
+    if (PyObject_TypeCheck(self, &StreamType)) {
+        pyuv__stream_close_cb((Stream *)self);
+    }
+
     if (self->on_close_cb != Py_None) {
         result = PyObject_CallFunctionObjArgs(self->on_close_cb, self, NULL);
         if (result == NULL) {
@@ -86,6 +167,9 @@ pyuv__handle_dealloc_close_cb(uv_handle_t *handle)
 
     /* Can't use container_of here */
     self = (Handle *)handle->data;
+    if (PyObject_TypeCheck(self, &StreamType)) {
+        pyuv__stream_close_cb((Stream *)self);
+    }
     Py_DECREF(self);
 
     PyGILState_Release(gstate);
@@ -100,7 +184,7 @@ initialize_handle(Handle *self, Loop *loop)
     Py_INCREF(loop);
     self->loop = loop;
     Py_XDECREF(tmp);
-    self->flags = 0;
+    self->flags &= PYUV__UNTRACKED;
     self->initialized = True;
 }
 
@@ -124,6 +208,9 @@ Handle_func_close(Handle *self, PyObject *args)
 
     Py_INCREF(callback);
     self->on_close_cb = callback;
+    if (callback != Py_None) {
+        pyuv__handle_gc_track(self);
+    }
 
     /* Increase refcount so that object is not removed before the callback is called */
     Py_INCREF(self);
@@ -189,6 +276,44 @@ Handle_ref_set(Handle *self, PyObject* val, void* c)
 }
 
 
+static PyObject *
+Handle_priority_get(Handle *self, void *closure)
+{
+    UNUSED_ARG(closure);
+
+    return PyInt_FromLong((long)PYUV_HANDLE_PRIORITY(self));
+}
+
+
+static int
+Handle_priority_set(Handle *self, PyObject* val, void* c)
+{
+    long priority;
+
+    UNUSED_ARG(c);
+
+    if (val == NULL) {
+        PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+        return -1;
+    }
+
+    priority = PyLong_AsLong(val);
+    if (priority == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+
+    if (priority < PYUV_PRIORITY_MIN || priority > PYUV_PRIORITY_MAX) {
+        PyErr_Format(PyExc_ValueError, "priority must be between %d and %d", PYUV_PRIORITY_MIN, PYUV_PRIORITY_MAX);
+        return -1;
+    }
+
+    /* callbacks which are already deferred keep their place */
+    self->flags = (self->flags & ~PYUV__PRIORITY_MASK) | (((int)priority & 7) << PYUV__PRIORITY_SHIFT);
+
+    return 0;
+}
+
+
 static PyObject *
 Handle_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
@@ -265,6 +390,7 @@ Handle_dict_get(Handle *self, void* c)
         if (self->dict == NULL) {
             return NULL;
         }
+        pyuv__handle_gc_track(self);
     }
     Py_INCREF(self->dict);
     return self->dict;
@@ -290,10 +416,25 @@ Handle_dict_set(Handle *self, PyObject* val, void* c)
     Py_INCREF(val);
     self->dict = val;
     Py_XDECREF(tmp);
+    pyuv__handle_gc_track(self);
     return 0;
 }
 
 
+static int
+Handle_tp_setattro(Handle *self, PyObject *name, PyObject *value)
+{
+    int r;
+
+    r = PyObject_GenericSetAttr((PyObject *)self, name, value);
+    /* the attribute dictionary is created on the first assignment */
+    if (self->dict != NULL) {
+        pyuv__handle_gc_track(self);
+    }
+    return r;
+}
+
+
 static PyMethodDef
 Handle_tp_methods[] = {
     { "close", (PyCFunction)Handle_func_close, METH_VARARGS, "Close handle." },
@@ -312,6 +453,7 @@ static PyGetSetDef Handle_tp_getsets[] = {
     {"active", (getter)Handle_active_get, NULL, "Indicates if this handle is active.", NULL},
     {"ref", (getter)Handle_ref_get, (setter)Handle_ref_set, "Indicates if this handle is ref'd or not.", NULL},
     {"closed", (getter)Handle_closed_get, NULL, "Indicates if this handle is closing or already closed.", NULL},
+    {"priority", (getter)Handle_priority_get, (setter)Handle_priority_set, "Priority of the handle's deferred callbacks.", NULL},
     {NULL}
 };
 
@@ -334,7 +476,7 @@ static PyTypeObject HandleType = {
     0,                                                             /*tp_call*/
     0,                                                             /*tp_str*/
     0,                                                             /*tp_getattro*/
-    0,                                                             /*tp_setattro*/
+    (setattrofunc)Handle_tp_setattro,                              /*tp_setattro*/
     0,                                                             /*tp_as_buffer*/
     Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                       /*tp_flags*/
     0,                                                             /*tp_doc*/
@@ -37,31 +37,185 @@ new_loop(PyTypeObject *type, PyObject *args, PyObject *kwargs, int is_default)
     loop->is_default = is_default;
     loop->weakreflist = NULL;
     loop->buffer.in_use = False;
+    loop->buffer.view.obj = NULL;
+    loop->sync.async = NULL;
+    loop->sync.pending = NULL;
+    loop->sync.waiters = 0;
+    loop->sched.cpus = NULL;
+    loop->sched.policy = -1;
+    loop->sched.priority = 0;
+    loop->sched.running = False;
+    loop->spin.stop = False;
+    loop->defer.initialized = False;
+    loop->defer.enabled = False;
+    loop->defer.budget = 0;
+    loop->defer.count = 0;
+    loop->defer.bytes = 0;
+    loop->memory.initialized = False;
+    loop->memory.pressure = False;
+    loop->memory.budget = 0;
+    loop->memory.used = 0;
+    loop->memory.queued = 0;
+    loop->memory.on_pressure = NULL;
+    loop->memory.paused = NULL;
 
     return obj;
 }
 
 
+/* Check if the loop has work ready without blocking: due timers, pending callbacks or I/O which is
+ * ready on the backend. Doesn't need the GIL.
+ */
+static int
+pyuv__loop_ready(uv_loop_t *loop)
+{
+#ifndef PYUV_WINDOWS
+    int r;
+    struct pollfd pfd;
+#endif
+
+    uv_update_time(loop);
+    if (uv_backend_timeout(loop) == 0) {
+        return 1;
+    }
+
+#ifndef PYUV_WINDOWS
+    pfd.fd = uv_backend_fd(loop);
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    do {
+        r = poll(&pfd, 1, 0);
+    } while (r == -1 && errno == EINTR);
+    return r > 0;
+#else
+    /* there is no backend fd to check, so always run an iteration */
+    return 1;
+#endif
+}
+
+
+static void
+pyuv__loop_busy_poll_walk_cb(uv_handle_t *handle, void *arg)
+{
+    /* best effort, raising the busy poll time needs CAP_NET_ADMIN */
+    if (handle->type == UV_TCP || handle->type == UV_UDP) {
+        pyuv__set_busy_poll(handle, *(int *)arg);
+    }
+}
+
+
+/* Run the loop without blocking as long as it has been idle for less than spin_ns nanoseconds,
+ * then block for a single iteration and start spinning again. Doesn't need the GIL, which is only
+ * taken by the callbacks.
+ */
+static int
+pyuv__loop_run_spin(Loop *self, uint64_t spin_ns)
+{
+    int r;
+    uint64_t idle_start;
+
+    self->spin.stop = False;
+    idle_start = uv_hrtime();
+    r = uv_loop_alive(self->uv_loop);
+
+    /* uv_run resets the libuv stop flag on every iteration, so Loop.stop also sets our own */
+    while (r && !self->spin.stop) {
+        if (pyuv__loop_ready(self->uv_loop)) {
+            r = uv_run(self->uv_loop, UV_RUN_NOWAIT);
+            idle_start = uv_hrtime();
+        } else if (uv_hrtime() - idle_start >= spin_ns) {
+            r = uv_run(self->uv_loop, UV_RUN_ONCE);
+            idle_start = uv_hrtime();
+        } else {
+            r = uv_loop_alive(self->uv_loop);
+        }
+    }
+
+    self->spin.stop = False;
+    return r;
+}
+
+
+/* Record the thread about to run the loop and apply the affinity and scheduling settings to it,
+ * so that they can also be changed while it runs. Must be paired with pyuv__loop_sched_leave. */
+static int
+pyuv__loop_sched_enter(Loop *self)
+{
+#ifdef PYUV_LINUX
+    int err;
+    cpu_set_t cpuset;
+
+    self->sched.thread = pthread_self();
+    self->sched.tid = (long)syscall(SYS_gettid);
+    if (self->sched.cpus != NULL || self->sched.policy >= 0) {
+        if (self->sched.cpus != NULL) {
+            pyuv__cpus_to_cpuset(self->sched.cpus, &cpuset);
+        }
+        err = pyuv__sched_apply(self->sched.thread,
+                                self->sched.tid,
+                                self->sched.cpus != NULL ? &cpuset : NULL,
+                                self->sched.policy,
+                                self->sched.priority);
+        if (err < 0) {
+            RAISE_UV_EXCEPTION(err, PyExc_UVError);
+            return -1;
+        }
+    }
+#endif
+
+    self->sched.running = True;
+    return 0;
+}
+
+
+static void
+pyuv__loop_sched_leave(Loop *self)
+{
+    self->sched.running = False;
+}
+
+
 static PyObject *
-Loop_func_run(Loop *self, PyObject *args)
+Loop_func_run(Loop *self, PyObject *args, PyObject *kwargs)
 {
-    int mode, r;
+    int mode, spin_us, r;
+    static char *kwlist[] = {"mode", "spin_us", NULL};
 
     mode = UV_RUN_DEFAULT;
+    spin_us = 100;
 
-    if (!PyArg_ParseTuple(args, "|i:run", &mode)) {
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|ii:run", kwlist, &mode, &spin_us)) {
         return NULL;
     }
 
-    if (mode != UV_RUN_DEFAULT && mode != UV_RUN_ONCE && mode != UV_RUN_NOWAIT) {
+    if (mode != UV_RUN_DEFAULT && mode != UV_RUN_ONCE && mode != UV_RUN_NOWAIT && mode != PYUV_RUN_SPIN) {
         PyErr_SetString(PyExc_ValueError, "invalid mode specified");
         return NULL;
     }
 
+    if (spin_us < 0) {
+        PyErr_SetString(PyExc_ValueError, "spin_us must not be negative");
+        return NULL;
+    }
+
+    if (pyuv__loop_sched_enter(self) < 0) {
+        return NULL;
+    }
+
+    if (mode == PYUV_RUN_SPIN) {
+        uv_walk(self->uv_loop, pyuv__loop_busy_poll_walk_cb, &spin_us);
+    }
+
     Py_BEGIN_ALLOW_THREADS
-    r = uv_run(self->uv_loop, mode);
+    if (mode == PYUV_RUN_SPIN) {
+        r = pyuv__loop_run_spin(self, (uint64_t)spin_us * 1000);
+    } else {
+        r = uv_run(self->uv_loop, mode);
+    }
     Py_END_ALLOW_THREADS
 
+    pyuv__loop_sched_leave(self);
+
     return PyBool_FromLong((long)r);
 }
 
@@ -70,6 +224,7 @@ static PyObject *
 Loop_func_stop(Loop *self)
 {
     uv_stop(self->uv_loop);
+    self->spin.stop = True;
     Py_RETURN_NONE;
 }
 
@@ -103,6 +258,39 @@ Loop_func_get_timeout(Loop *self)
 }
 
 
+static PyObject *
+Loop_func_next_deadline(Loop *self)
+{
+    int timeout;
+
+    /* timers are based on the cached loop time, so the deadline is exact with regard to it */
+    timeout = uv_backend_timeout(self->uv_loop);
+    if (timeout < 0) {
+        Py_RETURN_NONE;
+    }
+    return PyLong_FromUnsignedLongLong(((unsigned PY_LONG_LONG)uv_now(self->uv_loop) + timeout) * 1000000);
+}
+
+
+static PyObject *
+Loop_func_process_ready(Loop *self)
+{
+    int r;
+
+    /* Callbacks re-enter the GIL we already hold, which is cheaper than dropping it around a loop
+     * iteration which doesn't block: the caller already waited for the backend fd or a deadline.
+     */
+    r = uv_run(self->uv_loop, UV_RUN_NOWAIT);
+
+    return PyBool_FromLong((long)r);
+}
+
+
+#ifdef PYUV_LINUX
+/* Set on the threadpool workers which ran a work callback, see pyuv__threadpool_sched */
+static __thread Bool pyuv__tp_worker = False;
+#endif
+
 static void
 pyuv__tp_work_cb(uv_work_t *req)
 {
@@ -111,18 +299,35 @@ pyuv__tp_work_cb(uv_work_t *req)
     PyObject *result;
 
     ASSERT(req);
+#ifdef PYUV_LINUX
+    pyuv__tp_worker = True;
+#endif
     work_req = PYUV_CONTAINER_OF(req, WorkRequest, req);
 
     result = PyObject_CallFunctionObjArgs(work_req->work_cb, NULL);
     if (result == NULL) {
         ASSERT(PyErr_Occurred());
-        PyErr_Print();
+        if (work_req->done_cb == pyuv__awaitable) {
+            /* raised to the coroutine awaiting the request instead */
+            PyObject *type, *tb;
+            PyErr_Fetch(&type, &work_req->error, &tb);
+            PyErr_NormalizeException(&type, &work_req->error, &tb);
+            Py_XDECREF(type);
+            Py_XDECREF(tb);
+        } else {
+            PyErr_Print();
+        }
     }
-    Py_XDECREF(result);
+    work_req->result = result;
 
     PyGILState_Release(gstate);
 }
 
+
+static void pyuv__request_complete(Request *self, int err, PyObject *value, PyObject *exc_type);
+static void pyuv__request_complete_exception(Request *self, PyObject *exc);
+
+
 static void
 pyuv__tp_done_cb(uv_work_t *req, int status)
 {
@@ -136,7 +341,13 @@ pyuv__tp_done_cb(uv_work_t *req, int status)
     work_req = PYUV_CONTAINER_OF(req, WorkRequest, req);
     loop = REQUEST(work_req)->loop;
 
-    if (work_req->done_cb != Py_None) {
+    if (status == 0 && work_req->error != NULL) {
+        pyuv__request_complete_exception(REQUEST(work_req), work_req->error);
+    } else {
+        pyuv__request_complete(REQUEST(work_req), status, work_req->result ? work_req->result : Py_None, PyExc_UVError);
+    }
+
+    if (work_req->done_cb != Py_None && work_req->done_cb != pyuv__awaitable) {
         if (status < 0) {
             errorno = PyInt_FromLong((long)status);
         } else {
@@ -202,6 +413,578 @@ error:
 }
 
 
+static PyObject *
+Loop_func_set_affinity(Loop *self, PyObject *cpus)
+{
+#ifdef PYUV_LINUX
+    int err;
+    cpu_set_t cpuset;
+    PyObject *tmp;
+
+    if (cpus == Py_None) {
+        cpus = NULL;
+    } else {
+        cpus = pyuv__cpus_parse(cpus);
+        if (cpus == NULL) {
+            return NULL;
+        }
+    }
+
+    if (self->sched.running) {
+        pyuv__cpus_to_cpuset(cpus, &cpuset);
+        err = pyuv__sched_apply(self->sched.thread, self->sched.tid, &cpuset, -1, 0);
+        if (err < 0) {
+            Py_XDECREF(cpus);
+            RAISE_UV_EXCEPTION(err, PyExc_UVError);
+            return NULL;
+        }
+    }
+
+    tmp = self->sched.cpus;
+    self->sched.cpus = cpus;
+    Py_XDECREF(tmp);
+
+    Py_RETURN_NONE;
+#else
+    UNUSED_ARG(cpus);
+    PyErr_SetString(PyExc_NotImplementedError, "CPU affinity is not supported on this platform");
+    return NULL;
+#endif
+}
+
+
+static PyObject *
+Loop_func_set_scheduling(Loop *self, PyObject *args)
+{
+#ifdef PYUV_LINUX
+    int err, policy, priority;
+
+    priority = 0;
+
+    if (!PyArg_ParseTuple(args, "i|i:set_scheduling", &policy, &priority)) {
+        return NULL;
+    }
+
+    if (pyuv__sched_check(policy, priority) != 0) {
+        return NULL;
+    }
+
+    if (self->sched.running) {
+        err = pyuv__sched_apply(self->sched.thread, self->sched.tid, NULL, policy, priority);
+        if (err < 0) {
+            RAISE_UV_EXCEPTION(err, PyExc_UVError);
+            return NULL;
+        }
+    }
+
+    self->sched.policy = policy;
+    self->sched.priority = priority;
+
+    Py_RETURN_NONE;
+#else
+    UNUSED_ARG(args);
+    PyErr_SetString(PyExc_NotImplementedError, "scheduling control is not supported on this platform");
+    return NULL;
+#endif
+}
+
+
+static PyObject *
+Loop_func_run_in_thread(Loop *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *thread_args, *result;
+
+    if (PyTuple_GET_SIZE(args) > 0) {
+        PyErr_SetString(PyExc_TypeError, "run_in_thread only takes keyword arguments");
+        return NULL;
+    }
+
+    thread_args = PyTuple_Pack(1, (PyObject *)self);
+    if (thread_args == NULL) {
+        return NULL;
+    }
+
+    result = PyObject_Call((PyObject *)&LoopThreadType, thread_args, kwargs);
+    Py_DECREF(thread_args);
+
+    return result;
+}
+
+
+/* Deferred callbacks are queued by handle priority and run from a check handle, highest priority
+ * first. Once the budget is exhausted the remaining ones carry over to the next iteration, the
+ * idle handle keeps the loop from blocking for I/O in the meantime.
+ */
+static void
+pyuv__loop_defer_idle_cb(uv_idle_t *handle)
+{
+    UNUSED_ARG(handle);
+}
+
+
+static void
+pyuv__loop_defer_check_cb(uv_check_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Loop *loop;
+    Handle *target;
+    PyObject *queue, *item, *result;
+    Py_ssize_t i, nbytes;
+    uint64_t start;
+    int p;
+    Bool expired;
+
+    loop = (Loop *)handle->data;
+    Py_INCREF(loop);
+
+    start = uv_hrtime();
+    expired = False;
+
+    for (p = PYUV_PRIORITY_LEVELS - 1; p >= 0 && !expired; p--) {
+        queue = loop->defer.queues[p];
+        if (queue == NULL) {
+            continue;
+        }
+        for (i = 0; i < PyList_GET_SIZE(queue) && !expired; i++) {
+            item = PyList_GET_ITEM(queue, i);
+            if (item == Py_None) {
+                /* dropped by pyuv__loop_defer_drop, already accounted for */
+                continue;
+            }
+            Py_INCREF(item);
+            /* callbacks for handles closed in the meantime are dropped */
+            target = (Handle *)PyTuple_GET_ITEM(item, 0);
+            nbytes = PyNumber_AsSsize_t(PyTuple_GET_ITEM(item, 3), NULL);
+            loop->defer.bytes -= nbytes;
+            loop->defer.count--;
+            /* accounted for, the callback could drop the rest of the handle's queued items */
+            Py_INCREF(Py_None);
+            PyList_SetItem(queue, i, Py_None);
+            if (!uv_is_closing(target->uv_handle)) {
+                result = PyObject_Call(PyTuple_GET_ITEM(item, 1), PyTuple_GET_ITEM(item, 2), NULL);
+                if (result == NULL) {
+                    handle_uncaught_exception(loop);
+                }
+                Py_XDECREF(result);
+            }
+            Py_DECREF(item);
+            if (loop->defer.budget > 0 && uv_hrtime() - start >= loop->defer.budget) {
+                expired = True;
+            }
+        }
+        if (PyList_SetSlice(queue, 0, i, NULL) < 0) {
+            handle_uncaught_exception(loop);
+        }
+    }
+
+    if (loop->defer.count == 0) {
+        uv_idle_stop(&loop->defer.idle_h);
+    }
+
+    Py_DECREF(loop);
+    PyGILState_Release(gstate);
+}
+
+
+/* Drop the callbacks queued for the given handle, used when it stops reading so that data read
+ * before isn't delivered afterwards. Items are replaced with None rather than removed, the check
+ * callback could be walking the queue.
+ */
+static void
+pyuv__loop_defer_drop(Loop *loop, Handle *handle)
+{
+    PyObject *queue, *item;
+    Py_ssize_t i, nbytes;
+    int p;
+
+    if (loop->defer.count == 0) {
+        return;
+    }
+
+    for (p = 0; p < PYUV_PRIORITY_LEVELS; p++) {
+        queue = loop->defer.queues[p];
+        if (queue == NULL) {
+            continue;
+        }
+        for (i = 0; i < PyList_GET_SIZE(queue); i++) {
+            item = PyList_GET_ITEM(queue, i);
+            if (item == Py_None || PyTuple_GET_ITEM(item, 0) != (PyObject *)handle) {
+                continue;
+            }
+            nbytes = PyNumber_AsSsize_t(PyTuple_GET_ITEM(item, 3), NULL);
+            loop->defer.bytes -= nbytes;
+            loop->defer.count--;
+            Py_INCREF(Py_None);
+            PyList_SET_ITEM(queue, i, Py_None);
+            Py_DECREF(item);
+        }
+    }
+
+    if (loop->defer.count == 0) {
+        uv_idle_stop(&loop->defer.idle_h);
+    }
+}
+
+
+static PyObject *
+Loop_func_defer_callbacks(Loop *self, PyObject *budget)
+{
+    int i;
+    double seconds;
+
+    if (budget == Py_None) {
+        /* callbacks which are already queued still run */
+        self->defer.enabled = False;
+        Py_RETURN_NONE;
+    }
+
+    seconds = PyFloat_AsDouble(budget);
+    if (seconds == -1 && PyErr_Occurred()) {
+        return NULL;
+    }
+
+    if (seconds < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "budget must not be negative");
+        return NULL;
+    }
+
+    if (!self->defer.initialized) {
+        for (i = 0; i < PYUV_PRIORITY_LEVELS; i++) {
+            if (self->defer.queues[i] == NULL) {
+                self->defer.queues[i] = PyList_New(0);
+                if (self->defer.queues[i] == NULL) {
+                    return NULL;
+                }
+            }
+        }
+        uv_check_init(self->uv_loop, &self->defer.check_h);
+        uv_idle_init(self->uv_loop, &self->defer.idle_h);
+        self->defer.check_h.data = self;
+        self->defer.idle_h.data = self;
+        uv_check_start(&self->defer.check_h, pyuv__loop_defer_check_cb);
+        uv_unref((uv_handle_t *)&self->defer.check_h);
+        self->defer.initialized = True;
+    }
+
+    self->defer.budget = (uint64_t)(seconds * 1e9);
+    self->defer.enabled = True;
+
+    Py_RETURN_NONE;
+}
+
+
+/* The memory budget covers the data pyuv holds on behalf of the application: write queues of
+ * streams and UDP handles and deferred reads. Both are counted as requests are queued and
+ * completed, so checking the budget once per loop iteration is cheap. When it's exceeded handles
+ * are walked and the reading streams using the most memory are paused until their usage covers
+ * the excess, they are resumed once the usage falls back under the budget.
+ */
+static int pyuv__stream_read_resume(Stream *self);
+
+/* Called once a write or send request was queued, with the size of the handle queue before and
+ * after it. Returns the bytes the request added, which are given back once it completes.
+ */
+static INLINE size_t
+pyuv__loop_memory_enqueue(uv_loop_t *uv_loop, size_t before, size_t after)
+{
+    Loop *loop = (Loop *)uv_loop->data;
+    size_t queued = after > before ? after - before : 0;
+
+    loop->memory.queued += queued;
+    return queued;
+}
+
+
+static INLINE void
+pyuv__loop_memory_dequeue(uv_loop_t *uv_loop, size_t queued)
+{
+    Loop *loop = (Loop *)uv_loop->data;
+
+    if (loop != NULL) {
+        loop->memory.queued -= queued;
+    }
+}
+
+
+typedef struct {
+    size_t paused;
+    PyObject *candidates;
+    PyObject *deferred;
+} pyuv__memory_walk_ctx;
+
+
+/* Handles don't keep count of the bytes their deferred reads hold, they are added up from the
+ * queues when the budget is exceeded. Returns a dict mapping handles to their usage.
+ */
+static PyObject *
+pyuv__loop_defer_usage(Loop *loop)
+{
+    PyObject *usage, *queue, *item, *value;
+    Py_ssize_t i, nbytes;
+    int p;
+
+    usage = PyDict_New();
+    if (usage == NULL || loop->defer.bytes == 0) {
+        return usage;
+    }
+
+    for (p = 0; p < PYUV_PRIORITY_LEVELS; p++) {
+        queue = loop->defer.queues[p];
+        if (queue == NULL) {
+            continue;
+        }
+        for (i = 0; i < PyList_GET_SIZE(queue); i++) {
+            item = PyList_GET_ITEM(queue, i);
+            if (item == Py_None) {
+                continue;
+            }
+            nbytes = PyNumber_AsSsize_t(PyTuple_GET_ITEM(item, 3), NULL);
+            if (nbytes == 0) {
+                continue;
+            }
+            value = PyDict_GetItem(usage, PyTuple_GET_ITEM(item, 0));
+            if (value != NULL) {
+                nbytes += PyNumber_AsSsize_t(value, NULL);
+            }
+            value = PyInt_FromSsize_t(nbytes);
+            if (value == NULL || PyDict_SetItem(usage, PyTuple_GET_ITEM(item, 0), value) < 0) {
+                Py_XDECREF(value);
+                Py_DECREF(usage);
+                return NULL;
+            }
+            Py_DECREF(value);
+        }
+    }
+
+    return usage;
+}
+
+
+static void
+pyuv__loop_memory_walk_cb(uv_handle_t *handle, void *arg)
+{
+    pyuv__memory_walk_ctx *ctx;
+    Handle *self;
+    PyObject *item, *deferred;
+    size_t usage;
+
+    ctx = (pyuv__memory_walk_ctx *)arg;
+
+    switch (handle->type) {
+        case UV_TCP:
+        case UV_NAMED_PIPE:
+        case UV_TTY:
+            usage = ((uv_stream_t *)handle)->write_queue_size;
+            break;
+        case UV_UDP:
+            usage = ((uv_udp_t *)handle)->send_queue_size;
+            break;
+        default:
+            return;
+    }
+
+    self = (Handle *)handle->data;
+    if (!IS_PYUV_HANDLE(self) || uv_is_closing(handle)) {
+        return;
+    }
+
+    if (ctx->deferred != NULL && (deferred = PyDict_GetItem(ctx->deferred, (PyObject *)self)) != NULL) {
+        usage += (size_t)PyNumber_AsSsize_t(deferred, NULL);
+    }
+
+    if (self->flags & PYUV__PAUSED) {
+        ctx->paused += usage;
+    } else if (ctx->candidates != NULL && usage > 0 && handle->type != UV_UDP && (self->flags & PYUV__READING)) {
+        /* the position breaks ties, so that handles are never compared */
+        item = Py_BuildValue("(nnO)", (Py_ssize_t)usage, PyList_GET_SIZE(ctx->candidates), (PyObject *)self);
+        if (item == NULL || PyList_Append(ctx->candidates, item) < 0) {
+            PyErr_Clear();
+        }
+        Py_XDECREF(item);
+    }
+}
+
+
+static void
+pyuv__loop_memory_pause(Loop *loop, size_t excess)
+{
+    Py_ssize_t i;
+    size_t paused;
+    Handle *target;
+    PyObject *item;
+    pyuv__memory_walk_ctx ctx;
+
+    ctx.paused = 0;
+    ctx.candidates = PyList_New(0);
+    ctx.deferred = pyuv__loop_defer_usage(loop);
+    if (ctx.candidates == NULL || ctx.deferred == NULL) {
+        handle_uncaught_exception(loop);
+        Py_XDECREF(ctx.candidates);
+        Py_XDECREF(ctx.deferred);
+        return;
+    }
+
+    uv_walk(loop->uv_loop, pyuv__loop_memory_walk_cb, &ctx);
+    Py_DECREF(ctx.deferred);
+
+    /* biggest consumers first */
+    if (PyList_Sort(ctx.candidates) < 0 || PyList_Reverse(ctx.candidates) < 0) {
+        handle_uncaught_exception(loop);
+        Py_DECREF(ctx.candidates);
+        return;
+    }
+
+    /* streams paused earlier already account for part of the excess */
+    paused = ctx.paused;
+    for (i = 0; i < PyList_GET_SIZE(ctx.candidates) && paused < excess; i++) {
+        item = PyList_GET_ITEM(ctx.candidates, i);
+        target = (Handle *)PyTuple_GET_ITEM(item, 2);
+        if (PyList_Append(loop->memory.paused, (PyObject *)target) < 0) {
+            handle_uncaught_exception(loop);
+            break;
+        }
+        uv_read_stop((uv_stream_t *)target->uv_handle);
+        target->flags |= PYUV__PAUSED;
+        paused += (size_t)PyNumber_AsSsize_t(PyTuple_GET_ITEM(item, 0), NULL);
+    }
+
+    Py_DECREF(ctx.candidates);
+}
+
+
+static void
+pyuv__loop_memory_resume(Loop *loop)
+{
+    Py_ssize_t i;
+    Handle *target;
+    PyObject *paused;
+
+    paused = loop->memory.paused;
+    for (i = 0; i < PyList_GET_SIZE(paused); i++) {
+        target = (Handle *)PyList_GET_ITEM(paused, i);
+        /* it may have been closed or stopped by the application meanwhile */
+        if ((target->flags & PYUV__PAUSED) && !uv_is_closing(target->uv_handle)) {
+            pyuv__stream_read_resume((Stream *)target);
+        }
+        target->flags &= ~PYUV__PAUSED;
+    }
+
+    if (PyList_SetSlice(paused, 0, PyList_GET_SIZE(paused), NULL) < 0) {
+        handle_uncaught_exception(loop);
+    }
+}
+
+
+static void
+pyuv__loop_memory_notify(Loop *loop)
+{
+    PyObject *result;
+
+    if (loop->memory.on_pressure == NULL || loop->memory.on_pressure == Py_None) {
+        return;
+    }
+
+    result = PyObject_CallFunction(loop->memory.on_pressure, "OOn", (PyObject *)loop, loop->memory.pressure ? Py_True : Py_False, (Py_ssize_t)loop->memory.used);
+    if (result == NULL) {
+        handle_uncaught_exception(loop);
+    }
+    Py_XDECREF(result);
+}
+
+
+static void
+pyuv__loop_memory_check_cb(uv_check_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Loop *loop;
+
+    loop = (Loop *)handle->data;
+    Py_INCREF(loop);
+
+    loop->memory.used = loop->memory.queued + (size_t)loop->defer.bytes;
+
+    if (loop->memory.used > loop->memory.budget) {
+        /* while the pressure lasts more streams are paused, if the ones paused so far don't suffice */
+        pyuv__loop_memory_pause(loop, loop->memory.used - loop->memory.budget);
+        if (!loop->memory.pressure) {
+            loop->memory.pressure = True;
+            pyuv__loop_memory_notify(loop);
+        }
+    } else if (loop->memory.pressure) {
+        pyuv__loop_memory_resume(loop);
+        loop->memory.pressure = False;
+        pyuv__loop_memory_notify(loop);
+    }
+
+    Py_DECREF(loop);
+    PyGILState_Release(gstate);
+}
+
+
+static PyObject *
+Loop_func_set_memory_budget(Loop *self, PyObject *args, PyObject *kwargs)
+{
+    Py_ssize_t budget;
+    PyObject *tmp, *py_budget, *on_pressure;
+
+    static char *kwlist[] = {"budget", "on_pressure", NULL};
+
+    on_pressure = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O:set_memory_budget", kwlist, &py_budget, &on_pressure)) {
+        return NULL;
+    }
+
+    if (on_pressure != Py_None && !PyCallable_Check(on_pressure)) {
+        PyErr_SetString(PyExc_TypeError, "on_pressure must be a callable or None");
+        return NULL;
+    }
+
+    if (py_budget == Py_None) {
+        /* give the paused streams back */
+        if (self->memory.initialized) {
+            uv_check_stop(&self->memory.check_h);
+            pyuv__loop_memory_resume(self);
+        }
+        self->memory.pressure = False;
+        self->memory.used = 0;
+        Py_CLEAR(self->memory.on_pressure);
+        Py_RETURN_NONE;
+    }
+
+    budget = PyNumber_AsSsize_t(py_budget, PyExc_OverflowError);
+    if (budget == -1 && PyErr_Occurred()) {
+        return NULL;
+    }
+
+    if (budget <= 0) {
+        PyErr_SetString(PyExc_ValueError, "budget must be greater than 0");
+        return NULL;
+    }
+
+    if (!self->memory.initialized) {
+        self->memory.paused = PyList_New(0);
+        if (self->memory.paused == NULL) {
+            return NULL;
+        }
+        uv_check_init(self->uv_loop, &self->memory.check_h);
+        self->memory.check_h.data = self;
+        uv_unref((uv_handle_t *)&self->memory.check_h);
+        self->memory.initialized = True;
+    }
+
+    tmp = self->memory.on_pressure;
+    Py_INCREF(on_pressure);
+    self->memory.on_pressure = on_pressure;
+    Py_XDECREF(tmp);
+
+    self->memory.budget = (size_t)budget;
+    uv_check_start(&self->memory.check_h, pyuv__loop_memory_check_cb);
+
+    Py_RETURN_NONE;
+}
+
+
 static PyObject *
 Loop_func_excepthook(Loop *self, PyObject *args)
 {
@@ -301,6 +1084,22 @@ Loop_alive_get(Loop *self, void *closure)
 }
 
 
+static PyObject *
+Loop_memory_used_get(Loop *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyLong_FromSize_t(self->memory.used);
+}
+
+
+static PyObject *
+Loop_deferred_get(Loop *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyInt_FromSsize_t(self->defer.count);
+}
+
+
 static PyObject *
 Loop_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
@@ -311,7 +1110,16 @@ Loop_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static int
 Loop_tp_traverse(Loop *self, visitproc visit, void *arg)
 {
+    int i;
+
     Py_VISIT(self->dict);
+    Py_VISIT(self->sync.pending);
+    Py_VISIT(self->sched.cpus);
+    for (i = 0; i < PYUV_PRIORITY_LEVELS; i++) {
+        Py_VISIT(self->defer.queues[i]);
+    }
+    Py_VISIT(self->memory.on_pressure);
+    Py_VISIT(self->memory.paused);
     return 0;
 }
 
@@ -319,16 +1127,51 @@ Loop_tp_traverse(Loop *self, visitproc visit, void *arg)
 static int
 Loop_tp_clear(Loop *self)
 {
+    int i;
+
     Py_CLEAR(self->dict);
+    Py_CLEAR(self->sync.pending);
+    Py_CLEAR(self->sched.cpus);
+    for (i = 0; i < PYUV_PRIORITY_LEVELS; i++) {
+        Py_CLEAR(self->defer.queues[i]);
+    }
+    Py_CLEAR(self->memory.on_pressure);
+    Py_CLEAR(self->memory.paused);
+    self->defer.count = 0;
+    self->defer.bytes = 0;
     return 0;
 }
 
 
+static void
+pyuv__loop_sync_close_cb(uv_handle_t *handle)
+{
+    PyMem_Free(handle);
+}
+
+
 static void
 Loop_tp_dealloc(Loop *self)
 {
     if (self->uv_loop) {
         self->uv_loop->data = NULL;
+        if (self->defer.initialized) {
+            uv_close((uv_handle_t *)&self->defer.check_h, NULL);
+            uv_close((uv_handle_t *)&self->defer.idle_h, NULL);
+            uv_run(self->uv_loop, UV_RUN_NOWAIT);
+            self->defer.initialized = False;
+        }
+        if (self->memory.initialized) {
+            uv_close((uv_handle_t *)&self->memory.check_h, NULL);
+            uv_run(self->uv_loop, UV_RUN_NOWAIT);
+            self->memory.initialized = False;
+        }
+        if (self->sync.async) {
+            /* close the async handle shared by the loop synchronization primitives */
+            uv_close((uv_handle_t *)self->sync.async, pyuv__loop_sync_close_cb);
+            uv_run(self->uv_loop, UV_RUN_NOWAIT);
+            self->sync.async = NULL;
+        }
         uv_loop_close(self->uv_loop);
     }
     if (self->weakreflist != NULL) {
@@ -380,14 +1223,21 @@ Loop_dict_set(Loop *self, PyObject* val, void* c)
 
 static PyMethodDef
 Loop_tp_methods[] = {
-    { "run", (PyCFunction)Loop_func_run, METH_VARARGS, "Run the event loop." },
+    { "run", (PyCFunction)Loop_func_run, METH_VARARGS|METH_KEYWORDS, "Run the event loop." },
     { "stop", (PyCFunction)Loop_func_stop, METH_NOARGS, "Stop running the event loop." },
     { "now", (PyCFunction)Loop_func_now, METH_NOARGS, "Return event loop time, expressed in nanoseconds." },
     { "update_time", (PyCFunction)Loop_func_update_time, METH_NOARGS, "Update event loop's notion of time by querying the kernel." },
     { "fileno", (PyCFunction)Loop_func_fileno, METH_NOARGS, "Get the loop backend file descriptor." },
     { "get_timeout", (PyCFunction)Loop_func_get_timeout, METH_NOARGS, "Get the poll timeout, or -1 for no timeout." },
+    { "next_deadline", (PyCFunction)Loop_func_next_deadline, METH_NOARGS, "Get the time at which the loop needs to run next, expressed in nanoseconds." },
+    { "process_ready", (PyCFunction)Loop_func_process_ready, METH_NOARGS, "Run the callbacks for all the work which is ready, without blocking." },
     { "default_loop", (PyCFunction)Loop_func_default_loop, METH_CLASS|METH_NOARGS, "Instantiate the default loop." },
     { "queue_work", (PyCFunction)Loop_func_queue_work, METH_VARARGS, "Queue the given function to be run in the thread pool." },
+    { "set_affinity", (PyCFunction)Loop_func_set_affinity, METH_O, "Set the CPUs the thread running the loop may run on." },
+    { "set_scheduling", (PyCFunction)Loop_func_set_scheduling, METH_VARARGS, "Set the scheduling policy of the thread running the loop." },
+    { "run_in_thread", (PyCFunction)Loop_func_run_in_thread, METH_VARARGS|METH_KEYWORDS, "Run the loop in a new thread until it's stopped." },
+    { "defer_callbacks", (PyCFunction)Loop_func_defer_callbacks, METH_O, "Defer handle callbacks to run by priority, within a time budget per iteration." },
+    { "set_memory_budget", (PyCFunction)Loop_func_set_memory_budget, METH_VARARGS|METH_KEYWORDS, "Pause reading streams when the memory held by pyuv exceeds the given budget." },
     { "excepthook", (PyCFunction)Loop_func_excepthook, METH_VARARGS, "Loop uncaught exception handler" },
     { NULL }
 };
@@ -398,6 +1248,8 @@ static PyGetSetDef Loop_tp_getsets[] = {
     {"alive", (getter)Loop_alive_get, NULL, "Indicates if the loop is still running / alive", NULL},
     {"default", (getter)Loop_default_get, NULL, "Is this the default loop?", NULL},
     {"handles", (getter)Loop_handles_get, NULL, "Returns a list with all handles in the Loop", NULL},
+    {"deferred", (getter)Loop_deferred_get, NULL, "Number of deferred callbacks waiting to run", NULL},
+    {"memory_used", (getter)Loop_memory_used_get, NULL, "Memory held by pyuv when the budget was last checked", NULL},
     {NULL}
 };
 
@@ -0,0 +1,606 @@
+
+/*
+ * LoopEvent, LoopSemaphore and LoopLock
+ *
+ * Any thread can set or release them, callbacks waiting on them always run in the loop thread.
+ * All the state is only accessed while holding the GIL. Primitives which may have waiters to
+ * wake up are added to the loop's pending list and the async handle shared by all primitives
+ * in the loop is signalled, its callback then runs the waiters. The async handle is only
+ * referenced while there are waiters, so it doesn't keep the loop alive otherwise.
+ */
+
+static void
+pyuv__loop_sync_add_waiters(Loop *loop, Py_ssize_t n)
+{
+    Py_ssize_t waiters;
+
+    waiters = loop->sync.waiters;
+    loop->sync.waiters += n;
+
+    if (waiters == 0 && loop->sync.waiters > 0) {
+        uv_ref((uv_handle_t *)loop->sync.async);
+    } else if (waiters > 0 && loop->sync.waiters == 0) {
+        uv_unref((uv_handle_t *)loop->sync.async);
+    }
+}
+
+
+static INLINE Bool
+pyuv__loop_sync_ready(LoopSync *self)
+{
+    return PyList_GET_SIZE(self->waiters) > 0 && self->value > 0;
+}
+
+
+/* Queue the primitive for processing in the loop if some waiter can be woken up */
+static int
+pyuv__loop_sync_schedule(LoopSync *self)
+{
+    int err;
+
+    if (self->pending || !pyuv__loop_sync_ready(self)) {
+        return 0;
+    }
+
+    if (PyList_Append(self->loop->sync.pending, (PyObject *)self) != 0) {
+        return -1;
+    }
+    self->pending = True;
+
+    err = uv_async_send(self->loop->sync.async);
+    if (err < 0) {
+        RAISE_UV_EXCEPTION(err, PyExc_AsyncError);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static void
+pyuv__loop_sync_run_callback(LoopSync *self, PyObject *callback)
+{
+    PyObject *result;
+
+    result = PyObject_CallFunctionObjArgs(callback, self, NULL);
+    if (result == NULL) {
+        handle_uncaught_exception(self->loop);
+    }
+    Py_XDECREF(result);
+}
+
+
+static void
+pyuv__loop_sync_process(LoopSync *self)
+{
+    Py_ssize_t i, n;
+    PyObject *waiters, *callback;
+
+    self->pending = False;
+
+    if (self->kind == PYUV_LOOP_EVENT) {
+        if (!pyuv__loop_sync_ready(self)) {
+            return;
+        }
+        /* wake up all the waiters, new waiters added by the callbacks will wait for the next set */
+        waiters = self->waiters;
+        self->waiters = PyList_New(0);
+        if (self->waiters == NULL) {
+            self->waiters = waiters;
+            handle_uncaught_exception(self->loop);
+            return;
+        }
+        n = PyList_GET_SIZE(waiters);
+        pyuv__loop_sync_add_waiters(self->loop, -n);
+        for (i = 0; i < n; i++) {
+            pyuv__loop_sync_run_callback(self, PyList_GET_ITEM(waiters, i));
+        }
+        Py_DECREF(waiters);
+    } else {
+        /* wake up waiters in order for as long as the counter allows it */
+        while (pyuv__loop_sync_ready(self)) {
+            callback = PyList_GET_ITEM(self->waiters, 0);
+            Py_INCREF(callback);
+            if (PyList_SetSlice(self->waiters, 0, 1, NULL) != 0) {
+                Py_DECREF(callback);
+                handle_uncaught_exception(self->loop);
+                return;
+            }
+            self->value--;
+            pyuv__loop_sync_add_waiters(self->loop, -1);
+            pyuv__loop_sync_run_callback(self, callback);
+            Py_DECREF(callback);
+        }
+    }
+}
+
+
+static void
+pyuv__loop_sync_async_cb(uv_async_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Loop *loop;
+    PyObject *pending;
+    Py_ssize_t i;
+
+    ASSERT(handle);
+    loop = (Loop *)handle->data;
+
+    /* Primitives could go out of scope in the callbacks, the pending list keeps them alive */
+    pending = loop->sync.pending;
+    loop->sync.pending = PyList_New(0);
+    if (loop->sync.pending == NULL) {
+        loop->sync.pending = pending;
+        handle_uncaught_exception(loop);
+        goto done;
+    }
+
+    for (i = 0; i < PyList_GET_SIZE(pending); i++) {
+        pyuv__loop_sync_process((LoopSync *)PyList_GET_ITEM(pending, i));
+    }
+    Py_DECREF(pending);
+
+done:
+    PyGILState_Release(gstate);
+}
+
+
+static int
+pyuv__loop_sync_init(Loop *loop)
+{
+    int err;
+    uv_async_t *async;
+
+    if (loop->sync.async != NULL) {
+        return 0;
+    }
+
+    loop->sync.pending = PyList_New(0);
+    if (loop->sync.pending == NULL) {
+        return -1;
+    }
+
+    async = PyMem_Malloc(sizeof *async);
+    if (!async) {
+        Py_CLEAR(loop->sync.pending);
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    err = uv_async_init(loop->uv_loop, async, pyuv__loop_sync_async_cb);
+    if (err < 0) {
+        PyMem_Free(async);
+        Py_CLEAR(loop->sync.pending);
+        RAISE_UV_EXCEPTION(err, PyExc_AsyncError);
+        return -1;
+    }
+
+    async->data = loop;
+    uv_unref((uv_handle_t *)async);
+    loop->sync.async = async;
+    loop->sync.waiters = 0;
+
+    return 0;
+}
+
+
+static PyObject *
+pyuv__loop_sync_add_waiter(LoopSync *self, PyObject *callback)
+{
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    if (PyList_Append(self->waiters, callback) != 0) {
+        return NULL;
+    }
+    pyuv__loop_sync_add_waiters(self->loop, 1);
+
+    if (pyuv__loop_sync_schedule(self) != 0) {
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+LoopSync_func_set(LoopSync *self)
+{
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    self->value = 1;
+    if (pyuv__loop_sync_schedule(self) != 0) {
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+LoopSync_func_clear(LoopSync *self)
+{
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    self->value = 0;
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+LoopSync_func_is_set(LoopSync *self)
+{
+    return PyBool_FromLong((long)(self->value > 0));
+}
+
+
+static PyObject *
+LoopSync_func_wait(LoopSync *self, PyObject *callback)
+{
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    return pyuv__loop_sync_add_waiter(self, callback);
+}
+
+
+static PyObject *
+LoopSync_func_acquire(LoopSync *self, PyObject *callback)
+{
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    return pyuv__loop_sync_add_waiter(self, callback);
+}
+
+
+static PyObject *
+LoopSync_func_try_acquire(LoopSync *self)
+{
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    /* don't jump ahead of the waiting callbacks */
+    if (self->value == 0 || PyList_GET_SIZE(self->waiters) > 0) {
+        Py_RETURN_FALSE;
+    }
+
+    self->value--;
+    Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+LoopSync_func_release(LoopSync *self)
+{
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    if (self->kind == PYUV_LOOP_LOCK && self->value > 0) {
+        PyErr_SetString(PyExc_RuntimeError, "release unlocked lock");
+        return NULL;
+    }
+
+    self->value++;
+    if (pyuv__loop_sync_schedule(self) != 0) {
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+LoopSync_func_locked(LoopSync *self)
+{
+    return PyBool_FromLong((long)(self->value == 0));
+}
+
+
+static PyObject *
+LoopSync_loop_get(LoopSync *self, void *closure)
+{
+    UNUSED_ARG(closure);
+
+    if (self->loop == NULL) {
+        Py_RETURN_NONE;
+    }
+
+    Py_INCREF(self->loop);
+    return (PyObject *)self->loop;
+}
+
+
+static PyObject *
+LoopSync_waiters_get(LoopSync *self, void *closure)
+{
+    UNUSED_ARG(closure);
+
+    return PyInt_FromSsize_t(self->waiters ? PyList_GET_SIZE(self->waiters) : 0);
+}
+
+
+static PyObject *
+LoopSync_value_get(LoopSync *self, void *closure)
+{
+    UNUSED_ARG(closure);
+
+    return PyInt_FromSsize_t(self->value);
+}
+
+
+static int
+LoopSync_tp_init(LoopSync *self, PyObject *args, PyObject *kwargs)
+{
+    Loop *loop;
+    Py_ssize_t value;
+
+    static char *kwlist[] = {"loop", "value", NULL};
+    static char *kwlist_noval[] = {"loop", NULL};
+
+    RAISE_IF_INITIALIZED(self, -1);
+
+    value = self->kind == PYUV_LOOP_EVENT ? 0 : 1;
+
+    if (self->kind == PYUV_LOOP_SEMAPHORE) {
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|n:__init__", kwlist, &LoopType, &loop, &value)) {
+            return -1;
+        }
+        if (value < 0) {
+            PyErr_SetString(PyExc_ValueError, "initial value must be >= 0");
+            return -1;
+        }
+    } else {
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!:__init__", kwlist_noval, &LoopType, &loop)) {
+            return -1;
+        }
+    }
+
+    if (pyuv__loop_sync_init(loop) != 0) {
+        return -1;
+    }
+
+    self->waiters = PyList_New(0);
+    if (self->waiters == NULL) {
+        return -1;
+    }
+
+    Py_INCREF(loop);
+    self->loop = loop;
+    self->value = value;
+    self->initialized = True;
+
+    return 0;
+}
+
+
+static PyObject *
+LoopSync_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    LoopSync *self;
+
+    self = (LoopSync *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->initialized = False;
+    self->pending = False;
+    self->weakreflist = NULL;
+    if (PyType_IsSubtype(type, &LoopSemaphoreType)) {
+        self->kind = PYUV_LOOP_SEMAPHORE;
+    } else if (PyType_IsSubtype(type, &LoopLockType)) {
+        self->kind = PYUV_LOOP_LOCK;
+    } else {
+        self->kind = PYUV_LOOP_EVENT;
+    }
+    return (PyObject *)self;
+}
+
+
+static int
+LoopSync_tp_traverse(LoopSync *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->waiters);
+    Py_VISIT(self->loop);
+    return 0;
+}
+
+
+static int
+LoopSync_tp_clear(LoopSync *self)
+{
+    if (self->waiters != NULL && self->loop != NULL) {
+        pyuv__loop_sync_add_waiters(self->loop, -PyList_GET_SIZE(self->waiters));
+    }
+    Py_CLEAR(self->waiters);
+    Py_CLEAR(self->loop);
+    return 0;
+}
+
+
+static void
+LoopSync_tp_dealloc(LoopSync *self)
+{
+    PyObject_GC_UnTrack(self);
+    if (self->weakreflist != NULL) {
+        PyObject_ClearWeakRefs((PyObject *)self);
+    }
+    LoopSync_tp_clear(self);
+    Py_TYPE(self)->tp_free(self);
+}
+
+
+static PyMethodDef
+LoopEvent_tp_methods[] = {
+    { "set", (PyCFunction)LoopSync_func_set, METH_NOARGS, "Set the event, waking up all the waiters. Can be called from any thread." },
+    { "clear", (PyCFunction)LoopSync_func_clear, METH_NOARGS, "Reset the event." },
+    { "is_set", (PyCFunction)LoopSync_func_is_set, METH_NOARGS, "Return True if the event is set." },
+    { "wait", (PyCFunction)LoopSync_func_wait, METH_O, "Call the given function in the loop once the event is set." },
+    { NULL }
+};
+
+
+static PyMethodDef
+LoopSemaphore_tp_methods[] = {
+    { "acquire", (PyCFunction)LoopSync_func_acquire, METH_O, "Call the given function in the loop once the semaphore has been acquired." },
+    { "try_acquire", (PyCFunction)LoopSync_func_try_acquire, METH_NOARGS, "Acquire the semaphore if it can be done without waiting." },
+    { "release", (PyCFunction)LoopSync_func_release, METH_NOARGS, "Release the semaphore. Can be called from any thread." },
+    { NULL }
+};
+
+
+static PyMethodDef
+LoopLock_tp_methods[] = {
+    { "acquire", (PyCFunction)LoopSync_func_acquire, METH_O, "Call the given function in the loop once the lock has been acquired." },
+    { "try_acquire", (PyCFunction)LoopSync_func_try_acquire, METH_NOARGS, "Acquire the lock if it can be done without waiting." },
+    { "release", (PyCFunction)LoopSync_func_release, METH_NOARGS, "Release the lock. Can be called from any thread." },
+    { "locked", (PyCFunction)LoopSync_func_locked, METH_NOARGS, "Return True if the lock is held." },
+    { NULL }
+};
+
+
+static PyGetSetDef LoopEvent_tp_getsets[] = {
+    {"loop", (getter)LoopSync_loop_get, NULL, "Loop where the callbacks are run.", NULL},
+    {"waiters", (getter)LoopSync_waiters_get, NULL, "Number of waiting callbacks.", NULL},
+    {NULL}
+};
+
+
+static PyGetSetDef LoopSemaphore_tp_getsets[] = {
+    {"loop", (getter)LoopSync_loop_get, NULL, "Loop where the callbacks are run.", NULL},
+    {"waiters", (getter)LoopSync_waiters_get, NULL, "Number of waiting callbacks.", NULL},
+    {"value", (getter)LoopSync_value_get, NULL, "Current value of the semaphore counter.", NULL},
+    {NULL}
+};
+
+
+static PyGetSetDef LoopLock_tp_getsets[] = {
+    {"loop", (getter)LoopSync_loop_get, NULL, "Loop where the callbacks are run.", NULL},
+    {"waiters", (getter)LoopSync_waiters_get, NULL, "Number of waiting callbacks.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject LoopEventType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.LoopEvent",                                        /*tp_name*/
+    sizeof(LoopSync),                                               /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)LoopSync_tp_dealloc,                                /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)LoopSync_tp_traverse,                             /*tp_traverse*/
+    (inquiry)LoopSync_tp_clear,                                     /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    offsetof(LoopSync, weakreflist),                                /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    LoopEvent_tp_methods,                                           /*tp_methods*/
+    0,                                                              /*tp_members*/
+    LoopEvent_tp_getsets,                                           /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)LoopSync_tp_init,                                     /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    LoopSync_tp_new,                                                /*tp_new*/
+};
+
+
+static PyTypeObject LoopSemaphoreType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.LoopSemaphore",                                    /*tp_name*/
+    sizeof(LoopSync),                                               /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)LoopSync_tp_dealloc,                                /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)LoopSync_tp_traverse,                             /*tp_traverse*/
+    (inquiry)LoopSync_tp_clear,                                     /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    offsetof(LoopSync, weakreflist),                                /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    LoopSemaphore_tp_methods,                                       /*tp_methods*/
+    0,                                                              /*tp_members*/
+    LoopSemaphore_tp_getsets,                                       /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)LoopSync_tp_init,                                     /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    LoopSync_tp_new,                                                /*tp_new*/
+};
+
+
+static PyTypeObject LoopLockType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.LoopLock",                                         /*tp_name*/
+    sizeof(LoopSync),                                               /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)LoopSync_tp_dealloc,                                /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)LoopSync_tp_traverse,                             /*tp_traverse*/
+    (inquiry)LoopSync_tp_clear,                                     /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    offsetof(LoopSync, weakreflist),                                /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    LoopLock_tp_methods,                                            /*tp_methods*/
+    0,                                                              /*tp_members*/
+    LoopLock_tp_getsets,                                            /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)LoopSync_tp_init,                                     /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    LoopSync_tp_new,                                                /*tp_new*/
+};
@@ -14,18 +14,22 @@ pyuv__pipe_listen_cb(uv_stream_t* handle, int status)
 
     if (status != 0) {
         py_errorno = PyInt_FromLong((long)status);
+    } else if (!pyuv__stream_accept_admit((Stream *)self)) {
+        /* reset or left pending by the accept policy */
+        goto done;
     } else {
         py_errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(self->on_new_connection_cb, self, py_errorno, NULL);
+    result = PyObject_CallFunctionObjArgs(self->stream.on_read_cb, self, py_errorno, NULL);
     if (result == NULL) {
         handle_uncaught_exception(HANDLE(self)->loop);
     }
     Py_XDECREF(result);
     Py_DECREF(py_errorno);
 
+done:
     Py_DECREF(self);
     PyGILState_Release(gstate);
 }
@@ -118,16 +122,24 @@ Pipe_func_listen(Pipe *self, PyObject *args)
         return NULL;
     }
 
+    /* a reading stream can't listen, the callback slot is shared */
+    if (self->stream.on_read_cb != NULL && !(HANDLE(self)->flags & PYUV__LISTENING)) {
+        RAISE_UV_EXCEPTION(UV_EINVAL, PyExc_PipeError);
+        return NULL;
+    }
+
     err = uv_listen((uv_stream_t *)&self->pipe_h, backlog, pyuv__pipe_listen_cb);
     if (err < 0) {
         RAISE_UV_EXCEPTION(err, PyExc_PipeError);
         return NULL;
     }
 
-    tmp = self->on_new_connection_cb;
+    tmp = self->stream.on_read_cb;
     Py_INCREF(callback);
-    self->on_new_connection_cb = callback;
+    self->stream.on_read_cb = callback;
     Py_XDECREF(tmp);
+    HANDLE(self)->flags |= PYUV__LISTENING;
+    pyuv__handle_gc_track(HANDLE(self));
 
     Py_RETURN_NONE;
 }
@@ -164,6 +176,10 @@ Pipe_func_accept(Pipe *self, PyObject *args)
         return NULL;
     }
 
+    if (PyObject_IsSubclass((PyObject *)client->ob_type, (PyObject *)&StreamType) && pyuv__stream_accept_track((Stream *)self, (Stream *)client) < 0) {
+        return NULL;
+    }
+
     Py_RETURN_NONE;
 }
 
@@ -249,6 +265,16 @@ Pipe_func_pending_instances(Pipe *self, PyObject *args)
 }
 
 
+static PyObject *
+Pipe_func_set_accept_policy(Pipe *self, PyObject *args, PyObject *kwargs)
+{
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    return pyuv__stream_set_accept_policy((Stream *)self, args, kwargs, PyExc_PipeError);
+}
+
+
 static PyObject *
 Pipe_func_pending_handle_type(Pipe *self)
 {
@@ -521,7 +547,6 @@ Pipe_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static int
 Pipe_tp_traverse(Pipe *self, visitproc visit, void *arg)
 {
-    Py_VISIT(self->on_new_connection_cb);
     return StreamType.tp_traverse((PyObject *)self, visit, arg);
 }
 
@@ -529,7 +554,6 @@ Pipe_tp_traverse(Pipe *self, visitproc visit, void *arg)
 static int
 Pipe_tp_clear(Pipe *self)
 {
-    Py_CLEAR(self->on_new_connection_cb);
     return StreamType.tp_clear((PyObject *)self);
 }
 
@@ -539,6 +563,7 @@ Pipe_tp_methods[] = {
     { "bind", (PyCFunction)Pipe_func_bind, METH_VARARGS, "Bind to the specified Pipe name." },
     { "listen", (PyCFunction)Pipe_func_listen, METH_VARARGS, "Start listening for connections on the Pipe." },
     { "accept", (PyCFunction)Pipe_func_accept, METH_VARARGS, "Accept incoming connection." },
+    { "set_accept_policy", (PyCFunction)Pipe_func_set_accept_policy, METH_VARARGS|METH_KEYWORDS, "Limit the number of active connections and the rate at which they are accepted." },
     { "connect", (PyCFunction)Pipe_func_connect, METH_VARARGS, "Start connecion to the remote Pipe." },
     { "open", (PyCFunction)Pipe_func_open, METH_VARARGS, "Open the specified file descriptor and manage it as a Pipe." },
     { "pending_instances", (PyCFunction)Pipe_func_pending_instances, METH_VARARGS, "Set the number of pending pipe instance handles when the pipe server is waiting for connections." },
@@ -224,3 +224,605 @@ static PyTypeObject PollType = {
     Poll_tp_new,                                                    /*tp_new*/
 };
 
+
+
+/* PollGroup: monitors many file descriptors with a single handle. Each descriptor gets its own
+ * uv_poll_t, but readiness is only recorded (without taking the GIL) when it fires, and all the
+ * descriptors which became ready during the poll phase are delivered in a single callback from
+ * the check phase of the same loop iteration.
+ */
+
+#define PYUV__POLL_GROUP_EVENTS (UV_READABLE | UV_WRITABLE | UV_DISCONNECT)
+
+struct pyuv__poll_group_entry_s {
+    uv_poll_t poll_h;
+    PollGroup *group;
+    PyObject *token;
+    long fd;
+    int events;
+    int revents;
+    Bool queued;
+};
+
+
+static void
+pyuv__poll_group_entry_close_cb(uv_handle_t *handle)
+{
+    free(PYUV_CONTAINER_OF(handle, pyuv__poll_group_entry, poll_h));
+}
+
+
+static void
+pyuv__poll_group_check_cb(uv_check_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    PollGroup *self;
+    PyObject *ready, *item, *result;
+    pyuv__poll_group_entry *entry;
+    Py_ssize_t i;
+
+    ASSERT(handle);
+
+    self = PYUV_CONTAINER_OF(handle, PollGroup, check_h);
+
+    /* Object could go out of scope in the callback, increase refcount to avoid it */
+    Py_INCREF(self);
+
+    uv_check_stop(handle);
+
+    ready = PyList_New(self->ready_count);
+    if (!ready) {
+        handle_uncaught_exception(HANDLE(self)->loop);
+        goto end;
+    }
+
+    for (i = 0; i < self->ready_count; i++) {
+        entry = self->ready[i];
+        item = Py_BuildValue("(Oi)", entry->token, entry->revents);
+        if (!item) {
+            PyErr_Clear();
+            Py_INCREF(Py_None);
+            item = Py_None;
+        }
+        PyList_SET_ITEM(ready, i, item);
+        entry->revents = 0;
+        entry->queued = False;
+    }
+    self->ready_count = 0;
+
+    if (self->callback) {
+        result = PyObject_CallFunctionObjArgs(self->callback, self, ready, NULL);
+        if (result == NULL) {
+            handle_uncaught_exception(HANDLE(self)->loop);
+        }
+        Py_XDECREF(result);
+    }
+    Py_DECREF(ready);
+
+end:
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+/* Called without the GIL, it only records the events */
+static void
+pyuv__poll_group_poll_cb(uv_poll_t *handle, int status, int events)
+{
+    pyuv__poll_group_entry *entry;
+    PollGroup *group;
+
+    entry = PYUV_CONTAINER_OF(handle, pyuv__poll_group_entry, poll_h);
+    group = entry->group;
+
+    /* on error the descriptor is reported as ready for everything it was registered for, so that
+     * the actual error is raised by the next I/O operation on it */
+    entry->revents |= status < 0 ? entry->events : events;
+
+    if (!entry->queued) {
+        /* ready has room for every entry, see PollGroup_func_add */
+        group->ready[group->ready_count++] = entry;
+        entry->queued = True;
+        if (group->ready_count == 1 && !uv_is_closing((uv_handle_t *)&group->check_h)) {
+            uv_check_start(&group->check_h, pyuv__poll_group_check_cb);
+        }
+    }
+}
+
+
+static pyuv__poll_group_entry *
+pyuv__poll_group_lookup(PollGroup *self, PyObject *key)
+{
+    PyObject *capsule = PyDict_GetItem(self->entries, key);
+    if (!capsule) {
+        return NULL;
+    }
+    return PyCapsule_GetPointer(capsule, NULL);
+}
+
+
+static void
+pyuv__poll_group_unqueue(PollGroup *self, pyuv__poll_group_entry *entry)
+{
+    Py_ssize_t i;
+
+    if (!entry->queued) {
+        return;
+    }
+
+    for (i = 0; i < self->ready_count; i++) {
+        if (self->ready[i] == entry) {
+            memmove(&self->ready[i], &self->ready[i+1], sizeof(*self->ready) * (self->ready_count - i - 1));
+            self->ready_count--;
+            break;
+        }
+    }
+
+    entry->queued = False;
+    entry->revents = 0;
+}
+
+
+static int
+pyuv__poll_group_entry_start(PollGroup *self, pyuv__poll_group_entry *entry)
+{
+    if (self->callback && entry->events) {
+        return uv_poll_start(&entry->poll_h, entry->events, pyuv__poll_group_poll_cb);
+    }
+    return uv_poll_stop(&entry->poll_h);
+}
+
+
+static void
+pyuv__poll_group_clear(PollGroup *self)
+{
+    Py_ssize_t pos;
+    PyObject *key, *value;
+    pyuv__poll_group_entry *entry;
+
+    if (self->entries) {
+        pos = 0;
+        while (PyDict_Next(self->entries, &pos, &key, &value)) {
+            entry = PyCapsule_GetPointer(value, NULL);
+            Py_CLEAR(entry->token);
+            uv_close((uv_handle_t *)&entry->poll_h, pyuv__poll_group_entry_close_cb);
+        }
+        PyDict_Clear(self->entries);
+    }
+
+    self->ready_count = 0;
+}
+
+
+static PyObject *
+PollGroup_func_add(PollGroup *self, PyObject *args)
+{
+    int err, events;
+    long fd;
+    PyObject *token, *key, *capsule;
+    pyuv__poll_group_entry *entry, **ready;
+    Py_ssize_t ready_size;
+
+    token = Py_None;
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "li|O:add", &fd, &events, &token)) {
+        return NULL;
+    }
+
+    if (events & ~PYUV__POLL_GROUP_EVENTS) {
+        PyErr_SetString(PyExc_ValueError, "invalid events specified");
+        return NULL;
+    }
+
+    key = PyInt_FromLong(fd);
+    if (!key) {
+        return NULL;
+    }
+
+    if (pyuv__poll_group_lookup(self, key)) {
+        Py_DECREF(key);
+        RAISE_UV_EXCEPTION(UV_EEXIST, PyExc_PollError);
+        return NULL;
+    }
+
+    /* make sure the poll callback never needs to grow the ready array */
+    ready_size = PyDict_Size(self->entries) + 1;
+    if (ready_size > self->ready_size) {
+        ready_size = self->ready_size ? self->ready_size * 2 : 16;
+        ready = realloc(self->ready, sizeof(*ready) * ready_size);
+        if (!ready) {
+            Py_DECREF(key);
+            return PyErr_NoMemory();
+        }
+        self->ready = ready;
+        self->ready_size = ready_size;
+    }
+
+    entry = calloc(1, sizeof *entry);
+    if (!entry) {
+        Py_DECREF(key);
+        return PyErr_NoMemory();
+    }
+
+    err = uv_poll_init_socket(HANDLE(self)->loop->uv_loop, &entry->poll_h, (uv_os_sock_t)fd);
+    if (err < 0) {
+        Py_DECREF(key);
+        free(entry);
+        RAISE_UV_EXCEPTION(err, PyExc_PollError);
+        return NULL;
+    }
+
+    entry->group = self;
+    entry->fd = fd;
+    entry->events = events;
+    Py_INCREF(token);
+    entry->token = token;
+
+    capsule = PyCapsule_New(entry, NULL, NULL);
+    if (!capsule || PyDict_SetItem(self->entries, key, capsule) != 0) {
+        Py_XDECREF(capsule);
+        Py_DECREF(key);
+        Py_CLEAR(entry->token);
+        uv_close((uv_handle_t *)&entry->poll_h, pyuv__poll_group_entry_close_cb);
+        return NULL;
+    }
+    Py_DECREF(capsule);
+
+    err = pyuv__poll_group_entry_start(self, entry);
+    if (err < 0) {
+        PyDict_DelItem(self->entries, key);
+        Py_DECREF(key);
+        Py_CLEAR(entry->token);
+        uv_close((uv_handle_t *)&entry->poll_h, pyuv__poll_group_entry_close_cb);
+        RAISE_UV_EXCEPTION(err, PyExc_PollError);
+        return NULL;
+    }
+
+    Py_DECREF(key);
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+PollGroup_func_modify(PollGroup *self, PyObject *args)
+{
+    int err, events;
+    long fd;
+    PyObject *token, *key, *tmp;
+    pyuv__poll_group_entry *entry;
+
+    token = NULL;
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "li|O:modify", &fd, &events, &token)) {
+        return NULL;
+    }
+
+    if (events & ~PYUV__POLL_GROUP_EVENTS) {
+        PyErr_SetString(PyExc_ValueError, "invalid events specified");
+        return NULL;
+    }
+
+    key = PyInt_FromLong(fd);
+    if (!key) {
+        return NULL;
+    }
+    entry = pyuv__poll_group_lookup(self, key);
+    Py_DECREF(key);
+    if (!entry) {
+        RAISE_UV_EXCEPTION(UV_ENOENT, PyExc_PollError);
+        return NULL;
+    }
+
+    if (token) {
+        tmp = entry->token;
+        Py_INCREF(token);
+        entry->token = token;
+        Py_DECREF(tmp);
+    }
+
+    entry->events = events;
+    /* drop the events which were not asked for anymore */
+    entry->revents &= events;
+    if (entry->queued && !entry->revents) {
+        pyuv__poll_group_unqueue(self, entry);
+    }
+
+    err = pyuv__poll_group_entry_start(self, entry);
+    if (err < 0) {
+        RAISE_UV_EXCEPTION(err, PyExc_PollError);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+PollGroup_func_remove(PollGroup *self, PyObject *args)
+{
+    long fd;
+    PyObject *key;
+    pyuv__poll_group_entry *entry;
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "l:remove", &fd)) {
+        return NULL;
+    }
+
+    key = PyInt_FromLong(fd);
+    if (!key) {
+        return NULL;
+    }
+    entry = pyuv__poll_group_lookup(self, key);
+    if (!entry) {
+        Py_DECREF(key);
+        RAISE_UV_EXCEPTION(UV_ENOENT, PyExc_PollError);
+        return NULL;
+    }
+
+    pyuv__poll_group_unqueue(self, entry);
+    Py_CLEAR(entry->token);
+    /* the descriptor can be closed right away, the entry memory is released in the close callback */
+    uv_close((uv_handle_t *)&entry->poll_h, pyuv__poll_group_entry_close_cb);
+
+    if (PyDict_DelItem(self->entries, key) != 0) {
+        Py_DECREF(key);
+        return NULL;
+    }
+    Py_DECREF(key);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+PollGroup_func_start(PollGroup *self, PyObject *args)
+{
+    int err;
+    Py_ssize_t pos;
+    PyObject *tmp, *callback, *key, *value;
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "O:start", &callback)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    tmp = self->callback;
+    Py_INCREF(callback);
+    self->callback = callback;
+
+    if (!tmp) {
+        pos = 0;
+        while (PyDict_Next(self->entries, &pos, &key, &value)) {
+            err = pyuv__poll_group_entry_start(self, PyCapsule_GetPointer(value, NULL));
+            if (err < 0) {
+                RAISE_UV_EXCEPTION(err, PyExc_PollError);
+                return NULL;
+            }
+        }
+    }
+    Py_XDECREF(tmp);
+
+    PYUV_HANDLE_INCREF(self);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+PollGroup_func_stop(PollGroup *self)
+{
+    Py_ssize_t pos;
+    PyObject *key, *value;
+    pyuv__poll_group_entry *entry;
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    pos = 0;
+    while (PyDict_Next(self->entries, &pos, &key, &value)) {
+        entry = PyCapsule_GetPointer(value, NULL);
+        uv_poll_stop(&entry->poll_h);
+        entry->revents = 0;
+        entry->queued = False;
+    }
+    self->ready_count = 0;
+    uv_check_stop(&self->check_h);
+
+    Py_CLEAR(self->callback);
+
+    PYUV_HANDLE_DECREF(self);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+PollGroup_func_close(PollGroup *self, PyObject *args)
+{
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    pyuv__poll_group_clear(self);
+
+    return Handle_func_close(HANDLE(self), args);
+}
+
+
+static Py_ssize_t
+PollGroup_tp_len(PollGroup *self)
+{
+    return PyDict_Size(self->entries);
+}
+
+
+static int
+PollGroup_tp_contains(PollGroup *self, PyObject *fd)
+{
+    return PyDict_Contains(self->entries, fd);
+}
+
+
+static int
+PollGroup_tp_init(PollGroup *self, PyObject *args, PyObject *kwargs)
+{
+    int err;
+    Loop *loop;
+
+    UNUSED_ARG(kwargs);
+
+    RAISE_IF_HANDLE_INITIALIZED(self, -1);
+
+    if (!PyArg_ParseTuple(args, "O!:__init__", &LoopType, &loop)) {
+        return -1;
+    }
+
+    err = uv_check_init(loop->uv_loop, &self->check_h);
+    if (err < 0) {
+        RAISE_UV_EXCEPTION(err, PyExc_PollError);
+        return -1;
+    }
+
+    initialize_handle(HANDLE(self), loop);
+
+    return 0;
+}
+
+
+static PyObject *
+PollGroup_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    PollGroup *self;
+
+    self = (PollGroup *)HandleType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+
+    self->entries = PyDict_New();
+    if (!self->entries) {
+        Py_DECREF(self);
+        return NULL;
+    }
+
+    self->check_h.data = self;
+    UV_HANDLE(self) = (uv_handle_t *)&self->check_h;
+
+    return (PyObject *)self;
+}
+
+
+static int
+PollGroup_tp_traverse(PollGroup *self, visitproc visit, void *arg)
+{
+    Py_ssize_t pos;
+    PyObject *key, *value;
+    pyuv__poll_group_entry *entry;
+
+    if (self->entries) {
+        pos = 0;
+        while (PyDict_Next(self->entries, &pos, &key, &value)) {
+            entry = PyCapsule_GetPointer(value, NULL);
+            Py_VISIT(entry->token);
+        }
+    }
+    Py_VISIT(self->callback);
+    return HandleType.tp_traverse((PyObject *)self, visit, arg);
+}
+
+
+static int
+PollGroup_tp_clear(PollGroup *self)
+{
+    /* the entries need the loop, close them before it's released */
+    if (HANDLE(self)->initialized) {
+        pyuv__poll_group_clear(self);
+    }
+    Py_CLEAR(self->entries);
+    Py_CLEAR(self->callback);
+    free(self->ready);
+    self->ready = NULL;
+    self->ready_size = 0;
+    return HandleType.tp_clear((PyObject *)self);
+}
+
+
+static PySequenceMethods PollGroup_tp_as_sequence = {
+    (lenfunc)PollGroup_tp_len,                                      /*sq_length*/
+    0,                                                              /*sq_concat*/
+    0,                                                              /*sq_repeat*/
+    0,                                                              /*sq_item*/
+    0,                                                              /*sq_slice*/
+    0,                                                              /*sq_ass_item*/
+    0,                                                              /*sq_ass_slice*/
+    (objobjproc)PollGroup_tp_contains,                              /*sq_contains*/
+};
+
+
+static PyMethodDef
+PollGroup_tp_methods[] = {
+    { "add", (PyCFunction)PollGroup_func_add, METH_VARARGS, "Start monitoring the given file descriptor." },
+    { "modify", (PyCFunction)PollGroup_func_modify, METH_VARARGS, "Change the events (and optionally the token) of a monitored file descriptor." },
+    { "remove", (PyCFunction)PollGroup_func_remove, METH_VARARGS, "Stop monitoring the given file descriptor." },
+    { "start", (PyCFunction)PollGroup_func_start, METH_VARARGS, "Start delivering events." },
+    { "stop", (PyCFunction)PollGroup_func_stop, METH_NOARGS, "Stop delivering events." },
+    { "close", (PyCFunction)PollGroup_func_close, METH_VARARGS, "Close the handle and stop monitoring all file descriptors." },
+    { NULL }
+};
+
+
+static PyTypeObject PollGroupType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.PollGroup",                                        /*tp_name*/
+    sizeof(PollGroup),                                              /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    0,                                                              /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    &PollGroup_tp_as_sequence,                                      /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)PollGroup_tp_traverse,                            /*tp_traverse*/
+    (inquiry)PollGroup_tp_clear,                                    /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    PollGroup_tp_methods,                                           /*tp_methods*/
+    0,                                                              /*tp_members*/
+    0,                                                              /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)PollGroup_tp_init,                                    /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    PollGroup_tp_new,                                               /*tp_new*/
+};
@@ -169,8 +169,161 @@ static PyTypeObject StdIOType = {
 
 /* Process handle */
 
-/* forward declaration */
+/* forward declarations */
 static PyObject* Process_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs);
+static void pyuv__process_run_exit(pyuv__process_run_ctx *ctx, int64_t exit_status, int term_signal);
+
+
+/* Child resource usage. On Linux a pidfd becomes readable as soon as the child turns into a
+ * zombie, at that point waitid(2) is used with WNOWAIT to peek at its resource usage, leaving it
+ * for libuv to reap. libuv runs signal watchers (and thus child reaping) after all other I/O
+ * watchers in a loop iteration, so the child is still there when the poll callback runs.
+ */
+
+#ifdef PYUV_LINUX
+
+#ifndef __NR_pidfd_open
+# define __NR_pidfd_open 434
+#endif
+
+struct pyuv__process_rusage_watcher_s {
+    uv_poll_t poll_h;
+    int pid;
+    int pidfd;
+    Bool collected;
+    struct rusage ru;
+};
+
+
+static void
+pyuv__process_rusage_close_cb(uv_handle_t *handle)
+{
+    pyuv__process_rusage_watcher *watcher = PYUV_CONTAINER_OF(handle, pyuv__process_rusage_watcher, poll_h);
+    close(watcher->pidfd);
+    free(watcher);
+}
+
+
+static void
+pyuv__process_rusage_poll_cb(uv_poll_t *handle, int status, int events)
+{
+    int r;
+    siginfo_t info;
+    pyuv__process_rusage_watcher *watcher;
+
+    UNUSED_ARG(events);
+
+    watcher = PYUV_CONTAINER_OF(handle, pyuv__process_rusage_watcher, poll_h);
+
+    if (status == 0) {
+        memset(&info, 0, sizeof(info));
+        /* the glibc wrapper doesn't expose the rusage argument */
+        do {
+            r = syscall(SYS_waitid, P_PID, (id_t)watcher->pid, &info, WEXITED | WNOHANG | WNOWAIT, &watcher->ru);
+        } while (r == -1 && errno == EINTR);
+        if (r == 0 && info.si_pid == 0) {
+            /* not ready yet */
+            return;
+        }
+        watcher->collected = (r == 0);
+    }
+
+    uv_poll_stop(handle);
+}
+
+
+static void
+pyuv__process_rusage_start(Process *self)
+{
+    int pidfd;
+    pyuv__process_rusage_watcher *watcher;
+
+    pidfd = (int)syscall(__NR_pidfd_open, self->process_h.pid, 0);
+    if (pidfd == -1) {
+        /* not supported by the running kernel */
+        return;
+    }
+
+    watcher = calloc(1, sizeof *watcher);
+    if (!watcher) {
+        close(pidfd);
+        return;
+    }
+    watcher->pid = self->process_h.pid;
+    watcher->pidfd = pidfd;
+
+    if (uv_poll_init(UV_HANDLE_LOOP(self), &watcher->poll_h, pidfd) != 0) {
+        close(pidfd);
+        free(watcher);
+        return;
+    }
+    uv_unref((uv_handle_t *)&watcher->poll_h);
+    uv_poll_start(&watcher->poll_h, UV_READABLE, pyuv__process_rusage_poll_cb);
+
+    self->rusage_watcher = watcher;
+}
+
+
+/* Must be called with the GIL held */
+static void
+pyuv__process_rusage_stop(Process *self)
+{
+    uv_rusage_t ru;
+    PyObject *tmp, *result;
+    pyuv__process_rusage_watcher *watcher = self->rusage_watcher;
+
+    if (!watcher) {
+        return;
+    }
+    self->rusage_watcher = NULL;
+
+    if (watcher->collected) {
+        ru.ru_utime.tv_sec = watcher->ru.ru_utime.tv_sec;
+        ru.ru_utime.tv_usec = watcher->ru.ru_utime.tv_usec;
+        ru.ru_stime.tv_sec = watcher->ru.ru_stime.tv_sec;
+        ru.ru_stime.tv_usec = watcher->ru.ru_stime.tv_usec;
+        ru.ru_maxrss = watcher->ru.ru_maxrss;
+        ru.ru_ixrss = watcher->ru.ru_ixrss;
+        ru.ru_idrss = watcher->ru.ru_idrss;
+        ru.ru_isrss = watcher->ru.ru_isrss;
+        ru.ru_minflt = watcher->ru.ru_minflt;
+        ru.ru_majflt = watcher->ru.ru_majflt;
+        ru.ru_nswap = watcher->ru.ru_nswap;
+        ru.ru_inblock = watcher->ru.ru_inblock;
+        ru.ru_oublock = watcher->ru.ru_oublock;
+        ru.ru_msgsnd = watcher->ru.ru_msgsnd;
+        ru.ru_msgrcv = watcher->ru.ru_msgrcv;
+        ru.ru_nsignals = watcher->ru.ru_nsignals;
+        ru.ru_nvcsw = watcher->ru.ru_nvcsw;
+        ru.ru_nivcsw = watcher->ru.ru_nivcsw;
+        result = pyuv__rusage_result_new(&ru);
+        if (result == NULL) {
+            handle_uncaught_exception(HANDLE(self)->loop);
+        } else {
+            tmp = self->rusage;
+            self->rusage = result;
+            Py_XDECREF(tmp);
+        }
+    }
+
+    uv_close((uv_handle_t *)&watcher->poll_h, pyuv__process_rusage_close_cb);
+}
+
+#else
+
+static INLINE void
+pyuv__process_rusage_start(Process *self)
+{
+    UNUSED_ARG(self);
+}
+
+static INLINE void
+pyuv__process_rusage_stop(Process *self)
+{
+    UNUSED_ARG(self);
+}
+
+#endif
 
 
 static void
@@ -184,6 +337,15 @@ pyuv__process_exit_cb(uv_process_t *handle, int64_t exit_status, int term_signal
 
     self = PYUV_CONTAINER_OF(handle, Process, process_h);
 
+    pyuv__process_rusage_stop(self);
+
+    if (self->run_ctx) {
+        pyuv__process_run_exit(self->run_ctx, exit_status, term_signal);
+        Py_DECREF(self);
+        PyGILState_Release(gstate);
+        return;
+    }
+
     py_exit_status = PyInt_FromLong(exit_status);
     py_term_signal = PyInt_FromLong(term_signal);
 
@@ -204,127 +366,159 @@ pyuv__process_exit_cb(uv_process_t *handle, int64_t exit_status, int term_signal
 }
 
 
-static PyObject *
-Process_func_spawn(PyObject *cls, PyObject *args, PyObject *kwargs)
+static void
+pyuv__process_free_strv(char **strv)
 {
-    int err, flags, stdio_count;
-    unsigned int uid, gid;
-    Py_ssize_t i, n, pos, size;
-    PyObject *key, *value, *item, *tmp, *callback, *arguments, *env, *stdio, *ret, *executable, *cwd;
-    Process *self;
-    Loop *loop;
-    uv_process_options_t options;
-    uv_stdio_container_t *stdio_container;
+    Py_ssize_t i;
 
-    static char *kwlist[] = {"loop", "args", "executable", "env", "cwd", "uid", "gid", "flags", "stdio", "exit_callback", NULL};
+    if (strv) {
+        for (i = 0; strv[i] != NULL; ++i) {
+            PyMem_Free(strv[i]);
+        }
+        PyMem_Free(strv);
+    }
+}
 
-    cwd = executable = Py_None;
-    tmp = arguments = env = stdio = NULL;
-    stdio_container = NULL;
-    flags = uid = gid = stdio_count = 0;
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!O|OO!OIIiOO:__init__", kwlist, &LoopType, &loop, &arguments, &executable, &PyDict_Type, &env, &cwd, &uid, &gid, &flags, &stdio, &callback)) {
-        return NULL;
+static void
+pyuv__process_free_options(uv_process_options_t *options)
+{
+    pyuv__process_free_strv(options->args);
+    pyuv__process_free_strv(options->env);
+    PyMem_Free((void*)options->cwd);
+    PyMem_Free((void*)options->file);
+    PyMem_Free(options->stdio);
+    memset(options, 0, sizeof(uv_process_options_t));
+}
+
+
+static int
+pyuv__process_build_stdio(PyObject *stdio, uv_stdio_container_t **stdio_container, int *stdio_count)
+{
+    Py_ssize_t i, n;
+    PyObject *item;
+    uv_stdio_container_t *container;
+
+    *stdio_container = NULL;
+    *stdio_count = 0;
+
+    if (!stdio) {
+        return 0;
     }
 
-    if (callback != Py_None && !PyCallable_Check(callback)) {
-        PyErr_SetString(PyExc_TypeError, "a callable is required");
-        return NULL;
+    n = PySequence_Length(stdio);
+    if (n < 0) {
+        return -1;
+    }
+    container = PyMem_Malloc(sizeof *container * (n ? n : 1));
+    if (!container) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (i = 0;i < n; i++) {
+        item = PySequence_GetItem(stdio, i);
+        if (!item || !PyObject_TypeCheck(item, &StdIOType)) {
+            Py_XDECREF(item);
+            PyErr_SetString(PyExc_TypeError, "a StdIO instance is required");
+            PyMem_Free(container);
+            return -1;
+        }
+        container[i].flags = ((StdIO *)item)->flags;
+        if (((StdIO *)item)->flags & (UV_CREATE_PIPE | UV_INHERIT_STREAM)) {
+            container[i].data.stream = (uv_stream_t *)(UV_HANDLE(((StdIO *)item)->stream));
+        } else if (((StdIO *)item)->flags & UV_INHERIT_FD) {
+            container[i].data.fd = ((StdIO *)item)->fd;
+        }
+        Py_DECREF(item);
     }
 
+    *stdio_container = container;
+    *stdio_count = (int)n;
+    return 0;
+}
+
+
+/* Convert the Python level spawn arguments into a uv_process_options_t structure. All memory
+ * is allocated with PyMem and must be released with pyuv__process_free_options, also on error.
+ */
+static int
+pyuv__process_build_options(uv_process_options_t *options, PyObject *arguments, PyObject *executable, PyObject *env, PyObject *cwd, PyObject *stdio)
+{
+    Py_ssize_t i, n, pos, size;
+    PyObject *key, *value, *item;
+
     if (!PyBytes_Check(arguments) && !PyUnicode_Check(arguments) && !PySequence_Check(arguments)) {
         PyErr_SetString(PyExc_TypeError, "only string or iterable objects are supported for 'args'");
-        return NULL;
+        return -1;
     }
 
     if (stdio && !PySequence_Check(stdio)) {
         PyErr_SetString(PyExc_TypeError, "only iterable objects are supported for 'stdio'");
-        return NULL;
-    }
-
-    self = (Process *)Process_tp_new((PyTypeObject *) cls, args, kwargs);
-    if (!self) {
-        return NULL;
+        return -1;
     }
 
-    initialize_handle(HANDLE(self), loop);
-    /* Don't consider the handle initialized until uv_spawn is called. Unline other handles,
-     * there is no uv_process_init, it's called at the begining of uv_spawn, so don't
-     * consider the handle initialized until then, or we'd call uv_close when the Python
-     * object is deallocated, which is not A Good Thing (TM).
-     */
-    HANDLE(self)->initialized = False;
-
-    memset(&options, 0, sizeof(uv_process_options_t));
-
-    options.uid = uid;
-    options.gid = gid;
-    options.flags = flags;
-    options.exit_cb = pyuv__process_exit_cb;
-
     /* process args */
 
     if (PyBytes_Check(arguments) || PyUnicode_Check(arguments)) {
-        options.args = PyMem_Malloc(sizeof *(options.args) * 2);
-        if (!options.args) {
+        options->args = PyMem_Malloc(sizeof *(options->args) * 2);
+        if (!options->args) {
             PyErr_NoMemory();
-            goto error;
+            return -1;
         }
-        options.args[0] = pyuv_dup_strobj(arguments);
-        if (!options.args[0]) {
-            goto error;
+        options->args[0] = pyuv_dup_strobj(arguments);
+        if (!options->args[0]) {
+            return -1;
         }
-        options.args[1] = NULL;
+        options->args[1] = NULL;
     } else {
         /* it's a sequence object */
         n = PySequence_Length(arguments);
         if (n < 1) {
             PyErr_SetString(PyExc_ValueError, "'args' must contain at least one element");
-            goto error;
+            return -1;
         }
-        options.args = PyMem_Malloc(sizeof *(options.args) * (n + 1));
-        if (!options.args) {
+        options->args = PyMem_Malloc(sizeof *(options->args) * (n + 1));
+        if (!options->args) {
             PyErr_NoMemory();
-            goto error;
+            return -1;
         }
         for (i = 0; i < n; i++) {
             item = PySequence_GetItem(arguments, i);
             if (!item) {
-                options.args[i] = NULL;
-                goto error;
-            }
-            options.args[i] = pyuv_dup_strobj(item);
-            if (!options.args[i]) {
-                Py_DECREF(item);
-                goto error;
+                options->args[i] = NULL;
+                return -1;
             }
+            options->args[i] = pyuv_dup_strobj(item);
             Py_DECREF(item);
+            if (!options->args[i]) {
+                return -1;
+            }
         }
-        options.args[n] = NULL;
+        options->args[n] = NULL;
     }
 
     /* process file */
 
     if (executable != Py_None) {
-        options.file = pyuv_dup_strobj(executable);
-        if (!options.file) {
-            goto error;
+        options->file = pyuv_dup_strobj(executable);
+        if (!options->file) {
+            return -1;
         }
     } else {
-        size = strlen(options.args[0]) + 1;
-        options.file = PyMem_Malloc(size);
-        if (!options.file) {
+        size = strlen(options->args[0]) + 1;
+        options->file = PyMem_Malloc(size);
+        if (!options->file) {
             PyErr_NoMemory();
-            goto error;
+            return -1;
         }
-        memcpy((void*)options.file, options.args[0], size);
+        memcpy((void*)options->file, options->args[0], size);
     }
 
     /* process cwd */
     if (cwd != Py_None) {
-        options.cwd = pyuv_dup_strobj(cwd);
-        if (!options.cwd) {
-            goto error;
+        options->cwd = pyuv_dup_strobj(cwd);
+        if (!options->cwd) {
+            return -1;
         }
     }
 
@@ -335,84 +529,70 @@ Process_func_spawn(PyObject *cls, PyObject *args, PyObject *kwargs)
         PyObject *key_bytes, *value_bytes;
         n = PyDict_Size(env);
         if (n > 0) {
-            options.env = PyMem_Malloc(sizeof *(options.env) * (n + 1));
-            if (!options.env) {
+            options->env = PyMem_Malloc(sizeof *(options->env) * (n + 1));
+            if (!options->env) {
                 PyErr_NoMemory();
-                goto error;
+                return -1;
             }
             i = 0;
             pos = 0;
             while (PyDict_Next(env, &pos, &key, &value)) {
                 key_bytes = value_bytes = NULL;
+                options->env[i] = NULL;
                 if (!pyuv_PyUnicode_FSConverter(key, &key_bytes)) {
-                    options.env[i] = NULL;
-                    goto error;
+                    return -1;
                 }
                 if (!pyuv_PyUnicode_FSConverter(value, &value_bytes)) {
                     Py_DECREF(key_bytes);
-                    options.env[i] = NULL;
-                    goto error;
+                    return -1;
                 }
                 key_str = PyBytes_AS_STRING(key_bytes);
                 value_str = PyBytes_AS_STRING(value_bytes);
                 size = PyBytes_GET_SIZE(key_bytes) + PyBytes_GET_SIZE(value_bytes) + 2;
-                options.env[i] = PyMem_Malloc(size);
-                if (!options.env[i]) {
-                    options.env[i] = NULL;
+                options->env[i] = PyMem_Malloc(size);
+                if (!options->env[i]) {
                     PyErr_NoMemory();
                     Py_DECREF(key_bytes);
                     Py_DECREF(value_bytes);
-                    goto error;
+                    return -1;
                 }
-                PyOS_snprintf(options.env[i], size, "%s=%s", key_str, value_str);
+                PyOS_snprintf(options->env[i], size, "%s=%s", key_str, value_str);
                 Py_DECREF(key_bytes);
                 Py_DECREF(value_bytes);
                 i++;
             }
-            options.env[i] = NULL;
+            options->env[i] = NULL;
         }
     }
 
     /* process stdio container */
 
-    if (stdio) {
-        n = PySequence_Length(stdio);
-        stdio_container = PyMem_Malloc(sizeof *stdio_container * n);
-        if (!stdio_container) {
-            PyErr_NoMemory();
-            goto error;
-        }
-        item = NULL;
-        for (i = 0;i < n; i++) {
-            item = PySequence_GetItem(stdio, i);
-            if (!item || !PyObject_TypeCheck(item, &StdIOType)) {
-                Py_XDECREF(item);
-                PyErr_SetString(PyExc_TypeError, "a StdIO instance is required");
-                goto error;
-            }
-            stdio_count++;
-            stdio_container[i].flags = ((StdIO *)item)->flags;
-            if (((StdIO *)item)->flags & (UV_CREATE_PIPE | UV_INHERIT_STREAM)) {
-                stdio_container[i].data.stream = (uv_stream_t *)(UV_HANDLE(((StdIO *)item)->stream));
-            } else if (((StdIO *)item)->flags & UV_INHERIT_FD) {
-                stdio_container[i].data.fd = ((StdIO *)item)->fd;
-            }
-            Py_DECREF(item);
-        }
-    }
-    options.stdio = stdio_container;
-    options.stdio_count = stdio_count;
+    return pyuv__process_build_stdio(stdio, &options->stdio, &options->stdio_count);
+}
+
+
+/* Spawn a process using already built options. On success the Process takes a reference to the
+ * exit callback and the stdio sequence, and holds a reference to itself until the process exits.
+ */
+static int
+pyuv__process_do_spawn(Process *self, Loop *loop, uv_process_options_t *options, PyObject *callback, PyObject *stdio, Bool rusage)
+{
+    int err;
+    PyObject *tmp;
+
+    /* There is no uv_process_init, the handle is initialized at the begining of uv_spawn, which
+     * is called right away, so it's safe to consider the handle initialized here.
+     */
+    initialize_handle(HANDLE(self), loop);
 
-    HANDLE(self)->initialized = True;
+    options->exit_cb = pyuv__process_exit_cb;
 
-    err = uv_spawn(UV_HANDLE_LOOP(self), &self->process_h, &options);
+    err = uv_spawn(UV_HANDLE_LOOP(self), &self->process_h, options);
     if (err < 0) {
         RAISE_UV_EXCEPTION(err, PyExc_ProcessError);
-        goto error;
+        return -1;
     }
 
-    ret = (PyObject *) self;
-
     tmp = (PyObject *)self->on_exit_cb;
     Py_INCREF(callback);
     self->on_exit_cb = callback;
@@ -423,35 +603,465 @@ Process_func_spawn(PyObject *cls, PyObject *args, PyObject *kwargs)
     self->stdio = stdio;
     Py_XDECREF(tmp);
 
+    /* collecting it costs a pidfd and a poll handle per child, so it's opt-in */
+    if (rusage) {
+        pyuv__process_rusage_start(self);
+    }
+
     /* Increase refcount so that object is not removed before the exit callback is called */
     Py_INCREF(self);
 
-    goto cleanup;
+    return 0;
+}
 
-error:
-    ret = NULL;
-    Py_DECREF(self);
 
-cleanup:
-    if (options.args) {
-        for (i = 0; options.args[i] != NULL; ++i) {
-            PyMem_Free(options.args[i]);
+static PyObject *
+Process_func_spawn(PyObject *cls, PyObject *args, PyObject *kwargs)
+{
+    int flags, rusage;
+    unsigned int uid, gid;
+    PyObject *callback, *arguments, *env, *stdio, *executable, *cwd, *py_rusage;
+    Process *self;
+    Loop *loop;
+    uv_process_options_t options;
+
+    static char *kwlist[] = {"loop", "args", "executable", "env", "cwd", "uid", "gid", "flags", "stdio", "exit_callback", "rusage", NULL};
+
+    cwd = executable = callback = Py_None;
+    py_rusage = Py_False;
+    arguments = env = stdio = NULL;
+    flags = uid = gid = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!O|OO!OIIiOOO:__init__", kwlist, &LoopType, &loop, &arguments, &executable, &PyDict_Type, &env, &cwd, &uid, &gid, &flags, &stdio, &callback, &py_rusage)) {
+        return NULL;
+    }
+
+    rusage = PyObject_IsTrue(py_rusage);
+    if (rusage < 0) {
+        return NULL;
+    }
+
+    if (callback != Py_None && !PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    memset(&options, 0, sizeof(uv_process_options_t));
+
+    options.uid = uid;
+    options.gid = gid;
+    options.flags = flags;
+
+    if (pyuv__process_build_options(&options, arguments, executable, env, cwd, stdio) != 0) {
+        pyuv__process_free_options(&options);
+        return NULL;
+    }
+
+    self = (Process *)Process_tp_new((PyTypeObject *) cls, args, kwargs);
+    if (!self) {
+        pyuv__process_free_options(&options);
+        return NULL;
+    }
+
+    if (pyuv__process_do_spawn(self, loop, &options, callback, stdio, (Bool)rusage) != 0) {
+        Py_DECREF(self);
+        self = NULL;
+    }
+
+    pyuv__process_free_options(&options);
+
+    return (PyObject *)self;
+}
+
+
+/* Process.run support: stdin, stdout and stderr are driven from C and the output is accumulated
+ * in growable buffers, the callback is called once with all the collected data. Everything here
+ * may run without holding the GIL, so the C allocator is used.
+ */
+
+#define PYUV__PROCESS_RUN_READ_SIZE 65536
+
+typedef struct {
+    uv_pipe_t pipe;
+    char *data;
+    size_t len;
+    size_t size;
+} pyuv__process_run_output;
+
+struct pyuv__process_run_ctx_s {
+    Process *process;
+    PyObject *callback;
+    uv_timer_t timer;
+    uv_pipe_t stdin_pipe;
+    uv_write_t write_req;
+    char *input;
+    size_t input_len;
+    pyuv__process_run_output out;
+    pyuv__process_run_output err;
+    int active_handles;
+    Bool capture;
+    Bool has_input;
+    Bool has_timer;
+    Bool spawned;
+    Bool exited;
+    int64_t exit_status;
+    int term_signal;
+};
+
+
+static void
+pyuv__process_run_maybe_done(pyuv__process_run_ctx *ctx)
+{
+    PyGILState_STATE gstate;
+    PyObject *result, *out, *err;
+    Process *process;
+
+    if (ctx->active_handles > 0 || (ctx->spawned && !ctx->exited)) {
+        return;
+    }
+
+    if (ctx->spawned) {
+        gstate = PyGILState_Ensure();
+        process = ctx->process;
+        process->run_ctx = NULL;
+
+        if (ctx->capture) {
+            out = PyBytes_FromStringAndSize(ctx->out.data, ctx->out.len);
+            err = PyBytes_FromStringAndSize(ctx->err.data, ctx->err.len);
+        } else {
+            out = Py_None;
+            Py_INCREF(out);
+            err = Py_None;
+            Py_INCREF(err);
+        }
+
+        if (!out || !err) {
+            handle_uncaught_exception(HANDLE(process)->loop);
+        } else if (ctx->callback != Py_None) {
+            result = PyObject_CallFunction(ctx->callback, "OLiOOO", process, (PY_LONG_LONG)ctx->exit_status, ctx->term_signal, out, err, process->rusage ? process->rusage : Py_None);
+            if (result == NULL) {
+                handle_uncaught_exception(HANDLE(process)->loop);
+            }
+            Py_XDECREF(result);
         }
-        PyMem_Free(options.args);
+
+        Py_XDECREF(out);
+        Py_XDECREF(err);
+        Py_DECREF(ctx->callback);
+        Py_DECREF(process);
+        PyGILState_Release(gstate);
     }
 
-    if (options.env) {
-        for (i = 0; options.env[i] != NULL; ++i) {
-            PyMem_Free(options.env[i]);
+    free(ctx->out.data);
+    free(ctx->err.data);
+    free(ctx->input);
+    free(ctx);
+}
+
+
+static void
+pyuv__process_run_close_cb(uv_handle_t *handle)
+{
+    pyuv__process_run_ctx *ctx = handle->data;
+    ctx->active_handles--;
+    pyuv__process_run_maybe_done(ctx);
+}
+
+
+static INLINE void
+pyuv__process_run_close(uv_handle_t *handle)
+{
+    if (!uv_is_closing(handle)) {
+        uv_close(handle, pyuv__process_run_close_cb);
+    }
+}
+
+
+static void
+pyuv__process_run_close_all(pyuv__process_run_ctx *ctx)
+{
+    if (ctx->has_input) {
+        pyuv__process_run_close((uv_handle_t *)&ctx->stdin_pipe);
+    }
+    if (ctx->capture) {
+        pyuv__process_run_close((uv_handle_t *)&ctx->out.pipe);
+        pyuv__process_run_close((uv_handle_t *)&ctx->err.pipe);
+    }
+    if (ctx->has_timer) {
+        pyuv__process_run_close((uv_handle_t *)&ctx->timer);
+    }
+}
+
+
+static void
+pyuv__process_run_alloc_cb(uv_handle_t* handle, size_t suggested_size, uv_buf_t *buf)
+{
+    pyuv__process_run_output *output;
+    size_t size;
+    char *data;
+
+    UNUSED_ARG(suggested_size);
+
+    output = PYUV_CONTAINER_OF(handle, pyuv__process_run_output, pipe);
+
+    if (output->size - output->len < PYUV__PROCESS_RUN_READ_SIZE) {
+        size = output->size ? output->size * 2 : PYUV__PROCESS_RUN_READ_SIZE;
+        while (size - output->len < PYUV__PROCESS_RUN_READ_SIZE) {
+            size *= 2;
         }
-        PyMem_Free(options.env);
+        data = realloc(output->data, size);
+        if (!data) {
+            buf->base = NULL;
+            buf->len = 0;
+            return;
+        }
+        output->data = data;
+        output->size = size;
     }
 
-    PyMem_Free((void*)options.cwd);
-    PyMem_Free((void*)options.file);
-    PyMem_Free(options.stdio);
+    buf->base = output->data + output->len;
+    buf->len = output->size - output->len;
+}
+
+
+static void
+pyuv__process_run_read_cb(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf)
+{
+    pyuv__process_run_output *output;
+
+    UNUSED_ARG(buf);
+
+    output = PYUV_CONTAINER_OF(handle, pyuv__process_run_output, pipe);
 
-    return ret;
+    if (nread > 0) {
+        output->len += nread;
+    } else if (nread < 0) {
+        /* EOF or error, either way there is nothing else to read */
+        pyuv__process_run_close((uv_handle_t *)handle);
+    }
+}
+
+
+static void
+pyuv__process_run_write_cb(uv_write_t* req, int status)
+{
+    pyuv__process_run_ctx *ctx = req->data;
+
+    UNUSED_ARG(status);
+
+    /* all input was written (or the child is gone), signal EOF */
+    pyuv__process_run_close((uv_handle_t *)&ctx->stdin_pipe);
+}
+
+
+static void
+pyuv__process_run_timer_cb(uv_timer_t *handle)
+{
+    pyuv__process_run_ctx *ctx = handle->data;
+
+    uv_process_kill(&ctx->process->process_h, SIGKILL);
+    pyuv__process_run_close_all(ctx);
+}
+
+
+static void
+pyuv__process_run_exit(pyuv__process_run_ctx *ctx, int64_t exit_status, int term_signal)
+{
+    ctx->exited = True;
+    ctx->exit_status = exit_status;
+    ctx->term_signal = term_signal;
+
+    /* stdout and stderr are kept open until EOF, there may still be data buffered */
+    if (ctx->has_input) {
+        pyuv__process_run_close((uv_handle_t *)&ctx->stdin_pipe);
+    }
+    if (ctx->has_timer) {
+        pyuv__process_run_close((uv_handle_t *)&ctx->timer);
+    }
+
+    pyuv__process_run_maybe_done(ctx);
+}
+
+
+static PyObject *
+Process_func_run(PyObject *cls, PyObject *args, PyObject *kwargs)
+{
+    int err, flags, rusage;
+    double timeout;
+    PyObject *callback, *arguments, *input, *capture, *env, *executable, *cwd, *py_rusage;
+    Process *self;
+    Loop *loop;
+    Py_buffer view;
+    uv_buf_t buf;
+    uv_process_options_t options;
+    uv_stdio_container_t stdio_container[3];
+    pyuv__process_run_ctx *ctx;
+
+    static char *kwlist[] = {"loop", "args", "callback", "input", "capture", "timeout", "executable", "env", "cwd", "flags", "rusage", NULL};
+
+    callback = input = cwd = executable = Py_None;
+    capture = Py_True;
+    py_rusage = Py_False;
+    env = NULL;
+    timeout = 0.0;
+    flags = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!O|OOOdOO!OiO:run", kwlist, &LoopType, &loop, &arguments, &callback, &input, &capture, &timeout, &executable, &PyDict_Type, &env, &cwd, &flags, &py_rusage)) {
+        return NULL;
+    }
+
+    rusage = PyObject_IsTrue(py_rusage);
+    if (rusage < 0) {
+        return NULL;
+    }
+
+    if (callback != Py_None && !PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    if (timeout < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "a positive value or zero is required");
+        return NULL;
+    }
+
+    ctx = calloc(1, sizeof *ctx);
+    if (!ctx) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    ctx->capture = PyObject_IsTrue(capture);
+    if (ctx->capture < 0) {
+        free(ctx);
+        return NULL;
+    }
+
+    if (input != Py_None) {
+        if (PyObject_GetBuffer(input, &view, PyBUF_SIMPLE) != 0) {
+            free(ctx);
+            return NULL;
+        }
+        ctx->input_len = view.len;
+        ctx->input = malloc(view.len ? view.len : 1);
+        if (ctx->input) {
+            memcpy(ctx->input, view.buf, view.len);
+        }
+        PyBuffer_Release(&view);
+        if (!ctx->input) {
+            free(ctx);
+            PyErr_NoMemory();
+            return NULL;
+        }
+        ctx->has_input = True;
+    }
+
+    memset(&options, 0, sizeof(uv_process_options_t));
+    options.flags = flags;
+
+    if (pyuv__process_build_options(&options, arguments, executable, env, cwd, NULL) != 0) {
+        pyuv__process_free_options(&options);
+        free(ctx->input);
+        free(ctx);
+        return NULL;
+    }
+
+    if (ctx->has_input) {
+        uv_pipe_init(loop->uv_loop, &ctx->stdin_pipe, 0);
+        ctx->stdin_pipe.data = ctx;
+        ctx->active_handles++;
+        stdio_container[0].flags = UV_CREATE_PIPE | UV_READABLE_PIPE;
+        stdio_container[0].data.stream = (uv_stream_t *)&ctx->stdin_pipe;
+    } else {
+        stdio_container[0].flags = UV_IGNORE;
+    }
+
+    if (ctx->capture) {
+        uv_pipe_init(loop->uv_loop, &ctx->out.pipe, 0);
+        ctx->out.pipe.data = ctx;
+        uv_pipe_init(loop->uv_loop, &ctx->err.pipe, 0);
+        ctx->err.pipe.data = ctx;
+        ctx->active_handles += 2;
+        stdio_container[1].flags = UV_CREATE_PIPE | UV_WRITABLE_PIPE;
+        stdio_container[1].data.stream = (uv_stream_t *)&ctx->out.pipe;
+        stdio_container[2].flags = UV_CREATE_PIPE | UV_WRITABLE_PIPE;
+        stdio_container[2].data.stream = (uv_stream_t *)&ctx->err.pipe;
+    } else {
+        stdio_container[1].flags = UV_INHERIT_FD;
+        stdio_container[1].data.fd = 1;
+        stdio_container[2].flags = UV_INHERIT_FD;
+        stdio_container[2].data.fd = 2;
+    }
+
+    if (timeout > 0.0) {
+        uv_timer_init(loop->uv_loop, &ctx->timer);
+        ctx->timer.data = ctx;
+        ctx->has_timer = True;
+        ctx->active_handles++;
+    }
+
+    options.stdio = stdio_container;
+    options.stdio_count = 3;
+
+    self = (Process *)Process_tp_new((PyTypeObject *) cls, args, kwargs);
+    if (self) {
+        self->run_ctx = ctx;
+        ctx->process = self;
+        if (pyuv__process_do_spawn(self, loop, &options, Py_None, NULL, (Bool)rusage) != 0) {
+            self->run_ctx = NULL;
+            Py_DECREF(self);
+            self = NULL;
+        }
+    }
+
+    /* the stdio container lives on the stack */
+    options.stdio = NULL;
+    pyuv__process_free_options(&options);
+
+    if (!self) {
+        /* the context is freed once all handles are closed */
+        if (ctx->active_handles > 0) {
+            pyuv__process_run_close_all(ctx);
+        } else {
+            pyuv__process_run_maybe_done(ctx);
+        }
+        return NULL;
+    }
+
+    ctx->spawned = True;
+    Py_INCREF(callback);
+    ctx->callback = callback;
+    /* released once the callback is called */
+    Py_INCREF(self);
+
+    if (ctx->capture) {
+        err = uv_read_start((uv_stream_t *)&ctx->out.pipe, (uv_alloc_cb)pyuv__process_run_alloc_cb, (uv_read_cb)pyuv__process_run_read_cb);
+        if (err < 0) {
+            pyuv__process_run_close((uv_handle_t *)&ctx->out.pipe);
+        }
+        err = uv_read_start((uv_stream_t *)&ctx->err.pipe, (uv_alloc_cb)pyuv__process_run_alloc_cb, (uv_read_cb)pyuv__process_run_read_cb);
+        if (err < 0) {
+            pyuv__process_run_close((uv_handle_t *)&ctx->err.pipe);
+        }
+    }
+
+    if (ctx->has_input) {
+        err = -1;
+        if (ctx->input_len > 0) {
+            buf = uv_buf_init(ctx->input, (unsigned int)ctx->input_len);
+            ctx->write_req.data = ctx;
+            err = uv_write(&ctx->write_req, (uv_stream_t *)&ctx->stdin_pipe, &buf, 1, pyuv__process_run_write_cb);
+        }
+        if (err < 0) {
+            pyuv__process_run_close((uv_handle_t *)&ctx->stdin_pipe);
+        }
+    }
+
+    if (ctx->has_timer) {
+        uv_timer_start(&ctx->timer, (uv_timer_cb)pyuv__process_run_timer_cb, (uint64_t)(timeout * 1000), 0);
+    }
+
+    return (PyObject *)self;
 }
 
 
@@ -485,6 +1095,8 @@ Process_func_close(Process *self, PyObject *args)
         return NULL;
     }
 
+    pyuv__process_rusage_stop(self);
+
     return Handle_func_close(HANDLE(self), args);
 }
 
@@ -501,6 +1113,19 @@ Process_pid_get(Process *self, void *closure)
 }
 
 
+static PyObject *
+Process_rusage_get(Process *self, void *closure)
+{
+    UNUSED_ARG(closure);
+
+    if (!self->rusage) {
+        Py_RETURN_NONE;
+    }
+    Py_INCREF(self->rusage);
+    return self->rusage;
+}
+
+
 static PyObject *
 Process_func_disable_stdio_inheritance(PyObject *cls)
 {
@@ -532,6 +1157,7 @@ Process_tp_traverse(Process *self, visitproc visit, void *arg)
 {
     Py_VISIT(self->on_exit_cb);
     Py_VISIT(self->stdio);
+    Py_VISIT(self->rusage);
     return HandleType.tp_traverse((PyObject *)self, visit, arg);
 }
 
@@ -541,6 +1167,7 @@ Process_tp_clear(Process *self)
 {
     Py_CLEAR(self->on_exit_cb);
     Py_CLEAR(self->stdio);
+    Py_CLEAR(self->rusage);
     return HandleType.tp_clear((PyObject *)self);
 }
 
@@ -548,6 +1175,7 @@ Process_tp_clear(Process *self)
 static PyMethodDef
 Process_tp_methods[] = {
     { "spawn", (PyCFunction)Process_func_spawn, METH_CLASS|METH_VARARGS|METH_KEYWORDS, "Spawn the child process." },
+    { "run", (PyCFunction)Process_func_run, METH_CLASS|METH_VARARGS|METH_KEYWORDS, "Spawn the child process and collect its output." },
     { "kill", (PyCFunction)Process_func_kill, METH_VARARGS, "Kill this process with the specified signal number." },
     { "close", (PyCFunction)Process_func_close, METH_VARARGS, "Close process handle." },
     { "disable_stdio_inheritance", (PyCFunction)Process_func_disable_stdio_inheritance, METH_NOARGS|METH_CLASS, "Disables inheritance for file descriptors / handles that this process inherited from its parent." },
@@ -557,6 +1185,7 @@ Process_tp_methods[] = {
 
 static PyGetSetDef Process_tp_getsets[] = {
     {"pid", (getter)Process_pid_get, NULL, "Process ID", NULL},
+    {"rusage", (getter)Process_rusage_get, NULL, "Resource usage of the exited process", NULL},
     {NULL}
 };
 
@@ -602,3 +1231,244 @@ static PyTypeObject ProcessType = {
     Process_tp_new,                                                 /*tp_new*/
 };
 
+
+
+/* Spawn template, holds pre-converted spawn options which can be reused */
+
+static int
+SpawnTemplate_tp_init(SpawnTemplate *self, PyObject *args, PyObject *kwargs)
+{
+    int i, flags;
+    unsigned int uid, gid;
+    PyObject *arguments, *env, *stdio, *executable, *cwd, *tmp;
+
+    static char *kwlist[] = {"args", "executable", "env", "cwd", "uid", "gid", "flags", "stdio", NULL};
+
+    cwd = executable = Py_None;
+    arguments = env = stdio = NULL;
+    flags = uid = gid = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OO!OIIiO:__init__", kwlist, &arguments, &executable, &PyDict_Type, &env, &cwd, &uid, &gid, &flags, &stdio)) {
+        return -1;
+    }
+
+    if (stdio == Py_None) {
+        stdio = NULL;
+    }
+
+    pyuv__process_free_options(&self->options);
+    self->initialized = False;
+
+    self->options.uid = uid;
+    self->options.gid = gid;
+    self->options.flags = flags;
+
+    if (pyuv__process_build_options(&self->options, arguments, executable, env, cwd, stdio) != 0) {
+        pyuv__process_free_options(&self->options);
+        return -1;
+    }
+
+    /* a created pipe is bound to the first child, every spawn would reuse it */
+    for (i = 0; i < self->options.stdio_count; i++) {
+        if (self->options.stdio[i].flags & UV_CREATE_PIPE) {
+            PyErr_SetString(PyExc_ValueError, "UV_CREATE_PIPE containers must be passed to spawn()");
+            pyuv__process_free_options(&self->options);
+            return -1;
+        }
+    }
+
+    tmp = self->stdio;
+    Py_XINCREF(stdio);
+    self->stdio = stdio;
+    Py_XDECREF(tmp);
+
+    self->initialized = True;
+
+    return 0;
+}
+
+
+static PyObject *
+SpawnTemplate_func_spawn(SpawnTemplate *self, PyObject *args, PyObject *kwargs)
+{
+    int rusage;
+    PyObject *callback, *stdio, *py_rusage;
+    Process *process;
+    Loop *loop;
+    uv_process_options_t options;
+
+    static char *kwlist[] = {"loop", "exit_callback", "stdio", "rusage", NULL};
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    callback = Py_None;
+    py_rusage = Py_False;
+    stdio = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|OOO:spawn", kwlist, &LoopType, &loop, &callback, &stdio, &py_rusage)) {
+        return NULL;
+    }
+
+    rusage = PyObject_IsTrue(py_rusage);
+    if (rusage < 0) {
+        return NULL;
+    }
+
+    if (callback != Py_None && !PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    if (stdio == Py_None) {
+        stdio = NULL;
+    }
+
+    if (stdio && !PySequence_Check(stdio)) {
+        PyErr_SetString(PyExc_TypeError, "only iterable objects are supported for 'stdio'");
+        return NULL;
+    }
+
+    /* shallow copy, only the stdio container may be replaced */
+    options = self->options;
+    if (stdio) {
+        if (pyuv__process_build_stdio(stdio, &options.stdio, &options.stdio_count) != 0) {
+            return NULL;
+        }
+    } else {
+        stdio = self->stdio;
+    }
+
+    process = (Process *)Process_tp_new(&ProcessType, NULL, NULL);
+    if (process && pyuv__process_do_spawn(process, loop, &options, callback, stdio, (Bool)rusage) != 0) {
+        Py_DECREF(process);
+        process = NULL;
+    }
+
+    if (options.stdio != self->options.stdio) {
+        PyMem_Free(options.stdio);
+    }
+
+    return (PyObject *)process;
+}
+
+
+static PyObject *
+SpawnTemplate_args_get(SpawnTemplate *self, void *closure)
+{
+    int i;
+    PyObject *result, *item;
+
+    UNUSED_ARG(closure);
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    result = PyList_New(0);
+    if (!result) {
+        return NULL;
+    }
+
+    for (i = 0; self->options.args[i] != NULL; i++) {
+        item = Py_BuildValue("s", self->options.args[i]);
+        if (!item || PyList_Append(result, item) != 0) {
+            Py_XDECREF(item);
+            Py_DECREF(result);
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+
+    return result;
+}
+
+
+static PyObject *
+SpawnTemplate_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    SpawnTemplate *self = (SpawnTemplate *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->initialized = False;
+    memset(&self->options, 0, sizeof(uv_process_options_t));
+    return (PyObject *)self;
+}
+
+
+static int
+SpawnTemplate_tp_traverse(SpawnTemplate *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->stdio);
+    return 0;
+}
+
+
+static int
+SpawnTemplate_tp_clear(SpawnTemplate *self)
+{
+    Py_CLEAR(self->stdio);
+    return 0;
+}
+
+
+static void
+SpawnTemplate_tp_dealloc(SpawnTemplate *self)
+{
+    pyuv__process_free_options(&self->options);
+    SpawnTemplate_tp_clear(self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyMethodDef
+SpawnTemplate_tp_methods[] = {
+    { "spawn", (PyCFunction)SpawnTemplate_func_spawn, METH_VARARGS|METH_KEYWORDS, "Spawn a child process using this template." },
+    { NULL }
+};
+
+
+static PyGetSetDef SpawnTemplate_tp_getsets[] = {
+    {"args", (getter)SpawnTemplate_args_get, NULL, "Arguments for the child process.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject SpawnTemplateType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.SpawnTemplate",                                    /*tp_name*/
+    sizeof(SpawnTemplate),                                          /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)SpawnTemplate_tp_dealloc,                           /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)SpawnTemplate_tp_traverse,                        /*tp_traverse*/
+    (inquiry)SpawnTemplate_tp_clear,                                /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    SpawnTemplate_tp_methods,                                       /*tp_methods*/
+    0,                                                              /*tp_members*/
+    SpawnTemplate_tp_getsets,                                       /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)SpawnTemplate_tp_init,                                /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    SpawnTemplate_tp_new,                                           /*tp_new*/
+};
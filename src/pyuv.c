@@ -8,6 +8,8 @@
 #include "handle.c"
 #include "request.c"
 #include "async.c"
+#include "channel.c"
+#include "loopsync.c"
 #include "timer.c"
 #include "prepare.c"
 #include "idle.c"
@@ -22,8 +24,10 @@
 #include "fs.c"
 #include "process.c"
 #include "dns.c"
+#include "resolver.c"
 #include "util.c"
 #include "thread.c"
+#include "asyncio.c"
 
 
 #ifdef PYUV_PYTHON3
@@ -67,6 +71,9 @@ init_pyuv(void)
     PyObject *dns_module;
     PyObject *util_module;
     PyObject *thread_module;
+#ifdef PYUV_PYTHON3
+    PyObject *asyncio_module;
+#endif
 
     /* Initialize GIL */
     PyEval_InitThreads();
@@ -150,8 +157,21 @@ init_pyuv(void)
     Py_DECREF(thread_module);
 #endif
 
+#ifdef PYUV_PYTHON3
+    /* asyncio event loop core, used by pyuv.asyncio */
+    asyncio_module = init_asyncio();
+    if (asyncio_module == NULL) {
+        goto fail;
+    }
+    PyUVModule_AddObject(pyuv, "_asyncio", asyncio_module);
+    PyDict_SetItemString(PyImport_GetModuleDict(), pyuv_asyncio_module.m_name, asyncio_module);
+    Py_DECREF(asyncio_module);
+#endif
+
     /* Types */
     AsyncType.tp_base = &HandleType;
+    AsyncQueueType.tp_base = &HandleType;
+    ChannelType.tp_base = &HandleType;
     TimerType.tp_base = &HandleType;
     PrepareType.tp_base = &HandleType;
     IdleType.tp_base = &HandleType;
@@ -159,6 +179,7 @@ init_pyuv(void)
     SignalType.tp_base = &HandleType;
     UDPType.tp_base = &HandleType;
     PollType.tp_base = &HandleType;
+    PollGroupType.tp_base = &HandleType;
     ProcessType.tp_base = &HandleType;
 
     StreamType.tp_base = &HandleType;
@@ -166,6 +187,12 @@ init_pyuv(void)
     PipeType.tp_base = &StreamType;
     TTYType.tp_base = &StreamType;
 
+#if PY_VERSION_HEX >= 0x03050000
+    RequestType.tp_as_async = &Request_tp_as_async;
+#endif
+    if (PyType_Ready(&RequestFutureType) < 0) {
+        return NULL;
+    }
     GAIRequestType.tp_base = &RequestType;
     if (PyType_Ready(&GAIRequestType) < 0) {
         return NULL;
@@ -185,6 +212,11 @@ init_pyuv(void)
 
     PyUVModule_AddType(pyuv, "Loop", &LoopType);
     PyUVModule_AddType(pyuv, "Async", &AsyncType);
+    PyUVModule_AddType(pyuv, "AsyncQueue", &AsyncQueueType);
+    PyUVModule_AddType(pyuv, "Channel", &ChannelType);
+    PyUVModule_AddType(pyuv, "LoopEvent", &LoopEventType);
+    PyUVModule_AddType(pyuv, "LoopSemaphore", &LoopSemaphoreType);
+    PyUVModule_AddType(pyuv, "LoopLock", &LoopLockType);
     PyUVModule_AddType(pyuv, "Timer", &TimerType);
     PyUVModule_AddType(pyuv, "Prepare", &PrepareType);
     PyUVModule_AddType(pyuv, "Idle", &IdleType);
@@ -195,17 +227,27 @@ init_pyuv(void)
     PyUVModule_AddType(pyuv, "TTY", &TTYType);
     PyUVModule_AddType(pyuv, "UDP", &UDPType);
     PyUVModule_AddType(pyuv, "Poll", &PollType);
+    PyUVModule_AddType(pyuv, "PollGroup", &PollGroupType);
     PyUVModule_AddType(pyuv, "StdIO", &StdIOType);
     PyUVModule_AddType(pyuv, "Process", &ProcessType);
+    PyUVModule_AddType(pyuv, "SpawnTemplate", &SpawnTemplateType);
 
     /* Handle and Stream base classes */
     PyUVModule_AddType(pyuv, "Handle", &HandleType);
     PyUVModule_AddType(pyuv, "Stream", &StreamType);
 
+    /* Requests */
+    pyuv__awaitable = PyCFunction_New(&pyuv__awaitable_def, NULL);
+    if (pyuv__awaitable == NULL) {
+        goto fail;
+    }
+    PyUVModule_AddObject(pyuv, "AWAITABLE", pyuv__awaitable);
+
     /* Loop.run modes */
     PyModule_AddIntMacro(pyuv, UV_RUN_DEFAULT);
     PyModule_AddIntMacro(pyuv, UV_RUN_ONCE);
     PyModule_AddIntMacro(pyuv, UV_RUN_NOWAIT);
+    PyModule_AddIntConstant(pyuv, "UV_RUN_SPIN", PYUV_RUN_SPIN);
 
     /* UDP constants */
     PyModule_AddIntMacro(pyuv, UV_JOIN_GROUP);
@@ -24,6 +24,16 @@
 /* libuv */
 #include "uv.h"
 
+#if defined(__linux__)
+    #define PYUV_LINUX
+    #include <ctype.h>
+    #include <dirent.h>
+    #include <sched.h>
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <sys/wait.h>
+#endif
+
 
 /* Custom types */
 typedef int Bool;
@@ -45,6 +55,18 @@ typedef int Bool;
     #define PYUV_MAXSTDIO 2048
 #endif
 
+#ifndef PYUV_WINDOWS
+    #include <poll.h>
+#endif
+
+/* Handle priorities, used to order the callbacks deferred by the loop */
+#define PYUV_PRIORITY_MIN -2
+#define PYUV_PRIORITY_MAX 2
+#define PYUV_PRIORITY_LEVELS (PYUV_PRIORITY_MAX - PYUV_PRIORITY_MIN + 1)
+
+/* Loop.run mode which busy polls the loop, next to the libuv ones */
+#define PYUV_RUN_SPIN 100
+
 #ifdef _MSC_VER
     #define INLINE __inline
 #else
@@ -145,9 +167,25 @@ typedef int Bool;
 
 #define PYUV_SLAB_SIZE 65536
 
+/* Seconds set_threadpool_affinity and set_threadpool_scheduling wait for the workers to be idle */
+#define PYUV_THREADPOOL_SCHED_TIMEOUT 5.0
+
 
 /* Custom pyuv handle flags */
-#define PYUV__PYREF    (1 << 1)
+#define PYUV__PYREF       (1 << 1)
+#define PYUV__UNTRACKED   (1 << 2)
+#define PYUV__LISTENING   (1 << 3)
+#define PYUV__PROTOCOL    (1 << 4)
+#define PYUV__READING     (1 << 5)
+#define PYUV__PAUSED      (1 << 6)
+#define PYUV__ACCEPT_POLICY (1 << 7)
+#define PYUV__ACCEPTED    (1 << 8)
+
+/* The priority of a handle's deferred callbacks is kept in 3 bits of the flags, in two's
+ * complement, so that zeroed flags mean the default priority 0. */
+#define PYUV__PRIORITY_SHIFT 12
+#define PYUV__PRIORITY_MASK  (7 << PYUV__PRIORITY_SHIFT)
+#define PYUV_HANDLE_PRIORITY(obj) ((((HANDLE(obj)->flags >> PYUV__PRIORITY_SHIFT) & 7) ^ 4) - 4)
 
 #define PYUV_HANDLE_INCREF(obj)                        \
     do {                                               \
@@ -174,6 +212,8 @@ typedef int Bool;
 /* Python types definitions */
 
 /* Loop */
+typedef struct pyuv__stream_accept_policy_s pyuv__stream_accept_policy;
+
 typedef struct {
     PyObject_HEAD
     PyObject *weakreflist;
@@ -184,7 +224,47 @@ typedef struct {
     struct {
         char slab[PYUV_SLAB_SIZE];
         Bool in_use;
+        Py_buffer view;
     } buffer;
+    struct {
+        uv_async_t *async;
+        PyObject *pending;
+        Py_ssize_t waiters;
+    } sync;
+    struct {
+        PyObject *cpus;
+        int policy;
+        int priority;
+        Bool running;
+        uv_thread_t thread;
+        long tid;
+    } sched;
+    struct {
+        volatile Bool stop;
+    } spin;
+    struct {
+        uv_check_t check_h;
+        uv_idle_t idle_h;
+        Bool initialized;
+        Bool enabled;
+        uint64_t budget;
+        Py_ssize_t count;
+        Py_ssize_t bytes;
+        PyObject *queues[PYUV_PRIORITY_LEVELS];
+    } defer;
+    struct {
+        uv_check_t check_h;
+        Bool initialized;
+        Bool pressure;
+        size_t budget;
+        size_t used;
+        /* bytes left in write and send queues by the requests still in flight */
+        size_t queued;
+        PyObject *on_pressure;
+        PyObject *paused;
+    } memory;
+    /* Accept policies of the listening streams, see pyuv__stream_set_accept_policy */
+    pyuv__stream_accept_policy *accept_policies;
 } Loop;
 
 static PyTypeObject LoopType;
@@ -213,6 +293,60 @@ typedef struct {
 
 static PyTypeObject AsyncType;
 
+/* AsyncQueue */
+typedef struct {
+    Handle handle;
+    uv_async_t async_h;
+    PyObject *callback;
+    PyObject *items;
+    /* items before it were delivered already, see pyuv__async_queue_cb */
+    Py_ssize_t head;
+    Py_ssize_t batch_max;
+} AsyncQueue;
+
+static PyTypeObject AsyncQueueType;
+
+/* Channel */
+typedef struct {
+    Handle handle;
+    uv_async_t async_h;
+    uv_mutex_t mutex;
+    uv_cond_t not_full;
+    PyObject *callback;
+    PyObject *writable_cb;
+    PyObject **items;
+    PyObject **scratch;
+    Py_ssize_t capacity;
+    Py_ssize_t head;
+    Py_ssize_t count;
+    Bool closed;
+    Bool sync_initialized;
+} Channel;
+
+static PyTypeObject ChannelType;
+
+/* LoopEvent, LoopSemaphore and LoopLock */
+enum {
+    PYUV_LOOP_EVENT = 0,
+    PYUV_LOOP_SEMAPHORE,
+    PYUV_LOOP_LOCK
+};
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *weakreflist;
+    Bool initialized;
+    Loop *loop;
+    PyObject *waiters;
+    Py_ssize_t value;
+    int kind;
+    Bool pending;
+} LoopSync;
+
+static PyTypeObject LoopEventType;
+static PyTypeObject LoopSemaphoreType;
+static PyTypeObject LoopLockType;
+
 /* Timer */
 typedef struct {
     Handle handle;
@@ -270,6 +404,7 @@ static PyTypeObject SignalCheckerType;
 /* Stream */
 typedef struct {
     Handle handle;
+    /* A listening stream never reads, so it keeps the connection callback here */
     PyObject *on_read_cb;
 } Stream;
 
@@ -279,7 +414,6 @@ static PyTypeObject StreamType;
 typedef struct {
     Stream stream;
     uv_tcp_t tcp_h;
-    PyObject *on_new_connection_cb;
 } TCP;
 
 static PyTypeObject TCPType;
@@ -288,7 +422,6 @@ static PyTypeObject TCPType;
 typedef struct {
     Stream stream;
     uv_pipe_t pipe_h;
-    PyObject *on_new_connection_cb;
 } Pipe;
 
 static PyTypeObject PipeType;
@@ -319,6 +452,21 @@ typedef struct {
 
 static PyTypeObject PollType;
 
+/* PollGroup */
+typedef struct pyuv__poll_group_entry_s pyuv__poll_group_entry;
+
+typedef struct {
+    Handle handle;
+    uv_check_t check_h;
+    PyObject *callback;
+    PyObject *entries;
+    pyuv__poll_group_entry **ready;
+    Py_ssize_t ready_count;
+    Py_ssize_t ready_size;
+} PollGroup;
+
+static PyTypeObject PollGroupType;
+
 /* Process */
 typedef struct {
     PyObject_HEAD
@@ -329,16 +477,70 @@ typedef struct {
 
 static PyTypeObject StdIOType;
 
+typedef struct pyuv__process_run_ctx_s pyuv__process_run_ctx;
+typedef struct pyuv__process_rusage_watcher_s pyuv__process_rusage_watcher;
+
 typedef struct {
     Handle handle;
     Bool spawned;
     uv_process_t process_h;
     PyObject *on_exit_cb;
     PyObject *stdio;
+    pyuv__process_run_ctx *run_ctx;
+    pyuv__process_rusage_watcher *rusage_watcher;
+    PyObject *rusage;
 } Process;
 
 static PyTypeObject ProcessType;
 
+typedef struct {
+    PyObject_HEAD
+    Bool initialized;
+    uv_process_options_t options;
+    PyObject *stdio;
+} SpawnTemplate;
+
+static PyTypeObject SpawnTemplateType;
+
+/* DNSCache */
+typedef struct {
+    Handle handle;
+    uv_idle_t idle_h;
+    double ttl;
+    double negative_ttl;
+    Py_ssize_t max_entries;
+    PyObject *entries;
+    PyObject *pending;
+    PyObject *ready;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t coalesced;
+} DNSCache;
+
+static PyTypeObject DNSCacheType;
+
+/* Resolver */
+#define PYUV_QUERY_TYPE_A       1
+#define PYUV_QUERY_TYPE_TXT     16
+#define PYUV_QUERY_TYPE_AAAA    28
+#define PYUV_QUERY_TYPE_SRV     33
+
+typedef struct pyuv__resolver_query_s pyuv__resolver_query;
+
+typedef struct {
+    PyObject_HEAD
+    Bool initialized;
+    Loop *loop;
+    struct sockaddr_storage *nameservers;
+    int nameservers_count;
+    double timeout;
+    int tries;
+    uint32_t seed;
+    pyuv__resolver_query *queries;
+} Resolver;
+
+static PyTypeObject ResolverType;
+
 /* FSEvent */
 typedef struct {
     Handle handle;
@@ -402,17 +604,148 @@ typedef struct {
 
 static PyTypeObject SemaphoreType;
 
+/* SPSCQueue and MPMCQueue */
+typedef struct {
+    PyObject_HEAD
+    Bool initialized;
+    Bool single;
+    PyObject **items;
+    Py_ssize_t capacity;
+    Py_ssize_t head;
+    Py_ssize_t count;
+    int get_waiters;
+    int put_waiters;
+    uv_mutex_t mutex;
+    uv_cond_t not_empty;
+    uv_cond_t not_full;
+} ThreadQueue;
+
+static PyTypeObject SPSCQueueType;
+static PyTypeObject MPMCQueueType;
+
+/* Thread */
+typedef struct {
+    PyObject_HEAD
+    Bool initialized;
+    Bool started;
+    Bool finished;
+    Bool joined;
+    PyObject *target;
+    PyObject *args;
+    PyObject *kwargs;
+    PyObject *name;
+    PyObject *cpus;
+    Py_ssize_t stack_size;
+    char native_name[16];
+    uv_thread_t tid;
+} Thread;
+
+static PyTypeObject ThreadType;
+
+/* LoopThread */
+typedef struct {
+    PyObject_HEAD
+    Bool initialized;
+    Bool async_initialized;
+    Bool stopping;
+    Loop *loop;
+    PyObject *thread;
+    PyObject *pending;
+    uv_async_t async_h;
+} LoopThread;
+
+static PyTypeObject LoopThreadType;
+
+#ifdef PYUV_PYTHON3
+/* asyncio event loop core */
+typedef struct {
+    uv_timer_t timer_h;
+    uv_async_t async_h;
+    int pending_closes;
+} asyncio_loop_watchers;
+
+typedef struct AsyncioHandle AsyncioHandle;
+
+typedef struct {
+    PyObject_HEAD
+    Bool initialized;
+    Bool closed;
+    Bool stopping;
+    Bool debug;
+    Loop *loop;
+    PyObject *io_events;
+    asyncio_loop_watchers *watchers;
+    struct {
+        PyObject **items;
+        Py_ssize_t capacity;
+        Py_ssize_t head;
+        Py_ssize_t count;
+    } ready;
+    struct {
+        AsyncioHandle **items;
+        Py_ssize_t capacity;
+        Py_ssize_t count;
+        unsigned long long seq;
+    } scheduled;
+} AsyncioLoop;
+
+static PyTypeObject AsyncioLoopType;
+
+struct AsyncioHandle {
+    PyObject_HEAD
+    PyObject *weakreflist;
+    PyObject *callback;
+    PyObject *args;
+    PyObject *context;
+    AsyncioLoop *loop;
+    Bool cancelled;
+    double when;
+    Py_ssize_t heap_index;
+    unsigned long long seq;
+};
+
+static PyTypeObject AsyncioHandleType;
+static PyTypeObject AsyncioTimerHandleType;
+#endif
+
 /* Request */
+enum {
+    PYUV_REQUEST_PENDING = 0,
+    PYUV_REQUEST_DONE,
+    PYUV_REQUEST_FAILED,
+    PYUV_REQUEST_CANCELLED
+};
+
 typedef struct {
     PyObject_HEAD
     Bool initialized;
     uv_req_t *req_ptr;
     Loop *loop;
     PyObject *dict;
+    struct {
+        int state;
+        PyObject *value;
+        PyObject *future;
+    } completion;
 } Request;
 
 static PyTypeObject RequestType;
 
+/* RequestFuture: what awaiting a Request yields to the asyncio task */
+typedef struct {
+    PyObject_HEAD
+    Request *request;
+    PyObject *loop;
+    PyObject *callbacks;
+    PyObject *cancel_msg;
+    Bool blocking;
+} RequestFuture;
+
+static PyTypeObject RequestFutureType;
+
+/* callback marker for requests which are only awaited */
+static PyObject *pyuv__awaitable;
+
 /* GAIRequest */
 typedef struct {
     Request request;
@@ -437,6 +770,8 @@ typedef struct {
     uv_work_t req;
     PyObject *work_cb;
     PyObject *done_cb;
+    PyObject *result;
+    PyObject *error;
 } WorkRequest;
 
 static PyTypeObject WorkRequestType;
@@ -578,6 +913,12 @@ static PyStructSequence_Field cpu_info_result_fields[] = {
     {"model", ""},
     {"speed", ""},
     {"times", ""},
+    /* topology, only available as attributes */
+    {"cpu", ""},
+    {"core", ""},
+    {"package", ""},
+    {"siblings", ""},
+    {"numa_node", ""},
     {NULL}
 };
 
@@ -1,4 +1,529 @@
 
+/* Requests can be awaited from asyncio coroutines. The completion state is recorded in C when
+ * the libuv callback runs, and awaiting a request yields a RequestFuture, a minimal
+ * future-compatible object which asyncio tasks know how to wait for. Passing AWAITABLE as the
+ * callback starts a request asynchronously without a Python callback.
+ */
+
+static PyObject *
+pyuv__awaitable_func(PyObject *obj, PyObject *args)
+{
+    UNUSED_ARG(obj);
+    UNUSED_ARG(args);
+    Py_RETURN_NONE;
+}
+
+
+static PyMethodDef pyuv__awaitable_def = {
+    "AWAITABLE", (PyCFunction)pyuv__awaitable_func, METH_VARARGS, "Pass as callback in order to await the request."
+};
+
+
+static PyObject *
+pyuv__asyncio_attr(const char *name)
+{
+    PyObject *asyncio, *attr;
+
+    asyncio = PyImport_ImportModule("asyncio");
+    if (asyncio == NULL) {
+        return NULL;
+    }
+    attr = PyObject_GetAttrString(asyncio, name);
+    Py_DECREF(asyncio);
+    return attr;
+}
+
+
+/* same as with asyncio futures, done callbacks are scheduled with call_soon */
+static int
+pyuv__request_future_schedule(RequestFuture *self, PyObject *callback, PyObject *context)
+{
+    PyObject *call_soon, *args, *kwargs, *result;
+
+    call_soon = PyObject_GetAttrString(self->loop, "call_soon");
+    if (call_soon == NULL) {
+        return -1;
+    }
+
+    args = PyTuple_Pack(2, callback, (PyObject *)self);
+    kwargs = NULL;
+    if (args != NULL && context != Py_None) {
+        kwargs = Py_BuildValue("{s:O}", "context", context);
+    }
+
+    result = NULL;
+    if (args != NULL && (context == Py_None || kwargs != NULL)) {
+        result = PyObject_Call(call_soon, args, kwargs);
+    }
+
+    Py_DECREF(call_soon);
+    Py_XDECREF(args);
+    Py_XDECREF(kwargs);
+    if (result == NULL) {
+        return -1;
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
+
+static void
+pyuv__request_finish(Request *self)
+{
+    Py_ssize_t i;
+    RequestFuture *future;
+    PyObject *callbacks, *item;
+
+    future = (RequestFuture *)self->completion.future;
+    if (future == NULL || future->callbacks == NULL) {
+        return;
+    }
+
+    callbacks = future->callbacks;
+    future->callbacks = NULL;
+
+    for (i = 0; i < PyList_GET_SIZE(callbacks); i++) {
+        item = PyList_GET_ITEM(callbacks, i);
+        if (pyuv__request_future_schedule(future, PyTuple_GET_ITEM(item, 0), PyTuple_GET_ITEM(item, 1)) < 0) {
+            handle_uncaught_exception(self->loop);
+        }
+    }
+
+    Py_DECREF(callbacks);
+}
+
+
+static void
+pyuv__request_complete(Request *self, int err, PyObject *value, PyObject *exc_type)
+{
+    PyObject *tmp, *exc;
+
+    tmp = self->completion.value;
+    if (err == UV_ECANCELED || err == UV_EAI_CANCELED) {
+        self->completion.state = PYUV_REQUEST_CANCELLED;
+        self->completion.value = NULL;
+    } else if (err < 0) {
+        exc = PyObject_CallFunction(exc_type, "is", err, uv_strerror(err));
+        if (exc == NULL) {
+            /* fail with whatever went wrong creating the exception */
+            PyObject *type, *tb;
+            PyErr_Fetch(&type, &exc, &tb);
+            PyErr_NormalizeException(&type, &exc, &tb);
+            Py_XDECREF(type);
+            Py_XDECREF(tb);
+        }
+        self->completion.state = PYUV_REQUEST_FAILED;
+        self->completion.value = exc;
+    } else {
+        self->completion.state = PYUV_REQUEST_DONE;
+        Py_INCREF(value);
+        self->completion.value = value;
+    }
+    Py_XDECREF(tmp);
+
+    pyuv__request_finish(self);
+}
+
+
+static void
+pyuv__request_complete_exception(Request *self, PyObject *exc)
+{
+    PyObject *tmp;
+
+    tmp = self->completion.value;
+    Py_INCREF(exc);
+    self->completion.value = exc;
+    self->completion.state = PYUV_REQUEST_FAILED;
+    Py_XDECREF(tmp);
+
+    pyuv__request_finish(self);
+}
+
+
+static PyObject *
+RequestFuture_func_get_loop(RequestFuture *self)
+{
+    PyObject *get_event_loop;
+
+    if (self->loop == NULL) {
+        get_event_loop = pyuv__asyncio_attr("get_event_loop");
+        if (get_event_loop == NULL) {
+            return NULL;
+        }
+        self->loop = PyObject_CallFunctionObjArgs(get_event_loop, NULL);
+        Py_DECREF(get_event_loop);
+        if (self->loop == NULL) {
+            return NULL;
+        }
+    }
+    Py_INCREF(self->loop);
+    return self->loop;
+}
+
+
+static PyObject *
+RequestFuture_loop_get(RequestFuture *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return RequestFuture_func_get_loop(self);
+}
+
+
+static PyObject *
+RequestFuture_blocking_get(RequestFuture *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyBool_FromLong((long)self->blocking);
+}
+
+
+static int
+RequestFuture_blocking_set(RequestFuture *self, PyObject *value, void *closure)
+{
+    int r;
+
+    UNUSED_ARG(closure);
+
+    if (value == NULL) {
+        PyErr_SetString(PyExc_AttributeError, "cannot delete attribute");
+        return -1;
+    }
+    r = PyObject_IsTrue(value);
+    if (r < 0) {
+        return -1;
+    }
+    self->blocking = r ? True : False;
+    return 0;
+}
+
+
+static PyObject *
+RequestFuture_func_done(RequestFuture *self)
+{
+    return PyBool_FromLong((long)(self->request->completion.state != PYUV_REQUEST_PENDING));
+}
+
+
+static PyObject *
+RequestFuture_func_cancelled(RequestFuture *self)
+{
+    return PyBool_FromLong((long)(self->request->completion.state == PYUV_REQUEST_CANCELLED));
+}
+
+
+static PyObject *
+RequestFuture_func_cancel(RequestFuture *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *msg, *tmp;
+    Request *request = self->request;
+
+    static char *kwlist[] = {"msg", NULL};
+
+    msg = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O:cancel", kwlist, &msg)) {
+        return NULL;
+    }
+
+    /* the request completes with UV_ECANCELED later on */
+    if (request->completion.state == PYUV_REQUEST_PENDING && request->req_ptr && uv_cancel(request->req_ptr) == 0) {
+        tmp = self->cancel_msg;
+        Py_INCREF(msg);
+        self->cancel_msg = msg;
+        Py_XDECREF(tmp);
+        Py_RETURN_TRUE;
+    } else {
+        Py_RETURN_FALSE;
+    }
+}
+
+
+static int
+pyuv__request_future_check_state(RequestFuture *self)
+{
+    PyObject *exc_type;
+
+    switch (self->request->completion.state) {
+        case PYUV_REQUEST_PENDING:
+            exc_type = pyuv__asyncio_attr("InvalidStateError");
+            if (exc_type != NULL) {
+                PyErr_SetString(exc_type, "Result is not ready.");
+                Py_DECREF(exc_type);
+            }
+            return -1;
+        case PYUV_REQUEST_CANCELLED:
+            exc_type = pyuv__asyncio_attr("CancelledError");
+            if (exc_type != NULL) {
+                if (self->cancel_msg != NULL && self->cancel_msg != Py_None) {
+                    PyErr_SetObject(exc_type, self->cancel_msg);
+                } else {
+                    PyErr_SetNone(exc_type);
+                }
+                Py_DECREF(exc_type);
+            }
+            return -1;
+        default:
+            return 0;
+    }
+}
+
+
+static PyObject *
+RequestFuture_func_result(RequestFuture *self)
+{
+    PyObject *value;
+
+    if (pyuv__request_future_check_state(self) < 0) {
+        return NULL;
+    }
+
+    value = self->request->completion.value;
+    if (self->request->completion.state == PYUV_REQUEST_FAILED) {
+        PyErr_SetObject((PyObject *)Py_TYPE(value), value);
+        return NULL;
+    }
+    Py_INCREF(value);
+    return value;
+}
+
+
+static PyObject *
+RequestFuture_func_exception(RequestFuture *self)
+{
+    if (pyuv__request_future_check_state(self) < 0) {
+        return NULL;
+    }
+
+    if (self->request->completion.state == PYUV_REQUEST_FAILED) {
+        Py_INCREF(self->request->completion.value);
+        return self->request->completion.value;
+    }
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+RequestFuture_func_add_done_callback(RequestFuture *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *callback, *context, *loop, *item;
+
+    static char *kwlist[] = {"fn", "context", NULL};
+
+    context = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O:add_done_callback", kwlist, &callback, &context)) {
+        return NULL;
+    }
+
+    loop = RequestFuture_func_get_loop(self);
+    if (loop == NULL) {
+        return NULL;
+    }
+    Py_DECREF(loop);
+
+    if (self->request->completion.state != PYUV_REQUEST_PENDING) {
+        if (pyuv__request_future_schedule(self, callback, context) < 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    if (self->callbacks == NULL) {
+        self->callbacks = PyList_New(0);
+        if (self->callbacks == NULL) {
+            return NULL;
+        }
+    }
+
+    item = PyTuple_Pack(2, callback, context);
+    if (item == NULL) {
+        return NULL;
+    }
+    if (PyList_Append(self->callbacks, item) < 0) {
+        Py_DECREF(item);
+        return NULL;
+    }
+    Py_DECREF(item);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+RequestFuture_func_remove_done_callback(RequestFuture *self, PyObject *callback)
+{
+    int r;
+    Py_ssize_t i, count;
+
+    count = 0;
+    if (self->callbacks == NULL) {
+        return PyInt_FromSsize_t(count);
+    }
+
+    for (i = PyList_GET_SIZE(self->callbacks) - 1; i >= 0; i--) {
+        r = PyObject_RichCompareBool(PyTuple_GET_ITEM(PyList_GET_ITEM(self->callbacks, i), 0), callback, Py_EQ);
+        if (r < 0) {
+            return NULL;
+        }
+        if (r && PySequence_DelItem(self->callbacks, i) == 0) {
+            count++;
+        }
+    }
+
+    return PyInt_FromSsize_t(count);
+}
+
+
+static PyObject *
+RequestFuture_tp_iternext(RequestFuture *self)
+{
+    PyObject *result, *exc;
+
+    if (self->request->completion.state == PYUV_REQUEST_PENDING) {
+        /* yield to the task, which waits for the request to complete */
+        self->blocking = True;
+        Py_INCREF(self);
+        return (PyObject *)self;
+    }
+
+    result = RequestFuture_func_result(self);
+    if (result == NULL) {
+        return NULL;
+    }
+
+    /* return the result from the await expression */
+    if (result != Py_None) {
+        exc = PyObject_CallFunctionObjArgs(PyExc_StopIteration, result, NULL);
+        if (exc != NULL) {
+            PyErr_SetObject(PyExc_StopIteration, exc);
+            Py_DECREF(exc);
+        }
+    }
+    Py_DECREF(result);
+    return NULL;
+}
+
+
+static int
+RequestFuture_tp_traverse(RequestFuture *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->request);
+    Py_VISIT(self->loop);
+    Py_VISIT(self->callbacks);
+    Py_VISIT(self->cancel_msg);
+    return 0;
+}
+
+
+static int
+RequestFuture_tp_clear(RequestFuture *self)
+{
+    Py_CLEAR(self->request);
+    Py_CLEAR(self->loop);
+    Py_CLEAR(self->callbacks);
+    Py_CLEAR(self->cancel_msg);
+    return 0;
+}
+
+
+static void
+RequestFuture_tp_dealloc(RequestFuture *self)
+{
+    PyObject_GC_UnTrack(self);
+    Py_TYPE(self)->tp_clear((PyObject *)self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyMethodDef
+RequestFuture_tp_methods[] = {
+    { "done", (PyCFunction)RequestFuture_func_done, METH_NOARGS, "Return True if the request completed." },
+    { "cancelled", (PyCFunction)RequestFuture_func_cancelled, METH_NOARGS, "Return True if the request was cancelled." },
+    { "cancel", (PyCFunction)RequestFuture_func_cancel, METH_VARARGS|METH_KEYWORDS, "Cancel the request." },
+    { "result", (PyCFunction)RequestFuture_func_result, METH_NOARGS, "Return the result of the request." },
+    { "exception", (PyCFunction)RequestFuture_func_exception, METH_NOARGS, "Return the exception the request failed with." },
+    { "add_done_callback", (PyCFunction)RequestFuture_func_add_done_callback, METH_VARARGS|METH_KEYWORDS, "Add a callback to be run when the request completes." },
+    { "remove_done_callback", (PyCFunction)RequestFuture_func_remove_done_callback, METH_O, "Remove all instances of a callback." },
+    { "get_loop", (PyCFunction)RequestFuture_func_get_loop, METH_NOARGS, "Return the asyncio event loop the request is awaited from." },
+    { NULL }
+};
+
+
+static PyGetSetDef RequestFuture_tp_getsets[] = {
+    {"_loop", (getter)RequestFuture_loop_get, NULL, "asyncio event loop the request is awaited from.", NULL},
+    {"_asyncio_future_blocking", (getter)RequestFuture_blocking_get, (setter)RequestFuture_blocking_set, "Used by asyncio tasks.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject RequestFutureType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.RequestFuture",                                    /*tp_name*/
+    sizeof(RequestFuture),                                          /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)RequestFuture_tp_dealloc,                           /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                        /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)RequestFuture_tp_traverse,                        /*tp_traverse*/
+    (inquiry)RequestFuture_tp_clear,                                /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    PyObject_SelfIter,                                              /*tp_iter*/
+    (iternextfunc)RequestFuture_tp_iternext,                        /*tp_iternext*/
+    RequestFuture_tp_methods,                                       /*tp_methods*/
+    0,                                                              /*tp_members*/
+    RequestFuture_tp_getsets,                                       /*tp_getsets*/
+};
+
+
+static PyObject *
+Request_tp_await(Request *self)
+{
+    RequestFuture *future;
+
+    if (self->completion.future == NULL) {
+        future = PyObject_GC_New(RequestFuture, &RequestFutureType);
+        if (future == NULL) {
+            return NULL;
+        }
+        Py_INCREF(self);
+        future->request = self;
+        future->loop = NULL;
+        future->callbacks = NULL;
+        future->cancel_msg = NULL;
+        future->blocking = False;
+        PyObject_GC_Track(future);
+        self->completion.future = (PyObject *)future;
+    }
+
+    Py_INCREF(self->completion.future);
+    return self->completion.future;
+}
+
+
+#if PY_VERSION_HEX >= 0x03050000
+static PyAsyncMethods Request_tp_as_async = {
+    (unaryfunc)Request_tp_await,                                    /*am_await*/
+    0,                                                              /*am_aiter*/
+    0,                                                              /*am_anext*/
+};
+#endif
+
+
 static PyObject *
 Request_func_cancel(Request *self)
 {
@@ -120,6 +645,8 @@ Request_tp_traverse(Request *self, visitproc visit, void *arg)
 {
     Py_VISIT(self->loop);
     Py_VISIT(self->dict);
+    Py_VISIT(self->completion.value);
+    Py_VISIT(self->completion.future);
     return 0;
 }
 
@@ -129,6 +656,8 @@ Request_tp_clear(Request *self)
 {
     Py_CLEAR(self->loop);
     Py_CLEAR(self->dict);
+    Py_CLEAR(self->completion.value);
+    Py_CLEAR(self->completion.future);
     return 0;
 }
 
@@ -442,6 +971,8 @@ WorkRequest_tp_traverse(WorkRequest *self, visitproc visit, void *arg)
 {
     Py_VISIT(self->work_cb);
     Py_VISIT(self->done_cb);
+    Py_VISIT(self->result);
+    Py_VISIT(self->error);
     return RequestType.tp_traverse((PyObject *)self, visit, arg);
 }
 
@@ -451,6 +982,8 @@ WorkRequest_tp_clear(WorkRequest *self)
 {
     Py_CLEAR(self->work_cb);
     Py_CLEAR(self->done_cb);
+    Py_CLEAR(self->result);
+    Py_CLEAR(self->error);
     return RequestType.tp_clear((PyObject *)self);
 }
 
@@ -0,0 +1,1156 @@
+
+/* Resolver: asynchronous DNS stub resolver which talks to the nameservers directly over UDP (and
+ * TCP for truncated answers), without using the threadpool.
+ */
+
+#define PYUV__DNS_PORT           53
+#define PYUV__DNS_HEADER_SIZE    12
+#define PYUV__DNS_MAX_NAME       255
+#define PYUV__DNS_MAX_QUERY      (PYUV__DNS_HEADER_SIZE + PYUV__DNS_MAX_NAME + 1 + 4)
+#define PYUV__DNS_UDP_BUFSIZE    4096
+#define PYUV__DNS_TCP_BUFSIZE    (65535 + 2)
+#define PYUV__DNS_MAX_NAMESERVERS 3
+
+#define PYUV__DNS_CLASS_IN       1
+
+#define PYUV__DNS_FLAG_QR        0x8000
+#define PYUV__DNS_FLAG_TC        0x0200
+#define PYUV__DNS_FLAG_RD        0x0100
+
+#define PYUV__DNS_RCODE_OK       0
+#define PYUV__DNS_RCODE_SERVFAIL 2
+#define PYUV__DNS_RCODE_NXDOMAIN 3
+#define PYUV__DNS_RCODE_NOTIMP   4
+#define PYUV__DNS_RCODE_REFUSED  5
+
+#define PYUV__DNS_GET16(p)       ((uint16_t)(((p)[0] << 8) | (p)[1]))
+#define PYUV__DNS_GET32(p)       ((uint32_t)(((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3]))
+#define PYUV__DNS_PUT16(p, v)    do { (p)[0] = (unsigned char)(((v) >> 8) & 0xff); (p)[1] = (unsigned char)((v) & 0xff); } while(0)
+
+
+struct pyuv__resolver_query_s {
+    Resolver *resolver;
+    PyObject *callback;
+    pyuv__resolver_query *next;
+    pyuv__resolver_query *prev;
+    uv_udp_t udp_h;
+    uv_tcp_t tcp_h;
+    uv_timer_t timer_h;
+    uv_connect_t connect_req;
+    uv_write_t write_req;
+    unsigned char query[PYUV__DNS_MAX_QUERY + 2];
+    size_t query_len;
+    unsigned char udp_buf[PYUV__DNS_UDP_BUFSIZE];
+    unsigned char *tcp_buf;
+    size_t tcp_len;
+    unsigned char *answer;
+    size_t answer_len;
+    uint16_t id;
+    int qtype;
+    int attempt;
+    int active_handles;
+    Bool tcp_started;
+    Bool done;
+    int status;
+};
+
+
+/* DNS message helpers */
+
+static int
+pyuv__dns_build_query(unsigned char *buf, size_t *buf_len, const char *name, uint16_t id, int qtype)
+{
+    unsigned char *p, *label;
+    const char *c;
+    size_t len;
+
+    memset(buf, 0, PYUV__DNS_HEADER_SIZE);
+    PYUV__DNS_PUT16(buf, id);
+    PYUV__DNS_PUT16(buf + 2, PYUV__DNS_FLAG_RD);
+    PYUV__DNS_PUT16(buf + 4, 1);
+
+    p = buf + PYUV__DNS_HEADER_SIZE;
+    len = strlen(name);
+    if (len > 0 && name[len - 1] == '.') {
+        len--;
+    }
+    if (len > PYUV__DNS_MAX_NAME - 2) {
+        return UV_EINVAL;
+    }
+
+    label = p++;
+    for (c = name; c < name + len; c++) {
+        if (*c == '.') {
+            if (p - label - 1 == 0 || p - label - 1 > 63) {
+                return UV_EINVAL;
+            }
+            *label = (unsigned char)(p - label - 1);
+            label = p++;
+        } else {
+            *p++ = (unsigned char)*c;
+        }
+    }
+    if (len > 0) {
+        if (p - label - 1 == 0 || p - label - 1 > 63) {
+            return UV_EINVAL;
+        }
+        *label = (unsigned char)(p - label - 1);
+        *p++ = 0;
+    } else {
+        /* the root */
+        *label = 0;
+    }
+
+    PYUV__DNS_PUT16(p, qtype);
+    PYUV__DNS_PUT16(p + 2, PYUV__DNS_CLASS_IN);
+    p += 4;
+
+    *buf_len = p - buf;
+    return 0;
+}
+
+
+/* Read a (possibly compressed) name starting at *offset, which is moved past it. If out is not NULL
+ * the name is stored there in dotted form.
+ */
+static int
+pyuv__dns_read_name(const unsigned char *msg, size_t msg_len, size_t *offset, char *out, size_t out_size)
+{
+    size_t pos, out_len;
+    int jumps;
+    Bool jumped;
+    unsigned int len;
+
+    pos = *offset;
+    out_len = 0;
+    jumps = 0;
+    jumped = False;
+
+    for (;;) {
+        if (pos >= msg_len) {
+            return UV_EPROTO;
+        }
+        len = msg[pos];
+        if ((len & 0xc0) == 0xc0) {
+            if (pos + 1 >= msg_len || ++jumps > 64) {
+                return UV_EPROTO;
+            }
+            if (!jumped) {
+                *offset = pos + 2;
+                jumped = True;
+            }
+            pos = ((len & 0x3f) << 8) | msg[pos + 1];
+            continue;
+        } else if (len & 0xc0) {
+            return UV_EPROTO;
+        }
+        pos++;
+        if (len == 0) {
+            break;
+        }
+        if (pos + len > msg_len) {
+            return UV_EPROTO;
+        }
+        if (out) {
+            if (out_len + len + 2 > out_size) {
+                return UV_EPROTO;
+            }
+            if (out_len > 0) {
+                out[out_len++] = '.';
+            }
+            memcpy(out + out_len, msg + pos, len);
+            out_len += len;
+        }
+        pos += len;
+    }
+
+    if (!jumped) {
+        *offset = pos;
+    }
+    if (out) {
+        out[out_len] = '\0';
+    }
+    return 0;
+}
+
+
+static int
+pyuv__dns_rcode_to_error(int rcode)
+{
+    switch (rcode) {
+        case PYUV__DNS_RCODE_OK:
+            return 0;
+        case PYUV__DNS_RCODE_NXDOMAIN:
+            return UV_EAI_NONAME;
+        case PYUV__DNS_RCODE_SERVFAIL:
+            return UV_EAI_AGAIN;
+        default:
+            return UV_EAI_FAIL;
+    }
+}
+
+
+/* Build the Python result out of a DNS answer. Must be called with the GIL held. */
+static int
+pyuv__dns_parse_answer(const unsigned char *msg, size_t msg_len, int qtype, PyObject **result)
+{
+    int err, i, qdcount, ancount;
+    uint16_t type, klass, rdlen, flags;
+    uint32_t ttl;
+    size_t offset, rd_offset, pos;
+    char name[PYUV__DNS_MAX_NAME + 2];
+    char ip[INET6_ADDRSTRLEN];
+    PyObject *item, *txt, *chunk;
+
+    if (msg_len < PYUV__DNS_HEADER_SIZE) {
+        return UV_EPROTO;
+    }
+
+    flags = PYUV__DNS_GET16(msg + 2);
+    err = pyuv__dns_rcode_to_error(flags & 0x000f);
+    if (err != 0) {
+        return err;
+    }
+
+    qdcount = PYUV__DNS_GET16(msg + 4);
+    ancount = PYUV__DNS_GET16(msg + 6);
+    offset = PYUV__DNS_HEADER_SIZE;
+
+    /* the question was matched against the query already, see pyuv__resolver_query_matches */
+    for (i = 0; i < qdcount; i++) {
+        err = pyuv__dns_read_name(msg, msg_len, &offset, NULL, 0);
+        if (err != 0) {
+            return err;
+        }
+        offset += 4;
+    }
+
+    *result = PyList_New(0);
+    if (!*result) {
+        return UV_ENOMEM;
+    }
+
+    for (i = 0; i < ancount; i++) {
+        err = pyuv__dns_read_name(msg, msg_len, &offset, NULL, 0);
+        if (err != 0 || offset + 10 > msg_len) {
+            goto error;
+        }
+        type = PYUV__DNS_GET16(msg + offset);
+        klass = PYUV__DNS_GET16(msg + offset + 2);
+        ttl = PYUV__DNS_GET32(msg + offset + 4);
+        rdlen = PYUV__DNS_GET16(msg + offset + 8);
+        rd_offset = offset + 10;
+        offset = rd_offset + rdlen;
+        if (offset > msg_len) {
+            goto error;
+        }
+        if (klass != PYUV__DNS_CLASS_IN || type != qtype) {
+            /* CNAME records and such */
+            continue;
+        }
+
+        item = NULL;
+        switch (type) {
+            case PYUV_QUERY_TYPE_A:
+                if (rdlen != 4) {
+                    goto error;
+                }
+                uv_inet_ntop(AF_INET, msg + rd_offset, ip, sizeof(ip));
+                item = Py_BuildValue("(sk)", ip, (unsigned long)ttl);
+                break;
+            case PYUV_QUERY_TYPE_AAAA:
+                if (rdlen != 16) {
+                    goto error;
+                }
+                uv_inet_ntop(AF_INET6, msg + rd_offset, ip, sizeof(ip));
+                item = Py_BuildValue("(sk)", ip, (unsigned long)ttl);
+                break;
+            case PYUV_QUERY_TYPE_SRV:
+                if (rdlen < 7) {
+                    goto error;
+                }
+                pos = rd_offset + 6;
+                if (pyuv__dns_read_name(msg, msg_len, &pos, name, sizeof(name)) != 0) {
+                    goto error;
+                }
+                item = Py_BuildValue("(iiisk)", PYUV__DNS_GET16(msg + rd_offset), PYUV__DNS_GET16(msg + rd_offset + 2),
+                                                PYUV__DNS_GET16(msg + rd_offset + 4), name, (unsigned long)ttl);
+                break;
+            case PYUV_QUERY_TYPE_TXT:
+                /* a TXT record contains one or more character strings, join them */
+                txt = PyBytes_FromStringAndSize(NULL, 0);
+                pos = rd_offset;
+                while (txt && pos < rd_offset + rdlen) {
+                    if (pos + 1 + msg[pos] > rd_offset + rdlen) {
+                        Py_DECREF(txt);
+                        goto error;
+                    }
+                    chunk = PyBytes_FromStringAndSize((const char *)msg + pos + 1, msg[pos]);
+                    PyBytes_ConcatAndDel(&txt, chunk);
+                    pos += 1 + msg[pos];
+                }
+                if (txt) {
+                    item = Py_BuildValue("(Nk)", txt, (unsigned long)ttl);
+                }
+                break;
+            default:
+                ASSERT(0);
+        }
+
+        if (!item || PyList_Append(*result, item) != 0) {
+            Py_XDECREF(item);
+            Py_CLEAR(*result);
+            PyErr_Clear();
+            return UV_ENOMEM;
+        }
+        Py_DECREF(item);
+    }
+
+    if (PyList_GET_SIZE(*result) == 0) {
+        Py_CLEAR(*result);
+        return UV_EAI_NODATA;
+    }
+
+    return 0;
+
+error:
+    Py_CLEAR(*result);
+    return UV_EPROTO;
+}
+
+
+/* Query handling. The query context is allocated with malloc, since it's released from close
+ * callbacks which run without the GIL.
+ */
+
+static void pyuv__resolver_query_attempt(pyuv__resolver_query *query);
+
+
+static uint16_t
+pyuv__resolver_next_id(Resolver *resolver)
+{
+    /* xorshift32, seeded with the high resolution clock */
+    uint32_t x = resolver->seed ^ (uint32_t)uv_hrtime();
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    resolver->seed = x;
+    return (uint16_t)(x & 0xffff);
+}
+
+
+static void
+pyuv__resolver_query_deliver(pyuv__resolver_query *query)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Resolver *resolver;
+    PyObject *dns_result, *errorno, *result;
+    int err;
+
+    resolver = query->resolver;
+    dns_result = NULL;
+
+    err = query->status;
+    if (err == 0) {
+        err = pyuv__dns_parse_answer(query->answer, query->answer_len, query->qtype, &dns_result);
+    }
+
+    if (err == 0) {
+        PYUV_SET_NONE(errorno);
+    } else {
+        errorno = PyInt_FromLong((long)err);
+        PYUV_SET_NONE(dns_result);
+    }
+
+    result = PyObject_CallFunctionObjArgs(query->callback, dns_result, errorno, NULL);
+    if (result == NULL) {
+        handle_uncaught_exception(resolver->loop);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(dns_result);
+    Py_DECREF(errorno);
+
+    Py_DECREF(query->callback);
+    free(query->answer);
+    free(query->tcp_buf);
+    free(query);
+
+    /* Refcount was increased when the query was started */
+    Py_DECREF(resolver);
+
+    PyGILState_Release(gstate);
+}
+
+
+static void
+pyuv__resolver_close_cb(uv_handle_t *handle)
+{
+    pyuv__resolver_query *query = handle->data;
+    if (--query->active_handles == 0) {
+        pyuv__resolver_query_deliver(query);
+    }
+}
+
+
+static void
+pyuv__resolver_query_finish(pyuv__resolver_query *query, int status)
+{
+    Resolver *resolver = query->resolver;
+
+    if (query->done) {
+        return;
+    }
+    query->done = True;
+    query->status = status;
+
+    /* unlink */
+    if (query->prev) {
+        query->prev->next = query->next;
+    } else {
+        resolver->queries = query->next;
+    }
+    if (query->next) {
+        query->next->prev = query->prev;
+    }
+
+    uv_close((uv_handle_t *)&query->udp_h, pyuv__resolver_close_cb);
+    uv_close((uv_handle_t *)&query->timer_h, pyuv__resolver_close_cb);
+    if (query->tcp_started) {
+        uv_close((uv_handle_t *)&query->tcp_h, pyuv__resolver_close_cb);
+    }
+}
+
+
+/* Check that a message answers the query: it must be a response with the query id which echoes
+ * the question, the name being compared case-insensitively (RFC 4343).
+ */
+static Bool
+pyuv__resolver_query_matches(pyuv__resolver_query *query, const unsigned char *msg, size_t msg_len)
+{
+    const unsigned char *sent;
+    size_t offset, sent_offset;
+    char name[PYUV__DNS_MAX_NAME + 2];
+    char sent_name[PYUV__DNS_MAX_NAME + 2];
+    char *a, *b;
+
+    if (msg_len < PYUV__DNS_HEADER_SIZE || PYUV__DNS_GET16(msg) != query->id) {
+        return False;
+    }
+
+    if (!(PYUV__DNS_GET16(msg + 2) & PYUV__DNS_FLAG_QR) || PYUV__DNS_GET16(msg + 4) != 1) {
+        return False;
+    }
+
+    offset = PYUV__DNS_HEADER_SIZE;
+    if (pyuv__dns_read_name(msg, msg_len, &offset, name, sizeof(name)) != 0 || offset + 4 > msg_len) {
+        return False;
+    }
+
+    /* the query was moved forward to make room for the length prefix when TCP was started */
+    sent = query->query + (query->tcp_started ? 2 : 0);
+    sent_offset = PYUV__DNS_HEADER_SIZE;
+    if (pyuv__dns_read_name(sent, query->query_len, &sent_offset, sent_name, sizeof(sent_name)) != 0) {
+        return False;
+    }
+
+    for (a = name, b = sent_name; *a && *b; a++, b++) {
+        if (Py_TOLOWER(*a) != Py_TOLOWER(*b)) {
+            return False;
+        }
+    }
+    if (*a || *b) {
+        return False;
+    }
+
+    /* qtype and qclass */
+    return memcmp(msg + offset, sent + sent_offset, 4) == 0;
+}
+
+
+/* Validate a response and take ownership of it. Returns True if the query is complete. */
+static Bool
+pyuv__resolver_query_response(pyuv__resolver_query *query, unsigned char *msg, size_t msg_len, Bool copy)
+{
+    uint16_t flags;
+    int rcode;
+
+    if (!pyuv__resolver_query_matches(query, msg, msg_len)) {
+        return False;
+    }
+
+    flags = PYUV__DNS_GET16(msg + 2);
+
+    rcode = flags & 0x000f;
+    if ((rcode == PYUV__DNS_RCODE_SERVFAIL || rcode == PYUV__DNS_RCODE_NOTIMP || rcode == PYUV__DNS_RCODE_REFUSED) &&
+        query->attempt + 1 < query->resolver->tries * query->resolver->nameservers_count) {
+        /* try the next server */
+        query->attempt++;
+        pyuv__resolver_query_attempt(query);
+        return False;
+    }
+
+    if (copy) {
+        query->answer = malloc(msg_len);
+        if (!query->answer) {
+            pyuv__resolver_query_finish(query, UV_ENOMEM);
+            return True;
+        }
+        memcpy(query->answer, msg, msg_len);
+    } else {
+        query->answer = msg;
+    }
+    query->answer_len = msg_len;
+
+    pyuv__resolver_query_finish(query, 0);
+    return True;
+}
+
+
+static void
+pyuv__resolver_tcp_alloc_cb(uv_handle_t* handle, size_t suggested_size, uv_buf_t *buf)
+{
+    pyuv__resolver_query *query = handle->data;
+
+    UNUSED_ARG(suggested_size);
+
+    if (!query->tcp_buf) {
+        query->tcp_buf = malloc(PYUV__DNS_TCP_BUFSIZE);
+    }
+    if (!query->tcp_buf || query->tcp_len == PYUV__DNS_TCP_BUFSIZE) {
+        buf->base = NULL;
+        buf->len = 0;
+        return;
+    }
+    buf->base = (char *)query->tcp_buf + query->tcp_len;
+    buf->len = PYUV__DNS_TCP_BUFSIZE - query->tcp_len;
+}
+
+
+static void
+pyuv__resolver_tcp_read_cb(uv_stream_t* handle, ssize_t nread, const uv_buf_t* buf)
+{
+    pyuv__resolver_query *query = handle->data;
+    unsigned char *msg;
+    size_t msg_len;
+
+    UNUSED_ARG(buf);
+
+    if (query->done) {
+        return;
+    }
+
+    if (nread < 0) {
+        /* connection failed, the timer will move on to the next attempt */
+        uv_read_stop(handle);
+        return;
+    }
+
+    query->tcp_len += nread;
+    if (query->tcp_len < 2) {
+        return;
+    }
+    msg_len = PYUV__DNS_GET16(query->tcp_buf);
+    if (query->tcp_len < msg_len + 2) {
+        return;
+    }
+
+    uv_read_stop(handle);
+
+    /* the answer is kept in the TCP buffer, after the length prefix */
+    msg = malloc(msg_len ? msg_len : 1);
+    if (!msg) {
+        pyuv__resolver_query_finish(query, UV_ENOMEM);
+        return;
+    }
+    memcpy(msg, query->tcp_buf + 2, msg_len);
+    if (!pyuv__resolver_query_response(query, msg, msg_len, False)) {
+        free(msg);
+    }
+}
+
+
+static void
+pyuv__resolver_tcp_write_cb(uv_write_t* req, int status)
+{
+    UNUSED_ARG(req);
+    UNUSED_ARG(status);
+}
+
+
+static void
+pyuv__resolver_tcp_connect_cb(uv_connect_t *req, int status)
+{
+    pyuv__resolver_query *query = req->data;
+    uv_buf_t buf;
+
+    if (query->done || status != 0) {
+        return;
+    }
+
+    /* the query buffer has 2 bytes of room for the length prefix */
+    PYUV__DNS_PUT16(query->query, query->query_len);
+    buf = uv_buf_init((char *)query->query, (unsigned int)query->query_len + 2);
+    query->write_req.data = query;
+    if (uv_write(&query->write_req, (uv_stream_t *)&query->tcp_h, &buf, 1, pyuv__resolver_tcp_write_cb) == 0) {
+        uv_read_start((uv_stream_t *)&query->tcp_h, pyuv__resolver_tcp_alloc_cb, pyuv__resolver_tcp_read_cb);
+    }
+}
+
+
+static void
+pyuv__resolver_query_tcp(pyuv__resolver_query *query, const struct sockaddr *addr)
+{
+    if (query->tcp_started) {
+        /* only one TCP connection per query */
+        return;
+    }
+
+    if (uv_tcp_init(query->udp_h.loop, &query->tcp_h) != 0) {
+        return;
+    }
+    query->tcp_h.data = query;
+    query->tcp_started = True;
+    query->active_handles++;
+
+    /* the query is moved 2 bytes forward to make room for the length prefix */
+    memmove(query->query + 2, query->query, query->query_len);
+    query->connect_req.data = query;
+    uv_tcp_connect(&query->connect_req, &query->tcp_h, addr, pyuv__resolver_tcp_connect_cb);
+}
+
+
+static void
+pyuv__resolver_udp_alloc_cb(uv_handle_t* handle, size_t suggested_size, uv_buf_t *buf)
+{
+    pyuv__resolver_query *query = handle->data;
+
+    UNUSED_ARG(suggested_size);
+
+    buf->base = (char *)query->udp_buf;
+    buf->len = sizeof(query->udp_buf);
+}
+
+
+static Bool
+pyuv__resolver_is_nameserver(Resolver *resolver, const struct sockaddr *addr)
+{
+    int i;
+    const struct sockaddr_storage *ns;
+
+    for (i = 0; i < resolver->nameservers_count; i++) {
+        ns = &resolver->nameservers[i];
+        if (ns->ss_family != addr->sa_family) {
+            continue;
+        }
+        if (addr->sa_family == AF_INET) {
+            const struct sockaddr_in *a = (const struct sockaddr_in *)addr;
+            const struct sockaddr_in *b = (const struct sockaddr_in *)ns;
+            if (a->sin_port == b->sin_port && a->sin_addr.s_addr == b->sin_addr.s_addr) {
+                return True;
+            }
+        } else if (addr->sa_family == AF_INET6) {
+            const struct sockaddr_in6 *a = (const struct sockaddr_in6 *)addr;
+            const struct sockaddr_in6 *b = (const struct sockaddr_in6 *)ns;
+            if (a->sin6_port == b->sin6_port && memcmp(&a->sin6_addr, &b->sin6_addr, sizeof(a->sin6_addr)) == 0) {
+                return True;
+            }
+        }
+    }
+
+    return False;
+}
+
+
+static void
+pyuv__resolver_udp_recv_cb(uv_udp_t* handle, ssize_t nread, const uv_buf_t* buf, const struct sockaddr* addr, unsigned flags)
+{
+    pyuv__resolver_query *query = handle->data;
+    unsigned char *msg;
+
+    if (query->done || nread <= 0 || !addr) {
+        return;
+    }
+
+    /* only accept answers from the configured servers */
+    if (!pyuv__resolver_is_nameserver(query->resolver, addr)) {
+        return;
+    }
+
+    msg = (unsigned char *)buf->base;
+    if (!pyuv__resolver_query_matches(query, msg, (size_t)nread)) {
+        return;
+    }
+
+    if ((flags & UV_UDP_PARTIAL) || (PYUV__DNS_GET16(msg + 2) & PYUV__DNS_FLAG_TC)) {
+        /* truncated, retry over TCP */
+        pyuv__resolver_query_tcp(query, addr);
+        return;
+    }
+
+    pyuv__resolver_query_response(query, msg, nread, True);
+}
+
+
+static void
+pyuv__resolver_timer_cb(uv_timer_t *handle)
+{
+    pyuv__resolver_query *query = handle->data;
+
+    query->attempt++;
+    pyuv__resolver_query_attempt(query);
+}
+
+
+static void
+pyuv__resolver_query_attempt(pyuv__resolver_query *query)
+{
+    int err;
+    uv_buf_t buf;
+    Resolver *resolver = query->resolver;
+    const struct sockaddr *addr;
+
+    if (query->attempt >= resolver->tries * resolver->nameservers_count) {
+        pyuv__resolver_query_finish(query, UV_ETIMEDOUT);
+        return;
+    }
+
+    /* servers are tried in order, the whole list is tried 'tries' times */
+    addr = (const struct sockaddr *)&resolver->nameservers[query->attempt % resolver->nameservers_count];
+
+    buf = uv_buf_init((char *)query->query, (unsigned int)query->query_len);
+    if (!query->tcp_started) {
+        err = uv_udp_try_send(&query->udp_h, &buf, 1, addr);
+        if (err < 0 && err != UV_EAGAIN) {
+            /* this server is not reachable, move on to the next one right away */
+            uv_timer_start(&query->timer_h, pyuv__resolver_timer_cb, 0, 0);
+            return;
+        }
+    }
+
+    uv_timer_start(&query->timer_h, pyuv__resolver_timer_cb, (uint64_t)(resolver->timeout * 1000), 0);
+}
+
+
+static void
+pyuv__resolver_cancel_all(Resolver *self)
+{
+    while (self->queries) {
+        pyuv__resolver_query_finish(self->queries, UV_ECANCELED);
+    }
+}
+
+
+/* resolv.conf parsing */
+
+#ifndef PYUV_WINDOWS
+static void
+pyuv__resolver_read_resolv_conf(PyObject *nameservers, double *timeout, int *tries)
+{
+    FILE *f;
+    char line[512], *p, *tok, *saveptr;
+    PyObject *ns;
+
+    f = fopen("/etc/resolv.conf", "r");
+    if (!f) {
+        return;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        p = strpbrk(line, "#;\r\n");
+        if (p) {
+            *p = '\0';
+        }
+        tok = strtok_r(line, " \t", &saveptr);
+        if (!tok) {
+            continue;
+        }
+        if (strcmp(tok, "nameserver") == 0) {
+            tok = strtok_r(NULL, " \t", &saveptr);
+            if (tok && PyList_GET_SIZE(nameservers) < PYUV__DNS_MAX_NAMESERVERS) {
+                /* strip IPv6 scope, not supported */
+                p = strchr(tok, '%');
+                if (p) {
+                    *p = '\0';
+                }
+                ns = Py_BuildValue("s", tok);
+                if (ns) {
+                    PyList_Append(nameservers, ns);
+                    Py_DECREF(ns);
+                }
+            }
+        } else if (strcmp(tok, "options") == 0) {
+            while ((tok = strtok_r(NULL, " \t", &saveptr)) != NULL) {
+                if (strncmp(tok, "timeout:", 8) == 0) {
+                    *timeout = atoi(tok + 8);
+                } else if (strncmp(tok, "attempts:", 9) == 0) {
+                    *tries = atoi(tok + 9);
+                }
+            }
+        }
+    }
+
+    fclose(f);
+    PyErr_Clear();
+}
+#endif
+
+
+static int
+pyuv__resolver_parse_nameserver(PyObject *item, struct sockaddr_storage *ss)
+{
+    int r;
+    PyObject *addr;
+
+    if (PyTuple_Check(item)) {
+        return pyuv_parse_addr_tuple(item, ss);
+    }
+
+    addr = Py_BuildValue("(Oi)", item, PYUV__DNS_PORT);
+    if (!addr) {
+        return -1;
+    }
+    r = pyuv_parse_addr_tuple(addr, ss);
+    Py_DECREF(addr);
+    return r;
+}
+
+
+static PyObject *
+Resolver_func_query(Resolver *self, PyObject *args, PyObject *kwargs)
+{
+    int err, qtype;
+    char *name_str;
+    PyObject *name, *callback, *idna;
+    pyuv__resolver_query *query;
+
+    static char *kwlist[] = {"name", "query_type", "callback", NULL};
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    idna = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OiO:query", kwlist, &name, &qtype, &callback)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    if (qtype != PYUV_QUERY_TYPE_A && qtype != PYUV_QUERY_TYPE_AAAA && qtype != PYUV_QUERY_TYPE_SRV && qtype != PYUV_QUERY_TYPE_TXT) {
+        PyErr_SetString(PyExc_ValueError, "invalid query type specified");
+        return NULL;
+    }
+
+    if (PyUnicode_Check(name)) {
+        idna = PyObject_CallMethod(name, "encode", "s", "idna");
+        if (!idna)
+            return NULL;
+        name_str = PyBytes_AS_STRING(idna);
+    } else if (PyBytes_Check(name)) {
+        name_str = PyBytes_AS_STRING(name);
+    } else {
+        PyErr_SetString(PyExc_TypeError, "name must be a string");
+        return NULL;
+    }
+
+    query = calloc(1, sizeof *query);
+    if (!query) {
+        Py_XDECREF(idna);
+        return PyErr_NoMemory();
+    }
+
+    query->id = pyuv__resolver_next_id(self);
+    query->qtype = qtype;
+    err = pyuv__dns_build_query(query->query, &query->query_len, name_str, query->id, qtype);
+    Py_XDECREF(idna);
+    if (err < 0) {
+        free(query);
+        RAISE_UV_EXCEPTION(err, PyExc_UVError);
+        return NULL;
+    }
+
+    err = uv_udp_init(self->loop->uv_loop, &query->udp_h);
+    if (err < 0) {
+        free(query);
+        RAISE_UV_EXCEPTION(err, PyExc_UVError);
+        return NULL;
+    }
+    query->udp_h.data = query;
+    uv_timer_init(self->loop->uv_loop, &query->timer_h);
+    query->timer_h.data = query;
+    query->active_handles = 2;
+
+    query->resolver = self;
+    Py_INCREF(self);
+    query->callback = callback;
+    Py_INCREF(callback);
+
+    /* link */
+    query->next = self->queries;
+    if (self->queries) {
+        self->queries->prev = query;
+    }
+    self->queries = query;
+
+    err = uv_udp_recv_start(&query->udp_h, pyuv__resolver_udp_alloc_cb, pyuv__resolver_udp_recv_cb);
+    if (err < 0) {
+        /* the callback will be called with the error */
+        pyuv__resolver_query_finish(query, err);
+    } else {
+        pyuv__resolver_query_attempt(query);
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Resolver_func_cancel(Resolver *self)
+{
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    pyuv__resolver_cancel_all(self);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Resolver_nameservers_get(Resolver *self, void *closure)
+{
+    int i;
+    PyObject *result, *item;
+
+    UNUSED_ARG(closure);
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    result = PyList_New(self->nameservers_count);
+    if (!result) {
+        return NULL;
+    }
+
+    for (i = 0; i < self->nameservers_count; i++) {
+        item = makesockaddr((struct sockaddr *)&self->nameservers[i]);
+        if (!item) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, i, item);
+    }
+
+    return result;
+}
+
+
+static int
+Resolver_tp_init(Resolver *self, PyObject *args, PyObject *kwargs)
+{
+    int tries, i, n;
+    double timeout;
+    Loop *loop;
+    PyObject *nameservers, *tmp, *item;
+    struct sockaddr_storage *servers;
+
+    static char *kwlist[] = {"loop", "nameservers", "timeout", "tries", NULL};
+
+    RAISE_IF_INITIALIZED(self, -1);
+
+    nameservers = Py_None;
+    timeout = -1.0;
+    tries = -1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|Odi:__init__", kwlist, &LoopType, &loop, &nameservers, &timeout, &tries)) {
+        return -1;
+    }
+
+    if (nameservers == Py_None) {
+        double conf_timeout = 5.0;
+        int conf_tries = 2;
+        nameservers = PyList_New(0);
+        if (!nameservers) {
+            return -1;
+        }
+#ifndef PYUV_WINDOWS
+        pyuv__resolver_read_resolv_conf(nameservers, &conf_timeout, &conf_tries);
+#endif
+        if (PyList_GET_SIZE(nameservers) == 0) {
+            item = Py_BuildValue("s", "127.0.0.1");
+            if (!item || PyList_Append(nameservers, item) != 0) {
+                Py_XDECREF(item);
+                Py_DECREF(nameservers);
+                return -1;
+            }
+            Py_DECREF(item);
+        }
+        if (timeout < 0) {
+            timeout = conf_timeout;
+        }
+        if (tries < 0) {
+            tries = conf_tries;
+        }
+    } else {
+        Py_INCREF(nameservers);
+    }
+
+    if (timeout < 0) {
+        timeout = 5.0;
+    }
+    if (tries < 0) {
+        tries = 2;
+    }
+
+    if (!PySequence_Check(nameservers) || (n = (int)PySequence_Length(nameservers)) < 1) {
+        Py_DECREF(nameservers);
+        PyErr_SetString(PyExc_ValueError, "at least one nameserver is required");
+        return -1;
+    }
+
+    if (timeout <= 0.0 || tries < 1) {
+        Py_DECREF(nameservers);
+        PyErr_SetString(PyExc_ValueError, "timeout and tries must be positive");
+        return -1;
+    }
+
+    servers = PyMem_Malloc(sizeof *servers * n);
+    if (!servers) {
+        Py_DECREF(nameservers);
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    for (i = 0; i < n; i++) {
+        item = PySequence_GetItem(nameservers, i);
+        if (!item || pyuv__resolver_parse_nameserver(item, &servers[i]) != 0) {
+            Py_XDECREF(item);
+            Py_DECREF(nameservers);
+            PyMem_Free(servers);
+            return -1;
+        }
+        Py_DECREF(item);
+    }
+    Py_DECREF(nameservers);
+
+    tmp = (PyObject *)self->loop;
+    Py_INCREF(loop);
+    self->loop = loop;
+    Py_XDECREF(tmp);
+
+    PyMem_Free(self->nameservers);
+    self->nameservers = servers;
+    self->nameservers_count = n;
+    self->timeout = timeout;
+    self->tries = tries;
+    self->seed = (uint32_t)uv_hrtime() ^ (uint32_t)(uintptr_t)self;
+    self->initialized = True;
+
+    return 0;
+}
+
+
+static PyObject *
+Resolver_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    Resolver *self = (Resolver *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->initialized = False;
+    self->nameservers = NULL;
+    self->queries = NULL;
+    return (PyObject *)self;
+}
+
+
+static int
+Resolver_tp_traverse(Resolver *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->loop);
+    return 0;
+}
+
+
+static int
+Resolver_tp_clear(Resolver *self)
+{
+    Py_CLEAR(self->loop);
+    return 0;
+}
+
+
+static void
+Resolver_tp_dealloc(Resolver *self)
+{
+    /* running queries hold a reference, so there can't be any at this point */
+    ASSERT(self->queries == NULL);
+    PyMem_Free(self->nameservers);
+    Resolver_tp_clear(self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyMethodDef
+Resolver_tp_methods[] = {
+    { "query", (PyCFunction)Resolver_func_query, METH_VARARGS|METH_KEYWORDS, "Send a DNS query." },
+    { "cancel", (PyCFunction)Resolver_func_cancel, METH_NOARGS, "Cancel all running queries." },
+    { NULL }
+};
+
+
+static PyMemberDef Resolver_tp_members[] = {
+    {"loop", T_OBJECT_EX, offsetof(Resolver, loop), READONLY, "Loop where this resolver runs."},
+    {"timeout", T_DOUBLE, offsetof(Resolver, timeout), READONLY, "Time to wait for an answer, in seconds."},
+    {"tries", T_INT, offsetof(Resolver, tries), READONLY, "Number of times each nameserver is tried."},
+    {NULL}
+};
+
+
+static PyGetSetDef Resolver_tp_getsets[] = {
+    {"nameservers", (getter)Resolver_nameservers_get, NULL, "Nameservers used by this resolver.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject ResolverType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.dns.Resolver",                                     /*tp_name*/
+    sizeof(Resolver),                                               /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)Resolver_tp_dealloc,                                /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)Resolver_tp_traverse,                             /*tp_traverse*/
+    (inquiry)Resolver_tp_clear,                                     /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    Resolver_tp_methods,                                            /*tp_methods*/
+    Resolver_tp_members,                                            /*tp_members*/
+    Resolver_tp_getsets,                                            /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)Resolver_tp_init,                                     /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    Resolver_tp_new,                                                /*tp_new*/
+};
+
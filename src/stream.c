@@ -7,6 +7,8 @@ typedef struct {
     Py_buffer *views;
     Py_buffer viewsml[4];
     int view_count;
+    /* bytes the request left in the write queue, see pyuv__loop_memory_enqueue */
+    size_t queued;
 } stream_write_ctx;
 
 
@@ -60,7 +62,7 @@ pyuv__stream_read_cb(uv_stream_t* handle, int nread, const uv_buf_t* buf)
     PyGILState_STATE gstate = PyGILState_Ensure();
     Loop *loop;
     Stream *self;
-    PyObject *result, *data, *py_errorno;
+    PyObject *data, *py_errorno;
     ASSERT(handle);
 
     /* Can't use container_of here */
@@ -79,14 +81,11 @@ pyuv__stream_read_cb(uv_stream_t* handle, int nread, const uv_buf_t* buf)
         py_errorno = PyInt_FromLong((long)nread);
         /* Stop reading, otherwise an assert blows up on unix */
         uv_read_stop(handle);
+        HANDLE(self)->flags &= ~PYUV__READING;
     }
 
-    result = PyObject_CallFunctionObjArgs(self->on_read_cb, self, data, py_errorno, NULL);
-    if (result == NULL) {
-        handle_uncaught_exception(HANDLE(self)->loop);
-    }
-    Py_XDECREF(result);
-    Py_DECREF(data);
+    pyuv__handle_dispatch(HANDLE(self), self->on_read_cb, Py_BuildValue("(OOO)", self, data, py_errorno), nread > 0 ? nread : 0);
+    Py_XDECREF(data);
     Py_DECREF(py_errorno);
 
     /* data has been read, unlock the buffer */
@@ -99,6 +98,137 @@ pyuv__stream_read_cb(uv_stream_t* handle, int nread, const uv_buf_t* buf)
 }
 
 
+/* In protocol mode on_read_cb holds a tuple with the protocol's bound methods, so that
+ * no attribute lookups happen per read. Calls to the allocation and read callbacks always
+ * come in pairs, so the buffer provided by the protocol is kept in the loop in between.
+ */
+enum {
+    PYUV__PROTOCOL_GET_BUFFER = 0,
+    PYUV__PROTOCOL_BUFFER_UPDATED,
+    PYUV__PROTOCOL_EOF_RECEIVED,
+    PYUV__PROTOCOL_CONNECTION_LOST,
+    PYUV__PROTOCOL_NMETHODS
+};
+
+
+static void
+pyuv__stream_protocol_alloc_cb(uv_handle_t* handle, size_t suggested_size, uv_buf_t *buf)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Loop *loop;
+    Stream *self;
+    PyObject *result, *py_size;
+    ASSERT(handle);
+
+    self = (Stream *)handle->data;
+    loop = handle->loop->data;
+    ASSERT(loop);
+    ASSERT(loop->buffer.view.obj == NULL);
+
+    buf->base = NULL;
+    buf->len = 0;
+
+    py_size = PyInt_FromSsize_t((Py_ssize_t)suggested_size);
+    result = PyObject_CallFunctionObjArgs(PyTuple_GET_ITEM(self->on_read_cb, PYUV__PROTOCOL_GET_BUFFER), py_size, NULL);
+    Py_XDECREF(py_size);
+    if (result == NULL) {
+        goto error;
+    }
+    if (PyObject_GetBuffer(result, &loop->buffer.view, PyBUF_WRITABLE) != 0) {
+        Py_DECREF(result);
+        goto error;
+    }
+    Py_DECREF(result);
+    if (loop->buffer.view.len == 0) {
+        PyBuffer_Release(&loop->buffer.view);
+        loop->buffer.view.obj = NULL;
+        PyErr_SetString(PyExc_RuntimeError, "get_buffer() returned an empty buffer");
+        goto error;
+    }
+
+    buf->base = loop->buffer.view.buf;
+    buf->len = loop->buffer.view.len;
+    PyGILState_Release(gstate);
+    return;
+
+error:
+    /* the read callback gets UV_ENOBUFS */
+    loop->buffer.view.obj = NULL;
+    handle_uncaught_exception(loop);
+    PyGILState_Release(gstate);
+}
+
+
+static void
+pyuv__stream_protocol_read_cb(uv_stream_t* handle, int nread, const uv_buf_t* buf)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Loop *loop;
+    Stream *self;
+    PyObject *methods, *result, *arg;
+    ASSERT(handle);
+
+    UNUSED_ARG(buf);
+
+    self = (Stream *)handle->data;
+    loop = handle->loop->data;
+    ASSERT(loop);
+
+    /* Object could go out of scope in the callback, increase refcount to avoid it */
+    Py_INCREF(self);
+
+    /* the protocol owns the data, release the buffer before handing control back */
+    if (loop->buffer.view.obj != NULL) {
+        PyBuffer_Release(&loop->buffer.view);
+        loop->buffer.view.obj = NULL;
+    }
+
+    methods = self->on_read_cb;
+    Py_INCREF(methods);
+    result = NULL;
+
+    if (nread > 0) {
+        arg = PyInt_FromLong((long)nread);
+        result = PyObject_CallFunctionObjArgs(PyTuple_GET_ITEM(methods, PYUV__PROTOCOL_BUFFER_UPDATED), arg, NULL);
+        Py_XDECREF(arg);
+    } else if (nread < 0) {
+        /* Stop reading, otherwise an assert blows up on unix */
+        uv_read_stop(handle);
+        HANDLE(self)->flags &= ~PYUV__READING;
+        if (nread == UV_EOF) {
+            if (PyTuple_GET_ITEM(methods, PYUV__PROTOCOL_EOF_RECEIVED) != Py_None) {
+                result = PyObject_CallFunctionObjArgs(PyTuple_GET_ITEM(methods, PYUV__PROTOCOL_EOF_RECEIVED), NULL);
+            } else {
+                result = Py_None;
+                Py_INCREF(Py_None);
+            }
+        } else {
+            if (PyTuple_GET_ITEM(methods, PYUV__PROTOCOL_CONNECTION_LOST) != Py_None) {
+                arg = PyInt_FromLong((long)nread);
+                result = PyObject_CallFunctionObjArgs(PyTuple_GET_ITEM(methods, PYUV__PROTOCOL_CONNECTION_LOST), arg, NULL);
+                Py_XDECREF(arg);
+            } else {
+                result = Py_None;
+                Py_INCREF(Py_None);
+            }
+        }
+    } else {
+        /* EAGAIN, nothing was read */
+        result = Py_None;
+        Py_INCREF(Py_None);
+    }
+
+    if (result == NULL) {
+        handle_uncaught_exception(HANDLE(self)->loop);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(methods);
+
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
 static void
 pyuv__stream_write_cb(uv_write_t* req, int status)
 {
@@ -114,6 +244,7 @@ pyuv__stream_write_cb(uv_write_t* req, int status)
     self = ctx->obj;
     callback = ctx->callback;
     send_handle = ctx->send_handle;
+    pyuv__loop_memory_dequeue(req->handle->loop, ctx->queued);
 
     if (callback != Py_None) {
         if (status < 0) {
@@ -192,6 +323,27 @@ error:
 }
 
 
+/* Start reading again after the loop paused the stream to stay within its memory budget, with
+ * the callbacks of the mode it was reading in.
+ */
+static int
+pyuv__stream_read_resume(Stream *self)
+{
+    int err;
+
+    HANDLE(self)->flags &= ~PYUV__PAUSED;
+    if (HANDLE(self)->flags & PYUV__PROTOCOL) {
+        err = uv_read_start((uv_stream_t *)UV_HANDLE(self), (uv_alloc_cb)pyuv__stream_protocol_alloc_cb, (uv_read_cb)pyuv__stream_protocol_read_cb);
+    } else {
+        err = uv_read_start((uv_stream_t *)UV_HANDLE(self), (uv_alloc_cb)pyuv__alloc_cb, (uv_read_cb)pyuv__stream_read_cb);
+    }
+    if (err < 0) {
+        HANDLE(self)->flags &= ~PYUV__READING;
+    }
+    return err;
+}
+
+
 static PyObject *
 Stream_func_start_read(Stream *self, PyObject *args)
 {
@@ -212,6 +364,12 @@ Stream_func_start_read(Stream *self, PyObject *args)
         return NULL;
     }
 
+    /* the callback slot is taken by the connection callback */
+    if (HANDLE(self)->flags & PYUV__LISTENING) {
+        RAISE_STREAM_EXCEPTION(UV_EINVAL, UV_HANDLE(self));
+        return NULL;
+    }
+
     err = uv_read_start((uv_stream_t *)UV_HANDLE(self), (uv_alloc_cb)pyuv__alloc_cb, (uv_read_cb)pyuv__stream_read_cb);
     if (err < 0) {
         RAISE_STREAM_EXCEPTION(err, UV_HANDLE(self));
@@ -222,6 +380,73 @@ Stream_func_start_read(Stream *self, PyObject *args)
     Py_INCREF(callback);
     self->on_read_cb = callback;
     Py_XDECREF(tmp);
+    HANDLE(self)->flags &= ~(PYUV__PROTOCOL | PYUV__PAUSED);
+    HANDLE(self)->flags |= PYUV__READING;
+    pyuv__handle_gc_track(HANDLE(self));
+
+    PYUV_HANDLE_INCREF(self);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Stream_func_start_read_protocol(Stream *self, PyObject *args)
+{
+    int i, err;
+    PyObject *tmp, *protocol, *methods, *method;
+    static const char *names[] = {"get_buffer", "buffer_updated", "eof_received", "connection_lost"};
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "O:start_read_protocol", &protocol)) {
+        return NULL;
+    }
+
+    /* the callback slot is taken by the connection callback */
+    if (HANDLE(self)->flags & PYUV__LISTENING) {
+        RAISE_STREAM_EXCEPTION(UV_EINVAL, UV_HANDLE(self));
+        return NULL;
+    }
+
+    methods = PyTuple_New(PYUV__PROTOCOL_NMETHODS);
+    if (!methods) {
+        return NULL;
+    }
+
+    for (i = 0; i < PYUV__PROTOCOL_NMETHODS; i++) {
+        method = PyObject_GetAttrString(protocol, names[i]);
+        if (method == NULL) {
+            /* eof_received and connection_lost are optional */
+            if (i < PYUV__PROTOCOL_EOF_RECEIVED || !PyErr_ExceptionMatches(PyExc_AttributeError)) {
+                Py_DECREF(methods);
+                return NULL;
+            }
+            PyErr_Clear();
+            PYUV_SET_NONE(method);
+        } else if (!PyCallable_Check(method)) {
+            PyErr_Format(PyExc_TypeError, "protocol.%s must be callable", names[i]);
+            Py_DECREF(method);
+            Py_DECREF(methods);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(methods, i, method);
+    }
+
+    err = uv_read_start((uv_stream_t *)UV_HANDLE(self), (uv_alloc_cb)pyuv__stream_protocol_alloc_cb, (uv_read_cb)pyuv__stream_protocol_read_cb);
+    if (err < 0) {
+        Py_DECREF(methods);
+        RAISE_STREAM_EXCEPTION(err, UV_HANDLE(self));
+        return NULL;
+    }
+
+    tmp = self->on_read_cb;
+    self->on_read_cb = methods;
+    Py_XDECREF(tmp);
+    HANDLE(self)->flags &= ~PYUV__PAUSED;
+    HANDLE(self)->flags |= PYUV__PROTOCOL | PYUV__READING;
+    pyuv__handle_gc_track(HANDLE(self));
 
     PYUV_HANDLE_INCREF(self);
 
@@ -237,14 +462,24 @@ Stream_func_stop_read(Stream *self)
     RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
     RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
 
+    if (HANDLE(self)->flags & PYUV__LISTENING) {
+        RAISE_STREAM_EXCEPTION(UV_EINVAL, UV_HANDLE(self));
+        return NULL;
+    }
+
     err = uv_read_stop((uv_stream_t *)UV_HANDLE(self));
     if (err < 0) {
         RAISE_STREAM_EXCEPTION(err, UV_HANDLE(self));
         return NULL;
     }
 
+    /* reads still queued by the loop are not delivered */
+    pyuv__loop_defer_drop(HANDLE(self)->loop, HANDLE(self));
+
     Py_XDECREF(self->on_read_cb);
     self->on_read_cb = NULL;
+    HANDLE(self)->flags &= ~(PYUV__PROTOCOL | PYUV__READING | PYUV__PAUSED);
+    pyuv__handle_gc_untrack(HANDLE(self), NULL);
 
     PYUV_HANDLE_DECREF(self);
 
@@ -283,6 +518,7 @@ static PyObject *
 pyuv__stream_write_bytes(Stream *self, PyObject *data, PyObject *callback, PyObject *send_handle)
 {
     int err;
+    size_t queued;
     uv_buf_t buf;
     stream_write_ctx *ctx;
     Py_buffer *view;
@@ -310,6 +546,7 @@ pyuv__stream_write_bytes(Stream *self, PyObject *data, PyObject *callback, PyObj
     Py_XINCREF(send_handle);
 
     buf = uv_buf_init(view->buf, view->len);
+    queued = ((uv_stream_t *)UV_HANDLE(self))->write_queue_size;
     if (send_handle != NULL) {
         ASSERT(UV_HANDLE(self)->type == UV_NAMED_PIPE);
         err = uv_write2(&ctx->req, (uv_stream_t *)UV_HANDLE(self), &buf, 1, (uv_stream_t *)UV_HANDLE(send_handle), pyuv__stream_write_cb);
@@ -326,6 +563,8 @@ pyuv__stream_write_bytes(Stream *self, PyObject *data, PyObject *callback, PyObj
         return NULL;
     }
 
+    ctx->queued = pyuv__loop_memory_enqueue(UV_HANDLE(self)->loop, queued, ((uv_stream_t *)UV_HANDLE(self))->write_queue_size);
+
     /* Increase refcount so that object is not removed before the callback is called */
     Py_INCREF(self);
 
@@ -337,6 +576,7 @@ static PyObject *
 pyuv__stream_write_sequence(Stream *self, PyObject *data, PyObject *callback, PyObject *send_handle)
 {
     int err;
+    size_t queued;
     stream_write_ctx *ctx;
     PyObject *data_fast, *item;
     Py_ssize_t i, j, buf_count;
@@ -394,6 +634,7 @@ pyuv__stream_write_sequence(Stream *self, PyObject *data, PyObject *callback, Py
         Py_INCREF(callback);
         Py_XINCREF(send_handle);
 
+        queued = ((uv_stream_t *)UV_HANDLE(self))->write_queue_size;
         if (send_handle != NULL) {
             ASSERT(UV_HANDLE(self)->type == UV_NAMED_PIPE);
             err = uv_write2(&ctx->req, (uv_stream_t *)UV_HANDLE(self), bufs, buf_count, (uv_stream_t *)UV_HANDLE(send_handle), pyuv__stream_write_cb);
@@ -409,6 +650,8 @@ pyuv__stream_write_sequence(Stream *self, PyObject *data, PyObject *callback, Py
         goto error;
     }
 
+    ctx->queued = pyuv__loop_memory_enqueue(UV_HANDLE(self)->loop, queued, ((uv_stream_t *)UV_HANDLE(self))->write_queue_size);
+
     /* Increase refcount so that object is not removed before the callback is called */
     Py_INCREF(self);
 
@@ -532,6 +775,407 @@ Stream_write_queue_size_get(Stream *self, void *closure)
 }
 
 
+/* Accept policy of a listening stream. Pending connections are admitted in C, before the
+ * connection callback runs: when max_active accepted connections are alive or the token bucket,
+ * refilled at max_rate per second, is empty, the connection is either reset or left pending,
+ * which makes libuv stop polling the listening socket until it's accepted. A timer hands it to
+ * the connection callback once the limits allow it again.
+ *
+ * Policies are linked from the loop, so that streams don't pay for them: the listener is flagged
+ * with PYUV__ACCEPT_POLICY and its accepted connections with PYUV__ACCEPTED.
+ */
+struct pyuv__stream_accept_policy_s {
+    uv_timer_t timer_h;
+    Stream *owner;
+    pyuv__stream_accept_policy *next;
+    Bool reset;
+    Bool paused;
+    Py_ssize_t max_active;
+    double max_rate;
+    double tokens;
+    uint64_t last;
+    PyObject *on_reject;
+    /* addresses of the accepted connections which are not closed yet, they are not kept alive */
+    PyObject *clients;
+};
+
+
+/* Returns the accept policy of a listening stream, or NULL if it has none */
+static pyuv__stream_accept_policy *
+pyuv__stream_accept_policy_get(Stream *self)
+{
+    Loop *loop;
+    pyuv__stream_accept_policy *policy;
+
+    if (!(HANDLE(self)->flags & PYUV__ACCEPT_POLICY)) {
+        return NULL;
+    }
+
+    /* the handle may have dropped its loop already, the libuv handle didn't */
+    loop = (Loop *)UV_HANDLE(self)->loop->data;
+    for (policy = loop != NULL ? loop->accept_policies : NULL; policy != NULL; policy = policy->next) {
+        if (policy->owner == self) {
+            return policy;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void
+pyuv__stream_accept_policy_close_cb(uv_handle_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    PyObject *loop = (PyObject *)handle->loop->data;
+
+    PyMem_Free(PYUV_CONTAINER_OF(handle, pyuv__stream_accept_policy, timer_h));
+    /* the loop was kept alive until the timer was unlinked from it */
+    Py_XDECREF(loop);
+
+    PyGILState_Release(gstate);
+}
+
+
+/* Runs without the GIL, so the handle isn't allocated by Python */
+static void
+pyuv__stream_accept_reset_close_cb(uv_handle_t *handle)
+{
+    free(handle);
+}
+
+
+/* Accept the pending connection and close it right away, with a RST for TCP */
+static void
+pyuv__stream_accept_reset(Stream *self)
+{
+    int err;
+    uv_stream_t *client;
+    uv_stream_t *server = (uv_stream_t *)UV_HANDLE(self);
+
+    if (server->type == UV_TCP) {
+        client = malloc(sizeof(uv_tcp_t));
+        if (!client) {
+            return;
+        }
+        err = uv_tcp_init(server->loop, (uv_tcp_t *)client);
+    } else {
+        client = malloc(sizeof(uv_pipe_t));
+        if (!client) {
+            return;
+        }
+        err = uv_pipe_init(server->loop, (uv_pipe_t *)client, 0);
+    }
+    if (err < 0) {
+        free(client);
+        return;
+    }
+    /* not a pyuv handle, Loop.handles and the memory walk must not mistake it for one */
+    client->data = NULL;
+
+#ifndef _WIN32
+    if (uv_accept(server, client) == 0 && server->type == UV_TCP) {
+        uv_os_fd_t fd;
+        struct linger l = {1, 0};
+        if (uv_fileno((uv_handle_t *)client, &fd) == 0) {
+            setsockopt(fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+        }
+    }
+#else
+    uv_accept(server, client);
+#endif
+
+    uv_close((uv_handle_t *)client, pyuv__stream_accept_reset_close_cb);
+}
+
+
+static void
+pyuv__stream_accept_notify(pyuv__stream_accept_policy *policy, const char *reason)
+{
+    PyObject *result;
+
+    if (policy->on_reject == NULL) {
+        return;
+    }
+
+    result = PyObject_CallFunction(policy->on_reject, "Os", (PyObject *)policy->owner, reason);
+    if (result == NULL) {
+        handle_uncaught_exception(HANDLE(policy->owner)->loop);
+    }
+    Py_XDECREF(result);
+}
+
+
+static Bool pyuv__stream_accept_admit(Stream *self);
+
+static void
+pyuv__stream_accept_timer_cb(uv_timer_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Stream *self;
+    PyObject *result;
+
+    self = PYUV_CONTAINER_OF(handle, pyuv__stream_accept_policy, timer_h)->owner;
+    Py_INCREF(self);
+
+    /* the connection is still pending, unless the stream was closed meanwhile */
+    if (!uv_is_closing(UV_HANDLE(self)) && self->on_read_cb != NULL && pyuv__stream_accept_admit(self)) {
+        result = PyObject_CallFunctionObjArgs(self->on_read_cb, self, Py_None, NULL);
+        if (result == NULL) {
+            handle_uncaught_exception(HANDLE(self)->loop);
+        }
+        Py_XDECREF(result);
+    }
+
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+/* Returns True if the pending connection can be handed to the connection callback, otherwise it
+ * was reset or left pending. Must be called with the GIL held.
+ */
+static Bool
+pyuv__stream_accept_admit(Stream *self)
+{
+    uint64_t now, timeout;
+    double burst;
+    const char *reason;
+    pyuv__stream_accept_policy *policy = pyuv__stream_accept_policy_get(self);
+
+    if (policy == NULL) {
+        return True;
+    }
+
+    if (policy->max_rate > 0) {
+        now = uv_hrtime();
+        burst = policy->max_rate > 1.0 ? policy->max_rate : 1.0;
+        policy->tokens += (now - policy->last) / 1e9 * policy->max_rate;
+        if (policy->tokens > burst) {
+            policy->tokens = burst;
+        }
+        policy->last = now;
+    }
+
+    if (policy->max_active > 0 && PySet_GET_SIZE(policy->clients) >= policy->max_active) {
+        reason = "max_active";
+    } else if (policy->max_rate > 0 && policy->tokens < 1.0) {
+        reason = "max_rate";
+    } else {
+        if (policy->max_rate > 0) {
+            policy->tokens -= 1.0;
+        }
+        policy->paused = False;
+        return True;
+    }
+
+    if (policy->reset) {
+        pyuv__stream_accept_reset(self);
+        pyuv__stream_accept_notify(policy, reason);
+        return False;
+    }
+
+    if (policy->max_active <= 0 || PySet_GET_SIZE(policy->clients) < policy->max_active) {
+        /* wait for the next token, a closing connection resumes accepting otherwise */
+        timeout = (uint64_t)((1.0 - policy->tokens) / policy->max_rate * 1000.0) + 1;
+        uv_timer_start(&policy->timer_h, pyuv__stream_accept_timer_cb, timeout, 0);
+    }
+
+    if (!policy->paused) {
+        policy->paused = True;
+        pyuv__stream_accept_notify(policy, reason);
+    }
+
+    return False;
+}
+
+
+/* Count a connection accepted by a listening stream with an accept policy */
+static int
+pyuv__stream_accept_track(Stream *self, Stream *client)
+{
+    int r;
+    PyObject *key;
+    pyuv__stream_accept_policy *policy;
+
+    /* handles received over an IPC pipe are not connections */
+    policy = pyuv__stream_accept_policy_get(self);
+    if (policy == NULL || !(HANDLE(self)->flags & PYUV__LISTENING)) {
+        return 0;
+    }
+
+    key = PyLong_FromVoidPtr(client);
+    if (key == NULL) {
+        return -1;
+    }
+    r = PySet_Add(policy->clients, key);
+    Py_DECREF(key);
+    if (r == 0) {
+        HANDLE(client)->flags |= PYUV__ACCEPTED;
+    }
+
+    return r;
+}
+
+
+/* Called once an accepted connection is closed, must be called with the GIL held */
+static void
+pyuv__stream_accept_release(Stream *client)
+{
+    Loop *loop;
+    PyObject *key;
+    pyuv__stream_accept_policy *policy;
+
+    if (!(HANDLE(client)->flags & PYUV__ACCEPTED)) {
+        return;
+    }
+    HANDLE(client)->flags &= ~PYUV__ACCEPTED;
+
+    loop = (Loop *)UV_HANDLE(client)->loop->data;
+    if (loop == NULL) {
+        return;
+    }
+    key = PyLong_FromVoidPtr(client);
+    if (key == NULL) {
+        handle_uncaught_exception(loop);
+        return;
+    }
+
+    for (policy = loop->accept_policies; policy != NULL; policy = policy->next) {
+        if (PySet_Discard(policy->clients, key) == 1) {
+            if (policy->paused && policy->max_active > 0 && PySet_GET_SIZE(policy->clients) < policy->max_active) {
+                uv_timer_start(&policy->timer_h, pyuv__stream_accept_timer_cb, 0, 0);
+            }
+            break;
+        }
+    }
+
+    Py_DECREF(key);
+}
+
+
+/* Called from the close callback of the stream, must be called with the GIL held */
+static void
+pyuv__stream_close_cb(Stream *self)
+{
+    Loop *loop;
+    pyuv__stream_accept_policy **link;
+    pyuv__stream_accept_policy *policy;
+
+    pyuv__stream_accept_release(self);
+
+    policy = pyuv__stream_accept_policy_get(self);
+    if (policy == NULL) {
+        return;
+    }
+    HANDLE(self)->flags &= ~PYUV__ACCEPT_POLICY;
+
+    loop = (Loop *)policy->timer_h.loop->data;
+    for (link = &loop->accept_policies; *link != policy; link = &(*link)->next);
+    *link = policy->next;
+
+    /* connections still open are no longer counted by anyone */
+    policy->owner = NULL;
+    Py_CLEAR(policy->on_reject);
+    Py_CLEAR(policy->clients);
+
+    /* the stream drops its loop once this returns, but the timer is only unlinked from it on
+     * the next iteration */
+    Py_INCREF(loop);
+    uv_close((uv_handle_t *)&policy->timer_h, pyuv__stream_accept_policy_close_cb);
+}
+
+
+/* Shared by TCP and Pipe, errors are raised with the given exception type */
+static PyObject *
+pyuv__stream_set_accept_policy(Stream *self, PyObject *args, PyObject *kwargs, PyObject *exc_type)
+{
+    int err;
+    double max_rate;
+    Py_ssize_t max_active;
+    PyObject *on_reject, *reset, *tmp;
+    pyuv__stream_accept_policy *policy;
+
+    static char *kwlist[] = {"max_active", "max_rate", "on_reject", "reset", NULL};
+
+    max_active = 0;
+    max_rate = 0.0;
+    on_reject = Py_None;
+    reset = Py_False;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|ndOO!:set_accept_policy", kwlist, &max_active, &max_rate, &on_reject, &PyBool_Type, &reset)) {
+        return NULL;
+    }
+
+    if (max_active < 0) {
+        PyErr_SetString(PyExc_ValueError, "max_active must be 0 or greater");
+        return NULL;
+    }
+
+    if (max_rate < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "max_rate must be 0 or greater");
+        return NULL;
+    }
+
+    if (on_reject != Py_None && !PyCallable_Check(on_reject)) {
+        PyErr_SetString(PyExc_TypeError, "on_reject must be a callable or None");
+        return NULL;
+    }
+
+    policy = pyuv__stream_accept_policy_get(self);
+    if (policy == NULL) {
+        policy = PyMem_Malloc(sizeof *policy);
+        if (!policy) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+        memset(policy, 0, sizeof *policy);
+        policy->clients = PySet_New(NULL);
+        if (policy->clients == NULL) {
+            PyMem_Free(policy);
+            return NULL;
+        }
+        err = uv_timer_init(UV_HANDLE_LOOP(self), &policy->timer_h);
+        if (err < 0) {
+            Py_DECREF(policy->clients);
+            PyMem_Free(policy);
+            RAISE_UV_EXCEPTION(err, exc_type);
+            return NULL;
+        }
+        /* not a pyuv handle, Loop.handles and the memory walk must not mistake it for one */
+        policy->timer_h.data = NULL;
+        uv_unref((uv_handle_t *)&policy->timer_h);
+        policy->owner = self;
+        policy->next = HANDLE(self)->loop->accept_policies;
+        HANDLE(self)->loop->accept_policies = policy;
+        HANDLE(self)->flags |= PYUV__ACCEPT_POLICY;
+        pyuv__handle_gc_track(HANDLE(self));
+    }
+
+    /* a new policy starts with a full bucket */
+    policy->max_active = max_active;
+    policy->max_rate = max_rate;
+    policy->tokens = max_rate > 1.0 ? max_rate : 1.0;
+    policy->last = uv_hrtime();
+    policy->reset = (reset == Py_True);
+
+    tmp = policy->on_reject;
+    if (on_reject != Py_None) {
+        Py_INCREF(on_reject);
+        policy->on_reject = on_reject;
+    } else {
+        policy->on_reject = NULL;
+    }
+    Py_XDECREF(tmp);
+
+    /* the pending connection is reconsidered with the new limits */
+    if (policy->paused) {
+        uv_timer_start(&policy->timer_h, pyuv__stream_accept_timer_cb, 0, 0);
+    }
+
+    Py_RETURN_NONE;
+}
+
 static PyObject *
 Stream_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
@@ -539,6 +1183,7 @@ Stream_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
     if (!self) {
         return NULL;
     }
+    pyuv__handle_gc_untrack(HANDLE(self), NULL);
     return (PyObject *)self;
 }
 
@@ -546,7 +1191,13 @@ Stream_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static int
 Stream_tp_traverse(Stream *self, visitproc visit, void *arg)
 {
+    pyuv__stream_accept_policy *policy;
+
     Py_VISIT(self->on_read_cb);
+    policy = pyuv__stream_accept_policy_get(self);
+    if (policy != NULL) {
+        Py_VISIT(policy->on_reject);
+    }
     return HandleType.tp_traverse((PyObject *)self, visit, arg);
 }
 
@@ -554,7 +1205,14 @@ Stream_tp_traverse(Stream *self, visitproc visit, void *arg)
 static int
 Stream_tp_clear(Stream *self)
 {
+    pyuv__stream_accept_policy *policy;
+
     Py_CLEAR(self->on_read_cb);
+    /* the policy itself goes away with the handle, see pyuv__stream_close_cb */
+    policy = pyuv__stream_accept_policy_get(self);
+    if (policy != NULL) {
+        Py_CLEAR(policy->on_reject);
+    }
     return HandleType.tp_clear((PyObject *)self);
 }
 
@@ -565,6 +1223,7 @@ Stream_tp_methods[] = {
     { "try_write", (PyCFunction)Stream_func_try_write, METH_VARARGS, "Try to write data on the stream." },
     { "write", (PyCFunction)Stream_func_write, METH_VARARGS, "Write data on the stream." },
     { "start_read", (PyCFunction)Stream_func_start_read, METH_VARARGS, "Start read data from the connected endpoint." },
+    { "start_read_protocol", (PyCFunction)Stream_func_start_read_protocol, METH_VARARGS, "Start reading into buffers provided by the given protocol." },
     { "stop_read", (PyCFunction)Stream_func_stop_read, METH_NOARGS, "Stop read data from the connected endpoint." },
     { "fileno", (PyCFunction)Stream_func_fileno, METH_NOARGS, "Returns the libuv OS handle." },
     { "set_blocking", (PyCFunction)Stream_func_set_blocking, METH_VARARGS, "Set the stream to be blocking." },
@@ -15,18 +15,22 @@ pyuv__tcp_listen_cb(uv_stream_t *handle, int status)
 
     if (status != 0) {
         py_errorno = PyInt_FromLong((long)status);
+    } else if (!pyuv__stream_accept_admit((Stream *)self)) {
+        /* reset or left pending by the accept policy */
+        goto done;
     } else {
         py_errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(self->on_new_connection_cb, self, py_errorno, NULL);
+    result = PyObject_CallFunctionObjArgs(self->stream.on_read_cb, self, py_errorno, NULL);
     if (result == NULL) {
         handle_uncaught_exception(HANDLE(self)->loop);
     }
     Py_XDECREF(result);
     Py_DECREF(py_errorno);
 
+done:
     Py_DECREF(self);
     PyGILState_Release(gstate);
 }
@@ -124,16 +128,24 @@ TCP_func_listen(TCP *self, PyObject *args)
         return NULL;
     }
 
+    /* a reading stream can't listen, the callback slot is shared */
+    if (self->stream.on_read_cb != NULL && !(HANDLE(self)->flags & PYUV__LISTENING)) {
+        RAISE_UV_EXCEPTION(UV_EINVAL, PyExc_TCPError);
+        return NULL;
+    }
+
     err = uv_listen((uv_stream_t *)&self->tcp_h, backlog, pyuv__tcp_listen_cb);
     if (err < 0) {
         RAISE_UV_EXCEPTION(err, PyExc_TCPError);
         return NULL;
     }
 
-    tmp = self->on_new_connection_cb;
+    tmp = self->stream.on_read_cb;
     Py_INCREF(callback);
-    self->on_new_connection_cb = callback;
+    self->stream.on_read_cb = callback;
     Py_XDECREF(tmp);
+    HANDLE(self)->flags |= PYUV__LISTENING;
+    pyuv__handle_gc_track(HANDLE(self));
 
     Py_RETURN_NONE;
 }
@@ -163,6 +175,10 @@ TCP_func_accept(TCP *self, PyObject *args)
         return NULL;
     }
 
+    if (pyuv__stream_accept_track((Stream *)self, (Stream *)client) < 0) {
+        return NULL;
+    }
+
     Py_RETURN_NONE;
 }
 
@@ -220,6 +236,345 @@ error:
 }
 
 
+/* Happy Eyeballs (RFC 8305) connection establishment: the name is resolved, the addresses are
+ * interleaved by family and connection attempts are started delay apart (or as soon as the
+ * previous one fails) until one of them succeeds. The remaining attempts are then closed.
+ */
+
+#define PYUV__TCP_CONNECT_HOST_MAX 16
+
+typedef struct pyuv__tcp_connect_host_ctx_s pyuv__tcp_connect_host_ctx;
+
+typedef struct {
+    uv_connect_t req;
+    TCP *tcp;
+    pyuv__tcp_connect_host_ctx *ctx;
+} pyuv__tcp_connect_host_attempt;
+
+struct pyuv__tcp_connect_host_ctx_s {
+    uv_getaddrinfo_t gai_req;
+    uv_timer_t timer_h;
+    Loop *loop;
+    PyObject *cls;
+    PyObject *callback;
+    uint64_t delay;
+    struct sockaddr_storage addrs[PYUV__TCP_CONNECT_HOST_MAX];
+    pyuv__tcp_connect_host_attempt attempts[PYUV__TCP_CONNECT_HOST_MAX];
+    int naddrs;
+    int next;
+    int pending;
+    int error;
+    Bool done;
+    Bool timer_closed;
+};
+
+
+static void pyuv__tcp_connect_host_next(pyuv__tcp_connect_host_ctx *ctx);
+
+
+static void
+pyuv__tcp_connect_host_maybe_free(pyuv__tcp_connect_host_ctx *ctx)
+{
+    if (!ctx->done || ctx->pending > 0 || !ctx->timer_closed) {
+        return;
+    }
+
+    Py_DECREF(ctx->loop);
+    Py_DECREF(ctx->cls);
+    Py_DECREF(ctx->callback);
+    free(ctx);
+}
+
+
+static void
+pyuv__tcp_connect_host_close_attempt(pyuv__tcp_connect_host_ctx *ctx, TCP *tcp)
+{
+    PyObject *result;
+
+    result = PyObject_CallMethod((PyObject *)tcp, "close", NULL);
+    if (result == NULL) {
+        handle_uncaught_exception(ctx->loop);
+    }
+    Py_XDECREF(result);
+}
+
+
+static void
+pyuv__tcp_connect_host_timer_close_cb(uv_handle_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    pyuv__tcp_connect_host_ctx *ctx;
+
+    ctx = PYUV_CONTAINER_OF(handle, pyuv__tcp_connect_host_ctx, timer_h);
+    ctx->timer_closed = True;
+    pyuv__tcp_connect_host_maybe_free(ctx);
+
+    PyGILState_Release(gstate);
+}
+
+
+static void
+pyuv__tcp_connect_host_finish(pyuv__tcp_connect_host_ctx *ctx, TCP *winner, int status)
+{
+    int i;
+    PyObject *result, *py_errorno;
+
+    ctx->done = True;
+
+    if (!ctx->timer_closed && !uv_is_closing((uv_handle_t *)&ctx->timer_h)) {
+        uv_close((uv_handle_t *)&ctx->timer_h, pyuv__tcp_connect_host_timer_close_cb);
+    }
+
+    /* close the attempts still in progress, their callbacks will get UV_ECANCELED */
+    for (i = 0; i < ctx->next; i++) {
+        if (ctx->attempts[i].tcp != NULL) {
+            pyuv__tcp_connect_host_close_attempt(ctx, ctx->attempts[i].tcp);
+        }
+    }
+
+    if (status != 0) {
+        py_errorno = PyInt_FromLong((long)status);
+    } else {
+        py_errorno = Py_None;
+        Py_INCREF(Py_None);
+    }
+
+    result = PyObject_CallFunctionObjArgs(ctx->callback, winner ? (PyObject *)winner : Py_None, py_errorno, NULL);
+    if (result == NULL) {
+        handle_uncaught_exception(ctx->loop);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(py_errorno);
+}
+
+
+static void
+pyuv__tcp_connect_host_attempt_cb(uv_connect_t *req, int status)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    pyuv__tcp_connect_host_attempt *attempt;
+    pyuv__tcp_connect_host_ctx *ctx;
+    TCP *tcp;
+
+    attempt = PYUV_CONTAINER_OF(req, pyuv__tcp_connect_host_attempt, req);
+    ctx = attempt->ctx;
+    tcp = attempt->tcp;
+    attempt->tcp = NULL;
+    ctx->pending--;
+
+    if (!ctx->done) {
+        if (status == 0) {
+            pyuv__tcp_connect_host_finish(ctx, tcp, 0);
+        } else {
+            ctx->error = status;
+            pyuv__tcp_connect_host_close_attempt(ctx, tcp);
+            /* don't wait for the delay to expire, move on to the next address right away */
+            pyuv__tcp_connect_host_next(ctx);
+        }
+    }
+
+    Py_DECREF(tcp);
+    pyuv__tcp_connect_host_maybe_free(ctx);
+
+    PyGILState_Release(gstate);
+}
+
+
+static void
+pyuv__tcp_connect_host_timer_cb(uv_timer_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    pyuv__tcp_connect_host_ctx *ctx;
+
+    ctx = PYUV_CONTAINER_OF(handle, pyuv__tcp_connect_host_ctx, timer_h);
+    pyuv__tcp_connect_host_next(ctx);
+    pyuv__tcp_connect_host_maybe_free(ctx);
+
+    PyGILState_Release(gstate);
+}
+
+
+static void
+pyuv__tcp_connect_host_next(pyuv__tcp_connect_host_ctx *ctx)
+{
+    int err;
+    TCP *tcp;
+    pyuv__tcp_connect_host_attempt *attempt;
+
+    uv_timer_stop(&ctx->timer_h);
+
+    while (ctx->next < ctx->naddrs) {
+        attempt = &ctx->attempts[ctx->next];
+        tcp = (TCP *)PyObject_CallFunctionObjArgs(ctx->cls, ctx->loop, NULL);
+        if (tcp == NULL) {
+            handle_uncaught_exception(ctx->loop);
+            ctx->error = UV_ENOMEM;
+            ctx->next++;
+            continue;
+        }
+
+        err = uv_tcp_connect(&attempt->req, &tcp->tcp_h, (struct sockaddr *)&ctx->addrs[ctx->next], pyuv__tcp_connect_host_attempt_cb);
+        ctx->next++;
+        if (err < 0) {
+            ctx->error = err;
+            pyuv__tcp_connect_host_close_attempt(ctx, tcp);
+            Py_DECREF(tcp);
+            continue;
+        }
+
+        attempt->tcp = tcp;
+        attempt->ctx = ctx;
+        ctx->pending++;
+
+        if (ctx->next < ctx->naddrs) {
+            uv_timer_start(&ctx->timer_h, pyuv__tcp_connect_host_timer_cb, ctx->delay, 0);
+        }
+        return;
+    }
+
+    if (ctx->pending == 0) {
+        pyuv__tcp_connect_host_finish(ctx, NULL, ctx->error);
+    }
+}
+
+
+static void
+pyuv__tcp_connect_host_gai_cb(uv_getaddrinfo_t *req, int status, struct addrinfo *res)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    int i, family, nprimary, nsecondary;
+    struct addrinfo *ai;
+    struct addrinfo *primary[PYUV__TCP_CONNECT_HOST_MAX];
+    struct addrinfo *secondary[PYUV__TCP_CONNECT_HOST_MAX];
+    pyuv__tcp_connect_host_ctx *ctx;
+
+    ctx = PYUV_CONTAINER_OF(req, pyuv__tcp_connect_host_ctx, gai_req);
+
+    if (status != 0) {
+        pyuv__tcp_connect_host_finish(ctx, NULL, status);
+        goto end;
+    }
+
+    /* the family of the first address is preferred, addresses are then alternated between families */
+    family = AF_UNSPEC;
+    nprimary = nsecondary = 0;
+    for (ai = res; ai; ai = ai->ai_next) {
+        if (ai->ai_family != AF_INET && ai->ai_family != AF_INET6) {
+            continue;
+        }
+        if (family == AF_UNSPEC) {
+            family = ai->ai_family;
+        }
+        if (ai->ai_family == family) {
+            if (nprimary < PYUV__TCP_CONNECT_HOST_MAX) {
+                primary[nprimary++] = ai;
+            }
+        } else if (nsecondary < PYUV__TCP_CONNECT_HOST_MAX) {
+            secondary[nsecondary++] = ai;
+        }
+    }
+
+    for (i = 0; ctx->naddrs < PYUV__TCP_CONNECT_HOST_MAX && (i < nprimary || i < nsecondary); i++) {
+        if (i < nprimary) {
+            memcpy(&ctx->addrs[ctx->naddrs++], primary[i]->ai_addr, primary[i]->ai_addrlen);
+        }
+        if (i < nsecondary && ctx->naddrs < PYUV__TCP_CONNECT_HOST_MAX) {
+            memcpy(&ctx->addrs[ctx->naddrs++], secondary[i]->ai_addr, secondary[i]->ai_addrlen);
+        }
+    }
+
+    uv_freeaddrinfo(res);
+
+    uv_timer_init(ctx->loop->uv_loop, &ctx->timer_h);
+    ctx->timer_closed = False;
+
+    if (ctx->naddrs == 0) {
+        pyuv__tcp_connect_host_finish(ctx, NULL, UV_EAI_NODATA);
+    } else {
+        pyuv__tcp_connect_host_next(ctx);
+    }
+
+end:
+    pyuv__tcp_connect_host_maybe_free(ctx);
+    PyGILState_Release(gstate);
+}
+
+
+static PyObject *
+TCP_func_connect_host(PyObject *cls, PyObject *args, PyObject *kwargs)
+{
+    int err;
+    double delay;
+    char *host_str, *service_str;
+    char port_str[6];
+    struct addrinfo hints;
+    Loop *loop;
+    PyObject *host, *port, *callback, *idna, *ascii;
+    pyuv__tcp_connect_host_ctx *ctx;
+
+    static char *kwlist[] = {"loop", "host", "port", "callback", "delay", NULL};
+
+    delay = 0.25;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!OOO|d:connect_host", kwlist, &LoopType, &loop, &host, &port, &callback, &delay)) {
+        return NULL;
+    }
+
+    if (host == Py_None || port == Py_None) {
+        PyErr_SetString(PyExc_TypeError, "host and port are required");
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    if (delay < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "a positive value or zero is required");
+        return NULL;
+    }
+
+    if (pyuv__getaddrinfo_parse_args(host, port, &host_str, &service_str, port_str, &idna, &ascii) != 0) {
+        return NULL;
+    }
+
+    ctx = calloc(1, sizeof *ctx);
+    if (!ctx) {
+        Py_XDECREF(idna);
+        Py_XDECREF(ascii);
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    ctx->delay = (uint64_t)(delay * 1000);
+    ctx->timer_closed = True;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    err = uv_getaddrinfo(loop->uv_loop, &ctx->gai_req, pyuv__tcp_connect_host_gai_cb, host_str, service_str, &hints);
+    Py_XDECREF(idna);
+    Py_XDECREF(ascii);
+    if (err < 0) {
+        free(ctx);
+        RAISE_UV_EXCEPTION(err, PyExc_TCPError);
+        return NULL;
+    }
+
+    Py_INCREF(loop);
+    Py_INCREF(cls);
+    Py_INCREF(callback);
+    ctx->loop = loop;
+    ctx->cls = cls;
+    ctx->callback = callback;
+
+    Py_RETURN_NONE;
+}
+
+
 static PyObject *
 TCP_func_getsockname(TCP *self)
 {
@@ -285,6 +640,33 @@ TCP_func_nodelay(TCP *self, PyObject *args)
 }
 
 
+static PyObject *
+TCP_func_set_busy_poll(TCP *self, PyObject *args)
+{
+    int err, usecs;
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "i:set_busy_poll", &usecs)) {
+        return NULL;
+    }
+
+    if (usecs < 0) {
+        PyErr_SetString(PyExc_ValueError, "usecs must not be negative");
+        return NULL;
+    }
+
+    err = pyuv__set_busy_poll(UV_HANDLE(self), usecs);
+    if (err < 0) {
+        RAISE_UV_EXCEPTION(err, PyExc_TCPError);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
 static PyObject *
 TCP_func_keepalive(TCP *self, PyObject *args)
 {
@@ -332,6 +714,16 @@ TCP_func_simultaneous_accepts(TCP *self, PyObject *args)
 }
 
 
+static PyObject *
+TCP_func_set_accept_policy(TCP *self, PyObject *args, PyObject *kwargs)
+{
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    return pyuv__stream_set_accept_policy((Stream *)self, args, kwargs, PyExc_TCPError);
+}
+
+
 static PyObject *
 TCP_func_open(TCP *self, PyObject *args)
 {
@@ -518,7 +910,6 @@ TCP_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static int
 TCP_tp_traverse(TCP *self, visitproc visit, void *arg)
 {
-    Py_VISIT(self->on_new_connection_cb);
     return StreamType.tp_traverse((PyObject *)self, visit, arg);
 }
 
@@ -526,7 +917,6 @@ TCP_tp_traverse(TCP *self, visitproc visit, void *arg)
 static int
 TCP_tp_clear(TCP *self)
 {
-    Py_CLEAR(self->on_new_connection_cb);
     return StreamType.tp_clear((PyObject *)self);
 }
 
@@ -536,10 +926,13 @@ TCP_tp_methods[] = {
     { "bind", (PyCFunction)TCP_func_bind, METH_VARARGS, "Bind to the specified IP and port." },
     { "listen", (PyCFunction)TCP_func_listen, METH_VARARGS, "Start listening for TCP connections." },
     { "accept", (PyCFunction)TCP_func_accept, METH_VARARGS, "Accept incoming connection." },
+    { "set_accept_policy", (PyCFunction)TCP_func_set_accept_policy, METH_VARARGS|METH_KEYWORDS, "Limit the number of active connections and the rate at which they are accepted." },
     { "connect", (PyCFunction)TCP_func_connect, METH_VARARGS, "Start connecion to remote endpoint." },
+    { "connect_host", (PyCFunction)TCP_func_connect_host, METH_CLASS|METH_VARARGS|METH_KEYWORDS, "Resolve the host and connect to it racing the addresses of both families." },
     { "getsockname", (PyCFunction)TCP_func_getsockname, METH_NOARGS, "Get local socket information." },
     { "getpeername", (PyCFunction)TCP_func_getpeername, METH_NOARGS, "Get remote socket information." },
     { "nodelay", (PyCFunction)TCP_func_nodelay, METH_VARARGS, "Enable/disable Nagle's algorithm." },
+    { "set_busy_poll", (PyCFunction)TCP_func_set_busy_poll, METH_VARARGS, "Busy poll the device queue when reading, for the given number of microseconds." },
     { "keepalive", (PyCFunction)TCP_func_keepalive, METH_VARARGS, "Enable/disable TCP keep-alive." },
     { "open", (PyCFunction)TCP_func_open, METH_VARARGS, "Open the specified file descriptor and manage it as a TCP handle." },
     { "simultaneous_accepts", (PyCFunction)TCP_func_simultaneous_accepts, METH_VARARGS, "Enable/disable simultaneous asynchronous accept requests that are queued by the operating system when listening for new tcp connections." },
@@ -1,4 +1,8 @@
 
+#ifdef PYUV_WINDOWS
+# include <process.h>
+#endif
+
 static PyObject *
 Barrier_func_wait(Barrier *self)
 {
@@ -730,6 +734,1351 @@ static PyTypeObject SemaphoreType = {
     Semaphore_tp_new,                                               /*tp_new*/
 };
 
+/*
+ * SPSCQueue and MPMCQueue
+ *
+ * The ring buffer is only ever accessed while holding the GIL, so putting and getting items
+ * doesn't take any lock. The mutex and the condition variables are only used when a thread
+ * needs to wait (with the GIL released) or when there is a waiting thread to wake up.
+ */
+
+static PyObject *
+pyuv__thread_queue_error(const char *name)
+{
+    PyObject *module, *exc;
+
+#ifdef PYUV_PYTHON3
+    module = PyImport_ImportModule("queue");
+#else
+    module = PyImport_ImportModule("Queue");
+#endif
+    if (module == NULL) {
+        return NULL;
+    }
+    exc = PyObject_GetAttrString(module, name);
+    Py_DECREF(module);
+    if (exc != NULL) {
+        PyErr_SetNone(exc);
+        Py_DECREF(exc);
+    }
+    return NULL;
+}
+
+
+static int
+pyuv__thread_queue_parse(PyObject *py_block, PyObject *py_timeout, Bool *block, uint64_t *deadline)
+{
+    int r;
+    double timeout;
+
+    r = PyObject_IsTrue(py_block);
+    if (r == -1) {
+        return -1;
+    }
+    *block = r ? True : False;
+    *deadline = 0;
+
+    if (py_timeout != Py_None) {
+        timeout = PyFloat_AsDouble(py_timeout);
+        if (timeout == -1.0 && PyErr_Occurred()) {
+            return -1;
+        }
+        if (timeout < 0.0) {
+            PyErr_SetString(PyExc_ValueError, "a positive value or zero is required");
+            return -1;
+        }
+        *deadline = uv_hrtime() + (uint64_t)(timeout * 1e9);
+    }
+
+    return 0;
+}
+
+
+/* Wait on the given condition with the GIL released, returns UV_ETIMEDOUT if the deadline passed */
+static int
+pyuv__thread_queue_wait(ThreadQueue *self, uv_cond_t *cond, int *waiters, uint64_t deadline)
+{
+    int r;
+    uint64_t now;
+
+    if (self->single && *waiters > 0) {
+        PyErr_SetString(PyExc_RuntimeError, "another thread is already waiting on this side of the queue");
+        return -1;
+    }
+
+    r = 0;
+    (*waiters)++;
+
+    /* The mutex is taken before releasing the GIL, so a wakeup cannot be missed */
+    uv_mutex_lock(&self->mutex);
+    Py_BEGIN_ALLOW_THREADS
+    if (deadline == 0) {
+        uv_cond_wait(cond, &self->mutex);
+    } else {
+        now = uv_hrtime();
+        if (now >= deadline) {
+            r = UV_ETIMEDOUT;
+        } else {
+            r = uv_cond_timedwait(cond, &self->mutex, deadline - now);
+        }
+    }
+    uv_mutex_unlock(&self->mutex);
+    Py_END_ALLOW_THREADS
+
+    (*waiters)--;
+    return r;
+}
+
+
+static void
+pyuv__thread_queue_wakeup(ThreadQueue *self, uv_cond_t *cond, int waiters, Py_ssize_t n)
+{
+    if (waiters == 0) {
+        return;
+    }
+
+    uv_mutex_lock(&self->mutex);
+    if (n == 1 || self->single) {
+        uv_cond_signal(cond);
+    } else {
+        uv_cond_broadcast(cond);
+    }
+    uv_mutex_unlock(&self->mutex);
+}
+
+
+/* Steals a reference to item, the queue must not be full */
+static INLINE void
+pyuv__thread_queue_push(ThreadQueue *self, PyObject *item)
+{
+    self->items[(self->head + self->count) % self->capacity] = item;
+    self->count++;
+}
+
+
+/* Returns a new reference, the queue must not be empty */
+static INLINE PyObject *
+pyuv__thread_queue_pop(ThreadQueue *self)
+{
+    PyObject *item;
+
+    item = self->items[self->head];
+    self->items[self->head] = NULL;
+    self->head = (self->head + 1) % self->capacity;
+    self->count--;
+    return item;
+}
+
+
+static PyObject *
+ThreadQueue_func_put(ThreadQueue *self, PyObject *args, PyObject *kwargs)
+{
+    int r;
+    Bool block;
+    uint64_t deadline;
+    PyObject *item, *py_block, *py_timeout;
+
+    static char *kwlist[] = {"item", "block", "timeout", NULL};
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    py_block = Py_True;
+    py_timeout = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OO:put", kwlist, &item, &py_block, &py_timeout)) {
+        return NULL;
+    }
+
+    if (pyuv__thread_queue_parse(py_block, py_timeout, &block, &deadline) != 0) {
+        return NULL;
+    }
+
+    while (self->count == self->capacity) {
+        if (!block) {
+            return pyuv__thread_queue_error("Full");
+        }
+        r = pyuv__thread_queue_wait(self, &self->not_full, &self->put_waiters, deadline);
+        if (r == -1) {
+            return NULL;
+        }
+        if (r == UV_ETIMEDOUT && self->count == self->capacity) {
+            return pyuv__thread_queue_error("Full");
+        }
+    }
+
+    Py_INCREF(item);
+    pyuv__thread_queue_push(self, item);
+    pyuv__thread_queue_wakeup(self, &self->not_empty, self->get_waiters, 1);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+ThreadQueue_func_get(ThreadQueue *self, PyObject *args, PyObject *kwargs)
+{
+    int r;
+    Bool block;
+    uint64_t deadline;
+    PyObject *item, *py_block, *py_timeout;
+
+    static char *kwlist[] = {"block", "timeout", NULL};
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    py_block = Py_True;
+    py_timeout = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|OO:get", kwlist, &py_block, &py_timeout)) {
+        return NULL;
+    }
+
+    if (pyuv__thread_queue_parse(py_block, py_timeout, &block, &deadline) != 0) {
+        return NULL;
+    }
+
+    while (self->count == 0) {
+        if (!block) {
+            return pyuv__thread_queue_error("Empty");
+        }
+        r = pyuv__thread_queue_wait(self, &self->not_empty, &self->get_waiters, deadline);
+        if (r == -1) {
+            return NULL;
+        }
+        if (r == UV_ETIMEDOUT && self->count == 0) {
+            return pyuv__thread_queue_error("Empty");
+        }
+    }
+
+    item = pyuv__thread_queue_pop(self);
+    pyuv__thread_queue_wakeup(self, &self->not_full, self->put_waiters, 1);
+
+    return item;
+}
+
+
+static PyObject *
+ThreadQueue_func_put_many(ThreadQueue *self, PyObject *args, PyObject *kwargs)
+{
+    int r;
+    Bool block;
+    uint64_t deadline;
+    Py_ssize_t i, n, pushed;
+    PyObject *items, *seq, *item, *py_block, *py_timeout;
+
+    static char *kwlist[] = {"items", "block", "timeout", NULL};
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    py_block = Py_True;
+    py_timeout = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OO:put_many", kwlist, &items, &py_block, &py_timeout)) {
+        return NULL;
+    }
+
+    if (pyuv__thread_queue_parse(py_block, py_timeout, &block, &deadline) != 0) {
+        return NULL;
+    }
+
+    seq = PySequence_Fast(items, "items must be an iterable");
+    if (seq == NULL) {
+        return NULL;
+    }
+
+    n = PySequence_Fast_GET_SIZE(seq);
+    i = 0;
+
+    while (i < n) {
+        for (pushed = 0; i < n && self->count < self->capacity; i++, pushed++) {
+            item = PySequence_Fast_GET_ITEM(seq, i);
+            Py_INCREF(item);
+            pyuv__thread_queue_push(self, item);
+        }
+        if (pushed > 0) {
+            pyuv__thread_queue_wakeup(self, &self->not_empty, self->get_waiters, pushed);
+        }
+        if (i == n || !block) {
+            break;
+        }
+        r = pyuv__thread_queue_wait(self, &self->not_full, &self->put_waiters, deadline);
+        if (r == -1) {
+            Py_DECREF(seq);
+            return NULL;
+        }
+        if (r == UV_ETIMEDOUT && self->count == self->capacity) {
+            break;
+        }
+    }
+
+    Py_DECREF(seq);
+    return PyInt_FromSsize_t(i);
+}
+
+
+static PyObject *
+ThreadQueue_func_get_many(ThreadQueue *self, PyObject *args, PyObject *kwargs)
+{
+    int r;
+    Bool block;
+    uint64_t deadline;
+    Py_ssize_t i, n, max_items;
+    PyObject *result, *py_block, *py_timeout;
+
+    static char *kwlist[] = {"max_items", "block", "timeout", NULL};
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    max_items = 0;
+    py_block = Py_True;
+    py_timeout = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|nOO:get_many", kwlist, &max_items, &py_block, &py_timeout)) {
+        return NULL;
+    }
+
+    if (pyuv__thread_queue_parse(py_block, py_timeout, &block, &deadline) != 0) {
+        return NULL;
+    }
+
+    while (self->count == 0) {
+        if (!block) {
+            return PyList_New(0);
+        }
+        r = pyuv__thread_queue_wait(self, &self->not_empty, &self->get_waiters, deadline);
+        if (r == -1) {
+            return NULL;
+        }
+        if (r == UV_ETIMEDOUT && self->count == 0) {
+            return PyList_New(0);
+        }
+    }
+
+    n = self->count;
+    if (max_items > 0 && n > max_items) {
+        n = max_items;
+    }
+
+    result = PyList_New(n);
+    if (result == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < n; i++) {
+        PyList_SET_ITEM(result, i, pyuv__thread_queue_pop(self));
+    }
+    pyuv__thread_queue_wakeup(self, &self->not_full, self->put_waiters, n);
+
+    return result;
+}
+
+
+static PyObject *
+ThreadQueue_func_qsize(ThreadQueue *self)
+{
+    return PyInt_FromSsize_t(self->count);
+}
+
+
+static PyObject *
+ThreadQueue_func_empty(ThreadQueue *self)
+{
+    return PyBool_FromLong((long)(self->count == 0));
+}
+
+
+static PyObject *
+ThreadQueue_func_full(ThreadQueue *self)
+{
+    return PyBool_FromLong((long)(self->initialized && self->count == self->capacity));
+}
+
+
+static Py_ssize_t
+ThreadQueue_tp_len(ThreadQueue *self)
+{
+    return self->count;
+}
+
+
+static int
+ThreadQueue_tp_init(ThreadQueue *self, PyObject *args, PyObject *kwargs)
+{
+    Py_ssize_t capacity;
+
+    static char *kwlist[] = {"capacity", NULL};
+
+    RAISE_IF_INITIALIZED(self, -1);
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "n:__init__", kwlist, &capacity)) {
+        return -1;
+    }
+
+    if (capacity <= 0) {
+        PyErr_SetString(PyExc_ValueError, "capacity must be greater than zero");
+        return -1;
+    }
+
+    self->items = PyMem_New(PyObject *, capacity);
+    if (self->items == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    memset(self->items, 0, capacity * sizeof(PyObject *));
+
+    if (uv_mutex_init(&self->mutex)) {
+        goto error;
+    }
+    if (uv_cond_init(&self->not_empty)) {
+        uv_mutex_destroy(&self->mutex);
+        goto error;
+    }
+    if (uv_cond_init(&self->not_full)) {
+        uv_cond_destroy(&self->not_empty);
+        uv_mutex_destroy(&self->mutex);
+        goto error;
+    }
+
+    self->capacity = capacity;
+    self->initialized = True;
+    return 0;
+
+error:
+    PyMem_Free(self->items);
+    self->items = NULL;
+    PyErr_Format(PyExc_ThreadError, "Error initializing %s", self->single ? "SPSCQueue" : "MPMCQueue");
+    return -1;
+}
+
+
+static PyObject *
+ThreadQueue_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    ThreadQueue *self;
+
+    self = (ThreadQueue *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->initialized = False;
+    self->single = PyType_IsSubtype(type, &SPSCQueueType) ? True : False;
+    self->items = NULL;
+    self->capacity = self->head = self->count = 0;
+    self->get_waiters = self->put_waiters = 0;
+    return (PyObject *)self;
+}
+
+
+static int
+ThreadQueue_tp_traverse(ThreadQueue *self, visitproc visit, void *arg)
+{
+    Py_ssize_t i;
+
+    for (i = 0; i < self->count; i++) {
+        Py_VISIT(self->items[(self->head + i) % self->capacity]);
+    }
+    return 0;
+}
+
+
+static int
+ThreadQueue_tp_clear(ThreadQueue *self)
+{
+    PyObject *item;
+
+    while (self->count > 0) {
+        item = pyuv__thread_queue_pop(self);
+        Py_DECREF(item);
+    }
+    return 0;
+}
+
+
+static void
+ThreadQueue_tp_dealloc(ThreadQueue *self)
+{
+    PyObject_GC_UnTrack(self);
+    ThreadQueue_tp_clear(self);
+    if (self->initialized) {
+        uv_cond_destroy(&self->not_full);
+        uv_cond_destroy(&self->not_empty);
+        uv_mutex_destroy(&self->mutex);
+        PyMem_Free(self->items);
+    }
+    Py_TYPE(self)->tp_free(self);
+}
+
+
+static PySequenceMethods ThreadQueue_tp_as_sequence = {
+    (lenfunc)ThreadQueue_tp_len,                                    /*sq_length*/
+    0,                                                              /*sq_concat*/
+    0,                                                              /*sq_repeat*/
+    0,                                                              /*sq_item*/
+    0,                                                              /*sq_slice*/
+    0,                                                              /*sq_ass_item*/
+    0,                                                              /*sq_ass_slice*/
+    0,                                                              /*sq_contains*/
+};
+
+
+static PyMethodDef
+ThreadQueue_tp_methods[] = {
+    { "put", (PyCFunction)ThreadQueue_func_put, METH_VARARGS|METH_KEYWORDS, "Put an item in the queue." },
+    { "get", (PyCFunction)ThreadQueue_func_get, METH_VARARGS|METH_KEYWORDS, "Remove and return an item from the queue." },
+    { "put_many", (PyCFunction)ThreadQueue_func_put_many, METH_VARARGS|METH_KEYWORDS, "Put several items in the queue, returns how many were put." },
+    { "get_many", (PyCFunction)ThreadQueue_func_get_many, METH_VARARGS|METH_KEYWORDS, "Remove and return a list of items from the queue." },
+    { "qsize", (PyCFunction)ThreadQueue_func_qsize, METH_NOARGS, "Return the number of items in the queue." },
+    { "empty", (PyCFunction)ThreadQueue_func_empty, METH_NOARGS, "Return True if the queue is empty." },
+    { "full", (PyCFunction)ThreadQueue_func_full, METH_NOARGS, "Return True if the queue is full." },
+    { NULL }
+};
+
+
+static PyMemberDef ThreadQueue_tp_members[] = {
+    {"capacity", T_PYSSIZET, offsetof(ThreadQueue, capacity), READONLY, "Maximum number of items the queue can hold."},
+    {NULL}
+};
+
+
+static PyTypeObject SPSCQueueType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.thread.SPSCQueue",                                 /*tp_name*/
+    sizeof(ThreadQueue),                                            /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)ThreadQueue_tp_dealloc,                             /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    &ThreadQueue_tp_as_sequence,                                    /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)ThreadQueue_tp_traverse,                          /*tp_traverse*/
+    (inquiry)ThreadQueue_tp_clear,                                  /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    ThreadQueue_tp_methods,                                         /*tp_methods*/
+    ThreadQueue_tp_members,                                         /*tp_members*/
+    0,                                                              /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)ThreadQueue_tp_init,                                  /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    ThreadQueue_tp_new,                                             /*tp_new*/
+};
+
+
+static PyTypeObject MPMCQueueType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.thread.MPMCQueue",                                 /*tp_name*/
+    sizeof(ThreadQueue),                                            /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)ThreadQueue_tp_dealloc,                             /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    &ThreadQueue_tp_as_sequence,                                    /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)ThreadQueue_tp_traverse,                          /*tp_traverse*/
+    (inquiry)ThreadQueue_tp_clear,                                  /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    ThreadQueue_tp_methods,                                         /*tp_methods*/
+    ThreadQueue_tp_members,                                         /*tp_members*/
+    0,                                                              /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)ThreadQueue_tp_init,                                  /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    ThreadQueue_tp_new,                                             /*tp_new*/
+};
+
+
+/*
+ * Thread
+ *
+ * Native thread which calls the given function with the GIL held. Unlike threading.Thread it
+ * allows choosing the stack size, the CPUs the thread may run on and the name the OS uses for it.
+ */
+
+static unsigned long pyuv__thread_counter = 0;
+
+
+static void
+pyuv__thread_run(Thread *self)
+{
+    PyGILState_STATE gstate;
+    PyObject *result;
+
+    if (self->native_name[0] != '\0') {
+#if defined(PYUV_LINUX)
+        pthread_setname_np(pthread_self(), self->native_name);
+#elif defined(__APPLE__)
+        pthread_setname_np(self->native_name);
+#endif
+    }
+
+    gstate = PyGILState_Ensure();
+
+    result = PyObject_Call(self->target, self->args, self->kwargs);
+    if (result == NULL) {
+#ifdef PYUV_PYTHON3
+        PySys_WriteStderr("Unhandled exception in thread %.200s:\n", PyUnicode_AsUTF8(self->name));
+#else
+        PySys_WriteStderr("Unhandled exception in thread %.200s:\n", PyString_AsString(self->name));
+#endif
+        PyErr_PrintEx(0);
+    }
+    Py_XDECREF(result);
+
+    self->finished = True;
+    /* drop the reference taken in start() */
+    Py_DECREF(self);
+
+    PyGILState_Release(gstate);
+}
+
+
+#ifdef PYUV_WINDOWS
+static unsigned __stdcall
+pyuv__thread_start(void *arg)
+{
+    pyuv__thread_run((Thread *)arg);
+    return 0;
+}
+#else
+static void *
+pyuv__thread_start(void *arg)
+{
+    pyuv__thread_run((Thread *)arg);
+    return NULL;
+}
+#endif
+
+
+static PyObject *
+Thread_func_start(Thread *self)
+{
+    int err;
+#ifdef PYUV_WINDOWS
+    uintptr_t handle;
+#else
+    pthread_attr_t attr;
+#endif
+#ifdef PYUV_LINUX
+    cpu_set_t cpuset;
+#endif
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    if (self->started) {
+        PyErr_SetString(PyExc_RuntimeError, "threads can only be started once");
+        return NULL;
+    }
+
+    /* the thread owns a reference until the target returns */
+    Py_INCREF(self);
+
+#ifdef PYUV_WINDOWS
+    handle = _beginthreadex(NULL, (unsigned)self->stack_size, pyuv__thread_start, self, 0, NULL);
+    err = handle == 0 ? errno : 0;
+    if (err == 0) {
+        self->tid = (uv_thread_t)handle;
+    }
+#else
+    err = pthread_attr_init(&attr);
+    if (err == 0) {
+        if (self->stack_size > 0) {
+            err = pthread_attr_setstacksize(&attr, (size_t)self->stack_size);
+        }
+#ifdef PYUV_LINUX
+        if (err == 0 && self->cpus != Py_None) {
+            pyuv__cpus_to_cpuset(self->cpus, &cpuset);
+            err = pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+        }
+#endif
+        if (err == 0) {
+            err = pthread_create(&self->tid, &attr, pyuv__thread_start, self);
+        }
+        pthread_attr_destroy(&attr);
+    }
+#endif
+
+    if (err != 0) {
+        Py_DECREF(self);
+#ifdef PYUV_WINDOWS
+        PyErr_SetString(PyExc_ThreadError, "Error creating thread");
+#else
+        RAISE_UV_EXCEPTION(-err, PyExc_ThreadError);
+#endif
+        return NULL;
+    }
+
+    self->started = True;
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Thread_func_join(Thread *self)
+{
+    uv_thread_t current;
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    if (!self->started) {
+        PyErr_SetString(PyExc_RuntimeError, "cannot join thread before it is started");
+        return NULL;
+    }
+
+    if (self->joined) {
+        Py_RETURN_NONE;
+    }
+
+    current = uv_thread_self();
+    if (uv_thread_equal(&current, &self->tid)) {
+        PyErr_SetString(PyExc_RuntimeError, "cannot join current thread");
+        return NULL;
+    }
+
+    /* The thread could be joined concurrently, mark it before releasing the GIL */
+    self->joined = True;
+
+    Py_BEGIN_ALLOW_THREADS
+    uv_thread_join(&self->tid);
+    Py_END_ALLOW_THREADS
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Thread_func_is_alive(Thread *self)
+{
+    return PyBool_FromLong((long)(self->started && !self->finished));
+}
+
+
+static int
+Thread_tp_init(Thread *self, PyObject *args, PyObject *kwargs)
+{
+    Py_ssize_t stack_size;
+    PyObject *target, *target_args, *target_kwargs, *name, *cpus, *tmp;
+    const char *native_name;
+
+    static char *kwlist[] = {"target", "args", "kwargs", "name", "stack_size", "cpus", NULL};
+
+    RAISE_IF_INITIALIZED(self, -1);
+
+    target_args = NULL;
+    target_kwargs = Py_None;
+    name = Py_None;
+    stack_size = 0;
+    cpus = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O!OOnO:__init__", kwlist, &target, &PyTuple_Type, &target_args, &target_kwargs, &name, &stack_size, &cpus)) {
+        return -1;
+    }
+
+    if (!PyCallable_Check(target)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return -1;
+    }
+
+    if (target_kwargs != Py_None && !PyDict_Check(target_kwargs)) {
+        PyErr_SetString(PyExc_TypeError, "kwargs must be a dict or None");
+        return -1;
+    }
+
+    if (stack_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "stack_size must be a positive value or zero");
+        return -1;
+    }
+
+    if (name == Py_None) {
+        name = PyUnicode_FromFormat("Thread-%lu", ++pyuv__thread_counter);
+    } else {
+        name = PyObject_Str(name);
+    }
+    if (name == NULL) {
+        return -1;
+    }
+#ifdef PYUV_PYTHON3
+    native_name = PyUnicode_AsUTF8(name);
+#else
+    native_name = PyString_AsString(name);
+#endif
+    if (native_name == NULL) {
+        Py_DECREF(name);
+        return -1;
+    }
+
+    if (cpus != Py_None) {
+#ifdef PYUV_LINUX
+        cpus = pyuv__cpus_parse(cpus);
+        if (cpus == NULL) {
+            Py_DECREF(name);
+            return -1;
+        }
+#else
+        PyErr_SetString(PyExc_NotImplementedError, "CPU affinity is not supported on this platform");
+        Py_DECREF(name);
+        return -1;
+#endif
+    } else {
+        Py_INCREF(cpus);
+    }
+
+    /* the OS limits thread names to 16 bytes including the terminator on Linux */
+    strncpy(self->native_name, native_name, sizeof(self->native_name) - 1);
+    self->native_name[sizeof(self->native_name) - 1] = '\0';
+
+    if (target_args == NULL) {
+        target_args = PyTuple_New(0);
+        if (target_args == NULL) {
+            goto error;
+        }
+    } else {
+        Py_INCREF(target_args);
+    }
+
+    tmp = self->target;
+    Py_INCREF(target);
+    self->target = target;
+    Py_XDECREF(tmp);
+
+    tmp = self->args;
+    self->args = target_args;
+    Py_XDECREF(tmp);
+
+    tmp = self->kwargs;
+    self->kwargs = target_kwargs == Py_None ? NULL : target_kwargs;
+    Py_XINCREF(self->kwargs);
+    Py_XDECREF(tmp);
+
+    tmp = self->name;
+    self->name = name;
+    Py_XDECREF(tmp);
+
+    tmp = self->cpus;
+    self->cpus = cpus;
+    Py_XDECREF(tmp);
+
+    self->stack_size = stack_size;
+    self->initialized = True;
+
+    return 0;
+
+error:
+    Py_DECREF(cpus);
+    Py_DECREF(name);
+    return -1;
+}
+
+
+static PyObject *
+Thread_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    Thread *self;
+
+    self = (Thread *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->initialized = False;
+    self->started = False;
+    self->finished = False;
+    self->joined = False;
+    self->native_name[0] = '\0';
+    return (PyObject *)self;
+}
+
+
+static int
+Thread_tp_traverse(Thread *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->target);
+    Py_VISIT(self->args);
+    Py_VISIT(self->kwargs);
+    return 0;
+}
+
+
+static int
+Thread_tp_clear(Thread *self)
+{
+    Py_CLEAR(self->target);
+    Py_CLEAR(self->args);
+    Py_CLEAR(self->kwargs);
+    return 0;
+}
+
+
+static void
+Thread_tp_dealloc(Thread *self)
+{
+    PyObject_GC_UnTrack(self);
+    if (self->started && !self->joined) {
+        /* nobody will join it, release its resources when it ends */
+#ifdef PYUV_WINDOWS
+        CloseHandle(self->tid);
+#else
+        pthread_detach(self->tid);
+#endif
+    }
+    Thread_tp_clear(self);
+    Py_XDECREF(self->name);
+    Py_XDECREF(self->cpus);
+    Py_TYPE(self)->tp_free(self);
+}
+
+
+static PyMethodDef
+Thread_tp_methods[] = {
+    { "start", (PyCFunction)Thread_func_start, METH_NOARGS, "Start the thread." },
+    { "join", (PyCFunction)Thread_func_join, METH_NOARGS, "Wait until the thread terminates." },
+    { "is_alive", (PyCFunction)Thread_func_is_alive, METH_NOARGS, "Return True if the thread is running." },
+    { NULL }
+};
+
+
+static PyMemberDef Thread_tp_members[] = {
+    {"name", T_OBJECT, offsetof(Thread, name), READONLY, "Thread name."},
+    {"cpus", T_OBJECT, offsetof(Thread, cpus), READONLY, "CPUs the thread is allowed to run on, None means all."},
+    {"stack_size", T_PYSSIZET, offsetof(Thread, stack_size), READONLY, "Stack size of the thread, 0 means the system default."},
+    {NULL}
+};
+
+
+static PyTypeObject ThreadType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.thread.Thread",                                    /*tp_name*/
+    sizeof(Thread),                                                 /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)Thread_tp_dealloc,                                  /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)Thread_tp_traverse,                               /*tp_traverse*/
+    (inquiry)Thread_tp_clear,                                       /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    Thread_tp_methods,                                              /*tp_methods*/
+    Thread_tp_members,                                              /*tp_members*/
+    0,                                                              /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)Thread_tp_init,                                       /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    Thread_tp_new,                                                  /*tp_new*/
+};
+
+
+/*
+ * LoopThread
+ *
+ * Runs a loop in a Thread until it's stopped. Callbacks can be scheduled to run in the loop from
+ * any thread, they are queued in a list (protected by the GIL) and the loop is woken up through an
+ * async handle, which also keeps it alive.
+ */
+
+static void
+pyuv__loop_thread_close_cb(uv_handle_t *handle)
+{
+    UNUSED_ARG(handle);
+}
+
+
+static void
+pyuv__loop_thread_async_cb(uv_async_t *handle)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    LoopThread *self;
+    PyObject *pending, *item, *result;
+    Py_ssize_t i;
+
+    ASSERT(handle);
+    self = PYUV_CONTAINER_OF(handle, LoopThread, async_h);
+
+    while (PyList_GET_SIZE(self->pending) > 0) {
+        pending = self->pending;
+        self->pending = PyList_New(0);
+        if (self->pending == NULL) {
+            self->pending = pending;
+            handle_uncaught_exception(self->loop);
+            break;
+        }
+        for (i = 0; i < PyList_GET_SIZE(pending); i++) {
+            item = PyList_GET_ITEM(pending, i);
+            result = PyObject_Call(PyTuple_GET_ITEM(item, 0), PyTuple_GET_ITEM(item, 1), NULL);
+            if (result == NULL) {
+                handle_uncaught_exception(self->loop);
+            }
+            Py_XDECREF(result);
+        }
+        Py_DECREF(pending);
+    }
+
+    if (self->stopping && !uv_is_closing((uv_handle_t *)&self->async_h)) {
+        uv_close((uv_handle_t *)&self->async_h, pyuv__loop_thread_close_cb);
+        uv_stop(self->loop->uv_loop);
+    }
+
+    PyGILState_Release(gstate);
+}
+
+
+/* Target of the thread, runs with the GIL held */
+static PyObject *
+pyuv__loop_thread_run(LoopThread *self, PyObject *unused)
+{
+    uv_loop_t *uv_loop;
+
+    UNUSED_ARG(unused);
+
+    uv_loop = self->loop->uv_loop;
+
+    /* the loop runs anyway if the scheduling settings can't be applied, nothing would stop it otherwise */
+    if (pyuv__loop_sched_enter(self->loop) < 0) {
+        handle_uncaught_exception(self->loop);
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    uv_run(uv_loop, UV_RUN_DEFAULT);
+    Py_END_ALLOW_THREADS
+
+    pyuv__loop_sched_leave(self->loop);
+
+    /* the loop could have been stopped with Loop.stop instead */
+    if (!uv_is_closing((uv_handle_t *)&self->async_h)) {
+        self->stopping = True;
+        uv_close((uv_handle_t *)&self->async_h, pyuv__loop_thread_close_cb);
+        Py_BEGIN_ALLOW_THREADS
+        uv_run(uv_loop, UV_RUN_NOWAIT);
+        Py_END_ALLOW_THREADS
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyMethodDef pyuv__loop_thread_run_def = {"run", (PyCFunction)pyuv__loop_thread_run, METH_NOARGS, NULL};
+
+
+static PyObject *
+LoopThread_func_call_soon_threadsafe(LoopThread *self, PyObject *args)
+{
+    int err;
+    PyObject *callback, *callback_args, *item;
+
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    if (self->stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "the loop thread is stopping");
+        return NULL;
+    }
+
+    if (PyTuple_GET_SIZE(args) < 1) {
+        PyErr_SetString(PyExc_TypeError, "call_soon_threadsafe requires a callback");
+        return NULL;
+    }
+
+    callback = PyTuple_GET_ITEM(args, 0);
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    callback_args = PyTuple_GetSlice(args, 1, PyTuple_GET_SIZE(args));
+    if (callback_args == NULL) {
+        return NULL;
+    }
+
+    item = PyTuple_Pack(2, callback, callback_args);
+    Py_DECREF(callback_args);
+    if (item == NULL) {
+        return NULL;
+    }
+
+    if (PyList_Append(self->pending, item) != 0) {
+        Py_DECREF(item);
+        return NULL;
+    }
+    Py_DECREF(item);
+
+    err = uv_async_send(&self->async_h);
+    if (err < 0) {
+        RAISE_UV_EXCEPTION(err, PyExc_ThreadError);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+LoopThread_func_stop(LoopThread *self)
+{
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    if (!self->stopping) {
+        self->stopping = True;
+        uv_async_send(&self->async_h);
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+LoopThread_func_join(LoopThread *self)
+{
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    return Thread_func_join((Thread *)self->thread);
+}
+
+
+static PyObject *
+LoopThread_func_is_alive(LoopThread *self)
+{
+    RAISE_IF_NOT_INITIALIZED(self, NULL);
+
+    return Thread_func_is_alive((Thread *)self->thread);
+}
+
+
+static int
+LoopThread_tp_init(LoopThread *self, PyObject *args, PyObject *kwargs)
+{
+    int err;
+    Loop *loop;
+    Py_ssize_t stack_size;
+    PyObject *name, *cpus, *target, *thread, *thread_args, *thread_kwargs, *result;
+
+    static char *kwlist[] = {"loop", "name", "stack_size", "cpus", NULL};
+
+    RAISE_IF_INITIALIZED(self, -1);
+
+    name = Py_None;
+    stack_size = 0;
+    cpus = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|OnO:__init__", kwlist, &LoopType, &loop, &name, &stack_size, &cpus)) {
+        return -1;
+    }
+
+    target = PyCFunction_New(&pyuv__loop_thread_run_def, (PyObject *)self);
+    if (target == NULL) {
+        return -1;
+    }
+    thread_args = Py_BuildValue("(N)", target);
+    if (thread_args == NULL) {
+        return -1;
+    }
+    thread_kwargs = Py_BuildValue("{s:O,s:n,s:O}", "name", name, "stack_size", stack_size, "cpus", cpus);
+    if (thread_kwargs == NULL) {
+        Py_DECREF(thread_args);
+        return -1;
+    }
+    thread = PyObject_Call((PyObject *)&ThreadType, thread_args, thread_kwargs);
+    Py_DECREF(thread_args);
+    Py_DECREF(thread_kwargs);
+    if (thread == NULL) {
+        return -1;
+    }
+
+    Py_CLEAR(self->pending);
+    self->pending = PyList_New(0);
+    if (self->pending == NULL) {
+        Py_DECREF(thread);
+        return -1;
+    }
+
+    err = uv_async_init(loop->uv_loop, &self->async_h, pyuv__loop_thread_async_cb);
+    if (err < 0) {
+        Py_DECREF(thread);
+        RAISE_UV_EXCEPTION(err, PyExc_ThreadError);
+        return -1;
+    }
+    self->async_initialized = True;
+
+    Py_INCREF(loop);
+    Py_CLEAR(self->loop);
+    self->loop = loop;
+    Py_CLEAR(self->thread);
+    self->thread = thread;
+    self->stopping = False;
+    self->initialized = True;
+
+    result = Thread_func_start((Thread *)thread);
+    if (result == NULL) {
+        /* the loop isn't running anywhere, close the async handle right away */
+        self->initialized = False;
+        self->async_initialized = False;
+        uv_close((uv_handle_t *)&self->async_h, pyuv__loop_thread_close_cb);
+        uv_run(loop->uv_loop, UV_RUN_NOWAIT);
+        return -1;
+    }
+    Py_DECREF(result);
+
+    return 0;
+}
+
+
+static PyObject *
+LoopThread_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    LoopThread *self;
+
+    self = (LoopThread *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->initialized = False;
+    self->async_initialized = False;
+    self->stopping = False;
+    return (PyObject *)self;
+}
+
+
+static int
+LoopThread_tp_traverse(LoopThread *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->loop);
+    Py_VISIT(self->thread);
+    Py_VISIT(self->pending);
+    return 0;
+}
+
+
+static int
+LoopThread_tp_clear(LoopThread *self)
+{
+    Py_CLEAR(self->loop);
+    Py_CLEAR(self->thread);
+    Py_CLEAR(self->pending);
+    return 0;
+}
+
+
+static void
+LoopThread_tp_dealloc(LoopThread *self)
+{
+    PyObject_GC_UnTrack(self);
+    /* the thread references this object while it runs, so the async handle is closed by now */
+    LoopThread_tp_clear(self);
+    Py_TYPE(self)->tp_free(self);
+}
+
+
+static PyMethodDef
+LoopThread_tp_methods[] = {
+    { "call_soon_threadsafe", (PyCFunction)LoopThread_func_call_soon_threadsafe, METH_VARARGS, "Call the given function with the given arguments in the loop thread." },
+    { "stop", (PyCFunction)LoopThread_func_stop, METH_NOARGS, "Stop the loop, the thread exits afterwards." },
+    { "join", (PyCFunction)LoopThread_func_join, METH_NOARGS, "Wait until the thread terminates." },
+    { "is_alive", (PyCFunction)LoopThread_func_is_alive, METH_NOARGS, "Return True if the thread is running." },
+    { NULL }
+};
+
+
+static PyMemberDef LoopThread_tp_members[] = {
+    {"loop", T_OBJECT, offsetof(LoopThread, loop), READONLY, "Loop which runs in the thread."},
+    {"thread", T_OBJECT, offsetof(LoopThread, thread), READONLY, "Thread where the loop runs."},
+    {NULL}
+};
+
+
+static PyTypeObject LoopThreadType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv._cpyuv.thread.LoopThread",                                /*tp_name*/
+    sizeof(LoopThread),                                             /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)LoopThread_tp_dealloc,                              /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,  /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)LoopThread_tp_traverse,                           /*tp_traverse*/
+    (inquiry)LoopThread_tp_clear,                                   /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    LoopThread_tp_methods,                                          /*tp_methods*/
+    LoopThread_tp_members,                                          /*tp_members*/
+    0,                                                              /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)LoopThread_tp_init,                                   /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    LoopThread_tp_new,                                              /*tp_new*/
+};
+
 
 #ifdef PYUV_PYTHON3
 static PyModuleDef pyuv_thread_module = {
@@ -759,6 +2108,10 @@ init_thread(void)
     PyUVModule_AddType(module, "Mutex", &MutexType);
     PyUVModule_AddType(module, "RWLock", &RWLockType);
     PyUVModule_AddType(module, "Semaphore", &SemaphoreType);
+    PyUVModule_AddType(module, "SPSCQueue", &SPSCQueueType);
+    PyUVModule_AddType(module, "MPMCQueue", &MPMCQueueType);
+    PyUVModule_AddType(module, "Thread", &ThreadType);
+    PyUVModule_AddType(module, "LoopThread", &LoopThreadType);
 
     return module;
 }
@@ -4,7 +4,6 @@ pyuv__timer_cb(uv_timer_t *handle)
 {
     PyGILState_STATE gstate = PyGILState_Ensure();
     Timer *self;
-    PyObject *result;
 
     ASSERT(handle);
     self = PYUV_CONTAINER_OF(handle, Timer, timer_h);
@@ -12,11 +11,7 @@ pyuv__timer_cb(uv_timer_t *handle)
     /* Object could go out of scope in the callback, increase refcount to avoid it */
     Py_INCREF(self);
 
-    result = PyObject_CallFunctionObjArgs(self->callback, self, NULL);
-    if (result == NULL) {
-        handle_uncaught_exception(HANDLE(self)->loop);
-    }
-    Py_XDECREF(result);
+    pyuv__handle_dispatch(HANDLE(self), self->callback, PyTuple_Pack(1, (PyObject *)self), 0);
 
     Py_DECREF(self);
     PyGILState_Release(gstate);
@@ -5,6 +5,8 @@ typedef struct {
     Py_buffer *views;
     Py_buffer viewsml[4];
     int view_count;
+    /* bytes the request left in the send queue, see pyuv__loop_memory_enqueue */
+    size_t queued;
 } udp_send_ctx;
 
 
@@ -14,7 +16,7 @@ pyuv__udp_recv_cd(uv_udp_t* handle, int nread, const uv_buf_t* buf, struct socka
     PyGILState_STATE gstate = PyGILState_Ensure();
     Loop *loop;
     UDP *self;
-    PyObject *result, *address_tuple, *data, *py_errorno;
+    PyObject *address_tuple, *data, *py_errorno;
 
     ASSERT(handle);
     ASSERT(flags == 0);
@@ -47,13 +49,9 @@ pyuv__udp_recv_cd(uv_udp_t* handle, int nread, const uv_buf_t* buf, struct socka
         py_errorno = PyInt_FromLong((long)nread);
     }
 
-    result = PyObject_CallFunctionObjArgs(self->on_read_cb, self, address_tuple, PyInt_FromLong((long)flags), data, py_errorno, NULL);
-    if (result == NULL) {
-        handle_uncaught_exception(HANDLE(self)->loop);
-    }
-    Py_XDECREF(result);
-    Py_DECREF(address_tuple);
-    Py_DECREF(data);
+    pyuv__handle_dispatch(HANDLE(self), self->on_read_cb, Py_BuildValue("(OOIOO)", self, address_tuple, flags, data, py_errorno), nread > 0 ? nread : 0);
+    Py_XDECREF(address_tuple);
+    Py_XDECREF(data);
     Py_DECREF(py_errorno);
 
 done:
@@ -81,6 +79,7 @@ pyuv__udp_send_cb(uv_udp_send_t* req, int status)
     ctx = PYUV_CONTAINER_OF(req, udp_send_ctx, req);
     self = PYUV_CONTAINER_OF(req->handle, UDP, udp_h);
     callback = ctx->callback;
+    pyuv__loop_memory_dequeue(req->handle->loop, ctx->queued);
 
     ASSERT(self);
 
@@ -175,6 +174,7 @@ UDP_func_start_recv(UDP *self, PyObject *args)
     Py_INCREF(callback);
     self->on_read_cb = callback;
     Py_XDECREF(tmp);
+    pyuv__handle_gc_track(HANDLE(self));
 
     PYUV_HANDLE_INCREF(self);
 
@@ -196,8 +196,12 @@ UDP_func_stop_recv(UDP *self)
         return NULL;
     }
 
+    /* datagrams still queued by the loop are not delivered */
+    pyuv__loop_defer_drop(HANDLE(self)->loop, HANDLE(self));
+
     Py_XDECREF(self->on_read_cb);
     self->on_read_cb = NULL;
+    pyuv__handle_gc_untrack(HANDLE(self), NULL);
 
     PYUV_HANDLE_DECREF(self);
 
@@ -244,6 +248,7 @@ static PyObject *
 pyuv__udp_send_bytes(UDP *self, struct sockaddr *addr, PyObject *data, PyObject *callback)
 {
     int err;
+    size_t queued;
     uv_buf_t buf;
     udp_send_ctx *ctx;
     Py_buffer *view;
@@ -269,6 +274,7 @@ pyuv__udp_send_bytes(UDP *self, struct sockaddr *addr, PyObject *data, PyObject
 
     buf = uv_buf_init(view->buf, view->len);
 
+    queued = self->udp_h.send_queue_size;
     err = uv_udp_send(&ctx->req, &self->udp_h, &buf, 1, addr, (uv_udp_send_cb)pyuv__udp_send_cb);
     if (err < 0) {
         RAISE_UV_EXCEPTION(err, PyExc_UDPError);
@@ -278,6 +284,8 @@ pyuv__udp_send_bytes(UDP *self, struct sockaddr *addr, PyObject *data, PyObject
         return NULL;
     }
 
+    ctx->queued = pyuv__loop_memory_enqueue(self->udp_h.loop, queued, self->udp_h.send_queue_size);
+
     /* Increase refcount so that object is not removed before the callback is called */
     Py_INCREF(self);
 
@@ -289,6 +297,7 @@ static PyObject *
 pyuv__udp_send_sequence(UDP *self, struct sockaddr *addr, PyObject *data, PyObject *callback)
 {
     int err;
+    size_t queued;
     udp_send_ctx *ctx;
     PyObject *data_fast, *item;
     Py_ssize_t i, j, buf_count;
@@ -342,6 +351,7 @@ pyuv__udp_send_sequence(UDP *self, struct sockaddr *addr, PyObject *data, PyObje
         ctx->callback = callback;
         Py_INCREF(callback);
 
+        queued = self->udp_h.send_queue_size;
         err = uv_udp_send(&ctx->req, &self->udp_h, bufs, buf_count, addr, (uv_udp_send_cb)pyuv__udp_send_cb);
     }
 
@@ -351,6 +361,8 @@ pyuv__udp_send_sequence(UDP *self, struct sockaddr *addr, PyObject *data, PyObje
         goto error;
     }
 
+    ctx->queued = pyuv__loop_memory_enqueue(self->udp_h.loop, queued, self->udp_h.send_queue_size);
+
     /* Increase refcount so that object is not removed before the callback is called */
     Py_INCREF(self);
 
@@ -592,6 +604,33 @@ UDP_func_open(UDP *self, PyObject *args)
 }
 
 
+static PyObject *
+UDP_func_set_busy_poll(UDP *self, PyObject *args)
+{
+    int err, usecs;
+
+    RAISE_IF_HANDLE_NOT_INITIALIZED(self, NULL);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "i:set_busy_poll", &usecs)) {
+        return NULL;
+    }
+
+    if (usecs < 0) {
+        PyErr_SetString(PyExc_ValueError, "usecs must not be negative");
+        return NULL;
+    }
+
+    err = pyuv__set_busy_poll(UV_HANDLE(self), usecs);
+    if (err < 0) {
+        RAISE_UV_EXCEPTION(err, PyExc_UDPError);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
 static PyObject *
 UDP_func_fileno(UDP *self)
 {
@@ -767,6 +806,7 @@ UDP_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 
     self->udp_h.data = self;
     UV_HANDLE(self) = (uv_handle_t *)&self->udp_h;
+    pyuv__handle_gc_untrack(HANDLE(self), NULL);
 
     return (PyObject *)self;
 }
@@ -803,6 +843,7 @@ UDP_tp_methods[] = {
     { "set_multicast_loop", (PyCFunction)UDP_func_set_multicast_loop, METH_VARARGS, "Set IP multicast loop flag. Makes multicast packets loop back to local sockets." },
     { "set_broadcast", (PyCFunction)UDP_func_set_broadcast, METH_VARARGS, "Set broadcast on or off." },
     { "set_ttl", (PyCFunction)UDP_func_set_ttl, METH_VARARGS, "Set the Time To Live." },
+    { "set_busy_poll", (PyCFunction)UDP_func_set_busy_poll, METH_VARARGS, "Busy poll the device queue when reading, for the given number of microseconds." },
     { "fileno", (PyCFunction)UDP_func_fileno, METH_NOARGS, "Returns the libuv OS handle." },
     { NULL }
 };
@@ -145,6 +145,151 @@ Util_func_interface_addresses(PyObject *obj)
 }
 
 
+#ifdef PYUV_LINUX
+static PyObject *
+pyuv__sysfs_read(const char *path)
+{
+    FILE *f;
+    char buf[1024];
+    size_t len;
+
+    f = fopen(path, "r");
+    if (f == NULL) {
+        return NULL;
+    }
+    len = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[len] = '\0';
+    while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == ' ')) {
+        buf[--len] = '\0';
+    }
+    return PyBytes_FromString(buf);
+}
+
+
+static PyObject *
+pyuv__sysfs_read_int(const char *path)
+{
+    PyObject *data, *result;
+
+    data = pyuv__sysfs_read(path);
+    if (data == NULL) {
+        Py_RETURN_NONE;
+    }
+    result = PyInt_FromLong(strtol(PyBytes_AS_STRING(data), NULL, 10));
+    Py_DECREF(data);
+    return result;
+}
+
+
+/* Parse a CPU list in the kernel format, such as "0-3,8,10-11" */
+static PyObject *
+pyuv__sysfs_read_cpulist(const char *path)
+{
+    long start, end;
+    char *p, *q;
+    PyObject *data, *result, *item;
+
+    data = pyuv__sysfs_read(path);
+    if (data == NULL) {
+        Py_RETURN_NONE;
+    }
+
+    result = PyList_New(0);
+    if (result == NULL) {
+        Py_DECREF(data);
+        return NULL;
+    }
+
+    p = PyBytes_AS_STRING(data);
+    while (*p != '\0') {
+        start = strtol(p, &q, 10);
+        if (q == p) {
+            break;
+        }
+        end = start;
+        if (*q == '-') {
+            p = q + 1;
+            end = strtol(p, &q, 10);
+        }
+        for (; start <= end; start++) {
+            item = PyInt_FromLong(start);
+            if (item == NULL || PyList_Append(result, item) != 0) {
+                Py_XDECREF(item);
+                Py_DECREF(result);
+                Py_DECREF(data);
+                return NULL;
+            }
+            Py_DECREF(item);
+        }
+        p = *q == ',' ? q + 1 : q;
+    }
+    Py_DECREF(data);
+
+    item = PyList_AsTuple(result);
+    Py_DECREF(result);
+    return item;
+}
+
+
+static PyObject *
+pyuv__sysfs_numa_node(int cpu)
+{
+    DIR *dir;
+    struct dirent *entry;
+    char path[64];
+    long node;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    dir = opendir(path);
+    if (dir == NULL) {
+        Py_RETURN_NONE;
+    }
+
+    node = -1;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && isdigit((unsigned char)entry->d_name[4])) {
+            node = strtol(entry->d_name + 4, NULL, 10);
+            break;
+        }
+    }
+    closedir(dir);
+
+    if (node == -1) {
+        Py_RETURN_NONE;
+    }
+    return PyInt_FromLong(node);
+}
+#endif
+
+
+static void
+pyuv__cpu_info_set_topology(PyObject *item, int cpu)
+{
+#ifdef PYUV_LINUX
+    char path[128];
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+    PyStructSequence_SET_ITEM(item, 4, pyuv__sysfs_read_int(path));
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    PyStructSequence_SET_ITEM(item, 5, pyuv__sysfs_read_int(path));
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+    PyStructSequence_SET_ITEM(item, 6, pyuv__sysfs_read_cpulist(path));
+    PyStructSequence_SET_ITEM(item, 7, pyuv__sysfs_numa_node(cpu));
+#else
+    Py_INCREF(Py_None);
+    PyStructSequence_SET_ITEM(item, 4, Py_None);
+    Py_INCREF(Py_None);
+    PyStructSequence_SET_ITEM(item, 5, Py_None);
+    Py_INCREF(Py_None);
+    PyStructSequence_SET_ITEM(item, 6, Py_None);
+    Py_INCREF(Py_None);
+    PyStructSequence_SET_ITEM(item, 7, Py_None);
+#endif
+    PyStructSequence_SET_ITEM(item, 3, PyInt_FromLong((long)cpu));
+}
+
+
 static PyObject *
 Util_func_cpu_info(PyObject *obj)
 {
@@ -175,6 +320,7 @@ Util_func_cpu_info(PyObject *obj)
             PyStructSequence_SET_ITEM(item, 0, Py_BuildValue("s", cpus[i].model));
             PyStructSequence_SET_ITEM(item, 1, PyInt_FromLong((long)cpus[i].speed));
             PyStructSequence_SET_ITEM(item, 2, times);
+            pyuv__cpu_info_set_topology(item, i);
             PyList_SET_ITEM(result, i, item);
             PyStructSequence_SET_ITEM(times, 0, PyLong_FromUnsignedLongLong((unsigned PY_LONG_LONG)cpus[i].cpu_times.sys));
             PyStructSequence_SET_ITEM(times, 1, PyLong_FromUnsignedLongLong((unsigned PY_LONG_LONG)cpus[i].cpu_times.user));
@@ -200,7 +346,6 @@ Util_func_getrusage(PyObject *obj)
 {
     int err;
     uv_rusage_t ru;
-    PyObject *result;
 
     UNUSED_ARG(obj);
 
@@ -210,50 +355,271 @@ Util_func_getrusage(PyObject *obj)
         return NULL;
     }
 
-    result = PyStructSequence_New(&RusageResultType);
-    if (!result)
+    return pyuv__rusage_result_new(&ru);
+}
+
+
+static PyObject *
+Util_func_guess_handle_type(PyObject *obj, PyObject *args)
+{
+    int fd;
+
+    UNUSED_ARG(obj);
+
+    if (!PyArg_ParseTuple(args, "i:guess_handle_type", &fd)) {
         return NULL;
+    }
 
-#define pyuv__doubletime(TV) ((double)(TV).tv_sec + 1e-6*(TV).tv_usec)
-    PyStructSequence_SET_ITEM(result, 0, PyFloat_FromDouble(pyuv__doubletime(ru.ru_utime)));
-    PyStructSequence_SET_ITEM(result, 1, PyFloat_FromDouble(pyuv__doubletime(ru.ru_stime)));
-    PyStructSequence_SET_ITEM(result, 2, PyLong_FromLong(ru.ru_maxrss));
-    PyStructSequence_SET_ITEM(result, 3, PyLong_FromLong(ru.ru_ixrss));
-    PyStructSequence_SET_ITEM(result, 4, PyLong_FromLong(ru.ru_idrss));
-    PyStructSequence_SET_ITEM(result, 5, PyLong_FromLong(ru.ru_isrss));
-    PyStructSequence_SET_ITEM(result, 6, PyLong_FromLong(ru.ru_minflt));
-    PyStructSequence_SET_ITEM(result, 7, PyLong_FromLong(ru.ru_majflt));
-    PyStructSequence_SET_ITEM(result, 8, PyLong_FromLong(ru.ru_nswap));
-    PyStructSequence_SET_ITEM(result, 9, PyLong_FromLong(ru.ru_inblock));
-    PyStructSequence_SET_ITEM(result, 10, PyLong_FromLong(ru.ru_oublock));
-    PyStructSequence_SET_ITEM(result, 11, PyLong_FromLong(ru.ru_msgsnd));
-    PyStructSequence_SET_ITEM(result, 12, PyLong_FromLong(ru.ru_msgrcv));
-    PyStructSequence_SET_ITEM(result, 13, PyLong_FromLong(ru.ru_nsignals));
-    PyStructSequence_SET_ITEM(result, 14, PyLong_FromLong(ru.ru_nvcsw));
-    PyStructSequence_SET_ITEM(result, 15, PyLong_FromLong(ru.ru_nivcsw));
-#undef pyuv__doubletime
+    return PyInt_FromLong((long) uv_guess_handle(fd));
+}
 
-    if (PyErr_Occurred()) {
-        Py_DECREF(result);
+
+#ifdef PYUV_LINUX
+/* One request is queued per worker, they wait for each other so that each of them is known to
+ * run on a different worker. The caller gives up after a timeout, releasing the ones waiting.
+ */
+typedef struct {
+    uv_mutex_t mutex;
+    uv_cond_t cond;
+    int nthreads;
+    int arrived;
+    Bool cancelled;
+} pyuv__threadpool_rendezvous;
+
+typedef struct {
+    uv_work_t req;
+    pyuv__threadpool_rendezvous *rendezvous;
+    const cpu_set_t *cpuset;
+    int policy;
+    int priority;
+    int err;
+} pyuv__threadpool_sched_req;
+
+
+static void
+pyuv__threadpool_sched_work_cb(uv_work_t *req)
+{
+    Bool apply;
+    pyuv__threadpool_sched_req *sched_req;
+    pyuv__threadpool_rendezvous *rv;
+
+    sched_req = PYUV_CONTAINER_OF(req, pyuv__threadpool_sched_req, req);
+    rv = sched_req->rendezvous;
+
+    uv_mutex_lock(&rv->mutex);
+    rv->arrived++;
+    uv_cond_broadcast(&rv->cond);
+    while (rv->arrived < rv->nthreads && !rv->cancelled) {
+        uv_cond_wait(&rv->cond, &rv->mutex);
+    }
+    apply = !rv->cancelled;
+    uv_mutex_unlock(&rv->mutex);
+
+    if (apply) {
+        sched_req->err = pyuv__sched_apply(pthread_self(),
+                                           (long)syscall(SYS_gettid),
+                                           sched_req->cpuset,
+                                           sched_req->policy,
+                                           sched_req->priority);
+    }
+}
+
+
+static void
+pyuv__threadpool_sched_after_work_cb(uv_work_t *req, int status)
+{
+    UNUSED_ARG(req);
+    UNUSED_ARG(status);
+}
+
+
+/* Apply the given settings to every thread in the pool, blocks until all of them are idle or
+ * the timeout expires, in which case none of them is changed.
+ */
+static PyObject *
+pyuv__threadpool_sched(const cpu_set_t *cpuset, int policy, int priority, double timeout)
+{
+    int i, err, nthreads;
+    const char *val;
+    uint64_t now, deadline;
+    uv_loop_t loop;
+    pyuv__threadpool_rendezvous rv;
+    pyuv__threadpool_sched_req *reqs;
+
+    /* the worker would wait for itself */
+    if (pyuv__tp_worker) {
+        PyErr_SetString(PyExc_RuntimeError, "cannot be called from a threadpool worker");
         return NULL;
     }
 
-    return result;
+    if (timeout < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "timeout must be 0 or greater");
+        return NULL;
+    }
+
+    /* same logic libuv uses to size the pool */
+    nthreads = 4;
+    val = getenv("UV_THREADPOOL_SIZE");
+    if (val != NULL) {
+        nthreads = atoi(val);
+    }
+    if (nthreads <= 0) {
+        nthreads = 1;
+    }
+    if (nthreads > 128) {
+        nthreads = 128;
+    }
+
+    reqs = PyMem_New(pyuv__threadpool_sched_req, nthreads);
+    if (reqs == NULL) {
+        return PyErr_NoMemory();
+    }
+
+    err = uv_loop_init(&loop);
+    if (err < 0) {
+        PyMem_Free(reqs);
+        RAISE_UV_EXCEPTION(err, PyExc_UVError);
+        return NULL;
+    }
+    if (uv_mutex_init(&rv.mutex)) {
+        uv_loop_close(&loop);
+        PyMem_Free(reqs);
+        PyErr_SetString(PyExc_ThreadError, "Error initializing Mutex");
+        return NULL;
+    }
+    if (uv_cond_init(&rv.cond)) {
+        uv_mutex_destroy(&rv.mutex);
+        uv_loop_close(&loop);
+        PyMem_Free(reqs);
+        PyErr_SetString(PyExc_ThreadError, "Error initializing Condition");
+        return NULL;
+    }
+    rv.nthreads = nthreads;
+    rv.arrived = 0;
+    rv.cancelled = False;
+
+    for (i = 0; i < nthreads; i++) {
+        reqs[i].rendezvous = &rv;
+        reqs[i].cpuset = cpuset;
+        reqs[i].policy = policy;
+        reqs[i].priority = priority;
+        reqs[i].err = 0;
+        uv_queue_work(&loop, &reqs[i].req, pyuv__threadpool_sched_work_cb, pyuv__threadpool_sched_after_work_cb);
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    deadline = uv_hrtime() + (uint64_t)(timeout * 1e9);
+    uv_mutex_lock(&rv.mutex);
+    while (rv.arrived < nthreads && !rv.cancelled) {
+        now = uv_hrtime();
+        if (now >= deadline) {
+            rv.cancelled = True;
+            uv_cond_broadcast(&rv.cond);
+        } else {
+            uv_cond_timedwait(&rv.cond, &rv.mutex, deadline - now);
+        }
+    }
+    uv_mutex_unlock(&rv.mutex);
+
+    /* requests still queued behind busy workers are dropped, the others return right away */
+    if (rv.cancelled) {
+        for (i = 0; i < nthreads; i++) {
+            uv_cancel((uv_req_t *)&reqs[i].req);
+        }
+    }
+    uv_run(&loop, UV_RUN_DEFAULT);
+    Py_END_ALLOW_THREADS
+
+    err = rv.cancelled ? UV_ETIMEDOUT : 0;
+    for (i = 0; i < nthreads && err == 0; i++) {
+        err = reqs[i].err;
+    }
+
+    uv_cond_destroy(&rv.cond);
+    uv_mutex_destroy(&rv.mutex);
+    uv_loop_close(&loop);
+    PyMem_Free(reqs);
+
+    if (err < 0) {
+        RAISE_UV_EXCEPTION(err, PyExc_UVError);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
 }
+#endif
 
 
 static PyObject *
-Util_func_guess_handle_type(PyObject *obj, PyObject *args)
+Util_func_set_threadpool_affinity(PyObject *obj, PyObject *args, PyObject *kwargs)
 {
-    int fd;
+#ifdef PYUV_LINUX
+    double timeout;
+    cpu_set_t cpuset;
+    PyObject *cpus;
+
+    static char *kwlist[] = {"cpus", "timeout", NULL};
 
     UNUSED_ARG(obj);
 
-    if (!PyArg_ParseTuple(args, "i:guess_handle_type", &fd)) {
+    timeout = PYUV_THREADPOOL_SCHED_TIMEOUT;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|d:set_threadpool_affinity", kwlist, &cpus, &timeout)) {
         return NULL;
     }
 
-    return PyInt_FromLong((long) uv_guess_handle(fd));
+    if (cpus == Py_None) {
+        pyuv__cpus_to_cpuset(NULL, &cpuset);
+    } else {
+        cpus = pyuv__cpus_parse(cpus);
+        if (cpus == NULL) {
+            return NULL;
+        }
+        pyuv__cpus_to_cpuset(cpus, &cpuset);
+        Py_DECREF(cpus);
+    }
+
+    return pyuv__threadpool_sched(&cpuset, -1, 0, timeout);
+#else
+    UNUSED_ARG(obj);
+    UNUSED_ARG(args);
+    UNUSED_ARG(kwargs);
+    PyErr_SetString(PyExc_NotImplementedError, "CPU affinity is not supported on this platform");
+    return NULL;
+#endif
+}
+
+
+static PyObject *
+Util_func_set_threadpool_scheduling(PyObject *obj, PyObject *args, PyObject *kwargs)
+{
+#ifdef PYUV_LINUX
+    int policy, priority;
+    double timeout;
+
+    static char *kwlist[] = {"policy", "priority", "timeout", NULL};
+
+    UNUSED_ARG(obj);
+
+    priority = 0;
+    timeout = PYUV_THREADPOOL_SCHED_TIMEOUT;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "i|id:set_threadpool_scheduling", kwlist, &policy, &priority, &timeout)) {
+        return NULL;
+    }
+
+    if (pyuv__sched_check(policy, priority) != 0) {
+        return NULL;
+    }
+
+    return pyuv__threadpool_sched(NULL, policy, priority, timeout);
+#else
+    UNUSED_ARG(obj);
+    UNUSED_ARG(args);
+    UNUSED_ARG(kwargs);
+    PyErr_SetString(PyExc_NotImplementedError, "scheduling control is not supported on this platform");
+    return NULL;
+#endif
 }
 
 
@@ -269,6 +635,8 @@ Util_methods[] = {
     { "cpu_info", (PyCFunction)Util_func_cpu_info, METH_NOARGS, "Gets system CPU information." },
     { "getrusage", (PyCFunction)Util_func_getrusage, METH_NOARGS, "Get information about OS resource utilization for the current process." },
     { "guess_handle_type", (PyCFunction)Util_func_guess_handle_type, METH_VARARGS, "Guess the handle type, given a file descriptor." },
+    { "set_threadpool_affinity", (PyCFunction)Util_func_set_threadpool_affinity, METH_VARARGS|METH_KEYWORDS, "Set the CPUs the threadpool workers may run on." },
+    { "set_threadpool_scheduling", (PyCFunction)Util_func_set_threadpool_scheduling, METH_VARARGS|METH_KEYWORDS, "Set the scheduling policy of the threadpool workers." },
     { NULL }
 };
 
@@ -519,6 +887,15 @@ init_util(void)
     SignalCheckerType.tp_base = &HandleType;
     PyUVModule_AddType(module, "SignalChecker", &SignalCheckerType);
 
+#ifdef PYUV_LINUX
+    /* scheduling policies */
+    PyModule_AddIntMacro(module, SCHED_OTHER);
+    PyModule_AddIntMacro(module, SCHED_FIFO);
+    PyModule_AddIntMacro(module, SCHED_RR);
+    PyModule_AddIntMacro(module, SCHED_BATCH);
+    PyModule_AddIntMacro(module, SCHED_IDLE);
+#endif
+
     return module;
 }
 
@@ -0,0 +1,89 @@
+
+from __future__ import print_function
+
+import sys
+sys.path.insert(0, '../')
+import asyncio
+import time
+import pyuv
+import pyuv.asyncio
+
+
+# Measure HTTP style request / response throughput over keep-alive connections, with the
+# default asyncio event loop versus the pyuv backed one.
+
+CONNECTIONS = (1, 10, 100)
+REQUESTS = 50000
+
+REQUEST = b"GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"
+RESPONSE = b"HTTP/1.1 200 OK\r\nContent-Length: 13\r\nContent-Type: text/plain\r\n\r\nHello, World!"
+
+
+class ServerProtocol(asyncio.Protocol):
+
+    def connection_made(self, transport):
+        self.transport = transport
+        self.buffer = b""
+
+    def data_received(self, data):
+        self.buffer += data
+        while b"\r\n\r\n" in self.buffer:
+            _, self.buffer = self.buffer.split(b"\r\n\r\n", 1)
+            self.transport.write(RESPONSE)
+
+
+class ClientProtocol(asyncio.Protocol):
+
+    def __init__(self, count, done):
+        self.count = count
+        self.done = done
+        self.received = 0
+
+    def connection_made(self, transport):
+        self.transport = transport
+        transport.write(REQUEST)
+
+    def data_received(self, data):
+        self.received += len(data)
+        while self.received >= len(RESPONSE):
+            self.received -= len(RESPONSE)
+            self.count -= 1
+            if self.count == 0:
+                self.transport.close()
+                self.done.set_result(None)
+                return
+            self.transport.write(REQUEST)
+
+
+def bench(loop, connections):
+    server = loop.run_until_complete(loop.create_server(ServerProtocol, "127.0.0.1", 0))
+    port = server.sockets[0].getsockname()[1]
+    futures = []
+    t0 = time.time()
+    for _ in range(connections):
+        done = loop.create_future()
+        count = REQUESTS // connections
+        loop.run_until_complete(loop.create_connection(lambda: ClientProtocol(count, done), "127.0.0.1", port))
+        futures.append(done)
+    loop.run_until_complete(asyncio.gather(*futures))
+    elapsed = time.time() - t0
+    server.close()
+    loop.run_until_complete(server.wait_closed())
+    return REQUESTS / elapsed
+
+
+def main():
+    print("%-12s %14s %14s" % ("connections", "asyncio (r/s)", "pyuv (r/s)"))
+    for connections in CONNECTIONS:
+        loop = asyncio.new_event_loop()
+        r1 = bench(loop, connections)
+        loop.close()
+        loop = pyuv.asyncio.EventLoop()
+        r2 = bench(loop, connections)
+        loop.close()
+        print("%-12d %14d %14d" % (connections, r1, r2))
+
+
+if __name__ == '__main__':
+    main()
+
@@ -0,0 +1,83 @@
+
+from __future__ import print_function
+
+import sys
+sys.path.insert(0, '../')
+import gc
+import resource
+import time
+import pyuv
+
+try:
+    import tracemalloc
+except ImportError:
+    tracemalloc = None
+
+
+# Measure the memory used by each handle and the time a full GC collection takes with many
+# idle handles alive, versus the same handles with an attribute dictionary attached, which
+# makes them tracked by the GC. Then measure the rate at which short-lived handles can be
+# created and closed.
+
+HANDLES = 200000
+CHURN = 1000000
+BATCH = 100
+
+
+def memory_usage():
+    if tracemalloc is not None:
+        return tracemalloc.get_traced_memory()[0]
+    # ru_maxrss is in kilobytes on Linux
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss * 1024
+
+
+def bench(loop, cls, attach):
+    gc.collect()
+    mem0 = memory_usage()
+    handles = [cls(loop) for _ in range(HANDLES)]
+    if attach:
+        for h in handles:
+            h.data = None
+    mem = memory_usage() - mem0
+    t0 = time.time()
+    gc.collect()
+    elapsed = time.time() - t0
+    for h in handles:
+        h.close()
+    del handles
+    loop.run()
+    return mem, elapsed
+
+
+def bench_churn(loop, cls):
+    t0 = time.time()
+    for _ in range(CHURN // BATCH):
+        handles = [cls(loop) for _ in range(BATCH)]
+        for h in handles:
+            h.close()
+        del handles
+        loop.run()
+    return CHURN / (time.time() - t0)
+
+
+def main():
+    if tracemalloc is not None:
+        tracemalloc.start()
+    loop = pyuv.Loop()
+    print("%d handles" % HANDLES)
+    print("%-10s %-10s %14s %16s" % ("type", "attached", "bytes/handle", "gc.collect (ms)"))
+    for cls in (pyuv.TCP, pyuv.Pipe, pyuv.UDP, pyuv.Timer):
+        for attach in (False, True):
+            mem, elapsed = bench(loop, cls, attach)
+            print("%-10s %-10s %14.1f %16.1f" % (cls.__name__, attach, float(mem) / HANDLES, elapsed * 1000))
+    if tracemalloc is not None:
+        tracemalloc.stop()
+    print("")
+    print("%-10s %16s" % ("type", "created+closed/s"))
+    for cls in (pyuv.TCP, pyuv.Pipe, pyuv.UDP, pyuv.Timer):
+        print("%-10s %16d" % (cls.__name__, bench_churn(loop, cls)))
+
+
+if __name__ == '__main__':
+    main()
+
@@ -0,0 +1,75 @@
+
+from __future__ import print_function
+
+import sys
+sys.path.insert(0, '../')
+import socket
+import time
+import pyuv
+
+
+# Measure the cost of a loop iteration with many ready file descriptors, using one Poll
+# handle per descriptor versus a single PollGroup.
+
+NUM_FDS = (100, 1000, 4000)
+ITERATIONS = 200
+
+
+def make_pairs(count):
+    pairs = [socket.socketpair() for _ in range(count)]
+    for a, b in pairs:
+        b.send(b"x")    # keep every descriptor readable
+    return pairs
+
+
+def bench_poll(loop, pairs):
+    state = {'events': 0}
+    def poll_cb(handle, events, error):
+        state['events'] += 1
+    polls = []
+    for a, b in pairs:
+        poll = pyuv.Poll(loop, a.fileno())
+        poll.start(pyuv.UV_READABLE, poll_cb)
+        polls.append(poll)
+    t0 = time.time()
+    for i in range(ITERATIONS):
+        loop.run(pyuv.UV_RUN_ONCE)
+    elapsed = time.time() - t0
+    for poll in polls:
+        poll.close()
+    loop.run()
+    return elapsed
+
+
+def bench_group(loop, pairs):
+    state = {'events': 0}
+    def poll_cb(group, ready):
+        state['events'] += len(ready)
+    group = pyuv.PollGroup(loop)
+    for a, b in pairs:
+        group.add(a.fileno(), pyuv.UV_READABLE, a)
+    group.start(poll_cb)
+    t0 = time.time()
+    for i in range(ITERATIONS):
+        loop.run(pyuv.UV_RUN_ONCE)
+    elapsed = time.time() - t0
+    group.close()
+    loop.run()
+    return elapsed
+
+
+def main():
+    loop = pyuv.Loop.default_loop()
+    print("%8s %18s %18s" % ("fds", "Poll (us/iter)", "PollGroup (us/iter)"))
+    for count in NUM_FDS:
+        pairs = make_pairs(count)
+        poll = bench_poll(loop, pairs)
+        group = bench_group(loop, pairs)
+        print("%8d %18.1f %18.1f" % (count, poll * 1e6 / ITERATIONS, group * 1e6 / ITERATIONS))
+        for a, b in pairs:
+            a.close()
+            b.close()
+
+
+if __name__ == '__main__':
+    main()
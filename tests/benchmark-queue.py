@@ -0,0 +1,91 @@
+
+from __future__ import print_function
+
+import sys
+sys.path.insert(0, '../')
+import threading
+import time
+import pyuv
+
+try:
+    import queue
+except ImportError:
+    import Queue as queue
+
+
+# Measure the throughput of passing items between threads with queue.Queue versus the
+# pyuv.thread queues, with one item per call and in batches.
+
+ITEMS = 200000
+BATCH = 64
+CAPACITY = 1024
+
+
+def run(q, producers, consumers, produce, consume):
+    count = ITEMS // producers
+    def consumer_cb():
+        while True:
+            items = consume()
+            if None in items:
+                # a batch can hold the sentinels of other consumers, give them back
+                for _ in range(items.count(None) - 1):
+                    q.put(None)
+                break
+    threads = [threading.Thread(target=produce, args=(count,)) for _ in range(producers)]
+    threads += [threading.Thread(target=consumer_cb) for _ in range(consumers)]
+    t0 = time.time()
+    for t in threads:
+        t.start()
+    for t in threads[:producers]:
+        t.join()
+    return t0, threads[producers:]
+
+
+def bench_single(q, producers, consumers):
+    def produce(count):
+        put = q.put
+        for i in range(count):
+            put(i)
+    def consume():
+        return [q.get()]
+    t0, threads = run(q, producers, consumers, produce, consume)
+    for _ in threads:
+        q.put(None)
+    for t in threads:
+        t.join()
+    return time.time() - t0
+
+
+def bench_batch(q, producers, consumers):
+    def produce(count):
+        items = list(range(BATCH))
+        for i in range(0, count, BATCH):
+            n = 0
+            while n < BATCH:
+                n += q.put_many(items[n:])
+    def consume():
+        return q.get_many(BATCH)
+    t0, threads = run(q, producers, consumers, produce, consume)
+    for _ in threads:
+        q.put(None)
+    for t in threads:
+        t.join()
+    return time.time() - t0
+
+
+def main():
+    print("%-24s %14s %14s %14s" % ("producers/consumers", "queue.Queue", "MPMCQueue", "MPMC batch"))
+    for producers, consumers in ((1, 1), (2, 2), (4, 4)):
+        std = bench_single(queue.Queue(CAPACITY), producers, consumers)
+        mpmc = bench_single(pyuv.thread.MPMCQueue(CAPACITY), producers, consumers)
+        batch = bench_batch(pyuv.thread.MPMCQueue(CAPACITY), producers, consumers)
+        print("%-24s %13.0fk %13.0fk %13.0fk" % ("%d/%d" % (producers, consumers), ITEMS / std / 1e3, ITEMS / mpmc / 1e3, ITEMS / batch / 1e3))
+    std = bench_single(queue.Queue(CAPACITY), 1, 1)
+    spsc = bench_single(pyuv.thread.SPSCQueue(CAPACITY), 1, 1)
+    batch = bench_batch(pyuv.thread.SPSCQueue(CAPACITY), 1, 1)
+    print("%-24s %13.0fk %13.0fk %13.0fk" % ("1/1 (SPSCQueue)", ITEMS / std / 1e3, ITEMS / spsc / 1e3, ITEMS / batch / 1e3))
+    print("(items per second)")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,52 @@
+
+from __future__ import print_function
+
+import sys
+sys.path.insert(0, '../')
+import time
+import pyuv
+
+
+# Measure process spawning rate with an increasing amount of resident memory in the parent.
+# The cost of forking grows with the size of the address space which has to be copied.
+
+NUM_SPAWNS = 200
+BALLAST_SIZES = (0, 64, 256, 1024)    # in MB
+CONCURRENCY = 16
+
+
+def run(loop, spawn):
+    state = {'started': 0, 'finished': 0}
+    def on_exit(proc, exit_status, term_signal):
+        proc.close()
+        state['finished'] += 1
+        if state['started'] < NUM_SPAWNS:
+            state['started'] += 1
+            spawn(on_exit)
+    for i in range(CONCURRENCY):
+        state['started'] += 1
+        spawn(on_exit)
+    t0 = time.time()
+    loop.run()
+    return NUM_SPAWNS / (time.time() - t0)
+
+
+def main():
+    loop = pyuv.Loop.default_loop()
+    args = ["/bin/true"]
+    template = pyuv.SpawnTemplate(args=args)
+    print("%10s %16s %16s" % ("RSS (MB)", "spawn (ops/s)", "template (ops/s)"))
+    for size in BALLAST_SIZES:
+        ballast = bytearray(size * 1024 * 1024)
+        for i in range(0, len(ballast), 4096):
+            ballast[i] = 1
+        rss = pyuv.util.resident_set_memory() / (1024 * 1024)
+        plain = run(loop, lambda cb: pyuv.Process.spawn(loop, args=args, exit_callback=cb))
+        templated = run(loop, lambda cb: template.spawn(loop, cb))
+        print("%10d %16.1f %16.1f" % (rss, plain, templated))
+        del ballast
+
+
+if __name__ == '__main__':
+    main()
+
@@ -0,0 +1,93 @@
+
+from __future__ import print_function
+
+import sys
+sys.path.insert(0, '../')
+import socket
+import struct
+import threading
+import time
+import pyuv
+
+
+# Measure the latency between an event happening in another thread (an Async handle being sent
+# or a UDP datagram being sent to the loop) and its callback running, with the default blocking
+# mode and with UV_RUN_SPIN, which trades a busy core for a shorter wake-up.
+
+SAMPLES = 2000
+INTERVAL = 0.0005
+SPIN_US = 1000
+
+
+def percentile(samples, p):
+    return samples[min(len(samples) - 1, int(len(samples) * p))]
+
+
+def bench_async(mode):
+    loop = pyuv.Loop()
+    latencies = []
+    sent = []
+
+    def async_cb(handle):
+        latencies.append(pyuv.util.hrtime() - sent[-1])
+        if len(latencies) == SAMPLES:
+            handle.close()
+
+    async_handle = pyuv.Async(loop, async_cb)
+
+    def sender():
+        for _ in range(SAMPLES):
+            time.sleep(INTERVAL)
+            sent.append(pyuv.util.hrtime())
+            async_handle.send()
+
+    t = threading.Thread(target=sender)
+    t.start()
+    loop.run(mode, SPIN_US)
+    t.join()
+    return sorted(latencies)
+
+
+def bench_udp(mode):
+    loop = pyuv.Loop()
+    latencies = []
+
+    def on_recv(handle, address, flags, data, error):
+        latencies.append(pyuv.util.hrtime() - struct.unpack("!Q", data)[0])
+        if len(latencies) == SAMPLES:
+            handle.close()
+
+    server = pyuv.UDP(loop)
+    server.bind(("127.0.0.1", 0))
+    server.start_recv(on_recv)
+    address = server.getsockname()
+
+    def sender():
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        for _ in range(SAMPLES):
+            time.sleep(INTERVAL)
+            sock.sendto(struct.pack("!Q", pyuv.util.hrtime()), address)
+        sock.close()
+
+    t = threading.Thread(target=sender)
+    t.start()
+    loop.run(mode, SPIN_US)
+    t.join()
+    return sorted(latencies)
+
+
+def main():
+    print("%d wake-ups, spin budget %dus" % (SAMPLES, SPIN_US))
+    print("%-8s %-8s %12s %12s %12s" % ("source", "mode", "p50 (us)", "p99 (us)", "max (us)"))
+    for name, bench in (("async", bench_async), ("udp", bench_udp)):
+        for label, mode in (("default", pyuv.UV_RUN_DEFAULT), ("spin", pyuv.UV_RUN_SPIN)):
+            latencies = bench(mode)
+            print("%-8s %-8s %12.1f %12.1f %12.1f" % (name, label,
+                                                    percentile(latencies, 0.5) / 1000.0,
+                                                    percentile(latencies, 0.99) / 1000.0,
+                                                    latencies[-1] / 1000.0))
+
+
+if __name__ == '__main__':
+    main()
+
@@ -0,0 +1,13 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import sys
+
+data = sys.stdin.read()
+sys.stdout.write(data.upper())
+sys.stdout.flush()
+print("ERROR", file=sys.stderr)
+sys.stderr.flush()
+sys.exit(3)
+
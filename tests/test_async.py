@@ -63,5 +63,72 @@ class AsyncTest(TestCase):
         self.assertEqual(self.check_cb_called, 1)
 
 
+class AsyncQueueTest(TestCase):
+
+    def test_async_queue(self):
+        self.items = []
+        self.calls = 0
+        def queue_cb(queue, items):
+            self.calls += 1
+            self.items.extend(items)
+            if len(self.items) == 4000:
+                queue.close()
+        def thread_cb(n):
+            for i in range(1000):
+                self.queue.put((n, i))
+        self.queue = pyuv.AsyncQueue(self.loop, queue_cb)
+        threads = [threading.Thread(target=thread_cb, args=(n,)) for n in range(4)]
+        for t in threads:
+            t.start()
+        self.loop.run()
+        for t in threads:
+            t.join()
+        self.assertEqual(len(self.items), 4000)
+        self.assertTrue(self.calls <= 4000)
+        for n in range(4):
+            self.assertEqual([i for m, i in self.items if m == n], list(range(1000)))
+
+    def test_async_queue_batch_max(self):
+        self.batches = []
+        def queue_cb(queue, items):
+            self.batches.append(items)
+            if sum(len(b) for b in self.batches) == 10:
+                queue.close()
+        queue = pyuv.AsyncQueue(self.loop, queue_cb, batch_max=4)
+        self.assertEqual(queue.batch_max, 4)
+        for i in range(10):
+            queue.put(i)
+        self.assertEqual(len(queue), 10)
+        self.loop.run()
+        self.assertEqual(self.batches, [[0, 1, 2, 3], [4, 5, 6, 7], [8, 9]])
+
+    def test_async_queue_batch_max_put(self):
+        self.items = []
+        self.lengths = []
+        def queue_cb(queue, items):
+            self.items.extend(items)
+            self.lengths.append(len(queue))
+            # items put while draining go after the pending ones
+            if len(self.lengths) == 1:
+                queue.put(1000)
+            if len(self.items) == 1001:
+                queue.close()
+        queue = pyuv.AsyncQueue(self.loop, queue_cb, batch_max=3)
+        for i in range(1000):
+            queue.put(i)
+        self.loop.run()
+        self.assertEqual(self.items, list(range(1001)))
+        self.assertEqual(self.lengths[:3], [997, 995, 992])
+        self.assertEqual(self.lengths[-1], 0)
+
+    def test_async_queue_closed(self):
+        queue = pyuv.AsyncQueue(self.loop, lambda *args: None)
+        queue.close()
+        self.assertRaises(pyuv.error.HandleClosedError, queue.put, 1)
+        self.assertRaises(TypeError, pyuv.AsyncQueue, self.loop, None)
+        self.assertRaises(ValueError, pyuv.AsyncQueue, self.loop, lambda *args: None, -1)
+        self.loop.run()
+
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
@@ -0,0 +1,340 @@
+
+import os
+import socket
+import sys
+import threading
+import unittest
+
+from common import TestCase
+import pyuv
+
+try:
+    import asyncio
+    import pyuv.asyncio
+except ImportError:
+    asyncio = None
+
+
+class EchoProtocol(object if asyncio is None else asyncio.Protocol):
+
+    def connection_made(self, transport):
+        self.transport = transport
+
+    def data_received(self, data):
+        self.transport.write(data)
+        self.transport.close()
+
+
+class ClientProtocol(object if asyncio is None else asyncio.Protocol):
+
+    def __init__(self, done):
+        self.done = done
+        self.data = b""
+
+    def connection_made(self, transport):
+        transport.write(b"PING")
+
+    def data_received(self, data):
+        self.data += data
+
+    def connection_lost(self, exc):
+        self.done.set_result(self.data)
+
+
+class BufferedClientProtocol(object if asyncio is None else getattr(asyncio, "BufferedProtocol", object)):
+
+    def __init__(self, done):
+        self.done = done
+        self.buf = bytearray(2)
+        self.data = b""
+
+    def connection_made(self, transport):
+        transport.write(b"PING")
+
+    def get_buffer(self, sizehint):
+        return self.buf
+
+    def buffer_updated(self, nbytes):
+        self.data += bytes(self.buf[:nbytes])
+
+    def eof_received(self):
+        pass
+
+    def connection_lost(self, exc):
+        self.done.set_result(self.data)
+
+
+class DatagramProtocol(object if asyncio is None else asyncio.DatagramProtocol):
+
+    def __init__(self, done=None):
+        self.done = done
+
+    def connection_made(self, transport):
+        self.transport = transport
+
+    def datagram_received(self, data, addr):
+        if self.done is None:
+            self.transport.sendto(data, addr)
+        else:
+            self.done.set_result(data)
+
+
+@unittest.skipIf(asyncio is None, "asyncio is not available")
+class AsyncioTest(TestCase):
+
+    def setUp(self):
+        super(AsyncioTest, self).setUp()
+        self.aloop = pyuv.asyncio.EventLoop(self.loop)
+
+    def tearDown(self):
+        self.aloop.close()
+        super(AsyncioTest, self).tearDown()
+
+    def test_call_soon_later(self):
+        calls = []
+        self.aloop.call_later(0.02, calls.append, 3)
+        self.aloop.call_later(0.01, calls.append, 2)
+        self.aloop.call_soon(calls.append, 1)
+        self.aloop.call_later(0.03, self.aloop.stop)
+        self.aloop.run_forever()
+        self.assertEqual(calls, [1, 2, 3])
+        self.assertTrue(self.aloop.uv_loop is self.loop)
+
+    def test_handles(self):
+        calls = []
+        handle = self.aloop.call_soon(calls.append, 1)
+        self.assertTrue(type(handle) is pyuv._cpyuv._asyncio.Handle)
+        when = self.aloop.time() + 0.01
+        timers = [self.aloop.call_at(when, calls.append, i) for i in range(2, 5)]
+        self.assertTrue(type(timers[0]) is pyuv._cpyuv._asyncio.TimerHandle)
+        self.assertEqual(timers[0].when(), when)
+        timers[1].cancel()
+        self.assertTrue(timers[1].cancelled())
+        self.aloop.call_soon(calls.append, 5).cancel()
+        self.aloop.call_later(0.02, self.aloop.stop)
+        self.aloop.run_forever()
+        # timers due at the same time run in the order they were scheduled
+        self.assertEqual(calls, [1, 2, 4])
+        self.assertRaises(TypeError, self.aloop.call_at, None, calls.append)
+
+    @unittest.skipIf(sys.version_info < (3, 7), "contextvars requires Python >= 3.7")
+    def test_context(self):
+        import contextvars
+        var = contextvars.ContextVar("var", default="default")
+        ctx = contextvars.copy_context()
+        ctx.run(var.set, "set")
+        values = []
+        self.aloop.call_soon(lambda: values.append(var.get()), context=ctx)
+        self.aloop.call_later(0.001, lambda: values.append(var.get()))
+        self.aloop.call_later(0.01, self.aloop.stop)
+        self.aloop.run_forever()
+        self.assertEqual(values, ["set", "default"])
+
+    def test_exception_handler(self):
+        contexts = []
+        self.aloop.set_exception_handler(lambda loop, context: contexts.append(context))
+        def fail():
+            raise ValueError("fail")
+        handle = self.aloop.call_soon(fail)
+        self.aloop.call_soon(self.aloop.stop)
+        self.aloop.run_forever()
+        self.assertEqual(len(contexts), 1)
+        self.assertTrue(isinstance(contexts[0]["exception"], ValueError))
+        self.assertTrue(contexts[0]["handle"] is handle)
+
+    def test_call_soon_threadsafe(self):
+        fut = self.aloop.create_future()
+        t = threading.Thread(target=self.aloop.call_soon_threadsafe, args=(fut.set_result, 42))
+        t.start()
+        self.assertEqual(self.aloop.run_until_complete(fut), 42)
+        t.join()
+
+    def test_tcp_echo(self):
+        server = self.aloop.run_until_complete(self.aloop.create_server(EchoProtocol, "127.0.0.1", 0))
+        port = server.sockets[0].getsockname()[1]
+        done = self.aloop.create_future()
+        transport, _ = self.aloop.run_until_complete(self.aloop.create_connection(lambda: ClientProtocol(done), "127.0.0.1", port))
+        # the connection is served by a pyuv TCP handle, not by the selector
+        self.assertTrue(isinstance(transport, pyuv.asyncio._StreamTransport))
+        self.assertEqual(transport.get_extra_info("peername"), ("127.0.0.1", port))
+        self.assertEqual(self.aloop.run_until_complete(done), b"PING")
+        server.close()
+        self.aloop.run_until_complete(server.wait_closed())
+        self.assertEqual(self.aloop._listeners, {})
+
+    @unittest.skipIf(sys.version_info < (3, 7), "BufferedProtocol requires Python >= 3.7")
+    def test_tcp_buffered(self):
+        server = self.aloop.run_until_complete(self.aloop.create_server(EchoProtocol, "127.0.0.1", 0))
+        port = server.sockets[0].getsockname()[1]
+        done = self.aloop.create_future()
+        self.aloop.run_until_complete(self.aloop.create_connection(lambda: BufferedClientProtocol(done), "127.0.0.1", port))
+        self.assertEqual(self.aloop.run_until_complete(done), b"PING")
+        server.close()
+        self.aloop.run_until_complete(server.wait_closed())
+
+    def test_udp_echo(self):
+        server, _ = self.aloop.run_until_complete(self.aloop.create_datagram_endpoint(DatagramProtocol, local_addr=("127.0.0.1", 0)))
+        done = self.aloop.create_future()
+        client, _ = self.aloop.run_until_complete(self.aloop.create_datagram_endpoint(lambda: DatagramProtocol(done),
+                                                                                      local_addr=("127.0.0.1", 0)))
+        self.assertTrue(isinstance(client, pyuv.asyncio._DatagramTransport))
+        client.sendto(b"PING", server.get_extra_info("sockname"))
+        self.assertEqual(self.aloop.run_until_complete(done), b"PING")
+        client.close()
+        # connected sockets are served by the selector
+        done = self.aloop.create_future()
+        client, _ = self.aloop.run_until_complete(self.aloop.create_datagram_endpoint(lambda: DatagramProtocol(done),
+                                                                                      remote_addr=server.get_extra_info("sockname")))
+        client.sendto(b"PONG")
+        self.assertEqual(self.aloop.run_until_complete(done), b"PONG")
+        client.close()
+        server.close()
+        self.aloop.run_until_complete(asyncio.sleep(0))
+
+    @unittest.skipIf(sys.platform == "win32", "Unix only test")
+    def test_pipes(self):
+        r, w = os.pipe()
+        done = self.aloop.create_future()
+        reader = ClientProtocol(done)
+        reader.connection_made = lambda transport: None
+        rtransport, _ = self.aloop.run_until_complete(self.aloop.connect_read_pipe(lambda: reader, os.fdopen(r, "rb", 0)))
+        wtransport, _ = self.aloop.run_until_complete(self.aloop.connect_write_pipe(asyncio.Protocol, os.fdopen(w, "wb", 0)))
+        self.assertTrue(isinstance(rtransport, pyuv.asyncio._ReadPipeTransport))
+        self.assertTrue(isinstance(wtransport, pyuv.asyncio._WritePipeTransport))
+        wtransport.write(b"PI")
+        wtransport.write(b"NG")
+        wtransport.write_eof()
+        self.assertEqual(self.aloop.run_until_complete(done), b"PING")
+
+    def test_pyuv_handles(self):
+        # handles of the pyuv loop run while asyncio waits
+        fut = self.aloop.create_future()
+        timer = pyuv.Timer(self.loop)
+        timer.start(lambda handle: fut.set_result("timer"), 0.01, 0)
+        self.assertEqual(self.aloop.run_until_complete(fut), "timer")
+        timer.close()
+
+    @unittest.skipIf(sys.platform == "win32", "Unix only test")
+    def test_subprocess(self):
+        # the child is watched by libuv, no child watcher is needed
+        create = asyncio.create_subprocess_exec(sys.executable, "-c", "import sys; sys.stdout.write(sys.stdin.read().upper())",
+                                                stdin=asyncio.subprocess.PIPE, stdout=asyncio.subprocess.PIPE)
+        proc = self.aloop.run_until_complete(create)
+        out, _ = self.aloop.run_until_complete(proc.communicate(b"hello"))
+        self.assertEqual(out, b"HELLO")
+        self.assertEqual(proc.returncode, 0)
+        self.assertTrue(isinstance(proc._transport, pyuv.asyncio._SubprocessTransport))
+
+    @unittest.skipIf(sys.platform == "win32", "Unix only test")
+    def test_subprocess_kill(self):
+        create = asyncio.create_subprocess_exec(sys.executable, "-c", "import time; time.sleep(10)")
+        proc = self.aloop.run_until_complete(create)
+        proc.kill()
+        self.assertEqual(self.aloop.run_until_complete(proc.wait()), -9)
+        create = asyncio.create_subprocess_exec(os.path.join(os.path.dirname(__file__), "nonexistent"))
+        self.assertRaises(FileNotFoundError, self.aloop.run_until_complete, create)
+
+    def test_policy(self):
+        policy = pyuv.asyncio.EventLoopPolicy()
+        loop = policy.new_event_loop()
+        try:
+            self.assertTrue(isinstance(loop, pyuv.asyncio.EventLoop))
+            self.assertTrue(isinstance(loop.uv_loop, pyuv.Loop))
+            self.assertEqual(loop.run_until_complete(asyncio.sleep(0.01, "done")), "done")
+        finally:
+            loop.close()
+
+
+@unittest.skipIf(asyncio is None or sys.version_info < (3, 5), "awaiting requests requires Python >= 3.5")
+class RequestAwaitTest(TestCase):
+
+    def setUp(self):
+        super(RequestAwaitTest, self).setUp()
+        self.aloop = pyuv.asyncio.EventLoop(self.loop)
+        asyncio.set_event_loop(self.aloop)
+
+    def tearDown(self):
+        asyncio.set_event_loop(None)
+        self.aloop.close()
+        super(RequestAwaitTest, self).tearDown()
+
+    def wait(self, req):
+        return self.aloop.run_until_complete(asyncio.ensure_future(req, loop=self.aloop))
+
+    def test_fs(self):
+        st = self.wait(pyuv.fs.stat(self.loop, __file__, pyuv.AWAITABLE))
+        self.assertEqual(st.st_size, os.stat(__file__).st_size)
+        self.assertRaises(pyuv.error.FSError, self.wait, pyuv.fs.stat(self.loop, __file__ + ".missing", pyuv.AWAITABLE))
+
+    def test_fs_callback(self):
+        # requests started with a callback can be awaited as well
+        calls = []
+        req = pyuv.fs.stat(self.loop, __file__, calls.append)
+        st = self.wait(req)
+        self.assertEqual(calls, [req])
+        self.assertEqual(st, req.result)
+        self.assertEqual(self.wait(req), st)
+
+    def test_dns(self):
+        res = self.wait(pyuv.dns.getaddrinfo(self.loop, "localhost", 80, callback=pyuv.AWAITABLE))
+        self.assertTrue(len(res) > 0)
+
+    def test_work(self):
+        self.assertEqual(self.wait(self.loop.queue_work(lambda: 42, pyuv.AWAITABLE)), 42)
+        def work():
+            raise ValueError("work")
+        self.assertRaises(ValueError, self.wait, self.loop.queue_work(work, pyuv.AWAITABLE))
+
+    def test_future(self):
+        req = pyuv.fs.stat(self.loop, __file__, pyuv.AWAITABLE)
+        fut = req.__await__()
+        self.assertTrue(fut is req.__await__())
+        self.assertFalse(fut.done())
+        self.assertRaises(asyncio.InvalidStateError, fut.result)
+        calls = []
+        fut.add_done_callback(calls.append)
+        fut.add_done_callback(calls.append)
+        self.assertEqual(fut.remove_done_callback(calls.append), 2)
+        fut.add_done_callback(lambda f: self.aloop.stop())
+        self.aloop.run_forever()
+        self.assertTrue(fut.done())
+        self.assertFalse(fut.cancelled())
+        self.assertEqual(fut.exception(), None)
+        self.assertEqual(fut.result().st_size, os.stat(__file__).st_size)
+        self.assertEqual(calls, [])
+
+    def test_cancel(self):
+        # keep the threadpool busy so that the awaited request stays queued
+        event = threading.Event()
+        blockers = [self.loop.queue_work(event.wait) for _ in range(int(os.environ.get("UV_THREADPOOL_SIZE", 4)))]
+        ran = []
+        req = self.loop.queue_work(lambda: ran.append(True), pyuv.AWAITABLE)
+        fut = req.__await__()
+        task = asyncio.ensure_future(req, loop=self.aloop)
+        self.aloop.call_later(0.05, task.cancel)
+        try:
+            self.assertRaises(asyncio.CancelledError, self.aloop.run_until_complete, task)
+        finally:
+            event.set()
+        self.assertEqual(self.aloop.run_until_complete(asyncio.gather(*blockers)), [True] * len(blockers))
+        # the request was cancelled in libuv, so the work never ran
+        self.assertTrue(fut.cancelled())
+        self.assertEqual(ran, [])
+        self.assertFalse(fut.cancel("too late"))
+
+    def test_cancel_msg(self):
+        event = threading.Event()
+        blockers = [self.loop.queue_work(event.wait) for _ in range(int(os.environ.get("UV_THREADPOOL_SIZE", 4)))]
+        fut = self.loop.queue_work(lambda: None, pyuv.AWAITABLE).__await__()
+        try:
+            self.assertTrue(fut.cancel(msg="stop"))
+        finally:
+            event.set()
+        self.aloop.run_until_complete(asyncio.gather(*blockers))
+        with self.assertRaises(asyncio.CancelledError) as cm:
+            fut.result()
+        self.assertEqual(cm.exception.args, ("stop",))
+
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
@@ -28,6 +28,15 @@ class TestBasetype(TestCase):
     def test_inherit_udp(self):
         self._inheritance_test(pyuv.UDP, self.loop)
 
+    def test_inherit_loop_event(self):
+        self._inheritance_test(pyuv.LoopEvent, self.loop)
+
+    def test_inherit_loop_semaphore(self):
+        self._inheritance_test(pyuv.LoopSemaphore, self.loop, 2)
+
+    def test_inherit_loop_lock(self):
+        self._inheritance_test(pyuv.LoopLock, self.loop)
+
     def test_inherit_poll(self):
         sock = socket.socket()
         self._inheritance_test(pyuv.Poll, self.loop, sock.fileno())
@@ -73,6 +82,15 @@ class TestBasetype(TestCase):
     def test_inherit_thread_semaphore(self):
         self._inheritance_test(pyuv.thread.Semaphore, 1)
 
+    def test_inherit_thread_spscqueue(self):
+        self._inheritance_test(pyuv.thread.SPSCQueue, 1)
+
+    def test_inherit_thread_mpmcqueue(self):
+        self._inheritance_test(pyuv.thread.MPMCQueue, 1)
+
+    def test_inherit_thread_thread(self):
+        self._inheritance_test(pyuv.thread.Thread, lambda: None)
+
 
 if __name__ == '__main__':
     unittest.main(verbosity=2)
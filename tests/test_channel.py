@@ -0,0 +1,118 @@
+
+import threading
+import time
+import unittest
+
+from common import TestCase
+import pyuv
+
+
+class ChannelTest(TestCase):
+
+    def test_channel(self):
+        self.items = []
+        def channel_cb(channel, items):
+            self.assertTrue(len(items) <= 8)
+            self.items.extend(items)
+            if len(self.items) == 4000:
+                channel.close()
+        def thread_cb(n):
+            for i in range(1000):
+                self.assertTrue(self.channel.put((n, i)))
+        self.channel = pyuv.Channel(self.loop, 8)
+        self.assertEqual(self.channel.capacity, 8)
+        self.channel.start(channel_cb)
+        threads = [threading.Thread(target=thread_cb, args=(n,)) for n in range(4)]
+        for t in threads:
+            t.start()
+        self.loop.run()
+        for t in threads:
+            t.join()
+        self.assertEqual(len(self.items), 4000)
+        for n in range(4):
+            self.assertEqual([i for m, i in self.items if m == n], list(range(1000)))
+
+    def test_channel_full(self):
+        channel = pyuv.Channel(self.loop, 2)
+        self.assertTrue(channel.try_put(1))
+        self.assertTrue(channel.put(2))
+        self.assertEqual(len(channel), 2)
+        self.assertFalse(channel.try_put(3))
+        t0 = time.time()
+        self.assertFalse(channel.put(3, timeout=0.05))
+        self.assertTrue(time.time() - t0 >= 0.04)
+        self.assertFalse(channel.put(3, timeout=0))
+        channel.close()
+        self.loop.run()
+
+    def test_channel_stopped(self):
+        self.items = []
+        def channel_cb(channel, items):
+            self.items.extend(items)
+            channel.close()
+        def timer_cb(timer):
+            self.assertEqual(len(self.channel), 2)
+            self.channel.start(channel_cb)
+            timer.close()
+        self.channel = pyuv.Channel(self.loop, 4)
+        self.channel.put(1)
+        self.channel.put(2)
+        timer = pyuv.Timer(self.loop)
+        timer.start(timer_cb, 0.01, 0)
+        self.loop.run()
+        self.assertEqual(self.items, [1, 2])
+
+    def test_channel_writable(self):
+        self.items = []
+        self.writable_called = 0
+        def channel_cb(channel, items):
+            self.items.extend(items)
+            if len(self.items) == 10:
+                channel.close()
+        def produce(channel):
+            self.writable_called += 1
+            while len(self.produced) < 10:
+                if not channel.try_put(len(self.produced)):
+                    channel.notify_writable(produce)
+                    break
+                self.produced.append(None)
+        self.produced = []
+        channel = pyuv.Channel(self.loop, 3)
+        channel.start(channel_cb)
+        channel.notify_writable(produce)
+        self.loop.run()
+        self.assertEqual(self.items, list(range(10)))
+        self.assertTrue(self.writable_called > 1)
+
+    def test_channel_close_wakes_producers(self):
+        self.errors = []
+        def thread_cb():
+            try:
+                self.channel.put(2)
+            except pyuv.error.HandleClosedError:
+                self.errors.append(True)
+        def timer_cb(timer):
+            self.channel.close()
+            timer.close()
+        self.channel = pyuv.Channel(self.loop, 1)
+        self.channel.put(1)
+        t = threading.Thread(target=thread_cb)
+        t.start()
+        timer = pyuv.Timer(self.loop)
+        timer.start(timer_cb, 0.05, 0)
+        self.loop.run()
+        t.join()
+        self.assertEqual(self.errors, [True])
+        self.assertRaises(pyuv.error.HandleClosedError, self.channel.put, 3)
+
+    def test_channel_invalid(self):
+        self.assertRaises(ValueError, pyuv.Channel, self.loop, 0)
+        channel = pyuv.Channel(self.loop, 1)
+        self.assertRaises(TypeError, channel.start, None)
+        self.assertRaises(ValueError, channel.put, 1, -1)
+        channel.close()
+        self.loop.run()
+
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
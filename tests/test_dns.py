@@ -1,5 +1,6 @@
 
 import socket
+import struct
 import unittest
 
 from common import TestCase
@@ -62,5 +63,330 @@ class DnsTest(TestCase):
         self.assertNotEqual(result, None)
 
 
+class GetaddrinfoManyTest(TestCase):
+
+    def getaddrinfo_many(self, hosts, **kwargs):
+        self.batches = []
+        def cb(results, finished):
+            self.assertFalse(self.batches and self.batches[-1][1])
+            self.batches.append((results, finished))
+        pyuv.dns.getaddrinfo_many(self.loop, hosts, 80, cb, **kwargs)
+        self.loop.run()
+        self.assertTrue(self.batches[-1][1])
+        return dict((host, (result, errorno)) for batch, _ in self.batches for host, result, errorno in batch)
+
+    def test_getaddrinfo_many(self):
+        hosts = ["localhost", "127.0.0.1", "localhost", b"127.0.0.2", "127.0.0.1"]
+        results = self.getaddrinfo_many(hosts, socktype=socket.SOCK_STREAM, concurrency=2, batch_size=2)
+        self.assertEqual(sum(len(batch) for batch, _ in self.batches), 3)
+        self.assertTrue(all(len(batch) <= 2 for batch, _ in self.batches))
+        self.assertEqual(set(results), set(["localhost", "127.0.0.1", b"127.0.0.2"]))
+        for result, errorno in results.values():
+            self.assertEqual(errorno, None)
+            self.assertEqual(result[0].socktype, socket.SOCK_STREAM)
+        self.assertEqual(results["127.0.0.1"][0][0].sockaddr, ("127.0.0.1", 80))
+
+    def test_getaddrinfo_many_errors(self):
+        results = self.getaddrinfo_many(["127.0.0.1", u"a"*64 + ".com"])
+        self.assertEqual(results[u"a"*64 + ".com"], (None, pyuv.errno.UV_EINVAL))
+        self.assertEqual(results["127.0.0.1"][1], None)
+
+    def test_getaddrinfo_many_failed_batches(self):
+        hosts = [u"%d" % i + u"a"*64 + ".com" for i in range(10)] + ["127.0.0.1"]
+        results = self.getaddrinfo_many(hosts, concurrency=2, batch_size=2)
+        # names failing before a lookup is started are delivered in batch_size slices too
+        self.assertTrue(all(len(batch) <= 2 for batch, _ in self.batches))
+        self.assertEqual(sum(len(batch) for batch, _ in self.batches), 11)
+        for host in hosts[:-1]:
+            self.assertEqual(results[host], (None, pyuv.errno.UV_EINVAL))
+        self.assertEqual(results["127.0.0.1"][1], None)
+
+    def test_getaddrinfo_many_empty(self):
+        self.getaddrinfo_many([])
+        self.assertEqual(self.batches, [([], True)])
+
+    def test_getaddrinfo_many_invalid(self):
+        self.assertRaises(TypeError, pyuv.dns.getaddrinfo_many, self.loop, [1], 80, lambda *args: None)
+        self.assertRaises(TypeError, pyuv.dns.getaddrinfo_many, self.loop, ["localhost"], 80, None)
+        self.assertRaises(ValueError, pyuv.dns.getaddrinfo_many, self.loop, ["localhost"], 80, lambda *args: None, concurrency=0)
+
+
+class DNSCacheTest(TestCase):
+
+    def test_cache_hit(self):
+        self.results = []
+        cache = pyuv.dns.DNSCache(self.loop)
+        def getaddrinfo_cb2(result, errorno):
+            self.assertEqual(errorno, None)
+            self.results.append(result)
+        def getaddrinfo_cb(result, errorno):
+            self.assertEqual(errorno, None)
+            self.results.append(result)
+            result.append(None)
+            cache.getaddrinfo('localhost', 80, socket.AF_INET, callback=getaddrinfo_cb2)
+            # callbacks are never called synchronously
+            self.assertEqual(len(self.results), 1)
+        cache.getaddrinfo('localhost', 80, socket.AF_INET, callback=getaddrinfo_cb)
+        self.loop.run()
+        self.assertEqual(len(self.results), 2)
+        self.assertEqual(self.results[0][:-1], self.results[1])
+        stats = cache.stats
+        self.assertEqual(stats['hits'], 1)
+        self.assertEqual(stats['misses'], 1)
+        self.assertEqual(stats['entries'], 1)
+        cache.clear()
+        self.assertEqual(cache.stats['entries'], 0)
+        cache.close()
+        self.loop.run()
+
+    def test_cache_coalesce(self):
+        self.results = []
+        cache = pyuv.dns.DNSCache(self.loop)
+        def getaddrinfo_cb(result, errorno):
+            self.assertEqual(errorno, None)
+            self.results.append(result)
+        for i in range(5):
+            cache.getaddrinfo('localhost', 80, socket.AF_INET, callback=getaddrinfo_cb)
+        self.assertEqual(cache.stats['pending'], 1)
+        self.loop.run()
+        self.assertEqual(len(self.results), 5)
+        stats = cache.stats
+        self.assertEqual(stats['misses'], 1)
+        self.assertEqual(stats['coalesced'], 4)
+        self.assertEqual(stats['pending'], 0)
+
+    def test_cache_negative(self):
+        self.errors = []
+        cache = pyuv.dns.DNSCache(self.loop, negative_ttl=10)
+        def getaddrinfo_cb2(result, errorno):
+            self.assertEqual(result, None)
+            self.errors.append(errorno)
+        def getaddrinfo_cb(result, errorno):
+            self.assertEqual(result, None)
+            self.errors.append(errorno)
+            cache.getaddrinfo('lala.lala.lala', 80, socket.AF_INET, callback=getaddrinfo_cb2)
+        cache.getaddrinfo('lala.lala.lala', 80, socket.AF_INET, callback=getaddrinfo_cb)
+        self.loop.run()
+        self.assertEqual(len(self.errors), 2)
+        self.assertNotEqual(self.errors[0], None)
+        self.assertEqual(self.errors[0], self.errors[1])
+        self.assertEqual(cache.stats['hits'], 1)
+
+    def test_cache_disabled(self):
+        self.results = []
+        cache = pyuv.dns.DNSCache(self.loop, ttl=0)
+        def getaddrinfo_cb(result, errorno):
+            self.assertEqual(errorno, None)
+            self.results.append(result)
+            if len(self.results) == 1:
+                cache.getaddrinfo('localhost', 80, socket.AF_INET, callback=getaddrinfo_cb)
+        cache.getaddrinfo('localhost', 80, socket.AF_INET, callback=getaddrinfo_cb)
+        self.loop.run()
+        self.assertEqual(len(self.results), 2)
+        self.assertEqual(cache.stats['misses'], 2)
+        self.assertEqual(cache.stats['entries'], 0)
+
+    def test_cache_max_entries(self):
+        cache = pyuv.dns.DNSCache(self.loop, max_entries=2)
+        def getaddrinfo_cb(result, errorno):
+            self.assertEqual(errorno, None)
+        for port in (80, 81, 82):
+            cache.getaddrinfo('localhost', port, socket.AF_INET, callback=getaddrinfo_cb)
+        self.loop.run()
+        self.assertEqual(cache.stats['entries'], 2)
+
+
+class StubDNSServer(object):
+    """Minimal DNS server answering queries from a static record table"""
+
+    def __init__(self, loop, records, truncate=False, rcode=0):
+        self.records = records
+        self.truncate = truncate
+        self.rcode = rcode
+        self.spoof = None
+        self.queries = 0
+        self.tcp_queries = 0
+        self.udp = pyuv.UDP(loop)
+        self.udp.bind(("127.0.0.1", 0))
+        self.address = self.udp.getsockname()
+        self.udp.start_recv(self.on_udp_recv)
+        self.tcp = pyuv.TCP(loop)
+        self.tcp.bind(self.address)
+        self.tcp.listen(self.on_connection)
+        self.clients = []
+
+    def close(self):
+        self.udp.close()
+        self.tcp.close()
+        for c in self.clients:
+            c.close()
+
+    def answer(self, query, truncate=False):
+        qid, = struct.unpack("!H", query[:2])
+        question = query[12:]
+        raw = bytearray(question)
+        labels = []
+        pos = 0
+        while raw[pos]:
+            labels.append(question[pos+1:pos+1+raw[pos]].decode())
+            pos += raw[pos] + 1
+        name = ".".join(labels)
+        qtype, = struct.unpack("!H", question[pos+1:pos+3])
+        answers = [] if truncate else [r for r in self.records.get((name, qtype), [])]
+        flags = 0x8180 | self.rcode | (0x0200 if truncate else 0)
+        msg = struct.pack("!HHHHHH", qid, flags, 1, len(answers), 0, 0) + question
+        for rdata in answers:
+            msg += struct.pack("!HHHIH", 0xc00c, qtype, 1, 300, len(rdata)) + rdata
+        return msg
+
+    def on_udp_recv(self, handle, ip_port, flags, data, error):
+        if data:
+            self.queries += 1
+            if self.spoof:
+                # an answer with the right id for a different question arrives first
+                handle.send(ip_port, self.answer(self.spoof(data)))
+            handle.send(ip_port, self.answer(data, self.truncate))
+
+    def on_connection(self, server, error):
+        client = pyuv.TCP(server.loop)
+        server.accept(client)
+        self.clients.append(client)
+        client.start_read(self.on_tcp_read)
+
+    def on_tcp_read(self, client, data, error):
+        if data:
+            self.tcp_queries += 1
+            response = self.answer(data[2:])
+            client.write(struct.pack("!H", len(response)) + response)
+
+
+def encode_name(name):
+    return b"".join(struct.pack("!B", len(l)) + l.encode() for l in name.split(".")) + b"\0"
+
+
+RECORDS = {
+    ("example.com", pyuv.dns.QUERY_TYPE_A): [socket.inet_aton("1.2.3.4"), socket.inet_aton("5.6.7.8")],
+    ("example.com", pyuv.dns.QUERY_TYPE_AAAA): [socket.inet_pton(socket.AF_INET6, "::1")],
+    ("_sip._udp.example.com", pyuv.dns.QUERY_TYPE_SRV): [struct.pack("!HHH", 10, 20, 5060) + encode_name("sip.example.com")],
+    ("example.com", pyuv.dns.QUERY_TYPE_TXT): [b"\x05hello\x06 world"],
+}
+
+
+class ResolverTest(TestCase):
+
+    def setUp(self):
+        super(ResolverTest, self).setUp()
+        self.server = StubDNSServer(self.loop, RECORDS)
+        self.resolver = pyuv.dns.Resolver(self.loop, nameservers=[self.server.address], timeout=0.2, tries=2)
+
+    def query(self, name, qtype):
+        self.results = []
+        def query_cb(result, errorno):
+            self.results.append((result, errorno))
+            self.server.close()
+        self.resolver.query(name, qtype, query_cb)
+        self.loop.run()
+        self.assertEqual(len(self.results), 1)
+        return self.results[0]
+
+    def test_nameservers(self):
+        self.assertEqual(self.resolver.nameservers, [self.server.address])
+        self.assertEqual(self.resolver.tries, 2)
+        resolver = pyuv.dns.Resolver(self.loop, nameservers=["127.0.0.1", "::1"])
+        self.assertEqual(resolver.nameservers, [("127.0.0.1", 53), ("::1", 53, 0, 0)])
+        resolver = pyuv.dns.Resolver(self.loop)
+        self.assertTrue(len(resolver.nameservers) > 0)
+        self.assertRaises(ValueError, pyuv.dns.Resolver, self.loop, nameservers=[])
+        self.server.close()
+        self.loop.run()
+
+    def test_query_a(self):
+        result, errorno = self.query("example.com", pyuv.dns.QUERY_TYPE_A)
+        self.assertEqual(errorno, None)
+        self.assertEqual(result, [("1.2.3.4", 300), ("5.6.7.8", 300)])
+
+    def test_query_aaaa(self):
+        result, errorno = self.query(u"example.com.", pyuv.dns.QUERY_TYPE_AAAA)
+        self.assertEqual(errorno, None)
+        self.assertEqual(result, [("::1", 300)])
+
+    def test_query_srv(self):
+        result, errorno = self.query("_sip._udp.example.com", pyuv.dns.QUERY_TYPE_SRV)
+        self.assertEqual(errorno, None)
+        self.assertEqual(result, [(10, 20, 5060, "sip.example.com", 300)])
+
+    def test_query_txt(self):
+        result, errorno = self.query("example.com", pyuv.dns.QUERY_TYPE_TXT)
+        self.assertEqual(errorno, None)
+        self.assertEqual(result, [(b"hello world", 300)])
+
+    def test_query_nodata(self):
+        result, errorno = self.query("example.org", pyuv.dns.QUERY_TYPE_A)
+        self.assertEqual(result, None)
+        self.assertEqual(errorno, pyuv.errno.UV_EAI_NODATA)
+
+    def test_query_nxdomain(self):
+        self.server.rcode = 3
+        result, errorno = self.query("example.org", pyuv.dns.QUERY_TYPE_A)
+        self.assertEqual(result, None)
+        self.assertEqual(errorno, pyuv.errno.UV_EAI_NONAME)
+
+    def test_query_tcp_fallback(self):
+        self.server.truncate = True
+        result, errorno = self.query("example.com", pyuv.dns.QUERY_TYPE_A)
+        self.assertEqual(errorno, None)
+        self.assertEqual(result, [("1.2.3.4", 300), ("5.6.7.8", 300)])
+        self.assertEqual(self.server.tcp_queries, 1)
+
+    def test_query_question_mismatch(self):
+        def spoof(query):
+            return query[:12] + encode_name("_sip._udp.example.com") + query[-4:]
+        self.server.spoof = spoof
+        result, errorno = self.query("example.com", pyuv.dns.QUERY_TYPE_A)
+        self.assertEqual(errorno, None)
+        self.assertEqual(result, [("1.2.3.4", 300), ("5.6.7.8", 300)])
+
+    def test_query_qtype_mismatch(self):
+        def spoof(query):
+            return query[:-4] + struct.pack("!HH", pyuv.dns.QUERY_TYPE_TXT, 1)
+        self.server.spoof = spoof
+        result, errorno = self.query("example.com", pyuv.dns.QUERY_TYPE_A)
+        self.assertEqual(errorno, None)
+        self.assertEqual(result, [("1.2.3.4", 300), ("5.6.7.8", 300)])
+
+    def test_query_question_case(self):
+        self.server.records[("EXAMPLE.com", pyuv.dns.QUERY_TYPE_A)] = [socket.inet_aton("1.2.3.4")]
+        def answer(query, truncate=False, answer=self.server.answer):
+            return answer(query[:12] + encode_name("EXAMPLE.com") + query[-4:], truncate)
+        self.server.answer = answer
+        result, errorno = self.query("example.com", pyuv.dns.QUERY_TYPE_A)
+        del self.server.records[("EXAMPLE.com", pyuv.dns.QUERY_TYPE_A)]
+        self.assertEqual(errorno, None)
+        self.assertEqual(result, [("1.2.3.4", 300)])
+
+    def test_query_timeout(self):
+        self.server.udp.stop_recv()
+        result, errorno = self.query("example.com", pyuv.dns.QUERY_TYPE_A)
+        self.assertEqual(result, None)
+        self.assertEqual(errorno, pyuv.errno.UV_ETIMEDOUT)
+
+    def test_query_cancel(self):
+        self.results = []
+        def query_cb(result, errorno):
+            self.results.append(errorno)
+        self.resolver.query("example.com", pyuv.dns.QUERY_TYPE_A, query_cb)
+        self.resolver.query("example.com", pyuv.dns.QUERY_TYPE_AAAA, query_cb)
+        self.resolver.cancel()
+        self.server.close()
+        self.loop.run()
+        self.assertEqual(self.results, [pyuv.errno.UV_ECANCELED]*2)
+
+    def test_query_invalid(self):
+        self.assertRaises(ValueError, self.resolver.query, "example.com", 255, lambda *args: None)
+        self.assertRaises(pyuv.error.UVError, self.resolver.query, b"a"*64 + b".com", pyuv.dns.QUERY_TYPE_A, lambda *args: None)
+        self.server.close()
+        self.loop.run()
+
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
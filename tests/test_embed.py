@@ -77,6 +77,53 @@ class EmbedTest(unittest.TestCase):
         self.assertEqual(self.embed_timer_called, 1)
 
 
+class ProcessReadyTest(unittest.TestCase):
+
+    def test_next_deadline(self):
+        loop = pyuv.Loop()
+        self.assertEqual(loop.next_deadline(), loop.now() * 1000000)
+        timer = pyuv.Timer(loop)
+        # the timer is due relative to the loop time it was started at, process_ready() may update it
+        start = loop.now()
+        timer.start(lambda h: None, 10, 0)
+        loop.process_ready()
+        self.assertEqual(loop.next_deadline(), (start + 10000) * 1000000)
+        timer.stop()
+        async_handle = pyuv.Async(loop, lambda h: None)
+        self.assertEqual(loop.next_deadline(), None)
+        async_handle.close()
+        timer.close()
+        loop.run()
+
+    def test_process_ready(self):
+        if poller is None:
+            self.skipTest("test disabled if no suitable poller method is found")
+            return
+        loop = pyuv.Loop()
+        calls = []
+        timer = pyuv.Timer(loop)
+        timer.start(lambda h: (calls.append("timer"), h.close()), 0.05, 0)
+        async_handle = pyuv.Async(loop, lambda h: (calls.append("async"), h.close()))
+        t = Thread(target=async_handle.send)
+        t.start()
+        t.join()
+        # drive the loop from the outside: wait for its fd or the next deadline, then process
+        poll = poller.fromfd(loop.fileno())
+        alive = True
+        iterations = 0
+        while alive:
+            deadline = loop.next_deadline()
+            timeout = -1 if deadline is None else max(0, deadline - pyuv.util.hrtime()) / 1e9
+            if poller_type == 'kqueue':
+                poll.control(None, 1, None if timeout < 0 else timeout)
+            else:
+                poll.poll(timeout)
+            alive = loop.process_ready()
+            iterations += 1
+        self.assertEqual(calls, ["async", "timer"])
+        self.assertTrue(iterations < 10)
+
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
 
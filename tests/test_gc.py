@@ -27,6 +27,63 @@ class GCTest(TestCase):
         gc.collect()
         self.assertEqual(w_timer(), None)
 
+    def test_untracked_handles(self):
+        tcp = pyuv.TCP(self.loop)
+        udp = pyuv.UDP(self.loop)
+        self.assertFalse(gc.is_tracked(tcp))
+        self.assertFalse(gc.is_tracked(udp))
+        tcp.foo = Foo()
+        self.assertTrue(gc.is_tracked(tcp))
+        udp.bind(("127.0.0.1", 0))
+        udp.start_recv(lambda *args: None)
+        self.assertTrue(gc.is_tracked(udp))
+        udp.stop_recv()
+        self.assertFalse(gc.is_tracked(udp))
+        class MyTCP(pyuv.TCP): pass
+        self.assertTrue(gc.is_tracked(MyTCP(self.loop)))
+        tcp.close()
+        udp.close()
+        self.loop.run()
+
+    def test_accept_policy_tracked(self):
+        self.tracked = []
+        def on_connection(server, error):
+            conn = pyuv.TCP(self.loop)
+            server.accept(conn)
+            conn.start_read(lambda *args: None)
+            conn.stop_read()
+            # the listener's policy counts the connection without referencing it
+            self.tracked.append(gc.is_tracked(conn))
+            conn.close()
+            client.close()
+            server.close()
+        server = pyuv.TCP(self.loop)
+        server.bind(("127.0.0.1", 0))
+        server.set_accept_policy(max_active=1)
+        self.assertTrue(gc.is_tracked(server))
+        server.listen(on_connection)
+        client = pyuv.TCP(self.loop)
+        client.connect(server.getsockname(), lambda *args: None)
+        self.loop.run()
+        self.assertEqual(self.tracked, [False])
+
+    def test_gc_listen_cycle(self):
+        tcp = pyuv.TCP(self.loop)
+        tcp.bind(("127.0.0.1", 0))
+        foo = Foo()
+        foo.tcp = tcp
+        tcp.listen(lambda handle, error, foo=foo: None)
+        self.assertTrue(gc.is_tracked(tcp))
+        self.assertRaises(pyuv.error.TCPError, tcp.start_read, lambda *args: None)
+        self.assertRaises(pyuv.error.TCPError, tcp.stop_read)
+
+        w_tcp = weakref.ref(tcp)
+        tcp = None
+        foo = None
+        gc.collect()
+        self.loop.run()
+        self.assertEqual(w_tcp(), None)
+
 
 if __name__ == '__main__':
     unittest.main(verbosity=2)
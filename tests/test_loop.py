@@ -1,4 +1,8 @@
 
+import os
+import sys
+import threading
+import time
 import unittest
 
 from common import TestCase
@@ -55,6 +59,203 @@ class LoopRunTest(TestCase):
         self.assertEqual(self.timer_called, 10)
         self.assertEqual(self.prepare_called, 10)
 
+    def test_run_spin(self):
+        self.timer_called = 0
+        self.async_called = 0
+        def timer_cb(handle):
+            self.timer_called += 1
+            if self.timer_called == 5:
+                # the loop is still alive, stop has to break out of the spin
+                self.loop.stop()
+        def async_cb(handle):
+            self.async_called += 1
+            handle.close()
+        timer = pyuv.Timer(self.loop)
+        timer.start(timer_cb, 0.01, 0.01)
+        async_handle = pyuv.Async(self.loop, async_cb)
+        t = threading.Thread(target=async_handle.send)
+        t.start()
+        self.loop.run(pyuv.UV_RUN_SPIN, spin_us=500)
+        t.join()
+        self.assertEqual(self.timer_called, 5)
+        self.assertEqual(self.async_called, 1)
+        timer.close()
+        self.loop.run(mode=pyuv.UV_RUN_SPIN, spin_us=0)
+        self.assertFalse(self.loop.alive)
+
+    def test_run_spin_invalid(self):
+        self.assertRaises(ValueError, self.loop.run, pyuv.UV_RUN_SPIN, -1)
+        self.assertRaises(ValueError, self.loop.run, 42)
+        self.assertRaises(ValueError, self.loop.run, pyuv.UV_RUN_SPIN, spin_us=-1)
+        self.assertRaises(TypeError, self.loop.run, pyuv.UV_RUN_SPIN, spin=100)
+
+
+class LoopDeferTest(TestCase):
+
+    def start_timers(self, calls, priorities, timeout=0.01):
+        timers = []
+        for name, priority in priorities:
+            timer = pyuv.Timer(self.loop)
+            timer.priority = priority
+            timer.start(lambda handle, name=name: (calls.append(name), handle.close()), timeout, 0)
+            timers.append(timer)
+        return timers
+
+    def test_priority(self):
+        timer = pyuv.Timer(self.loop)
+        self.assertEqual(timer.priority, 0)
+        timer.priority = -2
+        self.assertEqual(timer.priority, -2)
+        with self.assertRaises(ValueError):
+            timer.priority = 3
+        with self.assertRaises(TypeError):
+            del timer.priority
+        timer.close()
+        self.loop.run()
+
+    def test_defer_order(self):
+        calls = []
+        self.loop.defer_callbacks(0)
+        self.start_timers(calls, [("low", -1), ("normal", 0), ("high", 2), ("normal2", 0)])
+        self.loop.run()
+        self.assertEqual(calls, ["high", "normal", "normal2", "low"])
+        self.assertEqual(self.loop.deferred, 0)
+
+    def test_defer_disabled(self):
+        calls = []
+        self.loop.defer_callbacks(0)
+        self.loop.defer_callbacks(None)
+        self.start_timers(calls, [("low", -1), ("high", 2)])
+        self.loop.run()
+        self.assertEqual(calls, ["low", "high"])
+
+    def test_defer_budget(self):
+        calls = []
+        self.iterations = 0
+        def prepare_cb(handle):
+            self.iterations += 1
+        prepare = pyuv.Prepare(self.loop)
+        prepare.start(prepare_cb)
+        prepare.ref = False
+        def timer_cb(handle):
+            calls.append(self.iterations)
+            time.sleep(0.002)
+            handle.close()
+        self.loop.defer_callbacks(0.001)
+        for i in range(4):
+            timer = pyuv.Timer(self.loop)
+            timer.start(timer_cb, 0.01, 0)
+        self.loop.run()
+        # every iteration runs a single callback, the rest carries over without blocking
+        self.assertEqual(len(calls), 4)
+        self.assertEqual(calls, list(range(calls[0], calls[0] + 4)))
+        prepare.close()
+        self.loop.run()
+
+    def test_defer_closed(self):
+        calls = []
+        self.loop.defer_callbacks(0)
+        low, = self.start_timers(calls, [("low", -2)])
+        high = pyuv.Timer(self.loop)
+        high.priority = 2
+        high.start(lambda handle: (calls.append("high"), handle.close(), low.close()), 0.01, 0)
+        self.loop.run()
+        self.assertEqual(calls, ["high"])
+
+    def test_defer_stream(self):
+        received = []
+        def on_read(handle, data, error):
+            if data is None:
+                handle.close()
+            else:
+                received.append(data)
+        def on_connection(server, error):
+            client = pyuv.TCP(self.loop)
+            server.accept(client)
+            client.priority = 1
+            client.start_read(on_read)
+            server.close()
+        def on_connect(handle, error):
+            handle.write(b"PING")
+            handle.close()
+        self.loop.defer_callbacks(0.01)
+        server = pyuv.TCP(self.loop)
+        server.bind(("127.0.0.1", 0))
+        server.listen(on_connection)
+        client = pyuv.TCP(self.loop)
+        client.connect(server.getsockname(), on_connect)
+        self.loop.run()
+        self.assertEqual(b"".join(received), b"PING")
+
+    def test_defer_stop_recv(self):
+        received = []
+        def on_recv(handle, addr, flags, data, error):
+            received.append(data)
+            # the second datagram is already queued, it's dropped
+            handle.stop_recv()
+            self.assertEqual(self.loop.deferred, 0)
+            timer.start(lambda timer: (handle.close(), timer.close()), 0.01, 0)
+        self.loop.defer_callbacks(0)
+        server = pyuv.UDP(self.loop)
+        server.bind(("127.0.0.1", 0))
+        server.start_recv(on_recv)
+        client = pyuv.UDP(self.loop)
+        client.try_send(server.getsockname(), b"PING")
+        client.try_send(server.getsockname(), b"PONG")
+        client.close()
+        timer = pyuv.Timer(self.loop)
+        self.loop.run()
+        self.assertEqual(received, [b"PING"])
+
+
+class LoopMemoryBudgetTest(TestCase):
+
+    def test_memory_budget_invalid(self):
+        self.assertRaises(ValueError, self.loop.set_memory_budget, 0)
+        self.assertRaises(TypeError, self.loop.set_memory_budget, 1024, 42)
+        self.loop.set_memory_budget(None)
+        self.assertEqual(self.loop.memory_used, 0)
+
+    def test_memory_budget_pressure(self):
+        payload = b"x" * (16 * 1024 * 1024)
+        events = []
+        received = []
+        def on_server_read(handle, data, error):
+            events.append(data)
+            if data == b"PING":
+                handle.shutdown(lambda handle, error: handle.close())
+        def on_connection(server, error):
+            conn = pyuv.TCP(self.loop)
+            server.accept(conn)
+            conn.start_read(on_server_read)
+            conn.write(payload)
+            server.close()
+        def on_client_read(handle, data, error):
+            if data is None:
+                handle.close()
+            else:
+                received.append(data)
+        def on_pressure(loop, pressure, used):
+            events.append(pressure)
+            if pressure:
+                self.assertTrue(used > 1024)
+                # the server is paused, so it won't see this until the write queue drains
+                client.start_read(on_client_read)
+                client.write(b"PING")
+        self.loop.set_memory_budget(1024, on_pressure)
+        server = pyuv.TCP(self.loop)
+        server.bind(("127.0.0.1", 0))
+        server.listen(on_connection)
+        client = pyuv.TCP(self.loop)
+        client.connect(server.getsockname(), lambda handle, error: None)
+        self.loop.run()
+        self.assertEqual(events, [True, False, b"PING"])
+        self.assertEqual(len(b"".join(received)), len(payload))
+        # the write queue was given back as its request completed
+        self.assertEqual(self.loop.memory_used, 0)
+        self.loop.set_memory_budget(None)
+
+
 
 class LoopAliveTest(TestCase):
 
@@ -67,5 +268,59 @@ class LoopAliveTest(TestCase):
         self.loop.run(pyuv.UV_RUN_ONCE)
 
 
+@unittest.skipUnless(sys.platform.startswith('linux'), "Linux only test")
+class LoopSchedTest(TestCase):
+
+    def test_affinity(self):
+        cpus = sorted(os.sched_getaffinity(0))
+        self.result = []
+        def timer_cb(handle):
+            self.result.append(os.sched_getaffinity(0))
+            # applied right away to the running thread
+            self.loop.set_affinity(None)
+            self.result.append(os.sched_getaffinity(0))
+            handle.close()
+        self.loop.set_affinity(cpus[-1:])
+        timer = pyuv.Timer(self.loop)
+        timer.start(timer_cb, 0, 0)
+        # run it in another thread, the affinity sticks to the thread running the loop
+        t = threading.Thread(target=self.loop.run)
+        t.start()
+        t.join()
+        self.assertEqual(self.result, [set(cpus[-1:]), set(cpus)])
+        self.assertEqual(os.sched_getaffinity(0), set(cpus))
+        self.assertRaises(ValueError, self.loop.set_affinity, [-1])
+        self.assertRaises(TypeError, self.loop.set_affinity, 1)
+
+    def test_scheduling(self):
+        self.result = None
+        def timer_cb(handle):
+            self.result = (os.sched_getscheduler(0), os.getpriority(os.PRIO_PROCESS, 0))
+            handle.close()
+        nice = os.getpriority(os.PRIO_PROCESS, 0)
+        self.loop.set_scheduling(pyuv.util.SCHED_OTHER, min(nice + 1, 19))
+        timer = pyuv.Timer(self.loop)
+        timer.start(timer_cb, 0, 0)
+        t = threading.Thread(target=self.loop.run)
+        t.start()
+        t.join()
+        self.assertEqual(self.result, (pyuv.util.SCHED_OTHER, min(nice + 1, 19)))
+        self.assertEqual(os.getpriority(os.PRIO_PROCESS, 0), nice)
+        self.assertRaises(ValueError, self.loop.set_scheduling, -42)
+
+    def test_scheduling_loop_thread(self):
+        self.result = None
+        def check():
+            self.result = (os.sched_getscheduler(0), os.getpriority(os.PRIO_PROCESS, 0))
+            lt.stop()
+        nice = os.getpriority(os.PRIO_PROCESS, 0)
+        self.loop.set_scheduling(pyuv.util.SCHED_OTHER, min(nice + 1, 19))
+        lt = self.loop.run_in_thread()
+        lt.call_soon_threadsafe(check)
+        lt.join()
+        self.assertEqual(self.result, (pyuv.util.SCHED_OTHER, min(nice + 1, 19)))
+        self.assertEqual(os.getpriority(os.PRIO_PROCESS, 0), nice)
+
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
@@ -0,0 +1,128 @@
+
+import gc
+import threading
+import time
+import unittest
+import weakref
+
+from common import TestCase
+import pyuv
+
+
+class LoopEventTest(TestCase):
+
+    def test_event(self):
+        self.called = 0
+        def wait_cb(event):
+            self.assertTrue(event.is_set())
+            self.called += 1
+        def thread_cb():
+            time.sleep(0.05)
+            event.set()
+        event = pyuv.LoopEvent(self.loop)
+        self.assertEqual(event.loop, self.loop)
+        self.assertFalse(event.is_set())
+        event.wait(wait_cb)
+        event.wait(wait_cb)
+        self.assertEqual(event.waiters, 2)
+        t = threading.Thread(target=thread_cb)
+        t.start()
+        self.loop.run()
+        t.join()
+        self.assertEqual(self.called, 2)
+        self.assertEqual(event.waiters, 0)
+        event.clear()
+        self.assertFalse(event.is_set())
+
+    def test_already_set(self):
+        self.called = False
+        def wait_cb(event):
+            self.called = True
+        event = pyuv.LoopEvent(self.loop)
+        event.set()
+        event.wait(wait_cb)
+        # callbacks are never called synchronously
+        self.assertFalse(self.called)
+        self.loop.run()
+        self.assertTrue(self.called)
+
+    def test_no_waiters(self):
+        event = pyuv.LoopEvent(self.loop)
+        event.set()
+        # the shared async handle doesn't keep the loop alive
+        self.assertFalse(self.loop.run(pyuv.UV_RUN_NOWAIT))
+        self.loop.run()
+        self.assertRaises(TypeError, event.wait, None)
+
+
+class LoopSemaphoreTest(TestCase):
+
+    def test_semaphore(self):
+        self.order = []
+        def acquire_cb(sem):
+            self.order.append(len(self.order))
+        def thread_cb():
+            for i in range(3):
+                time.sleep(0.01)
+                sem.release()
+        sem = pyuv.LoopSemaphore(self.loop, 1)
+        self.assertEqual(sem.value, 1)
+        self.assertTrue(sem.try_acquire())
+        self.assertFalse(sem.try_acquire())
+        for i in range(3):
+            sem.acquire(acquire_cb)
+        t = threading.Thread(target=thread_cb)
+        t.start()
+        self.loop.run()
+        t.join()
+        self.assertEqual(self.order, [0, 1, 2])
+        self.assertEqual(sem.value, 0)
+        self.assertEqual(sem.waiters, 0)
+
+    def test_fairness(self):
+        self.acquired = False
+        def acquire_cb(sem):
+            self.acquired = True
+        sem = pyuv.LoopSemaphore(self.loop, 0)
+        sem.acquire(acquire_cb)
+        sem.release()
+        # the waiting callback gets the semaphore first
+        self.assertFalse(sem.try_acquire())
+        self.loop.run()
+        self.assertTrue(self.acquired)
+        self.assertRaises(ValueError, pyuv.LoopSemaphore, self.loop, -1)
+
+
+class LoopLockTest(TestCase):
+
+    def test_lock(self):
+        self.count = 0
+        def acquire_cb(lock):
+            self.assertTrue(lock.locked())
+            self.count += 1
+            # release it from a different thread
+            threading.Thread(target=lock.release).start()
+        lock = pyuv.LoopLock(self.loop)
+        self.assertFalse(lock.locked())
+        for i in range(10):
+            lock.acquire(acquire_cb)
+        self.loop.run()
+        self.assertEqual(self.count, 10)
+        self.assertFalse(lock.locked())
+        self.assertRaises(RuntimeError, lock.release)
+
+    def test_gc(self):
+        lock = pyuv.LoopLock(self.loop)
+        lock.try_acquire()
+        # the waiting callback references the lock, creating a cycle
+        lock.acquire(lambda l: lock.release())
+        ref = weakref.ref(lock)
+        del lock
+        gc.collect()
+        self.assertEqual(ref(), None)
+        # the loop isn't kept alive by the dropped waiter
+        self.loop.run()
+
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
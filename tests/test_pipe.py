@@ -237,6 +237,47 @@ class PipeShutdownTest(PipeTestCase):
         self.assertEqual(self.close_cb_called, 3)
 
 
+@platform_skip(["win32"])
+class PipeAcceptPolicyTest(PipeTestCase):
+
+    def on_connection(self, server, error):
+        conn = pyuv.Pipe(self.loop)
+        server.accept(conn)
+        self.client_connections.append(conn)
+        self.max_active = max(self.max_active, len(self.client_connections))
+        conn.start_read(self.on_conn_read)
+
+    def on_conn_read(self, conn, data, error):
+        conn.close(self.on_conn_close)
+
+    def on_conn_close(self, conn):
+        self.client_connections.remove(conn)
+        self.accepted += 1
+        if self.accepted == 2:
+            self.server.close()
+
+    def on_client_connection(self, client, error):
+        self.assertEqual(error, None)
+        client.write(b"PING")
+        client.close()
+
+    def test_pipe_accept_policy(self):
+        self.accepted = 0
+        self.max_active = 0
+        rejects = []
+        self.server = pyuv.Pipe(self.loop)
+        self.server.bind(TEST_PIPE)
+        self.server.set_accept_policy(max_active=1, on_reject=lambda server, reason: rejects.append(reason))
+        self.server.listen(self.on_connection)
+        for _ in range(2):
+            client = pyuv.Pipe(self.loop)
+            client.connect(TEST_PIPE, self.on_client_connection)
+        self.loop.run()
+        self.assertEqual(self.accepted, 2)
+        self.assertEqual(self.max_active, 1)
+        self.assertEqual(rejects, ["max_active"])
+
+
 class PipeTestFileno(TestCase):
 
     def check_fileno(self, handle):
@@ -89,5 +89,83 @@ class PollTest(TestCase):
         self.sock.close()
 
 
+class PollGroupTest(TestCase):
+
+    def setUp(self):
+        super(PollGroupTest, self).setUp()
+        self.pairs = [socket.socketpair() for _ in range(3)]
+        for a, b in self.pairs:
+            a.setblocking(False)
+        self.group = pyuv.PollGroup(self.loop)
+        self.calls = []
+
+    def tearDown(self):
+        for a, b in self.pairs:
+            a.close()
+            b.close()
+        super(PollGroupTest, self).tearDown()
+
+    def test_poll_group(self):
+        def poll_cb(group, ready):
+            self.calls.append(sorted(ready))
+            for token, events in ready:
+                self.pairs[token][0].recv(1024)
+            if len(self.calls) == 2:
+                group.close()
+            else:
+                self.pairs[2][1].send(b"PING")
+        for i, (a, b) in enumerate(self.pairs):
+            self.group.add(a.fileno(), pyuv.UV_READABLE, i)
+        self.assertEqual(len(self.group), 3)
+        self.assertTrue(self.pairs[0][0].fileno() in self.group)
+        self.group.start(poll_cb)
+        self.pairs[0][1].send(b"PING")
+        self.pairs[1][1].send(b"PING")
+        self.loop.run()
+        self.assertEqual(self.calls, [[(0, pyuv.UV_READABLE), (1, pyuv.UV_READABLE)], [(2, pyuv.UV_READABLE)]])
+
+    def test_poll_group_modify(self):
+        a, b = self.pairs[0]
+        def poll_cb(group, ready):
+            self.calls.append(ready)
+            if len(self.calls) == 1:
+                group.modify(a.fileno(), pyuv.UV_READABLE, "readable")
+                b.send(b"PING")
+            else:
+                group.remove(a.fileno())
+                self.assertEqual(len(group), 0)
+                group.stop()
+        self.group.add(a.fileno(), pyuv.UV_WRITABLE, "writable")
+        self.group.start(poll_cb)
+        self.loop.run()
+        self.assertEqual(self.calls, [[("writable", pyuv.UV_WRITABLE)], [("readable", pyuv.UV_READABLE)]])
+        self.group.close()
+        self.loop.run()
+
+    def test_poll_group_stopped(self):
+        a, b = self.pairs[0]
+        def poll_cb(group, ready):
+            self.calls.append(ready)
+        self.group.add(a.fileno(), pyuv.UV_WRITABLE)
+        self.loop.run()
+        self.assertEqual(self.calls, [])
+        self.group.start(poll_cb)
+        self.loop.run(pyuv.UV_RUN_ONCE)
+        self.assertEqual(self.calls, [[(None, pyuv.UV_WRITABLE)]])
+        self.group.close()
+        self.loop.run()
+
+    def test_poll_group_errors(self):
+        a, b = self.pairs[0]
+        self.group.add(a.fileno(), pyuv.UV_READABLE)
+        self.assertRaises(pyuv.error.PollError, self.group.add, a.fileno(), pyuv.UV_READABLE)
+        self.assertRaises(pyuv.error.PollError, self.group.remove, b.fileno())
+        self.assertRaises(pyuv.error.PollError, self.group.modify, b.fileno(), pyuv.UV_READABLE)
+        self.assertRaises(ValueError, self.group.add, b.fileno(), 1024)
+        self.group.close()
+        self.assertRaises(pyuv.error.HandleClosedError, self.group.add, b.fileno(), pyuv.UV_READABLE)
+        self.loop.run()
+
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
@@ -4,6 +4,7 @@ try:
     import pwd
 except ImportError:
     pwd = None
+import signal
 import sys
 import unittest
 
@@ -11,6 +12,31 @@ from common import linesep, platform_skip, TestCase
 import pyuv
 
 
+_pidfd_supported = None
+
+def rusage_supported():
+    # collected through a pidfd, pidfd_open may be missing or filtered even on recent kernels
+    global _pidfd_supported
+    if _pidfd_supported is None:
+        _pidfd_supported = False
+        if sys.platform.startswith('linux'):
+            try:
+                if hasattr(os, 'pidfd_open'):
+                    fd = os.pidfd_open(os.getpid())
+                else:
+                    import ctypes
+                    libc = ctypes.CDLL(None, use_errno=True)
+                    fd = libc.syscall(434, os.getpid(), 0)  # __NR_pidfd_open
+                    if fd < 0:
+                        raise OSError(ctypes.get_errno(), "pidfd_open")
+            except (OSError, AttributeError):
+                pass
+            else:
+                os.close(fd)
+                _pidfd_supported = True
+    return _pidfd_supported
+
+
 class ProcessTest(TestCase):
 
     def test_process_basic(self):
@@ -312,6 +338,148 @@ class ProcessTest(TestCase):
         proc.kill(15)
         self.assertNotEqual(pid, None)
 
+    def test_process_rusage(self):
+        self.rusage = []
+        def proc_exit_cb(proc, exit_status, term_signal):
+            self.rusage.append(proc.rusage)
+            proc.close()
+        proc = pyuv.Process.spawn(self.loop,
+                                  args=[sys.executable, "proc_basic.py"],
+                                  exit_callback=proc_exit_cb,
+                                  rusage=True)
+        self.assertEqual(proc.rusage, None)
+        self.loop.run()
+        self.assertEqual(len(self.rusage), 1)
+        rusage = self.rusage[0]
+        if not rusage_supported():
+            self.skipTest("pidfd_open is not available")
+        self.assertNotEqual(rusage, None)
+        self.assertEqual(len(rusage), 16)
+        self.assertTrue(rusage.ru_maxrss > 0)
+
+    def test_process_no_rusage(self):
+        self.rusage = []
+        def proc_exit_cb(proc, exit_status, term_signal):
+            self.rusage.append(proc.rusage)
+            proc.close()
+        pyuv.Process.spawn(self.loop, args=[sys.executable, "proc_basic.py"], exit_callback=proc_exit_cb)
+        self.loop.run()
+        self.assertEqual(self.rusage, [None])
+
+
+class ProcessRunTest(TestCase):
+
+    def test_run_capture(self):
+        self.results = []
+        def run_cb(proc, exit_status, term_signal, stdout, stderr, rusage):
+            self.results.append((exit_status, term_signal, stdout, stderr))
+            proc.close()
+        proc = pyuv.Process.run(self.loop, [sys.executable, "proc_stderr.py"], run_cb, input=b"test"*100000)
+        self.assertTrue(isinstance(proc, pyuv.Process))
+        self.loop.run()
+        self.assertEqual(len(self.results), 1)
+        exit_status, term_signal, stdout, stderr = self.results[0]
+        self.assertEqual(exit_status, 3)
+        self.assertEqual(term_signal, 0)
+        self.assertEqual(stdout, b"TEST"*100000)
+        self.assertEqual(stderr.strip(), b"ERROR")
+
+    def test_run_rusage(self):
+        self.results = []
+        def run_cb(proc, exit_status, term_signal, stdout, stderr, rusage):
+            self.results.append(rusage)
+            self.assertTrue(rusage is proc.rusage)
+            proc.close()
+        pyuv.Process.run(self.loop, [sys.executable, "proc_basic.py"], run_cb, rusage=True)
+        self.loop.run()
+        rusage = self.results[0]
+        if not rusage_supported():
+            self.skipTest("pidfd_open is not available")
+        self.assertNotEqual(rusage, None)
+        self.assertTrue(rusage.ru_maxrss > 0)
+        self.assertTrue(rusage.ru_utime + rusage.ru_stime > 0)
+
+    def test_run_no_input(self):
+        self.results = []
+        def run_cb(proc, exit_status, term_signal, stdout, stderr, rusage):
+            self.results.append((exit_status, stdout, stderr))
+            proc.close()
+        for i in range(10):
+            pyuv.Process.run(self.loop, [sys.executable, "proc_stdout.py"], run_cb)
+        self.loop.run()
+        self.assertEqual(self.results, [(0, b"TEST"+linesep, b"")]*10)
+
+    def test_run_no_capture(self):
+        self.results = []
+        def run_cb(proc, exit_status, term_signal, stdout, stderr, rusage):
+            self.results.append((exit_status, stdout, stderr))
+            proc.close()
+        pyuv.Process.run(self.loop, [sys.executable, "proc_basic.py"], run_cb, capture=False)
+        self.loop.run()
+        self.assertEqual(self.results, [(0, None, None)])
+
+    def test_run_timeout(self):
+        self.results = []
+        def run_cb(proc, exit_status, term_signal, stdout, stderr, rusage):
+            self.results.append(term_signal)
+            proc.close()
+        pyuv.Process.run(self.loop, [sys.executable, "proc_infinite.py"], run_cb, timeout=0.2)
+        self.loop.run()
+        self.assertEqual(len(self.results), 1)
+        if sys.platform != 'win32':
+            self.assertEqual(self.results[0], signal.SIGKILL)
+
+    def test_run_fail(self):
+        self.assertRaises(pyuv.error.ProcessError, pyuv.Process.run, self.loop, ["this_should_fail"], input=b"test")
+        self.loop.run()
+
+
+class SpawnTemplateTest(TestCase):
+
+    def test_template_spawn(self):
+        self.exit_cb_called = 0
+        self.close_cb_called = 0
+        self.received_output = []
+        def handle_close_cb(handle):
+            self.close_cb_called += 1
+        def proc_exit_cb(proc, exit_status, term_signal):
+            self.assertEqual(exit_status, 0)
+            self.exit_cb_called += 1
+            proc.close(handle_close_cb)
+        def stdout_read_cb(handle, data, error):
+            if data:
+                self.received_output.append(data.strip())
+            else:
+                handle.close(handle_close_cb)
+        template = pyuv.SpawnTemplate(args=[sys.executable, "proc_env_stdout.py"], env={"TEST": "TEST"})
+        self.assertEqual(template.args, [sys.executable, "proc_env_stdout.py"])
+        for i in range(3):
+            stdout_pipe = pyuv.Pipe(self.loop)
+            stdio = [pyuv.StdIO(flags=pyuv.UV_IGNORE),
+                     pyuv.StdIO(stream=stdout_pipe, flags=pyuv.UV_CREATE_PIPE|pyuv.UV_WRITABLE_PIPE)]
+            proc = template.spawn(self.loop, proc_exit_cb, stdio=stdio)
+            self.assertTrue(isinstance(proc, pyuv.Process))
+            self.assertNotEqual(proc.pid, None)
+            stdout_pipe.start_read(stdout_read_cb)
+        self.loop.run()
+        self.assertEqual(self.exit_cb_called, 3)
+        self.assertEqual(self.close_cb_called, 6)
+        self.assertEqual(self.received_output, [b"TEST"]*3)
+
+    def test_template_spawn_fail(self):
+        template = pyuv.SpawnTemplate(args=["this_should_fail"])
+        self.assertRaises(pyuv.error.ProcessError, template.spawn, self.loop)
+
+    def test_template_invalid_args(self):
+        self.assertRaises(ValueError, pyuv.SpawnTemplate, args=[])
+        self.assertRaises(TypeError, pyuv.SpawnTemplate, args=1)
+        template = pyuv.SpawnTemplate(args=[sys.executable, "proc_basic.py"])
+        self.assertRaises(TypeError, template.spawn, self.loop, 42)
+        stdio = [pyuv.StdIO(stream=pyuv.Pipe(self.loop), flags=pyuv.UV_CREATE_PIPE|pyuv.UV_WRITABLE_PIPE)]
+        self.assertRaises(ValueError, pyuv.SpawnTemplate, args=[sys.executable, "proc_basic.py"], stdio=stdio)
+        stdio = [pyuv.StdIO(fd=sys.stdout.fileno(), flags=pyuv.UV_INHERIT_FD)]
+        pyuv.SpawnTemplate(args=[sys.executable, "proc_basic.py"], stdio=stdio)
+
 
 if __name__ == '__main__':
     unittest.main(verbosity=2)
@@ -0,0 +1,117 @@
+
+import socket
+import threading
+import time
+import unittest
+
+from common import TestCase
+import pyuv
+import pyuv.selectors
+from pyuv.selectors import EVENT_READ, EVENT_WRITE
+
+
+class UVSelectorTest(TestCase):
+
+    def setUp(self):
+        super(UVSelectorTest, self).setUp()
+        self.selector = pyuv.selectors.UVSelector(self.loop)
+        self.a, self.b = socket.socketpair()
+        self.a.setblocking(False)
+        self.b.setblocking(False)
+
+    def tearDown(self):
+        self.selector.close()
+        self.a.close()
+        self.b.close()
+        super(UVSelectorTest, self).tearDown()
+
+    def test_register(self):
+        key = self.selector.register(self.a, EVENT_READ, "data")
+        self.assertEqual(key.fileobj, self.a)
+        self.assertEqual(key.fd, self.a.fileno())
+        self.assertEqual(key.events, EVENT_READ)
+        self.assertEqual(key.data, "data")
+        self.assertEqual(self.selector.get_key(self.a), key)
+        self.assertEqual(len(self.selector.get_map()), 1)
+        self.assertEqual(self.selector.get_map()[self.a.fileno()], key)
+        self.assertRaises(KeyError, self.selector.register, self.a, EVENT_READ)
+        self.assertRaises(ValueError, self.selector.register, self.b, 0)
+        self.assertRaises(ValueError, self.selector.register, -1, EVENT_READ)
+        self.assertRaises(KeyError, self.selector.get_key, self.b)
+
+    def test_unregister(self):
+        key = self.selector.register(self.a, EVENT_READ)
+        self.assertEqual(self.selector.unregister(self.a), key)
+        self.assertRaises(KeyError, self.selector.unregister, self.a)
+        self.assertEqual(len(self.selector.get_map()), 0)
+        self.b.send(b"PING")
+        self.assertEqual(self.selector.select(0), [])
+
+    def test_select(self):
+        key_a = self.selector.register(self.a, EVENT_READ)
+        key_b = self.selector.register(self.b, EVENT_READ | EVENT_WRITE)
+        ready = self.selector.select()
+        self.assertEqual(ready, [(key_b, EVENT_WRITE)])
+        self.b.send(b"PING")
+        ready = dict(self.selector.select(1.0))
+        self.assertEqual(ready, {key_a: EVENT_READ, key_b: EVENT_WRITE})
+        self.assertEqual(self.a.recv(1024), b"PING")
+
+    def test_select_timeout(self):
+        self.selector.register(self.a, EVENT_READ)
+        t0 = time.time()
+        self.assertEqual(self.selector.select(0.1), [])
+        self.assertTrue(time.time() - t0 >= 0.09)
+        self.assertEqual(self.selector.select(0), [])
+
+    def test_select_short_timeout(self):
+        # the timer may expire before the loop polls for I/O, select must return anyway
+        self.selector.register(self.a, EVENT_READ)
+        for i in range(200):
+            self.assertEqual(self.selector.select(0.0005), [])
+
+    def test_select_nothing_registered(self):
+        # nothing keeps the loop alive, select() blocks anyway until the unreferenced handle wakes it up
+        async_handle = pyuv.Async(self.loop, lambda handle: None)
+        async_handle.ref = False
+        t = threading.Timer(0.05, async_handle.send)
+        t.start()
+        t0 = time.time()
+        self.assertEqual(self.selector.select(), [])
+        self.assertTrue(time.time() - t0 >= 0.04)
+        t.join()
+        async_handle.close()
+
+    def test_modify(self):
+        key = self.selector.register(self.a, EVENT_READ, "read")
+        key2 = self.selector.modify(self.a, EVENT_WRITE, "write")
+        self.assertEqual(key2.events, EVENT_WRITE)
+        self.assertEqual(key2.data, "write")
+        self.assertEqual(self.selector.select(1.0), [(key2, EVENT_WRITE)])
+        key3 = self.selector.modify(self.a, EVENT_WRITE, "other")
+        self.assertEqual(key3.data, "other")
+        self.assertEqual(self.selector.get_key(self.a), key3)
+        self.assertRaises(KeyError, self.selector.modify, self.b, EVENT_READ)
+
+    def test_loop_handles(self):
+        # other handles on the loop keep working while waiting
+        self.selector.register(self.a, EVENT_READ)
+        def timer_cb(timer):
+            self.b.send(b"PING")
+            timer.close()
+        timer = pyuv.Timer(self.loop)
+        timer.start(timer_cb, 0.01, 0)
+        ready = []
+        while not ready:
+            ready = self.selector.select(1.0)
+        self.assertEqual(ready[0][1], EVENT_READ)
+
+    def test_own_loop(self):
+        with pyuv.selectors.UVSelector() as selector:
+            key = selector.register(self.a, EVENT_WRITE)
+            self.assertEqual(selector.select(), [(key, EVENT_WRITE)])
+        self.assertRaises(RuntimeError, selector.get_key, self.a)
+
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
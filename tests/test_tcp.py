@@ -1,5 +1,6 @@
 # coding=utf8
 
+import gc
 import os
 import socket
 import sys
@@ -437,6 +438,141 @@ class TCPFlagsTest(TestCase):
         tcp.close()
         self.loop.run()
 
+    @unittest.skipUnless(sys.platform.startswith('linux'), "Linux only test")
+    def test_tcp_busy_poll(self):
+        tcp = pyuv.TCP(self.loop)
+        self.assertRaises(pyuv.error.TCPError, tcp.set_busy_poll, 0)
+        tcp.bind(("127.0.0.1", 0))
+        tcp.set_busy_poll(0)
+        self.assertRaises(ValueError, tcp.set_busy_poll, -1)
+        tcp.close()
+        self.loop.run()
+
+
+class TCPAcceptPolicyTest(TestCase):
+
+    def setUp(self):
+        super(TCPAcceptPolicyTest, self).setUp()
+        self.server = pyuv.TCP(self.loop)
+        self.server.bind(("127.0.0.1", 0))
+        self.rejects = []
+        self.accepted = 0
+        self.active = 0
+        self.max_seen = 0
+
+    def on_reject(self, server, reason):
+        self.rejects.append(reason)
+
+    def on_connection(self, server, error):
+        self.assertEqual(error, None)
+        conn = pyuv.TCP(self.loop)
+        server.accept(conn)
+        self.accepted += 1
+        self.active += 1
+        self.max_seen = max(self.max_seen, self.active)
+        conn.start_read(self.on_conn_read)
+
+    def on_conn_read(self, conn, data, error):
+        conn.close(self.on_conn_close)
+
+    def on_conn_close(self, conn):
+        self.active -= 1
+        if self.accepted == 3 and self.active == 0:
+            self.server.close()
+
+    def on_client_read(self, client, data, error):
+        if data is None:
+            client.close()
+
+    def connect_clients(self, count):
+        def on_connect(client, error):
+            self.assertEqual(error, None)
+            client.start_read(self.on_client_read)
+            client.write(b"PING")
+        for _ in range(count):
+            client = pyuv.TCP(self.loop)
+            client.connect(self.server.getsockname(), on_connect)
+
+    def test_accept_policy_invalid(self):
+        self.assertRaises(ValueError, self.server.set_accept_policy, -1)
+        self.assertRaises(ValueError, self.server.set_accept_policy, 0, -1.0)
+        self.assertRaises(TypeError, self.server.set_accept_policy, 1, 0, 42)
+        self.server.set_accept_policy()
+        self.server.set_accept_policy(max_active=1)
+        # the policy timer is not a pyuv handle
+        self.assertEqual(self.loop.handles, [self.server])
+        self.server.close()
+        self.loop.run()
+
+    def test_accept_policy_close(self):
+        loop = pyuv.Loop()
+        server = pyuv.TCP(loop)
+        server.bind(("127.0.0.1", 0))
+        server.set_accept_policy(max_active=1, on_reject=self.on_reject)
+        server.listen(self.on_connection)
+        self.assertEqual(loop.handles, [server])
+        server.close()
+        loop.run()
+        # the policy went away with the listener, the loop can go first
+        del loop
+        gc.collect()
+        del server
+        gc.collect()
+        self.server.close()
+        self.loop.run()
+
+    def test_accept_policy_max_active(self):
+        self.server.set_accept_policy(max_active=1, on_reject=self.on_reject)
+        self.server.listen(self.on_connection)
+        self.connect_clients(3)
+        self.loop.run()
+        self.assertEqual(self.accepted, 3)
+        self.assertEqual(self.max_seen, 1)
+        self.assertTrue(len(self.rejects) >= 1)
+        self.assertEqual(set(self.rejects), set(["max_active"]))
+
+    def test_accept_policy_max_rate(self):
+        self.server.set_accept_policy(max_rate=2, on_reject=self.on_reject)
+        self.server.listen(self.on_connection)
+        self.connect_clients(3)
+        t0 = pyuv.util.hrtime()
+        self.loop.run()
+        # the bucket holds 2 connections, the third one waits for a token
+        self.assertTrue(pyuv.util.hrtime() - t0 >= 400 * 1000 * 1000)
+        self.assertEqual(self.accepted, 3)
+        self.assertEqual(self.rejects, ["max_rate"])
+
+    @platform_skip(["win32"])
+    def test_accept_policy_reset(self):
+        errors = []
+        conns = []
+        def on_connection(server, error):
+            conn = pyuv.TCP(self.loop)
+            server.accept(conn)
+            conns.append(conn)
+            # the first connection is kept, the second one gets reset
+            second = pyuv.TCP(self.loop)
+            second.connect(server.getsockname(), on_second_connect)
+        def on_second_connect(client, error):
+            # the reset may arrive before the connection is reported as established
+            if error is not None:
+                on_second_read(client, None, error)
+            else:
+                client.start_read(on_second_read)
+        def on_second_read(client, data, error):
+            errors.append(error)
+            client.close()
+            conns[0].close()
+            self.server.close()
+            first.close()
+        self.server.set_accept_policy(max_active=1, on_reject=self.on_reject, reset=True)
+        self.server.listen(on_connection)
+        first = pyuv.TCP(self.loop)
+        first.connect(self.server.getsockname(), lambda handle, error: None)
+        self.loop.run()
+        self.assertEqual(self.rejects, ["max_active"])
+        self.assertEqual(errors, [pyuv.errno.UV_ECONNRESET])
+
 
 @platform_skip(["win32"])
 class TCPTryTest(TestCase):
@@ -483,6 +619,69 @@ class TCPTryTest(TestCase):
         self.loop.run()
 
 
+class ReadProtocol(object):
+
+    def __init__(self):
+        self.buffer = bytearray(16)
+        self.data = b""
+        self.eof = False
+
+    def get_buffer(self, size_hint):
+        return self.buffer
+
+    def buffer_updated(self, nbytes):
+        self.data += bytes(self.buffer[:nbytes])
+
+    def eof_received(self):
+        self.eof = True
+
+
+class TCPReadProtocolTest(TestCase):
+
+    def setUp(self):
+        super(TCPReadProtocolTest, self).setUp()
+        self.server = None
+        self.protocol = ReadProtocol()
+
+    def on_connection(self, server, error):
+        self.assertEqual(error, None)
+        client = pyuv.TCP(self.loop)
+        server.accept(client)
+        client.write(b"PING"*10)
+        client.close()
+        server.close()
+
+    def on_client_connection(self, client, error):
+        self.assertEqual(error, None)
+        eof_received = self.protocol.eof_received
+        def on_eof():
+            eof_received()
+            client.close()
+        self.protocol.eof_received = on_eof
+        client.start_read_protocol(self.protocol)
+
+    def test_read_protocol(self):
+        self.server = pyuv.TCP(self.loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(self.on_connection)
+        client = pyuv.TCP(self.loop)
+        client.connect(("127.0.0.1", TEST_PORT), self.on_client_connection)
+        self.loop.run()
+        self.assertEqual(self.protocol.data, b"PING"*10)
+        self.assertTrue(self.protocol.eof)
+
+    def test_read_protocol_errors(self):
+        self.server = pyuv.TCP(self.loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(self.on_connection)
+        self.assertRaises(pyuv.error.TCPError, self.server.start_read_protocol, self.protocol)
+        client = pyuv.TCP(self.loop)
+        self.assertRaises(AttributeError, client.start_read_protocol, object())
+        client.close()
+        self.server.close()
+        self.loop.run()
+
+
 class TCPTestFileno(TestCase):
 
     def check_fileno(self, handle):
@@ -611,5 +810,65 @@ class TCPSocketFromfdTest(TestCase):
         self.loop.run()
 
 
+class TCPConnectHostTest(TestCase):
+
+    def setUp(self):
+        super(TCPConnectHostTest, self).setUp()
+        self.server = pyuv.TCP(self.loop)
+        self.server.bind(("127.0.0.1", TEST_PORT))
+        self.server.listen(self.on_connection)
+        self.connections = []
+
+    def on_connection(self, server, error):
+        self.assertEqual(error, None)
+        client = pyuv.TCP(self.loop)
+        server.accept(client)
+        self.connections.append(client)
+        client.close()
+        server.close()
+
+    def test_connect_host(self):
+        self.results = []
+        def connect_cb(tcp, error):
+            self.results.append((tcp, error))
+            self.assertEqual(tcp.getpeername(), ("127.0.0.1", TEST_PORT))
+            tcp.close()
+        pyuv.TCP.connect_host(self.loop, "localhost", TEST_PORT, connect_cb)
+        self.loop.run()
+        self.assertEqual(len(self.results), 1)
+        self.assertEqual(self.results[0][1], None)
+        self.assertTrue(isinstance(self.results[0][0], pyuv.TCP))
+        self.assertEqual(len(self.connections), 1)
+
+    def test_connect_host_subclass(self):
+        class MyTCP(pyuv.TCP):
+            pass
+        self.results = []
+        def connect_cb(tcp, error):
+            self.results.append((tcp, error))
+            tcp.close()
+        MyTCP.connect_host(self.loop, u"127.0.0.1", str(TEST_PORT), connect_cb, delay=0.0)
+        self.loop.run()
+        self.assertEqual(len(self.results), 1)
+        self.assertEqual(self.results[0][1], None)
+        self.assertTrue(isinstance(self.results[0][0], MyTCP))
+
+    def test_connect_host_refused(self):
+        self.server.close()
+        self.results = []
+        def connect_cb(tcp, error):
+            self.results.append((tcp, error))
+        pyuv.TCP.connect_host(self.loop, "127.0.0.1", TEST_PORT, connect_cb)
+        self.loop.run()
+        self.assertEqual(self.results, [(None, pyuv.errno.UV_ECONNREFUSED)])
+
+    def test_connect_host_invalid(self):
+        self.assertRaises(TypeError, pyuv.TCP.connect_host, self.loop, "localhost", TEST_PORT, None)
+        self.assertRaises(TypeError, pyuv.TCP.connect_host, self.loop, None, TEST_PORT, lambda *args: None)
+        self.assertRaises(ValueError, pyuv.TCP.connect_host, self.loop, "localhost", TEST_PORT, lambda *args: None, -1.0)
+        self.server.close()
+        self.loop.run()
+
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
@@ -0,0 +1,252 @@
+
+import os
+import sys
+import threading
+import time
+import unittest
+
+try:
+    import queue
+except ImportError:
+    import Queue as queue
+
+from common import TestCase
+import pyuv
+
+
+class ThreadQueueTestMixin(object):
+
+    def test_put_get(self):
+        q = self.queue_type(4)
+        self.assertEqual(q.capacity, 4)
+        self.assertTrue(q.empty())
+        self.assertFalse(q.full())
+        for i in range(4):
+            q.put(i)
+        self.assertTrue(q.full())
+        self.assertEqual(len(q), 4)
+        self.assertEqual(q.qsize(), 4)
+        self.assertRaises(queue.Full, q.put, 4, False)
+        self.assertEqual([q.get() for i in range(4)], [0, 1, 2, 3])
+        self.assertRaises(queue.Empty, q.get, False)
+        self.assertTrue(q.empty())
+
+    def test_timeout(self):
+        q = self.queue_type(1)
+        t0 = time.time()
+        self.assertRaises(queue.Empty, q.get, timeout=0.1)
+        self.assertTrue(time.time() - t0 >= 0.09)
+        q.put(None)
+        t0 = time.time()
+        self.assertRaises(queue.Full, q.put, None, timeout=0.1)
+        self.assertTrue(time.time() - t0 >= 0.09)
+        self.assertRaises(ValueError, q.get, timeout=-1)
+
+    def test_many(self):
+        q = self.queue_type(4)
+        self.assertEqual(q.put_many(range(6), block=False), 4)
+        self.assertEqual(q.get_many(3), [0, 1, 2])
+        self.assertEqual(q.put_many(iter(range(6)), block=False), 3)
+        self.assertEqual(q.get_many(), [3, 0, 1, 2])
+        self.assertEqual(q.get_many(block=False), [])
+        self.assertEqual(q.get_many(timeout=0.01), [])
+        self.assertEqual(q.put_many([]), 0)
+        self.assertRaises(TypeError, q.put_many, None)
+
+    def test_invalid_capacity(self):
+        self.assertRaises(ValueError, self.queue_type, 0)
+        self.assertRaises(ValueError, self.queue_type, -1)
+
+    def test_wakeup(self):
+        q = self.queue_type(1)
+        def thread_cb():
+            time.sleep(0.05)
+            q.put("PING")
+        t = threading.Thread(target=thread_cb)
+        t.start()
+        self.assertEqual(q.get(timeout=5), "PING")
+        t.join()
+
+    def test_producer_consumer(self):
+        q = self.queue_type(16)
+        count = 20000
+        def producer():
+            for i in range(0, count, 100):
+                q.put_many(range(i, i + 100))
+        def consumer(result):
+            while len(result) < count:
+                result.extend(q.get_many(32))
+        result = []
+        threads = [threading.Thread(target=producer), threading.Thread(target=consumer, args=(result,))]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(result, list(range(count)))
+
+
+class SPSCQueueTest(ThreadQueueTestMixin, TestCase):
+    queue_type = pyuv.thread.SPSCQueue
+
+    def test_single_waiter(self):
+        q = self.queue_type(1)
+        errors = []
+        def thread_cb():
+            try:
+                q.get(timeout=0.5)
+            except RuntimeError:
+                errors.append(True)
+            except queue.Empty:
+                pass
+        threads = [threading.Thread(target=thread_cb) for i in range(2)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(errors, [True])
+
+
+class MPMCQueueTest(ThreadQueueTestMixin, TestCase):
+    queue_type = pyuv.thread.MPMCQueue
+
+    def test_many_producers_consumers(self):
+        q = self.queue_type(8)
+        count = 5000
+        def producer(n):
+            for i in range(count):
+                q.put((n, i))
+        def consumer(result):
+            while True:
+                item = q.get()
+                if item is None:
+                    break
+                result.append(item)
+        results = [[] for i in range(4)]
+        producers = [threading.Thread(target=producer, args=(n,)) for n in range(4)]
+        consumers = [threading.Thread(target=consumer, args=(result,)) for result in results]
+        for t in producers + consumers:
+            t.start()
+        for t in producers:
+            t.join()
+        q.put_many([None] * len(consumers))
+        for t in consumers:
+            t.join()
+        items = sorted(item for result in results for item in result)
+        self.assertEqual(items, sorted((n, i) for n in range(4) for i in range(count)))
+        for result in results:
+            for n in range(4):
+                ordered = [i for m, i in result if m == n]
+                self.assertEqual(ordered, sorted(ordered))
+
+    def test_gc(self):
+        import gc
+        import weakref
+        class Foo(object):
+            pass
+        q = self.queue_type(2)
+        foo = Foo()
+        foo.q = q
+        q.put(foo)
+        ref = weakref.ref(foo)
+        del foo, q
+        gc.collect()
+        self.assertEqual(ref(), None)
+
+
+
+class ThreadTest(TestCase):
+
+    def test_thread(self):
+        self.result = None
+        def thread_cb(a, b=None):
+            self.result = (a, b, threading.current_thread() is not main_thread)
+        main_thread = threading.current_thread()
+        t = pyuv.thread.Thread(thread_cb, (1,), {'b': 2}, name="worker")
+        self.assertEqual(t.name, "worker")
+        self.assertFalse(t.is_alive())
+        self.assertRaises(RuntimeError, t.join)
+        t.start()
+        self.assertRaises(RuntimeError, t.start)
+        t.join()
+        t.join()
+        self.assertFalse(t.is_alive())
+        self.assertEqual(self.result, (1, 2, True))
+
+    def test_stack_size(self):
+        self.called = False
+        def thread_cb():
+            self.called = True
+        t = pyuv.thread.Thread(thread_cb, stack_size=1024*1024)
+        self.assertEqual(t.stack_size, 1024*1024)
+        t.start()
+        t.join()
+        self.assertTrue(self.called)
+        self.assertRaises(ValueError, pyuv.thread.Thread, thread_cb, stack_size=-1)
+        self.assertRaises(pyuv.error.ThreadError, pyuv.thread.Thread(thread_cb, stack_size=1).start)
+
+    @unittest.skipUnless(sys.platform.startswith('linux'), "Linux only test")
+    def test_name_affinity(self):
+        self.result = None
+        def thread_cb():
+            with open('/proc/thread-self/comm') as f:
+                comm = f.read().strip()
+            self.result = (comm, os.sched_getaffinity(0))
+        t = pyuv.thread.Thread(thread_cb, name="pyuv-test-thread-name", cpus=[0])
+        self.assertEqual(t.cpus, (0,))
+        t.start()
+        t.join()
+        self.assertEqual(self.result, ("pyuv-test-threa", {0}))
+        self.assertRaises(ValueError, pyuv.thread.Thread, thread_cb, cpus=[-1])
+
+    def test_invalid_target(self):
+        self.assertRaises(TypeError, pyuv.thread.Thread, None)
+
+
+class LoopThreadTest(TestCase):
+
+    def test_call_soon_threadsafe(self):
+        self.result = []
+        event = threading.Event()
+        def cb(*args):
+            self.result.append(args)
+            if len(self.result) == 3:
+                event.set()
+        lt = self.loop.run_in_thread(name="loop")
+        self.assertEqual(lt.loop, self.loop)
+        self.assertEqual(lt.thread.name, "loop")
+        self.assertTrue(lt.is_alive())
+        lt.call_soon_threadsafe(cb)
+        lt.call_soon_threadsafe(cb, 1)
+        lt.call_soon_threadsafe(cb, 1, 2)
+        self.assertTrue(event.wait(5))
+        lt.stop()
+        lt.join()
+        self.assertFalse(lt.is_alive())
+        self.assertEqual(self.result, [(), (1,), (1, 2)])
+        self.assertRaises(RuntimeError, lt.call_soon_threadsafe, cb)
+
+    def test_handles(self):
+        self.ticks = 0
+        def timer_cb(timer):
+            self.ticks += 1
+            if self.ticks == 3:
+                timer.close()
+                lt.stop()
+        def start_timer():
+            timer = pyuv.Timer(self.loop)
+            timer.start(timer_cb, 0.01, 0.01)
+        lt = pyuv.thread.LoopThread(self.loop)
+        lt.call_soon_threadsafe(start_timer)
+        lt.join()
+        self.assertEqual(self.ticks, 3)
+
+    def test_loop_stop(self):
+        lt = self.loop.run_in_thread()
+        lt.call_soon_threadsafe(self.loop.stop)
+        lt.join()
+        self.assertFalse(lt.is_alive())
+        self.assertRaises(TypeError, self.loop.run_in_thread, 1)
+
+
+if __name__ == '__main__':
+    unittest.main(verbosity=2)
@@ -448,6 +448,20 @@ class UDPTryTest(TestCase):
         self.assertEqual(self.on_close_called, 3)
 
 
+@unittest.skipUnless(sys.platform.startswith('linux'), "Linux only test")
+class UDPBusyPollTest(TestCase):
+
+    def test_set_busy_poll(self):
+        udp = pyuv.UDP(self.loop)
+        udp.bind(("127.0.0.1", TEST_PORT))
+        # lowering the value doesn't need privileges
+        udp.set_busy_poll(0)
+        self.assertRaises(ValueError, udp.set_busy_poll, -1)
+        udp.close()
+        self.assertRaises(pyuv.error.HandleClosedError, udp.set_busy_poll, 0)
+        self.loop.run()
+
+
 class UDPEarlyBindTest(TestCase):
 
     def test_early_bind_unspec(self):
@@ -1,4 +1,7 @@
 
+import os
+import sys
+import threading
 import unittest
 
 from common import TestCase
@@ -38,6 +41,77 @@ class UtilTest(TestCase):
     def test_cpu_info(self):
         r = pyuv.util.cpu_info()
         self.assertTrue(r)
+        # topology fields are only accessible as attributes
+        self.assertEqual(len(r[0]), 3)
+        self.assertEqual([c.cpu for c in r], list(range(len(r))))
+
+    @unittest.skipUnless(sys.platform.startswith('linux'), "Linux only test")
+    def test_cpu_topology(self):
+        for c in pyuv.util.cpu_info():
+            self.assertTrue(isinstance(c.core, int))
+            self.assertTrue(isinstance(c.package, int))
+            self.assertTrue(c.cpu in c.siblings)
+            self.assertTrue(c.numa_node is None or c.numa_node >= 0)
+
+
+@unittest.skipUnless(sys.platform.startswith('linux'), "Linux only test")
+class ThreadpoolSchedTest(TestCase):
+
+    def _worker_info(self):
+        result = []
+        lock = threading.Lock()
+        def work_cb():
+            with lock:
+                result.append((os.sched_getaffinity(0), os.sched_getscheduler(0)))
+        for i in range(8):
+            self.loop.queue_work(work_cb)
+        self.loop.run()
+        return result
+
+    def test_affinity(self):
+        cpus = sorted(os.sched_getaffinity(0))
+        pyuv.util.set_threadpool_affinity(cpus[:1])
+        try:
+            for affinity, policy in self._worker_info():
+                self.assertEqual(affinity, set(cpus[:1]))
+        finally:
+            pyuv.util.set_threadpool_affinity(None)
+        for affinity, policy in self._worker_info():
+            self.assertEqual(affinity, set(cpus))
+        self.assertRaises(ValueError, pyuv.util.set_threadpool_affinity, [])
+        self.assertRaises(ValueError, pyuv.util.set_threadpool_affinity, [-1])
+
+    def test_scheduling(self):
+        pyuv.util.set_threadpool_scheduling(pyuv.util.SCHED_OTHER)
+        for affinity, policy in self._worker_info():
+            self.assertEqual(policy, pyuv.util.SCHED_OTHER)
+        self.assertRaises(ValueError, pyuv.util.set_threadpool_scheduling, -42)
+        self.assertRaises(ValueError, pyuv.util.set_threadpool_scheduling, pyuv.util.SCHED_OTHER, 20)
+
+    def test_busy_worker(self):
+        release = threading.Event()
+        self.loop.queue_work(release.wait)
+        try:
+            t0 = pyuv.util.hrtime()
+            with self.assertRaises(pyuv.error.UVError) as cm:
+                pyuv.util.set_threadpool_scheduling(pyuv.util.SCHED_OTHER, timeout=0.2)
+            self.assertEqual(cm.exception.args[0], pyuv.errno.UV_ETIMEDOUT)
+            self.assertTrue(pyuv.util.hrtime() - t0 < 2 * 1000 * 1000 * 1000)
+        finally:
+            release.set()
+        self.loop.run()
+        pyuv.util.set_threadpool_scheduling(pyuv.util.SCHED_OTHER)
+
+    def test_from_worker(self):
+        errors = []
+        def work_cb():
+            try:
+                pyuv.util.set_threadpool_affinity(None)
+            except RuntimeError as e:
+                errors.append(e)
+        self.loop.queue_work(work_cb)
+        self.loop.run()
+        self.assertEqual(len(errors), 1)
 
 
 if __name__ == '__main__':